@@ -3,6 +3,10 @@
 #include "CubePawn.h"
 #include "Ball.h"
 #include "CubeProjectGameMode.h"
+#include "CubeProjectGameState.h"
+#include "CubeMatchSim.h"
+#include "MallocCounter.h"
+#include "CubeMatchSaveFormat.h"
 
 
 // Sets the ball's default properties
@@ -48,25 +52,10 @@ void ABall::Tick(float DeltaSeconds)
 }
 
 /** Gives the ball an initial jolt when spawned. */
-void ABall::StartMove(const bool bMoveRight)
+void ABall::StartMove(const bool bMoveRight, FCubeRandomStream& KickoffStream)
 {
-    // Stores the x-direction the ball will move in (this is the horizontal component of the ball's normalized velocity)
-    float DirectionX = 0.0f;
-    
-    if(bMoveRight)
-    {
-        // Choose a random positive direction (to move right)
-        DirectionX = FMath::FRandRange(0.0,1.0f);
-    }
-    else
-    {
-        // Choose a random negative direction (to move left)
-        DirectionX = FMath::FRandRange(-1.0f,0.0f);
-    }
-    
-    // Set the ball's initial velocity
-    Direction = FVector(0.0f, DirectionX, FMath::FRandRange(-0.5f,0.5f)); // Choose a random starting direction
-    Direction.Normalize();
+    // Choose a random starting direction towards the right or left of the field
+    Direction = CubeSim::ToWorld(CubeSim::GetKickoffDirection(KickoffStream, bMoveRight));
     Speed = DefaultSpeed;
 
     // Apply the new speed and direction to the ball's physics velocity
@@ -95,17 +84,137 @@ void ABall::Reset()
 /** Update the ball's velocity to match the 'Speed' and 'Direction' variables. */
 void ABall::UpdateVelocity()
 {
-    FVector BallVelocity = Direction * Speed;
+    // Clamp the ball's speed
+    const FVector BallVelocity = CubeSim::ToWorld(CubeSim::GetBallVelocity(CubeSim::ToPlane(Direction), Speed, GetRules()));
+    
+    if(bDeterministic)
+    {
+        // The ball is moved by StepDeterministic(), which reads the velocity from the component
+        BallMesh->ComponentVelocity = BallVelocity;
+    }
+    else
+    {
+        BallMesh->SetPhysicsLinearVelocity(BallVelocity);
+    }
+}
+
+float ABall::GetBounceSpeed() const
+{
+    // The speed the ball moves at once UpdateVelocity() clamps it
+    return CubeSim::Size(CubeSim::GetBallVelocity(CubeSim::ToPlane(Direction), Speed, GetRules()));
+}
 
-    // Clamp the ball's maximum speed
-    BallVelocity = BallVelocity.GetClampedToSize(MinSpeed, MaxSpeed);
-    BallMesh->SetPhysicsLinearVelocity(BallVelocity);
+FCubeBallRules ABall::GetRules() const
+{
+    FCubeBallRules Rules;
+    Rules.DefaultSpeed = DefaultSpeed;
+    Rules.MinSpeed = MinSpeed;
+    Rules.MaxSpeed = MaxSpeed;
+    Rules.PlayerSpeedBounceFactor = PlayerSpeedBounceFactor;
+    Rules.CosAngleToIgnorePlayerVelocity = COS_ANGLE_TO_IGNORE_PLAYER_VELOCITY;
+    return Rules;
+}
+
+void ABall::CaptureSimState(FCubeSimBall& OutBall, const FGameplayTimerWheel& TimerWheel) const
+{
+    const ACubePawn* LastPawnHit = Cast<ACubePawn>(LastActorHit);
+    
+    OutBall.Location = CubeSim::ToPlane(GetActorLocation());
+    OutBall.Direction = CubeSim::ToPlane(Direction);
+    OutBall.Speed = Speed;
+    OutBall.HitCooldownTicks = (uint16)FMath::Min(TimerWheel.GetRemainingTicks(HitCooldownTimerHandle), (uint32)MAX_uint16);
+    OutBall.LastPlayerHit = (int8)(LastPawnHit ? LastPawnHit->GetPlayerSlot() : INDEX_NONE);
+}
+
+void ABall::SaveState(FCubeSavedBall& OutBall, const FGameplayTimerWheel& TimerWheel) const
+{
+    FCubeSimBall SimBall;
+    CaptureSimState(SimBall, TimerWheel);
+    
+    // The determinism mode moves the ball with the component's velocity rather than PhysX
+    const FVector Velocity = bDeterministic ? BallMesh->ComponentVelocity : BallMesh->GetPhysicsLinearVelocity();
+    
+    OutBall.LocationY = SimBall.Location.X;
+    OutBall.LocationZ = SimBall.Location.Y;
+    OutBall.DirectionY = SimBall.Direction.X;
+    OutBall.DirectionZ = SimBall.Direction.Y;
+    OutBall.Speed = SimBall.Speed;
+    OutBall.VelocityY = Velocity.Y;
+    OutBall.VelocityZ = Velocity.Z;
+    OutBall.HitCooldownTicks = SimBall.HitCooldownTicks;
+    OutBall.LastPlayerHit = SimBall.LastPlayerHit;
+    OutBall.bEnabled = GetActorEnableCollision() ? 1 : 0;
+}
+
+void ABall::RestoreState(const FCubeSavedBall& Ball, AActor* LastPawnHit, FGameplayTimerWheel& TimerWheel)
+{
+    SetEnabled(Ball.bEnabled != 0);
+    SetActorLocation(CubeSim::ToWorld(FVector2D(Ball.LocationY, Ball.LocationZ), GetActorLocation().X));
+    
+    Direction = CubeSim::ToWorld(FVector2D(Ball.DirectionY, Ball.DirectionZ));
+    Speed = Ball.Speed;
+    LastActorHit = LastPawnHit;
+    
+    const FVector Velocity = CubeSim::ToWorld(FVector2D(Ball.VelocityY, Ball.VelocityZ));
+    
+    if(bDeterministic)
+    {
+        BallMesh->ComponentVelocity = Velocity;
+    }
+    else
+    {
+        BallMesh->SetPhysicsLinearVelocity(Velocity);
+    }
+    
+    TimerWheel.Cancel(HitCooldownTimerHandle);
+    
+    if(Ball.HitCooldownTicks > 0)
+    {
+        HitCooldownTimerHandle = TimerWheel.Schedule(Ball.HitCooldownTicks, FSimpleDelegate());
+    }
+}
+
+void ABall::SetDeterministic(bool bInDeterministic)
+{
+    bDeterministic = bInDeterministic;
+    
+    // Let PhysX move the ball outside of the determinism mode
+    BallMesh->SetSimulatePhysics(!bDeterministic);
+    BallMesh->ComponentVelocity = FVector::ZeroVector;
+}
+
+void ABall::StepDeterministic(float DeltaTime)
+{
+    // The ball is disabled between matches
+    if(!GetActorEnableCollision())
+        return;
+    
+    const FVector Location = GetActorLocation();
+    const FVector2D NewLocation = CubeSim::Integrate(CubeSim::ToPlane(Location), CubeSim::ToPlane(BallMesh->ComponentVelocity), DeltaTime);
+    
+    // Sweep the ball to its new location. A blocking hit calls NotifyHit(), which bounces the ball. The ball then stays at
+    // the point of contact until the next tick.
+    SetActorLocation(CubeSim::ToWorld(NewLocation, Location.X), true);
+}
+
+void ABall::HashState(FCubeStateHasher& Hasher, const FGameplayTimerWheel& TimerWheel) const
+{
+    const ACubePawn* LastPawnHit = Cast<ACubePawn>(LastActorHit);
+    
+    Hasher.AddBool(TEXT("Ball.Enabled"), INDEX_NONE, GetActorEnableCollision());
+    Hasher.AddPlaneVector(TEXT("Ball.Location.Y"), TEXT("Ball.Location.Z"), INDEX_NONE, GetActorLocation());
+    Hasher.AddPlaneVector(TEXT("Ball.Direction.Y"), TEXT("Ball.Direction.Z"), INDEX_NONE, Direction);
+    Hasher.AddFloat(TEXT("Ball.Speed"), INDEX_NONE, Speed);
+    Hasher.AddInt(TEXT("Ball.LastPlayerHit"), INDEX_NONE, LastPawnHit ? LastPawnHit->GetPlayerSlot() : INDEX_NONE);
+    Hasher.AddInt(TEXT("Ball.HitCooldown"), INDEX_NONE, (int32)TimerWheel.GetRemainingTicks(HitCooldownTimerHandle));
 }
 
 /** Called when the ball is hit by another actor. */
 void ABall::NotifyHit(UPrimitiveComponent* MyComponent, AActor* Other, UPrimitiveComponent* OtherComponent, 
     bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
 {  
+    FGameplayAllocationScope GameplayAllocationScope;
+    
     UWorld* World = GetWorld();
     ACubeProjectGameMode* GameMode = World->GetAuthGameMode<ACubeProjectGameMode>();
 
@@ -118,26 +227,29 @@ void ABall::NotifyHit(UPrimitiveComponent* MyComponent, AActor* Other, UPrimitiv
     // Else, if anything other than a player hit the ball
     else
     {
+        const FVector2D WallNormal = CubeSim::SafeNormal(CubeSim::ToPlane(HitNormal));
+        
+        // The angle between the ball's incoming direction and the wall, recorded in the match's event log. The direction is no
+        // longer normalized once a player has pushed the ball, so both vectors are normalized in the gameplay plane first.
+        const float Cosine = FMath::Abs(FVector2D::DotProduct(CubeSim::SafeNormal(CubeSim::ToPlane(Direction)), WallNormal));
+        const float IncidenceAngle = FMath::RadiansToDegrees(FMath::Acos(FMath::Min(Cosine, 1.0f)));
+        
         // Make the ball go in the opposite direction it was hit.
-        Direction = Direction.MirrorByVector(HitNormal);
+        Direction = CubeSim::ToWorld(CubeSim::BounceOffWall(CubeSim::ToPlane(Direction), WallNormal));
 
-        Speed = BallMesh->GetPhysicsLinearVelocity().Size();
-
-        // Play the sound of the ball hitting a wall
-        if(GameMode->BallHitWallSound)
+        // PhysX may have slowed the ball down. In the determinism mode, the ball keeps its speed.
+        if(!bDeterministic)
         {
-            UGameplayStatics::PlaySoundAtLocation(World,GameMode->BallHitWallSound,GetActorLocation());
-        }
-        
-        // Spawn particles where the ball hit the wall.
-        if(GameMode->BallHitWallParticles)
-        {
-            UGameplayStatics::SpawnEmitterAtLocation(World,GameMode->BallHitWallParticles,HitLocation);
+            Speed = BallMesh->GetPhysicsLinearVelocity().Size();
         }
+
+        // Play the sound of the ball hitting a wall, with particles where the ball hit the wall
+        GameMode->PlayEffect(ECubeEffect::BallHitWall, GetActorLocation(), HitLocation);
         
         // Play a camera shake when the ball hits a wall
         if(GameMode->BallHitWallCameraShake)
         {
+            FEngineAllocationScope EngineAllocationScope;
             World->GetFirstPlayerController()->ClientPlayCameraShake_Implementation(GameMode->BallHitWallCameraShake, 1.0f, ECameraAnimPlaySpace::World,
                                                                                     FRotator::ZeroRotator);
         }
@@ -145,8 +257,7 @@ void ABall::NotifyHit(UPrimitiveComponent* MyComponent, AActor* Other, UPrimitiv
         // Update the last actor hit by the ball.
         LastActorHit = Other;
         
-        if (GEngine)
-            GEngine->AddOnScreenDebugMessage(-1, 3.0f, FColor::Green, FString::Printf(TEXT("New speed %d"), Speed));
+        GameMode->RecordMatchEvent(EMatchEventType::WallHit, INDEX_NONE, HitLocation, HitNormal, GetBounceSpeed(), IncidenceAngle);
     }
 
     // Update the ball's velocity based on the 'Speed' and 'Direction' variables.
@@ -157,67 +268,60 @@ void ABall::OnHitPlayer(AActor* PlayerHit, FVector HitLocation, FVector HitNorma
 {
     UWorld* World = GetWorld();
     ACubeProjectGameMode* GameMode = World->GetAuthGameMode<ACubeProjectGameMode>();
+    FGameplayTimerWheel& TimerWheel = GameMode->GetGameState<ACubeProjectGameState>()->GetTimerWheel();
     
     // Stores true if the same actor did not hit the ball twice
     const bool bDifferentActorHitBall = (LastActorHit != PlayerHit);
     // Stores true if enough time has been passed for the same actor to hit the ball twice
-    const bool bCooldownElapsed = (World->GetTimeSeconds() - LastHitTime) >= ABall::MULTIPLE_HIT_COOLDOWN;
+    const bool bCooldownElapsed = !TimerWheel.IsActive(HitCooldownTimerHandle);
     
     // If a different actor hit the ball, or enough time has elapsed for the same actor to hit the ball twice, bounce the ball off the actor which was hit
     if (bDifferentActorHitBall || bCooldownElapsed)
     {
-        // Get the direction from the player's center to the ball's center. This is the direction the ball will bounce
-        FVector BounceDirection = (this->GetActorLocation() - PlayerHit->GetActorLocation()).GetSafeNormal();
-        Direction = BounceDirection;
-        Speed = DefaultSpeed;
-        
-        float AngleBetweenBounceAndVelocity_Radians = acosf(FVector::DotProduct(BounceDirection,PlayerHit->GetVelocity().GetSafeNormal()));
-        float AngleBetweenBounceAndVelocity_Degrees = FMath::RadiansToDegrees(AngleBetweenBounceAndVelocity_Radians);
-        
-        if(GEngine)
-            GEngine->AddOnScreenDebugMessage(-1,3.0f,FColor::White,FString::Printf(TEXT("Angle between bounce direction and player velocity: %f"),AngleBetweenBounceAndVelocity_Degrees));
+        const FVector2D BallLocation = CubeSim::ToPlane(GetActorLocation());
+        const FVector2D PlayerLocation = CubeSim::ToPlane(PlayerHit->GetActorLocation());
+        const FVector2D PlayerVelocity = CubeSim::ToPlane(PlayerHit->GetVelocity());
         
-        const bool bIgnorePlayerVelocity = (AngleBetweenBounceAndVelocity_Degrees > ANGLE_TO_IGNORE_PLAYER_VELOCITY);
-        
-        // If the player's velocity should affect the ball's bounce velocity
-        if(!bIgnorePlayerVelocity)
-        {
-            // Add the cube's velocity to the ball's direction. Hence, the ball will bounce in the direction the player is moving
-            Direction += PlayerHit->GetVelocity() * PlayerSpeedBounceFactor;
-        }
+        // Bounce the ball away from the player's center. Unless the player moves against the bounce, add the cube's velocity
+        // to the ball's direction. Hence, the ball will bounce in the direction the player is moving.
+        Direction = CubeSim::ToWorld(CubeSim::BounceOffPlayer(BallLocation, PlayerLocation, PlayerVelocity, GetRules()));
+        Speed = DefaultSpeed;
         
-        // Play the sound of the ball hitting a player
-        if(GameMode->BallHitPlayerSound)
-        {
-            UGameplayStatics::PlaySoundAtLocation(World,GameMode->BallHitPlayerSound,GetActorLocation());
-        }
+        // The angle is only displayed and logged. The bounce itself compares cosines, since acos() differs between platforms.
+        const float BounceCos = FVector2D::DotProduct(CubeSim::SafeNormal(BallLocation - PlayerLocation), CubeSim::SafeNormal(PlayerVelocity));
+        const float AngleBetweenBounceAndVelocity_Degrees = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(BounceCos, -1.0f, 1.0f)));
         
-        // Spawn particles where the ball hit the player.
-        if(GameMode->BallHitPlayerParticles)
-        {
-            UGameplayStatics::SpawnEmitterAtLocation(World,GameMode->BallHitPlayerParticles,PlayerHit->GetActorLocation());
-        }
+        // Play the sound of the ball hitting a player, with particles where the ball hit the player
+        GameMode->PlayEffect(ECubeEffect::BallHitPlayer, GetActorLocation(), PlayerHit->GetActorLocation());
         
         // Play a camera shake when the ball hits a player
         if(GameMode->BallHitPlayerCameraShake)
         {
+            FEngineAllocationScope EngineAllocationScope;
             World->GetFirstPlayerController()->ClientPlayCameraShake(GameMode->BallHitPlayerCameraShake,1.0f,ECameraAnimPlaySpace::World,
                                                                      FRotator::ZeroRotator);
         }
         
-        // Update the last time the ball was hit by an actor
-        LastHitTime = World->GetTimeSeconds();
+        // Start the cooldown before the same actor can hit the ball again. The timer has no callback: it is only checked on the next hit.
+        TimerWheel.Cancel(HitCooldownTimerHandle);
+        HitCooldownTimerHandle = TimerWheel.Schedule(ACubeProjectGameState::SecondsToTicks(ABall::MULTIPLE_HIT_COOLDOWN), FSimpleDelegate());
         LastActorHit = PlayerHit;
+        
+        const ACubePawn* PawnHit = Cast<ACubePawn>(PlayerHit);
+        GameMode->RecordMatchEvent(EMatchEventType::PlayerHit, PawnHit ? PawnHit->GetPlayerSlot() : INDEX_NONE, HitLocation, HitNormal,
+                                   GetBounceSpeed(), AngleBetweenBounceAndVelocity_Degrees);
     }
 }
 
 void ABall::NotifyActorBeginOverlap(AActor* Other)
 {
-    if (GEngine)
-        GEngine->AddOnScreenDebugMessage(-1, 3.0f, FColor::Green, "Begin to hit pawn");
+    FGameplayAllocationScope GameplayAllocationScope;
 
+    // If the ball overlaps a player
+    if (Other && Other->IsA(ACubePawn::StaticClass()))
+    {
         // Add the cube's velocity to the ball's direction. Hence, the ball will bounce in the direction the player is moving
-        Direction += Other->GetVelocity() * PlayerSpeedBounceFactor;
+        Direction = CubeSim::ToWorld(CubeSim::AddPlayerVelocity(CubeSim::ToPlane(Direction), CubeSim::ToPlane(Other->GetVelocity()), GetRules()));
     }
 
     // Update the ball's velocity based on the 'Speed' and 'Direction' variables.
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "GameFramework/Actor.h"
+#include "GameplayTimerWheel.h"
+#include "CubeSimRules.h"
 #include "Ball.generated.h"
 
 UCLASS()
@@ -26,14 +28,40 @@ public:
     UFUNCTION()
     virtual void NotifyActorBeginOverlap(AActor* OtherActor) override;
 
-    /** Called when the ball spawns. Gives the ball an initial push. If bMoveRight is true, the ball is launched to the right of the field. */
-    void StartMove(const bool bMoveRight);
+    /** Called when the ball spawns. Gives the ball an initial push. If bMoveRight is true, the ball is launched to the right of the field.
+      * The direction is drawn from the given stream, so that the kickoffs of a match only depend on its seed. */
+    void StartMove(const bool bMoveRight, FCubeRandomStream& KickoffStream);
     
     /** Enables/disables the ball. If disabled, the ball is no longer rendered on screen. */
     void SetEnabled(const bool bEnabled);
     
     /** Resets the ball to its starting position (0,0) */
     void Reset();    
+    
+    /** Enables or disables the determinism mode. In this mode, the ball is moved by StepDeterministic() instead of PhysX. */
+    void SetDeterministic(bool bInDeterministic);
+    
+    /** Moves the ball by one simulation tick in the determinism mode. Bounces are handled by NotifyHit() as usual. */
+    void StepDeterministic(float DeltaTime);
+    
+    /** Adds the ball's gameplay state to the given hash. */
+    void HashState(FCubeStateHasher& Hasher, const FGameplayTimerWheel& TimerWheel) const;
+    
+    /** Returns the ball's tuning in the form used by the gameplay rules. */
+    FCubeBallRules GetRules() const;
+    
+    /** Returns the ball's current speed, before it is clamped to the ball's speed range. */
+    FORCEINLINE float GetSpeed() const { return Speed; }
+    
+    /** Copies the ball's gameplay state to its form in the match simulation. */
+    void CaptureSimState(struct FCubeSimBall& OutBall, const FGameplayTimerWheel& TimerWheel) const;
+    
+    /** Copies the ball's state to a saved match. */
+    void SaveState(struct FCubeSavedBall& OutBall, const FGameplayTimerWheel& TimerWheel) const;
+    
+    /** Replaces the ball's state with a saved one. The hit cooldown is scheduled again on the given wheel.
+      * @param LastPawnHit The pawn of the saved LastPlayerHit slot, or NULL */
+    void RestoreState(const struct FCubeSavedBall& Ball, AActor* LastPawnHit, FGameplayTimerWheel& TimerWheel);
 
     /** The amount of time that must pass for the same player to hit the ball twice. If the player could hit the ball multiple times in
       * in a short time frame, the physics would be glitchy. */
@@ -44,11 +72,16 @@ public:
      * player velocity were pointing in opposite directions, the ball would move in a random direction if both vectors would
      * affect the ball's velocity. Thus, we should ignore the player's velocity and only let the hit normal affect the ball's velocity. */
     static constexpr float ANGLE_TO_IGNORE_PLAYER_VELOCITY = 100;
+    /** The cosine of ANGLE_TO_IGNORE_PLAYER_VELOCITY. The bounce compares cosines, which are exact on every platform. */
+    static constexpr float COS_ANGLE_TO_IGNORE_PLAYER_VELOCITY = -0.173648178f;
 
 private:
     /** Updates the ball's velocity based on the 'Speed' and 'Direction' variables. */
     void UpdateVelocity();
     
+    /** Returns the speed the ball will move at once UpdateVelocity() is called. */
+    float GetBounceSpeed() const;
+    
     /** Called when the ball hits a player. Makes the ball bounce in the appropriate direction. */
     void OnHitPlayer(AActor* PlayerHit, FVector HitLocation, FVector HitNormal);
 
@@ -79,8 +112,11 @@ private:
 
     /** Stores the last actor hit by the ball. Used to avoid bouncing off a player multiple times a second. */
     AActor* LastActorHit;
-    /** The last time at which the ball was hit. Used to avoid bouncing off a player multiple times a second. */
-    float LastHitTime; 
+    /** If true, the ball is moved by StepDeterministic() instead of PhysX. */
+    bool bDeterministic = false;
+    
+    /** The cooldown started when the ball bounces off a player. Used to avoid bouncing off a player multiple times a second. */
+    FGameplayTimerHandle HitCooldownTimerHandle;
 
 };
 
@@ -0,0 +1,452 @@
+#include "CubeProject.h"
+#include "BroadcastRelayCommandlet.h"
+#include "CubeBroadcast.h"
+#include "CubeMatchSim.h"
+#include "CubeBot.h"
+#include "CubeProjectGameState.h"
+#include "MatchEventLogFormat.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+namespace
+{
+    /** A chunk of the frame log. Frames are appended to the last chunk until it is full; a chunk is never reallocated or
+      * modified once full, so subscribers send straight from it. A chunk is freed once no subscriber needs it anymore. */
+    struct FFrameChunk
+    {
+        TArray<uint8> Data;
+        /** The offset of the chunk's first byte in the stream. */
+        uint64 StreamOffset;
+        /** The chunk after this one, once it is created. */
+        TSharedPtr<FFrameChunk> Next;
+    };
+
+    /** A position in the frame log. */
+    struct FFrameCursor
+    {
+        TSharedPtr<FFrameChunk> Chunk;
+        int32 Offset = 0;
+
+        FORCEINLINE uint64 GetStreamOffset() const { return Chunk->StreamOffset + Offset; }
+    };
+
+    /** The frames received from the game, shared by every subscriber. */
+    class FFrameLog
+    {
+    public:
+        FFrameLog()
+            : Tail(MakeShareable(new FFrameChunk()))
+            , StreamSize(0)
+        {
+            Tail->Data.Reserve(UBroadcastRelayCommandlet::CHUNK_SIZE);
+            Tail->StreamOffset = 0;
+        }
+
+        /** Appends a whole frame to the log. */
+        void Append(const uint8* Frame, int32 Size)
+        {
+            // Frames never span two chunks, so that a subscriber starting at a keyframe starts at a chunk offset
+            if(Tail->Data.Num() + Size > UBroadcastRelayCommandlet::CHUNK_SIZE)
+            {
+                TSharedPtr<FFrameChunk> NewTail = MakeShareable(new FFrameChunk());
+                NewTail->Data.Reserve(UBroadcastRelayCommandlet::CHUNK_SIZE);
+                NewTail->StreamOffset = StreamSize;
+                Tail->Next = NewTail;
+                Tail = NewTail;
+            }
+
+            if(CubeBroadcast::IsKeyframe(Frame))
+            {
+                LastKeyframe.Chunk = Tail;
+                LastKeyframe.Offset = Tail->Data.Num();
+            }
+
+            Tail->Data.Append(Frame, Size);
+            StreamSize += Size;
+        }
+
+        /** Returns the position of the last keyframe. Its chunk is invalid until the first keyframe is received. */
+        FORCEINLINE const FFrameCursor& GetLastKeyframe() const { return LastKeyframe; }
+
+        /** Returns the number of bytes appended to the log. */
+        FORCEINLINE uint64 GetStreamSize() const { return StreamSize; }
+
+    private:
+        TSharedPtr<FFrameChunk> Tail;
+        FFrameCursor LastKeyframe;
+        uint64 StreamSize;
+    };
+
+    /** A spectator connected to the relay. */
+    struct FSubscriber
+    {
+        FSocket* Socket;
+        /** The next byte to send. Its chunk is invalid until the subscriber starts at a keyframe. */
+        FFrameCursor Cursor;
+    };
+
+    /** Creates a non-blocking socket listening on every interface on the given port. Returns NULL on failure. */
+    FSocket* CreateListenSocket(int32 Port, const TCHAR* Description)
+    {
+        ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+        FSocket* Socket = SocketSubsystem->CreateSocket(NAME_Stream, Description, false);
+        TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr(0, Port);
+
+        if(!Socket || !Socket->SetReuseAddr(true) || !Socket->Bind(*Address) || !Socket->Listen(64) || !Socket->SetNonBlocking(true))
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("Could not listen on port %d"), Port);
+
+            if(Socket)
+            {
+                SocketSubsystem->DestroySocket(Socket);
+            }
+
+            return NULL;
+        }
+
+        return Socket;
+    }
+
+    /** Closes and destroys a socket. */
+    void DestroySocket(FSocket* Socket)
+    {
+        if(Socket)
+        {
+            Socket->Close();
+            ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        }
+    }
+
+    /** Returns true if the last socket error only means that the operation would block. */
+    bool WouldBlock()
+    {
+        return ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK;
+    }
+
+    /**
+     * Sends the subscriber as much of the log as its socket accepts, straight from the shared chunks.
+     * @return false if the connection is lost.
+     */
+    bool SendFrames(FSubscriber& Subscriber, uint64& InOutBytesSent)
+    {
+        FFrameCursor& Cursor = Subscriber.Cursor;
+
+        while(true)
+        {
+            const int32 Available = Cursor.Chunk->Data.Num() - Cursor.Offset;
+
+            if(Available == 0)
+            {
+                // Move to the next chunk once this one is full and sent
+                if(!Cursor.Chunk->Next.IsValid())
+                    return true;
+
+                Cursor.Chunk = Cursor.Chunk->Next;
+                Cursor.Offset = 0;
+                continue;
+            }
+
+            int32 Sent = 0;
+
+            if(!Subscriber.Socket->Send(Cursor.Chunk->Data.GetData() + Cursor.Offset, Available, Sent))
+                return WouldBlock();
+
+            if(Sent == 0)
+                return true;
+
+            Cursor.Offset += Sent;
+            InOutBytesSent += Sent;
+        }
+    }
+
+    /** Plays a match between scripted bots with the match simulation, and encodes it like the game does. */
+    class FSyntheticMatch
+    {
+    public:
+        explicit FSyntheticMatch(int32 NumPlayers)
+            : KickoffStream(FPlatformTime::Cycles64(), ECubeRandomStream::Kickoff)
+        {
+            FMemory::Memzero(State);
+            State.NumPlayers = FMath::Clamp(NumPlayers, 1, FCubePlayerRegistry::MAX_PLAYERS);
+            CubeSim::GetDefaultStartLocations(Config.Arena, State.NumPlayers, StartLocations);
+            CubeSim::ResetField(State, StartLocations);
+            CubeSim::Kickoff(State, Config, KickoffStream, true);
+        }
+
+        /** Simulates a tick and returns its frame, which is valid until the next tick. */
+        const TArray<uint8>& Tick()
+        {
+            FCubeSimInput Inputs[FCubePlayerRegistry::MAX_PLAYERS];
+            FCubeScriptedBot::GetSimInputs(State, Config, Inputs);
+
+            const FCubeSimEvents SimEvents = CubeSim::Step(State, Config, Inputs);
+            Events.Reset();
+
+            if(SimEvents.bWallHit)
+            {
+                AddEvent(EMatchEventType::WallHit, INDEX_NONE, 0);
+            }
+
+            if(SimEvents.PlayerHit != INDEX_NONE)
+            {
+                AddEvent(EMatchEventType::PlayerHit, SimEvents.PlayerHit, 0);
+            }
+
+            if(SimEvents.ScoringTeam != INDEX_NONE)
+            {
+                AddEvent(EMatchEventType::Goal, INDEX_NONE, SimEvents.ScoringTeam);
+
+                // Kick off towards the team which conceded, and start over once the scores get large
+                if(State.Scores[SimEvents.ScoringTeam] >= 99)
+                {
+                    State.Scores[0] = State.Scores[1] = 0;
+                }
+
+                CubeSim::ResetField(State, StartLocations);
+                CubeSim::Kickoff(State, Config, KickoffStream, SimEvents.ScoringTeam == 0);
+            }
+
+            FCubeBroadcastState BroadcastState;
+            FMemory::Memzero(BroadcastState);
+            BroadcastState.Tick = State.Tick;
+            BroadcastState.GameState = EGameState::PLAYING;
+            BroadcastState.Scores[0] = State.Scores[0];
+            BroadcastState.Scores[1] = State.Scores[1];
+            BroadcastState.NumPlayers = State.NumPlayers;
+            BroadcastState.BallY = CubeBroadcast::QuantizeLocation(State.Ball.Location.X);
+            BroadcastState.BallZ = CubeBroadcast::QuantizeLocation(State.Ball.Location.Y);
+
+            for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+            {
+                BroadcastState.PawnY[Slot] = CubeBroadcast::QuantizeLocation(State.Pawns[Slot].Location.X);
+                BroadcastState.PawnZ[Slot] = CubeBroadcast::QuantizeLocation(State.Pawns[Slot].Location.Y);
+            }
+
+            Encoder.Encode(BroadcastState, Events, Frame);
+            return Frame;
+        }
+
+    private:
+        void AddEvent(EMatchEventType::Type Type, int32 Slot, int32 Param)
+        {
+            FCubeBroadcastEvent& Event = Events[Events.AddUninitialized()];
+            Event.Type = Type;
+            Event.Slot = (int8)Slot;
+            Event.Param = (int16)Param;
+            Event.LocationY = CubeBroadcast::QuantizeLocation(State.Ball.Location.X);
+            Event.LocationZ = CubeBroadcast::QuantizeLocation(State.Ball.Location.Y);
+        }
+
+        FCubeSimConfig Config;
+        FCubeMatchState State;
+        FVector2D StartLocations[FCubePlayerRegistry::MAX_PLAYERS];
+        FCubeRandomStream KickoffStream;
+        FCubeBroadcastEncoder Encoder;
+        TArray<FCubeBroadcastEvent> Events;
+        /** The frame of the last tick. */
+        TArray<uint8> Frame;
+    };
+}
+
+UBroadcastRelayCommandlet::UBroadcastRelayCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UBroadcastRelayCommandlet::Main(const FString& Params)
+{
+    int32 IngestPort = DEFAULT_INGEST_PORT;
+    int32 Port = DEFAULT_PORT;
+    int32 NumPlayers = 2;
+    float Duration = 0.0f;
+    const bool bSynthetic = FParse::Param(*Params, TEXT("synthetic"));
+
+    FParse::Value(*Params, TEXT("IngestPort="), IngestPort);
+    FParse::Value(*Params, TEXT("Port="), Port);
+    FParse::Value(*Params, TEXT("players="), NumPlayers);
+    FParse::Value(*Params, TEXT("duration="), Duration);
+
+    FSocket* IngestListener = bSynthetic ? NULL : CreateListenSocket(IngestPort, TEXT("BroadcastRelayIngest"));
+    FSocket* Listener = CreateListenSocket(Port, TEXT("BroadcastRelay"));
+
+    if((!bSynthetic && !IngestListener) || !Listener)
+    {
+        DestroySocket(IngestListener);
+        DestroySocket(Listener);
+        return 2;
+    }
+
+    if(bSynthetic)
+    {
+        UE_LOG(LogCubeProject, Display, TEXT("Broadcasting a synthetic %d player match to subscribers on port %d"), NumPlayers, Port);
+    }
+    else
+    {
+        UE_LOG(LogCubeProject, Display, TEXT("Relaying the game on port %d to subscribers on port %d"), IngestPort, Port);
+    }
+
+    FFrameLog FrameLog;
+    TArray<FSubscriber> Subscribers;
+    FSocket* Publisher = NULL;
+    TArray<uint8> IngestBuffer;
+    int32 IngestBufferStart = 0;
+    TSharedPtr<FSyntheticMatch> SyntheticMatch = bSynthetic ? MakeShareable(new FSyntheticMatch(NumPlayers)) : NULL;
+
+    const double StartTime = FPlatformTime::Seconds();
+    double NextSyntheticTickTime = StartTime;
+    double NextReportTime = StartTime + 5.0;
+    uint64 BytesSent = 0;
+    int32 FramesReceived = 0;
+    int32 NumDropped = 0;
+
+    while(!GIsRequestingExit && (Duration <= 0.0f || FPlatformTime::Seconds() - StartTime < Duration))
+    {
+        bool bHasPendingConnection = false;
+
+        // Accept the new subscribers. They are started at the next send.
+        while(Listener->HasPendingConnection(bHasPendingConnection) && bHasPendingConnection)
+        {
+            FSocket* Socket = Listener->Accept(TEXT("BroadcastSubscriber"));
+
+            if(!Socket)
+                break;
+
+            Socket->SetNonBlocking(true);
+            Socket->SetNoDelay(true);
+
+            FSubscriber& Subscriber = Subscribers[Subscribers.AddDefaulted()];
+            Subscriber.Socket = Socket;
+        }
+
+        // Receive the frames of the tick
+        if(SyntheticMatch.IsValid())
+        {
+            while(FPlatformTime::Seconds() >= NextSyntheticTickTime)
+            {
+                const TArray<uint8>& Frame = SyntheticMatch->Tick();
+                FrameLog.Append(Frame.GetData(), Frame.Num());
+                FramesReceived++;
+                NextSyntheticTickTime += 1.0 / 60.0;
+            }
+        }
+        else
+        {
+            // Only one game is relayed at a time: a new connection replaces the current one
+            if(IngestListener->HasPendingConnection(bHasPendingConnection) && bHasPendingConnection)
+            {
+                if(FSocket* Socket = IngestListener->Accept(TEXT("BroadcastPublisher")))
+                {
+                    UE_LOG(LogCubeProject, Display, TEXT("The game connected"));
+                    DestroySocket(Publisher);
+                    Publisher = Socket;
+                    Publisher->SetNonBlocking(true);
+                    IngestBuffer.Reset();
+                    IngestBufferStart = 0;
+                }
+            }
+
+            uint32 PendingSize = 0;
+
+            while(Publisher && Publisher->HasPendingData(PendingSize))
+            {
+                const int32 ReadStart = IngestBuffer.Num();
+                int32 BytesRead = 0;
+                IngestBuffer.AddUninitialized(FMath::Min<int32>(PendingSize, CHUNK_SIZE));
+
+                Publisher->Recv(IngestBuffer.GetData() + ReadStart, IngestBuffer.Num() - ReadStart, BytesRead);
+                IngestBuffer.SetNum(ReadStart + FMath::Max(BytesRead, 0), false);
+            }
+
+            // A socket which can be read without any pending data was closed by the game
+            if(Publisher && Publisher->Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero()) && !Publisher->HasPendingData(PendingSize))
+            {
+                UE_LOG(LogCubeProject, Display, TEXT("The game disconnected"));
+                DestroySocket(Publisher);
+                Publisher = NULL;
+            }
+
+            // Append the whole frames received, keeping any partial frame for the next receive
+            while(true)
+            {
+                const int32 Available = IngestBuffer.Num() - IngestBufferStart;
+                const int32 FrameSize = CubeBroadcast::GetFrameSize(IngestBuffer.GetData() + IngestBufferStart, Available);
+
+                if(FrameSize == 0 || FrameSize > Available)
+                    break;
+
+                if(FrameSize < (int32)sizeof(FCubeBroadcastFrameHeader) || FrameSize > CUBE_BROADCAST_MAX_FRAME_SIZE)
+                {
+                    UE_LOG(LogCubeProject, Warning, TEXT("Received a malformed frame from the game. Disconnecting it."));
+                    DestroySocket(Publisher);
+                    Publisher = NULL;
+                    IngestBuffer.Reset();
+                    IngestBufferStart = 0;
+                    break;
+                }
+
+                FrameLog.Append(IngestBuffer.GetData() + IngestBufferStart, FrameSize);
+                IngestBufferStart += FrameSize;
+                FramesReceived++;
+            }
+
+            if(IngestBufferStart > 0)
+            {
+                IngestBuffer.RemoveAt(0, IngestBufferStart, false);
+                IngestBufferStart = 0;
+            }
+        }
+
+        // Send the new frames to every subscriber
+        for(int32 Index = Subscribers.Num() - 1; Index >= 0; Index--)
+        {
+            FSubscriber& Subscriber = Subscribers[Index];
+
+            if(!Subscriber.Cursor.Chunk.IsValid())
+            {
+                if(!FrameLog.GetLastKeyframe().Chunk.IsValid())
+                    continue;
+
+                Subscriber.Cursor = FrameLog.GetLastKeyframe();
+            }
+
+            const bool bTooFarBehind = FrameLog.GetStreamSize() - Subscriber.Cursor.GetStreamOffset() > (uint64)MAX_SUBSCRIBER_LAG;
+
+            if(bTooFarBehind || !SendFrames(Subscriber, BytesSent))
+            {
+                if(bTooFarBehind)
+                {
+                    NumDropped++;
+                }
+
+                DestroySocket(Subscriber.Socket);
+                Subscribers.RemoveAtSwap(Index);
+            }
+        }
+
+        if(FPlatformTime::Seconds() >= NextReportTime)
+        {
+            UE_LOG(LogCubeProject, Display, TEXT("%d subscribers, %.1f frames/s in, %.1f KB/s out, %d dropped for lagging"), Subscribers.Num(),
+                   FramesReceived / 5.0f, BytesSent / 5.0f / 1024.0f, NumDropped);
+
+            FramesReceived = 0;
+            BytesSent = 0;
+            NextReportTime += 5.0;
+        }
+
+        FPlatformProcess::Sleep(0.001f);
+    }
+
+    for(FSubscriber& Subscriber : Subscribers)
+    {
+        DestroySocket(Subscriber.Socket);
+    }
+
+    DestroySocket(Publisher);
+    DestroySocket(IngestListener);
+    DestroySocket(Listener);
+    return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BroadcastRelayCommandlet.generated.h"
+
+/**
+ * Relays the spectator broadcast of a match to many subscribers. The game (-Broadcast) connects to the ingest port and
+ * sends one encoded frame per tick; the relay appends the frames to a log of shared chunks and sends every subscriber
+ * its part of that log as is. Frames are never decoded, re-encoded or copied per subscriber, so the cost of a new
+ * subscriber is one send per chunk. New subscribers start at the last keyframe, and subscribers which fall more than
+ * MAX_SUBSCRIBER_LAG bytes behind are disconnected instead of slowing down the others.
+ *
+ * With -synthetic, the relay broadcasts a match between scripted bots played by the match simulation instead of waiting
+ * for a game, which lets UBroadcastSubscribersCommandlet measure the fan-out without running the game.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=BroadcastRelay [-IngestPort=<port>] [-Port=<port>] [-synthetic] [-players=<count>]
+ *        [-duration=<seconds>]
+ *
+ * Returns 0 once the relay ran for the given duration (forever by default), and 2 if a port can't be opened.
+ */
+UCLASS()
+class UBroadcastRelayCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    /** The default ports of the game's connection and of the subscribers. */
+    static constexpr int32 DEFAULT_INGEST_PORT = 7790;
+    static constexpr int32 DEFAULT_PORT = 7791;
+    /** The size of each chunk of the frame log, in bytes. */
+    static constexpr int32 CHUNK_SIZE = 16 * 1024;
+    /** The number of bytes a subscriber can fall behind the newest frame before it is disconnected. */
+    static constexpr int32 MAX_SUBSCRIBER_LAG = 64 * CHUNK_SIZE;
+
+    UBroadcastRelayCommandlet();
+
+    // Runs the relay
+    virtual int32 Main(const FString& Params) override;
+};
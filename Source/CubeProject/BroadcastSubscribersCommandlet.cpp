@@ -0,0 +1,209 @@
+#include "CubeProject.h"
+#include "BroadcastSubscribersCommandlet.h"
+#include "CubeBroadcast.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+namespace
+{
+    /** The number of bytes read from a socket at once. */
+    constexpr int32 RECEIVE_SIZE = 16 * 1024;
+
+    /** A spectator connected to the relay. */
+    struct FSubscriberStream
+    {
+        FSocket* Socket = NULL;
+        FCubeBroadcastDecoder Decoder;
+        /** The bytes received but not decoded yet. */
+        TArray<uint8> Buffer;
+        /** The tick of the last frame decoded. */
+        uint32 LastTick = 0;
+        int32 NumFrames = 0;
+        uint64 NumBytes = 0;
+        /** True once the stream is known to be bad. The subscriber is disconnected. */
+        bool bFailed = false;
+    };
+
+    /** Decodes the whole frames received by the subscriber. Returns false if the stream is malformed. */
+    bool DecodeFrames(FSubscriberStream& Subscriber)
+    {
+        int32 Start = 0;
+
+        while(true)
+        {
+            const int32 Available = Subscriber.Buffer.Num() - Start;
+            const uint8* Frame = Subscriber.Buffer.GetData() + Start;
+            const int32 FrameSize = CubeBroadcast::GetFrameSize(Frame, Available);
+
+            if(FrameSize == 0 || FrameSize > Available)
+                break;
+
+            if(FrameSize < (int32)sizeof(FCubeBroadcastFrameHeader))
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("Subscriber received a malformed frame (size %d)"), FrameSize);
+                return false;
+            }
+
+            // The relay starts every subscriber at a keyframe, and the ticks of a match only increase
+            const bool bStartsAtKeyframe = Subscriber.Decoder.HasKeyframe() || CubeBroadcast::IsKeyframe(Frame);
+
+            if(!bStartsAtKeyframe || !Subscriber.Decoder.Decode(Frame, FrameSize))
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("Subscriber received a malformed frame (%s)"), bStartsAtKeyframe ? TEXT("decode error") : TEXT("no keyframe"));
+                return false;
+            }
+
+            const uint32 Tick = Subscriber.Decoder.GetState().Tick;
+
+            if(Subscriber.NumFrames > 0 && Tick <= Subscriber.LastTick && !CubeBroadcast::IsKeyframe(Frame))
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("Subscriber received tick %u after tick %u"), Tick, Subscriber.LastTick);
+                return false;
+            }
+
+            Subscriber.LastTick = Tick;
+            Subscriber.NumFrames++;
+            Start += FrameSize;
+        }
+
+        Subscriber.Buffer.RemoveAt(0, Start, false);
+        return true;
+    }
+}
+
+UBroadcastSubscribersCommandlet::UBroadcastSubscribersCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UBroadcastSubscribersCommandlet::Main(const FString& Params)
+{
+    FString RelayAddress = TEXT("127.0.0.1:7791");
+    int32 Count = 200;
+    float Duration = 30.0f;
+
+    FParse::Value(*Params, TEXT("relay="), RelayAddress);
+    FParse::Value(*Params, TEXT("count="), Count);
+    FParse::Value(*Params, TEXT("duration="), Duration);
+
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+    FString Host;
+    FString Port;
+    bool bIsValid = false;
+
+    if(RelayAddress.Split(TEXT(":"), &Host, &Port))
+    {
+        Address->SetIp(*Host, bIsValid);
+        Address->SetPort(FCString::Atoi(*Port));
+    }
+
+    if(!bIsValid || Count <= 0)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=BroadcastSubscribers [-relay=<address:port>] [-count=<subscribers>] [-duration=<seconds>]"));
+        return 2;
+    }
+
+    TArray<FSubscriberStream> Subscribers;
+    Subscribers.AddDefaulted(Count);
+
+    for(FSubscriberStream& Subscriber : Subscribers)
+    {
+        Subscriber.Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("BroadcastSubscriber"), false);
+
+        if(!Subscriber.Socket || !Subscriber.Socket->Connect(*Address))
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("Could not connect to the relay at %s. Is it running?"), *RelayAddress);
+
+            for(FSubscriberStream& Connected : Subscribers)
+            {
+                if(Connected.Socket)
+                {
+                    SocketSubsystem->DestroySocket(Connected.Socket);
+                }
+            }
+
+            return 2;
+        }
+
+        Subscriber.Socket->SetNonBlocking(true);
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("%d subscribers connected to %s"), Count, *RelayAddress);
+
+    const double EndTime = FPlatformTime::Seconds() + Duration;
+    int32 NumFailed = 0;
+
+    while(FPlatformTime::Seconds() < EndTime && !GIsRequestingExit)
+    {
+        for(FSubscriberStream& Subscriber : Subscribers)
+        {
+            if(Subscriber.bFailed)
+                continue;
+
+            uint32 PendingSize = 0;
+
+            while(Subscriber.Socket->HasPendingData(PendingSize))
+            {
+                const int32 ReadStart = Subscriber.Buffer.Num();
+                int32 BytesRead = 0;
+                Subscriber.Buffer.AddUninitialized(FMath::Min<int32>(PendingSize, RECEIVE_SIZE));
+
+                Subscriber.Socket->Recv(Subscriber.Buffer.GetData() + ReadStart, Subscriber.Buffer.Num() - ReadStart, BytesRead);
+                BytesRead = FMath::Max(BytesRead, 0);
+                Subscriber.Buffer.SetNum(ReadStart + BytesRead, false);
+                Subscriber.NumBytes += BytesRead;
+            }
+
+            // A socket which can be read without any pending data was closed by the relay
+            const bool bDisconnected = Subscriber.Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero())
+                                       && !Subscriber.Socket->HasPendingData(PendingSize);
+
+            if(bDisconnected)
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("Subscriber was disconnected by the relay"));
+            }
+
+            if(bDisconnected || !DecodeFrames(Subscriber))
+            {
+                Subscriber.bFailed = true;
+                NumFailed++;
+            }
+        }
+
+        FPlatformProcess::Sleep(0.001f);
+    }
+
+    int32 TotalFrames = 0;
+    uint64 TotalBytes = 0;
+    int32 MinFrames = MAX_int32;
+    uint32 MinTick = MAX_uint32;
+    uint32 MaxTick = 0;
+
+    for(FSubscriberStream& Subscriber : Subscribers)
+    {
+        TotalFrames += Subscriber.NumFrames;
+        TotalBytes += Subscriber.NumBytes;
+        MinFrames = FMath::Min(MinFrames, Subscriber.NumFrames);
+
+        if(!Subscriber.bFailed)
+        {
+            MinTick = FMath::Min(MinTick, Subscriber.LastTick);
+            MaxTick = FMath::Max(MaxTick, Subscriber.LastTick);
+        }
+
+        Subscriber.Socket->Close();
+        SocketSubsystem->DestroySocket(Subscriber.Socket);
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("%d subscribers received %d frames (%d for the slowest), %.1f KB/s per subscriber"), Count,
+           TotalFrames, MinFrames, TotalBytes / 1024.0 / Duration / Count);
+    UE_LOG(LogCubeProject, Display, TEXT("Slowest subscriber %u ticks behind the fastest, %d failed"), (MaxTick >= MinTick) ? MaxTick - MinTick : 0,
+           NumFailed);
+
+    return (NumFailed > 0) ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BroadcastSubscribersCommandlet.generated.h"
+
+/**
+ * Connects many spectators to a broadcast relay (see UBroadcastRelayCommandlet) and decodes every stream, to check the
+ * fan-out under load. Each subscriber must start at a keyframe, decode every frame and see the ticks increase. Reports
+ * the frames and bytes received by the subscribers, and how far the slowest subscriber is behind the fastest.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=BroadcastSubscribers [-relay=<address:port>] [-count=<subscribers>] [-duration=<seconds>]
+ *
+ * Returns 0 if every stream decoded correctly, 1 if a stream was malformed or a subscriber was disconnected, and 2 if the
+ * relay can't be reached.
+ */
+UCLASS()
+class UBroadcastSubscribersCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UBroadcastSubscribersCommandlet();
+
+    // Runs the subscribers
+    virtual int32 Main(const FString& Params) override;
+};
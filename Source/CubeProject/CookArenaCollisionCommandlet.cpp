@@ -0,0 +1,534 @@
+#include "CubeProject.h"
+#include "CookArenaCollisionCommandlet.h"
+#include "CubeArenaGeometry.h"
+#include "Goal.h"
+#include "PhysicsEngine/BodySetup.h"
+
+namespace
+{
+    /** The number of spheres and of points per sphere used to outline the slice of a capsule which crosses the plane. */
+    constexpr int32 OBLIQUE_CAPSULE_SPHERES = 16;
+    constexpr int32 OBLIQUE_CAPSULE_POINTS = 16;
+    /** The longest random sweep of the benchmark. A ball at its highest speed moves a few times less during a tick. */
+    constexpr float BENCH_MAX_SWEEP = 200.0f;
+    /** The largest difference between the times of the cooked and physics sweeps for them to agree. */
+    constexpr float BENCH_TIME_TOLERANCE = 0.02f;
+
+    /** Returns the cross product of OA and OB: positive if O, A and B turn counterclockwise. */
+    float Cross(const FVector2D& O, const FVector2D& A, const FVector2D& B)
+    {
+        return (A.X - O.X) * (B.Y - O.Y) - (A.Y - O.Y) * (B.X - O.X);
+    }
+
+    /** Adds the outline of the convex hull of the given points to a set of primitives. */
+    void AddConvexHull(TArray<FCubeArenaPrimitive>& Primitives, TArray<FVector2D>& Points)
+    {
+        Points.Sort([](const FVector2D& A, const FVector2D& B) { return A.X < B.X || (A.X == B.X && A.Y < B.Y); });
+
+        // Andrew's monotone chain: the lower hull left to right, then the upper hull right to left
+        TArray<FVector2D> Hull;
+
+        for(int32 Pass = 0; Pass < 2; Pass++)
+        {
+            const int32 LowerSize = Hull.Num();
+
+            for(int32 Index = 0; Index < Points.Num(); Index++)
+            {
+                const FVector2D& Point = Points[Pass == 0 ? Index : Points.Num() - 1 - Index];
+
+                while(Hull.Num() >= LowerSize + 2 && Cross(Hull[Hull.Num() - 2], Hull.Last(), Point) <= 0.0f)
+                {
+                    Hull.Pop(false);
+                }
+
+                Hull.Add(Point);
+            }
+
+            // The last point of each half is the first point of the other
+            Hull.Pop(false);
+        }
+
+        if(Hull.Num() == 2)
+        {
+            FCubeArenaGeometry::AddSegment(Primitives, Hull[0], Hull[1]);
+        }
+        else if(Hull.Num() > 2)
+        {
+            for(int32 Index = 0; Index < Hull.Num(); Index++)
+            {
+                FCubeArenaGeometry::AddSegment(Primitives, Hull[Index], Hull[(Index + 1) % Hull.Num()]);
+            }
+        }
+    }
+
+    /** Adds the outline of the slice of a convex solid, given by its vertices, to a set of primitives. The slice is the
+      * convex hull of the points where the segments between the vertices cross the plane. */
+    void AddConvexSlice(TArray<FCubeArenaPrimitive>& Primitives, const TArray<FVector>& Vertices, float PlaneX)
+    {
+        TArray<FVector2D> Points;
+
+        for(int32 First = 0; First < Vertices.Num(); First++)
+        {
+            const float FirstSide = Vertices[First].X - PlaneX;
+
+            if(FirstSide == 0.0f)
+            {
+                Points.Add(CubeSim::ToPlane(Vertices[First]));
+                continue;
+            }
+
+            for(int32 Second = First + 1; Second < Vertices.Num(); Second++)
+            {
+                const float SecondSide = Vertices[Second].X - PlaneX;
+
+                if(SecondSide != 0.0f && (FirstSide < 0.0f) != (SecondSide < 0.0f))
+                {
+                    const float Alpha = FirstSide / (FirstSide - SecondSide);
+                    Points.Add(CubeSim::ToPlane(FMath::Lerp(Vertices[First], Vertices[Second], Alpha)));
+                }
+            }
+        }
+
+        AddConvexHull(Primitives, Points);
+    }
+
+    /** Adds the slice of a sphere to a set of primitives. */
+    void AddSphereSlice(TArray<FCubeArenaPrimitive>& Primitives, const FVector& Center, float Radius, float PlaneX)
+    {
+        const float Distance = FMath::Abs(Center.X - PlaneX);
+
+        if(Distance < Radius)
+        {
+            FCubeArenaGeometry::AddArc(Primitives, CubeSim::ToPlane(Center), FMath::Sqrt(Radius * Radius - Distance * Distance), FVector2D(1.0f, 0.0f), PI);
+        }
+    }
+
+    /** Adds the slice of a capsule, given by the ends of its axis, to a set of primitives. A capsule parallel to the plane
+      * leaves two segments joined by half circles. Other capsules leave an ellipse-like outline, approximated. */
+    void AddCapsuleSlice(TArray<FCubeArenaPrimitive>& Primitives, const FVector& Start, const FVector& End, float Radius, float PlaneX)
+    {
+        if(FMath::IsNearlyEqual(Start.X, End.X, KINDA_SMALL_NUMBER))
+        {
+            const float Distance = FMath::Abs(Start.X - PlaneX);
+
+            if(Distance >= Radius)
+                return;
+
+            const float SliceRadius = FMath::Sqrt(Radius * Radius - Distance * Distance);
+            const FVector2D PlaneStart = CubeSim::ToPlane(Start);
+            const FVector2D PlaneEnd = CubeSim::ToPlane(End);
+            const FVector2D Axis = (PlaneEnd - PlaneStart).GetSafeNormal();
+
+            if(Axis.IsZero())
+            {
+                FCubeArenaGeometry::AddArc(Primitives, PlaneStart, SliceRadius, FVector2D(1.0f, 0.0f), PI);
+                return;
+            }
+
+            const FVector2D Side = FVector2D(-Axis.Y, Axis.X) * SliceRadius;
+            FCubeArenaGeometry::AddSegment(Primitives, PlaneStart + Side, PlaneEnd + Side);
+            FCubeArenaGeometry::AddSegment(Primitives, PlaneStart - Side, PlaneEnd - Side);
+            FCubeArenaGeometry::AddArc(Primitives, PlaneEnd, SliceRadius, Axis, HALF_PI);
+            FCubeArenaGeometry::AddArc(Primitives, PlaneStart, SliceRadius, -Axis, HALF_PI);
+            return;
+        }
+
+        // Outline the union of the slices of spheres spread along the axis
+        TArray<FVector2D> Points;
+
+        for(int32 Sphere = 0; Sphere < OBLIQUE_CAPSULE_SPHERES; Sphere++)
+        {
+            const FVector Center = FMath::Lerp(Start, End, (float)Sphere / (OBLIQUE_CAPSULE_SPHERES - 1));
+            const float Distance = FMath::Abs(Center.X - PlaneX);
+
+            if(Distance >= Radius)
+                continue;
+
+            const float SliceRadius = FMath::Sqrt(Radius * Radius - Distance * Distance);
+
+            for(int32 Point = 0; Point < OBLIQUE_CAPSULE_POINTS; Point++)
+            {
+                const float Angle = 2.0f * PI * Point / OBLIQUE_CAPSULE_POINTS;
+                Points.Add(CubeSim::ToPlane(Center) + FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * SliceRadius);
+            }
+        }
+
+        AddConvexHull(Primitives, Points);
+    }
+
+    /** Adds the slice of a component's simple collision to a set of primitives. Returns false if the component only has
+      * complex collision, which is not sliced. */
+    bool AddComponentSlice(TArray<FCubeArenaPrimitive>& Primitives, const UPrimitiveComponent* Component, UBodySetup* BodySetup, float PlaneX)
+    {
+        if(BodySetup->CollisionTraceFlag == CTF_UseComplexAsSimple)
+            return false;
+
+        const FTransform& ComponentToWorld = Component->ComponentToWorld;
+        const float RadiusScale = ComponentToWorld.GetScale3D().GetAbsMin();
+        const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+
+        for(const FKSphereElem& Sphere : AggGeom.SphereElems)
+        {
+            AddSphereSlice(Primitives, ComponentToWorld.TransformPosition(Sphere.Center), Sphere.Radius * RadiusScale, PlaneX);
+        }
+
+        for(const FKSphylElem& Capsule : AggGeom.SphylElems)
+        {
+            const FTransform CapsuleToWorld = Capsule.GetTransform() * ComponentToWorld;
+            const FVector HalfAxis(0.0f, 0.0f, Capsule.Length * 0.5f);
+
+            AddCapsuleSlice(Primitives, CapsuleToWorld.TransformPosition(-HalfAxis), CapsuleToWorld.TransformPosition(HalfAxis),
+                            Capsule.Radius * RadiusScale, PlaneX);
+        }
+
+        TArray<FVector> Vertices;
+
+        for(const FKBoxElem& Box : AggGeom.BoxElems)
+        {
+            const FTransform BoxToWorld = Box.GetTransform() * ComponentToWorld;
+            const FVector HalfExtent(Box.X * 0.5f, Box.Y * 0.5f, Box.Z * 0.5f);
+            Vertices.Reset();
+
+            for(int32 Corner = 0; Corner < 8; Corner++)
+            {
+                const FVector Sign((Corner & 1) ? 1.0f : -1.0f, (Corner & 2) ? 1.0f : -1.0f, (Corner & 4) ? 1.0f : -1.0f);
+                Vertices.Add(BoxToWorld.TransformPosition(HalfExtent * Sign));
+            }
+
+            AddConvexSlice(Primitives, Vertices, PlaneX);
+        }
+
+        for(const FKConvexElem& Convex : AggGeom.ConvexElems)
+        {
+            const FTransform ConvexToWorld = Convex.GetTransform() * ComponentToWorld;
+            Vertices.Reset();
+
+            for(const FVector& Vertex : Convex.VertexData)
+            {
+                Vertices.Add(ConvexToWorld.TransformPosition(Vertex));
+            }
+
+            AddConvexSlice(Primitives, Vertices, PlaneX);
+        }
+
+        return true;
+    }
+
+    /** Loads a map for its collision, without playing it. Returns NULL if the map could not be loaded. */
+    UWorld* LoadWorld(const FString& MapName)
+    {
+        UPackage* Package = LoadPackage(NULL, *(TEXT("/Game/Maps/") + MapName), LOAD_None);
+        UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : NULL;
+
+        if(!World)
+            return NULL;
+
+        World->WorldType = EWorldType::Editor;
+        World->AddToRoot();
+
+        if(!World->bIsWorldInitialized)
+        {
+            UWorld::InitializationValues InitializationValues;
+            InitializationValues.RequiresHitProxies(false)
+                                .ShouldSimulatePhysics(false)
+                                .EnableTraceCollision(true)
+                                .CreateNavigation(false)
+                                .CreateAISystem(false)
+                                .AllowAudioPlayback(false)
+                                .CreatePhysicsScene(true);
+
+            World->InitWorld(InitializationValues);
+        }
+
+        World->PersistentLevel->UpdateModelComponents();
+        World->UpdateWorldComponents(true, false);
+        return World;
+    }
+
+    /** Releases a map loaded by LoadWorld(). */
+    void UnloadWorld(UWorld* World)
+    {
+        World->DestroyWorld(false);
+        World->RemoveFromRoot();
+        CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+    }
+
+    /** Finds the goal lines, goal mouths, floor and ceiling of a map, like ACubeProjectGameMode::BuildSimConfig(). */
+    FCubeSimArena FindArena(UWorld* World, float PlaneX)
+    {
+        FCubeSimArena Arena;
+        AGoal* Goals[FCubePlayerRegistry::TEAM_COUNT] = { NULL, NULL };
+
+        for(TActorIterator<AGoal> GoalIterator(World); GoalIterator; ++GoalIterator)
+        {
+            Goals[GoalIterator->IsRightHandSideGoal() ? 1 : 0] = *GoalIterator;
+        }
+
+        if(Goals[0] && Goals[1])
+        {
+            Arena.LeftGoalLineY = Goals[0]->GetActorLocation().Y;
+            Arena.RightGoalLineY = Goals[1]->GetActorLocation().Y;
+            Arena.GoalCenterZ = (Goals[0]->GetActorLocation().Z + Goals[1]->GetActorLocation().Z) * 0.5f;
+            Arena.GoalHalfHeight = FMath::Min(Goals[0]->GetMouthHalfHeight(), Goals[1]->GetMouthHalfHeight());
+        }
+        else
+        {
+            UE_LOG(LogCubeProject, Warning, TEXT("  The map does not have two goals: keeping the default goal lines"));
+        }
+
+        const FCollisionQueryParams QueryParams(TEXT("CookArenaCollision"), false);
+        const FVector Center(PlaneX, 0.0f, 0.0f);
+        FHitResult Hit;
+
+        if(World->LineTraceSingleByChannel(Hit, Center, Center - FVector(0.0f, 0.0f, HALF_WORLD_MAX), ECC_WorldStatic, QueryParams))
+        {
+            Arena.FloorZ = Hit.Location.Z;
+        }
+
+        if(World->LineTraceSingleByChannel(Hit, Center, Center + FVector(0.0f, 0.0f, HALF_WORLD_MAX), ECC_WorldStatic, QueryParams))
+        {
+            Arena.CeilingZ = Hit.Location.Z;
+        }
+
+        return Arena;
+    }
+
+    /** Runs random ball sweeps against the cooked walls and against the physics scene, and reports both rates and how
+      * often they agree. */
+    void RunBenchmark(UWorld* World, const FCubeArenaGeometry& Geometry, int32 NumQueries)
+    {
+        const FCubeSimArena& Arena = Geometry.GetArena();
+        const float Radius = FCubeSimConfig().BallRadius;
+        FCubeRandomStream Stream(0, ECubeRandomStream::Tools);
+
+        // Draw the sweeps first, from starts clear of the walls as a ball's would be
+        TArray<FVector2D> Starts;
+        TArray<FVector2D> Deltas;
+        Starts.Reserve(NumQueries);
+        Deltas.Reserve(NumQueries);
+
+        while(Starts.Num() < NumQueries)
+        {
+            const FVector2D Start(Stream.GetRange(Arena.LeftGoalLineY, Arena.RightGoalLineY), Stream.GetRange(Arena.FloorZ, Arena.CeilingZ));
+            FCubeArenaContact Contact;
+
+            if(Geometry.OverlapCircle(Start, Radius, Contact))
+                continue;
+
+            const float Angle = Stream.GetRange(0.0f, 2.0f * PI);
+            Starts.Add(Start);
+            Deltas.Add(FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * Stream.GetRange(0.0f, BENCH_MAX_SWEEP));
+        }
+
+        TArray<float> CookedTimes;
+        CookedTimes.SetNumUninitialized(NumQueries);
+        double StartTime = FPlatformTime::Seconds();
+
+        for(int32 Query = 0; Query < NumQueries; Query++)
+        {
+            FCubeArenaHit Hit;
+            CookedTimes[Query] = Geometry.SweepCircle(Starts[Query], Deltas[Query], Radius, Hit) ? Hit.Time : 1.0f;
+        }
+
+        const double CookedSeconds = FPlatformTime::Seconds() - StartTime;
+
+        TArray<float> PhysicsTimes;
+        PhysicsTimes.SetNumUninitialized(NumQueries);
+        const FCollisionQueryParams QueryParams(TEXT("CookArenaCollisionBench"), false);
+        const FCollisionShape Sphere = FCollisionShape::MakeSphere(Radius);
+        const float PlaneX = Geometry.GetPlaneX();
+        StartTime = FPlatformTime::Seconds();
+
+        for(int32 Query = 0; Query < NumQueries; Query++)
+        {
+            FHitResult Hit;
+            const bool bHit = World->SweepSingleByChannel(Hit, CubeSim::ToWorld(Starts[Query], PlaneX), CubeSim::ToWorld(Starts[Query] + Deltas[Query], PlaneX),
+                                                          FQuat::Identity, ECC_WorldStatic, Sphere, QueryParams);
+            PhysicsTimes[Query] = bHit ? Hit.Time : 1.0f;
+        }
+
+        const double PhysicsSeconds = FPlatformTime::Seconds() - StartTime;
+        int32 NumAgreements = 0;
+
+        for(int32 Query = 0; Query < NumQueries; Query++)
+        {
+            if(FMath::Abs(CookedTimes[Query] - PhysicsTimes[Query]) <= BENCH_TIME_TOLERANCE)
+            {
+                NumAgreements++;
+            }
+        }
+
+        UE_LOG(LogCubeProject, Display, TEXT("  %d sweeps: %.0f per second on the cooked walls, %.0f per second on the physics scene (%.1fx), %.2f%% agree"),
+               NumQueries, NumQueries / FMath::Max(CookedSeconds, 1.e-9), NumQueries / FMath::Max(PhysicsSeconds, 1.e-9),
+               PhysicsSeconds / FMath::Max(CookedSeconds, 1.e-9), 100.0 * NumAgreements / NumQueries);
+    }
+
+    /** Returns every Test_* map, the arenas of the game. */
+    TArray<FString> FindArenaMaps()
+    {
+        TArray<FString> MapNames;
+        IFileManager::Get().FindFiles(MapNames, *(FPaths::GameContentDir() / TEXT("Maps/Test_*.umap")), true, false);
+
+        for(FString& MapName : MapNames)
+        {
+            MapName = FPaths::GetBaseFilename(MapName);
+        }
+
+        MapNames.Sort();
+        return MapNames;
+    }
+
+    /** Cooks the walls of a map, and benchmarks them if NumBenchQueries is positive. Returns false if the map could not be
+      * loaded or its walls could not be written. */
+    bool CookMap(const FString& MapName, bool bPlaneOverridden, float PlaneOverride, int32 NumBenchQueries)
+    {
+        UWorld* World = LoadWorld(MapName);
+
+        if(!World)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("%s: the map could not be loaded"), *MapName);
+            return false;
+        }
+
+        // The game is played in the plane of the player starts
+        float PlaneX = PlaneOverride;
+
+        if(!bPlaneOverridden)
+        {
+            int32 NumPlayerStarts = 0;
+            PlaneX = 0.0f;
+
+            for(TActorIterator<APlayerStart> PlayerStartIterator(World); PlayerStartIterator; ++PlayerStartIterator)
+            {
+                PlaneX += PlayerStartIterator->GetActorLocation().X;
+                NumPlayerStarts++;
+            }
+
+            PlaneX = (NumPlayerStarts > 0) ? PlaneX / NumPlayerStarts : 0.0f;
+        }
+
+        // Slice the static components which block the ball. Goals only overlap, and moving components aren't walls.
+        TArray<FCubeArenaPrimitive> Primitives;
+        TArray<UPrimitiveComponent*> Components;
+        int32 NumComponents = 0;
+
+        for(TActorIterator<AActor> ActorIterator(World); ActorIterator; ++ActorIterator)
+        {
+            ActorIterator->GetComponents(Components);
+
+            for(UPrimitiveComponent* Component : Components)
+            {
+                UBodySetup* BodySetup = Component->GetBodySetup();
+
+                if(!BodySetup || !Component->IsCollisionEnabled() || Component->Mobility == EComponentMobility::Movable ||
+                   Component->GetCollisionResponseToChannel(ECC_WorldStatic) != ECR_Block)
+                    continue;
+
+                if(!AddComponentSlice(Primitives, Component, BodySetup, PlaneX))
+                {
+                    UE_LOG(LogCubeProject, Warning, TEXT("  %s only has complex collision and was left out"), *Component->GetPathName());
+                    continue;
+                }
+
+                NumComponents++;
+            }
+        }
+
+        FCubeArenaGeometry Geometry;
+        Geometry.Build(Primitives, FindArena(World, PlaneX), PlaneX);
+
+        const FString FileName = FCubeArenaGeometry::GetFileName(MapName);
+        const bool bSaved = Geometry.SaveToFile(FileName);
+
+        if(!bSaved)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("%s: %s could not be written"), *MapName, *FileName);
+        }
+        else
+        {
+            UE_LOG(LogCubeProject, Display, TEXT("%s: %d components sliced at X = %.1f into %d primitives and %d nodes (%lld bytes)"), *MapName,
+                   NumComponents, PlaneX, Geometry.NumPrimitives(), Geometry.NumNodes(), IFileManager::Get().FileSize(*FileName));
+        }
+
+        if(NumBenchQueries > 0)
+        {
+            RunBenchmark(World, Geometry, NumBenchQueries);
+        }
+
+        UnloadWorld(World);
+        return bSaved;
+    }
+}
+
+UCookArenaCollisionCommandlet::UCookArenaCollisionCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UCookArenaCollisionCommandlet::Main(const FString& Params)
+{
+    FString MapList;
+    float PlaneOverride = 0.0f;
+    int32 NumBenchQueries = 0;
+
+    FParse::Value(*Params, TEXT("maps="), MapList);
+    const bool bPlaneOverridden = FParse::Value(*Params, TEXT("plane="), PlaneOverride);
+    FParse::Value(*Params, TEXT("bench="), NumBenchQueries);
+
+    TArray<FString> MapNames;
+
+    if(MapList.IsEmpty())
+    {
+        MapNames = FindArenaMaps();
+    }
+    else
+    {
+        MapList.ParseIntoArray(MapNames, TEXT("+"), true);
+    }
+
+    if(MapNames.Num() == 0 || NumBenchQueries < 0)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=CookArenaCollision [-maps=<map>+<map>...] [-plane=<x>] [-bench=<count>]"));
+        return 2;
+    }
+
+    int32 NumFailures = 0;
+
+    for(const FString& MapName : MapNames)
+    {
+        if(!CookMap(MapName, bPlaneOverridden, PlaneOverride, NumBenchQueries))
+        {
+            NumFailures++;
+        }
+    }
+
+    return (NumFailures > 0) ? 1 : 0;
+}
+
+void UCookArenaCollisionCommandlet::CookForPackaging(TArray<FString>& ExtraPackagesToCook)
+{
+    // The walls are staged as loose files, so no package is added to the cook
+    const TArray<FString> MapNames = FindArenaMaps();
+    FString FailedMaps;
+
+    for(const FString& MapName : MapNames)
+    {
+        if(!CookMap(MapName, false, 0.0f, 0) || !IFileManager::Get().FileExists(*FCubeArenaGeometry::GetFileName(MapName)))
+        {
+            FailedMaps += FailedMaps.IsEmpty() ? MapName : TEXT(", ") + MapName;
+        }
+    }
+
+    // Without its file, an arena would silently be simulated as a box by the packaged game
+    if(MapNames.Num() == 0)
+    {
+        UE_LOG(LogCubeProject, Fatal, TEXT("No Test_* map was found to cook the arena collision of. Packaging stopped."));
+    }
+    else if(!FailedMaps.IsEmpty())
+    {
+        UE_LOG(LogCubeProject, Fatal, TEXT("The arena collision of %s could not be cooked. Packaging stopped."), *FailedMaps);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "CookArenaCollisionCommandlet.generated.h"
+
+/**
+ * Cooks the collision of the arenas for the match simulation (see FCubeArenaGeometry). Each map is loaded without being
+ * played, and the simple collision of every static component which blocks the ball is sliced by the plane of the game:
+ * spheres and capsules give arcs, boxes and convex elements give the outline of their slice. The goal lines come from the
+ * goals, and the floor and ceiling from traces, as in ACubeProjectGameMode::BuildSimConfig(). The walls are written to
+ * Content/ArenaCollision/<Map>.gsag, which is staged with the game. Packaging runs the cook of every map through
+ * CookForPackaging(), and fails if one of the files could not be written.
+ *
+ * With -bench=<count>, the given number of random ball sweeps are also run against the cooked walls and against the
+ * physics scene, and the rate of each and how often they agree are reported.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=CookArenaCollision [-maps=<map>+<map>...] [-plane=<x>] [-bench=<count>]
+ *
+ * Maps default to every Test_* map. The plane defaults to the average X of the map's player starts.
+ *
+ * Returns 0 if every map was cooked, 1 if one could not be loaded or written and 2 on invalid arguments.
+ */
+UCLASS()
+class UCookArenaCollisionCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UCookArenaCollisionCommandlet();
+
+    // Cooks the maps
+    virtual int32 Main(const FString& Params) override;
+
+    /** Bound to the engine's cook (FGameDelegates::GetCookModificationDelegate()), so that packaging cooks the collision of
+      * every map before the files are staged. Stops the cook with a fatal error if the file of a map is missing. */
+    static void CookForPackaging(TArray<FString>& ExtraPackagesToCook);
+};
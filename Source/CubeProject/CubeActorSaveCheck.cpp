@@ -0,0 +1,194 @@
+#include "CubeProject.h"
+#include "CubeActorSaveCheck.h"
+#include "CubeProjectGameMode.h"
+#include "CubeProjectGameState.h"
+#include "CubeMatchSave.h"
+#include "CubeBot.h"
+
+FCubeActorSaveCheck* FCubeActorSaveCheck::Instance = NULL;
+
+void FCubeActorSaveCheck::Start()
+{
+    if(!Instance)
+    {
+        Instance = new FCubeActorSaveCheck();
+    }
+}
+
+void FCubeActorSaveCheck::Stop()
+{
+    delete Instance;
+    Instance = NULL;
+}
+
+FCubeActorSaveCheck::FCubeActorSaveCheck()
+    : MaxRounds(32)
+    , NumTicks(300)
+    , NumRounds(0)
+    , NumFailures(0)
+    , FramesToNextCheck(1)
+{
+    uint64 Seed = 0;
+    FParse::Value(FCommandLine::Get(), TEXT("SaveCheckRounds="), MaxRounds);
+    FParse::Value(FCommandLine::Get(), TEXT("SaveCheckTicks="), NumTicks);
+    FParse::Value(FCommandLine::Get(), TEXT("seed="), Seed);
+
+    MaxRounds = FMath::Max(MaxRounds, 1);
+    NumTicks = FMath::Max(NumTicks, 1);
+    Stream = FCubeRandomStream(Seed, ECubeRandomStream::Tools);
+    FramesToNextCheck = 1 + (int32)(Stream.GetUnsignedInt() % MAX_FRAMES_BETWEEN_CHECKS);
+    UninterruptedHashes.Reserve(NumTicks);
+
+    // Simulate every frame with the same step, so that the bots play the same matches on every run
+    FApp::SetUseFixedTimeStep(true);
+    FApp::SetFixedDeltaTime(FIXED_DELTA_TIME);
+
+    UE_LOG(LogCubeProject, Display, TEXT("Actor save check: %d round trips of %d ticks"), MaxRounds, NumTicks);
+}
+
+void FCubeActorSaveCheck::OnGameModeBeginPlay(ACubeProjectGameMode* InGameMode)
+{
+    GameMode = InGameMode;
+
+    // Outside the determinism mode, PhysX moves the actors and a resumed match can't play on identically
+    if(!InGameMode->IsDeterministic())
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Actor save check: the game must be started with -deterministic"));
+        NumFailures++;
+        Finish();
+        return;
+    }
+
+    for(int32 Slot = 0; Slot < InGameMode->GetPlayerRegistry().Num(); Slot++)
+    {
+        InGameMode->SetBot(Slot, MakeShareable(new FCubeScriptedBot()));
+    }
+}
+
+bool FCubeActorSaveCheck::Tick(float DeltaTime)
+{
+    ACubeProjectGameMode* CurrentGameMode = GameMode.Get();
+
+    // Wait for the level to be loaded
+    if(!CurrentGameMode)
+        return true;
+
+    ACubeProjectGameState* GameState = CurrentGameMode->GetGameState<ACubeProjectGameState>();
+
+    if(!GameState)
+        return true;
+
+    switch(GameState->GetState())
+    {
+        case EGameState::GAME_BOOT:
+        {
+            break;
+        }
+        case EGameState::MAIN_MENU:
+        {
+            // Start the match as if the user pressed the start key in the main menu
+            CurrentGameMode->StartGame();
+            break;
+        }
+        case EGameState::WAITING_TO_RESTART:
+        {
+            CurrentGameMode->RestartGame();
+            break;
+        }
+        default:
+        {
+            // Every other state can be saved, including the countdowns between goals
+            if(--FramesToNextCheck > 0)
+                break;
+
+            FramesToNextCheck = 1 + (int32)(Stream.GetUnsignedInt() % MAX_FRAMES_BETWEEN_CHECKS);
+            NumRounds++;
+
+            if(!CheckRoundTrip(CurrentGameMode, GameState))
+            {
+                NumFailures++;
+            }
+
+            if(NumRounds >= MaxRounds)
+            {
+                Finish();
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool FCubeActorSaveCheck::CheckRoundTrip(ACubeProjectGameMode* CurrentGameMode, ACubeProjectGameState* GameState)
+{
+    FCubeMatchSaveRecord Record;
+
+    if(!CurrentGameMode->SaveMatchState(Record))
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Actor save check: round %d could not save the match"), NumRounds);
+        return false;
+    }
+
+    CubeMatchSave::Write(Record, SavedData);
+    const uint32 SaveTick = Record.Tick;
+
+    // Play the match ahead without interruption. The pawns keep the inputs the bots gave them last.
+    UninterruptedHashes.Reset();
+
+    for(int32 Tick = 0; Tick < NumTicks; Tick++)
+    {
+        GameState->StepSimulation();
+        UninterruptedHashes.Add(CurrentGameMode->GetLastStateHash());
+    }
+
+    // Resume the save from its bytes, as if it had been read from a file
+    FCubeMatchSaveRecord ReadRecord;
+
+    if(!CubeMatchSave::Read(SavedData.GetData(), SavedData.Num(), ReadRecord) || !CurrentGameMode->ResumeMatchState(ReadRecord))
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Actor save check: round %d could not resume the save of tick %u"), NumRounds, SaveTick);
+        return false;
+    }
+
+    // Saving the resumed actors must give back the same bytes
+    CurrentGameMode->SaveMatchState(Record);
+    CubeMatchSave::Write(Record, ResumedData);
+
+    if(ResumedData != SavedData)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Actor save check: round %d, the resumed match saves differently at tick %u"), NumRounds, SaveTick);
+        return false;
+    }
+
+    // Play the resumed match ahead, and compare its state to the uninterrupted run at every tick. The match's desync trace
+    // records the fields of both runs, which tells which one diverged.
+    for(int32 Tick = 0; Tick < NumTicks; Tick++)
+    {
+        GameState->StepSimulation();
+
+        if(CurrentGameMode->GetLastStateHash() != UninterruptedHashes[Tick])
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("Actor save check: round %d, saved at tick %u: desync at tick %u (%016llx, %016llx uninterrupted)"),
+                   NumRounds, SaveTick, SaveTick + Tick + 1, CurrentGameMode->GetLastStateHash(), UninterruptedHashes[Tick]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FCubeActorSaveCheck::Finish()
+{
+    if(NumFailures > 0)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Actor save check: FAILED %d of %d round trips"), NumFailures, NumRounds);
+    }
+    else
+    {
+        UE_LOG(LogCubeProject, Display, TEXT("Actor save check: PASSED %d round trips of %d ticks"), NumRounds, NumTicks);
+    }
+
+    GameMode = NULL;
+    CubeTestRun::RequestExit(NumFailures > 0);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Ticker.h"
+#include "CubeDeterminism.h"
+
+class ACubeProjectGameMode;
+class ACubeProjectGameState;
+
+/**
+ * Checks that the actors of a match resume bit-identically from a save, which -run=MatchSaveCheck can't: the commandlet
+ * round-trips the match simulation, whereas this check goes through ACubeProjectGameMode::SaveMatchState() and
+ * ResumeMatchState(), and so through the SaveState() and RestoreState() of ABall and ACubePawn.
+ *
+ * Enabled with -ActorSaveCheck in the determinism mode, it lets scripted bots play matches with a fixed time step. Every
+ * few frames, the match is saved to bytes and played ahead synchronously for a number of simulation ticks with the bots'
+ * last inputs held: this is the uninterrupted run. The save is then read back and resumed, which must save the same bytes
+ * again, and the match is played ahead once more; the hash of its gameplay state must match the uninterrupted run's after
+ * every tick. The match then carries on from there with the bots, so the next check starts from another state.
+ *
+ * Typical usage, headless on a build machine:
+ *   CubeProject -deterministic -ActorSaveCheck -nullrhi -unattended [-SaveCheckRounds=<count>] [-SaveCheckTicks=<count>]
+ *               [-seed=<seed>]
+ *
+ * Every failure is written to the log as an error, and the game exits once every round has been checked, with a failing
+ * status if any round failed.
+ */
+class CUBEPROJECT_API FCubeActorSaveCheck : public FTickerObjectBase
+{
+public:
+    /** The fixed time step of the simulated frames, in seconds. */
+    static constexpr float FIXED_DELTA_TIME = 1.0f / 60.0f;
+    /** The largest number of frames played by the bots between two checks. */
+    static constexpr int32 MAX_FRAMES_BETWEEN_CHECKS = 120;
+
+    /** Creates the check. Called at startup when -ActorSaveCheck is on the command line. */
+    static void Start();
+    /** Destroys the check. */
+    static void Stop();
+    /** Returns the running check, or NULL if the game was not started with -ActorSaveCheck. */
+    static FCubeActorSaveCheck* Get() { return Instance; }
+
+    /** Called by the game mode once every player has been created. Hands every slot to a bot. */
+    void OnGameModeBeginPlay(ACubeProjectGameMode* GameMode);
+
+    // FTickerObjectBase interface
+    virtual bool Tick(float DeltaTime) override;
+
+private:
+    FCubeActorSaveCheck();
+
+    /** Saves the match, plays it ahead, resumes the save and plays it ahead again. Returns false if the resumed match
+      * diverged from the uninterrupted run. */
+    bool CheckRoundTrip(ACubeProjectGameMode* CurrentGameMode, ACubeProjectGameState* GameState);
+
+    /** Reports the result and exits the game. */
+    void Finish();
+
+    /** The game mode of the current level. */
+    TWeakObjectPtr<ACubeProjectGameMode> GameMode;
+
+    /** The number of round trips to check, and the number of simulation ticks played ahead by each. */
+    int32 MaxRounds;
+    int32 NumTicks;
+
+    /** The number of round trips checked so far, and how many of them failed. */
+    int32 NumRounds;
+    int32 NumFailures;
+    /** The number of frames the bots play before the next check. */
+    int32 FramesToNextCheck;
+
+    /** Draws the number of frames between the checks. */
+    FCubeRandomStream Stream;
+
+    /** The state hashes of the uninterrupted run. */
+    TArray<uint64> UninterruptedHashes;
+    /** The bytes of the save, and of the resumed match saved again. */
+    TArray<uint8> SavedData;
+    TArray<uint8> ResumedData;
+
+    /** The running check. */
+    static FCubeActorSaveCheck* Instance;
+};
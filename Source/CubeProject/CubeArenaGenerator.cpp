@@ -0,0 +1,304 @@
+#include "CubeProject.h"
+#include "CubeArenaGenerator.h"
+#include "CubeArenaGeometry.h"
+#include "CubeStrictFloat.h"
+
+namespace
+{
+    /** The smallest playable field. */
+    const float MIN_HALF_LENGTH = 200.0f;
+    const float MIN_HALF_HEIGHT = 100.0f;
+    const float MIN_GOAL_HALF_HEIGHT = 30.0f;
+    /** The most obstacles an arena can have. */
+    const int32 MAX_OBSTACLES = 64;
+    /** The room left between an obstacle and the walls or other obstacles, enough for a pawn to pass. */
+    const float OBSTACLE_GAP = 100.0f;
+    /** The room kept clear of obstacles around the kickoff spot, the start locations and in front of the goals. */
+    const float KICKOFF_CLEARANCE = 150.0f;
+    const float START_CLEARANCE = 80.0f;
+    const float GOAL_CLEARANCE = 150.0f;
+    /** The most places tried for each pair of scattered obstacles. */
+    const int32 MAX_PLACEMENT_ATTEMPTS = 64;
+
+    FORCEINLINE float DistanceSquared(const FVector2D& A, const FVector2D& B)
+    {
+        return (A.X - B.X) * (A.X - B.X) + (A.Y - B.Y) * (A.Y - B.Y);
+    }
+
+    /** Adds a box to a set, unless it is empty. */
+    void AddBox(TArray<FCubeArenaBox>& Boxes, const FVector2D& Center, const FVector2D& Axis, const FVector2D& HalfSize)
+    {
+        if(HalfSize.X <= 0.0f || HalfSize.Y <= 0.0f)
+            return;
+
+        FCubeArenaBox& Box = Boxes[Boxes.AddUninitialized()];
+        Box.Center = Center;
+        Box.Axis = Axis;
+        Box.HalfSize = HalfSize;
+    }
+
+    /** Adds the boxes of a rounded corner, from the wall in the first direction to the wall in the second. Each box is
+      * tangent to the corner's circle in its middle, so the boxes outline the circle from outside. */
+    void AddCorner(TArray<FCubeArenaBox>& Walls, const FVector2D& Center, float Radius, const FVector2D& FirstDirection, const FVector2D& LastDirection)
+    {
+        using namespace CubeArenaGenerator;
+
+        // Split the quarter circle by repeated bisection, which only takes sums and square roots
+        FVector2D Directions[CORNER_PIECES + 1];
+        Directions[0] = FirstDirection;
+        Directions[CORNER_PIECES] = LastDirection;
+
+        for(int32 Step = CORNER_PIECES / 2; Step > 0; Step /= 2)
+        {
+            for(int32 Index = Step; Index < CORNER_PIECES; Index += 2 * Step)
+            {
+                Directions[Index] = CubeSim::SafeNormal(Directions[Index - Step] + Directions[Index + Step]);
+            }
+        }
+
+        for(int32 Piece = 0; Piece < CORNER_PIECES; Piece++)
+        {
+            const FVector2D Sum = Directions[Piece] + Directions[Piece + 1];
+            const FVector2D Middle = CubeSim::SafeNormal(Sum);
+
+            // The tangent of half the angle of the piece. The outer side of the box spans the piece at the outer radius.
+            const float HalfAngleTangent = CubeSim::Size(Directions[Piece] - Directions[Piece + 1]) / CubeSim::Size(Sum);
+
+            AddBox(Walls, Center + Middle * (Radius + WALL_THICKNESS * 0.5f), FVector2D(-Middle.Y, Middle.X),
+                   FVector2D((Radius + WALL_THICKNESS) * HalfAngleTangent, WALL_THICKNESS * 0.5f));
+        }
+    }
+
+    /** Returns true if an obstacle reaching the given distance from its center can stand at a place in the left half. */
+    bool CanPlaceObstacle(const FCubeGeneratedArena& Arena, const FVector2D& Center, float Reach)
+    {
+        if(DistanceSquared(Center, FVector2D::ZeroVector) < FMath::Square(KICKOFF_CLEARANCE + Reach))
+            return false;
+
+        // Obstacles are mirrored, so they must keep clear of the start locations of both teams
+        const FVector2D Mirrored(-Center.X, Center.Y);
+
+        for(int32 Slot = 0; Slot < Arena.NumPlayers; Slot++)
+        {
+            if(DistanceSquared(Center, Arena.StartLocations[Slot]) < FMath::Square(START_CLEARANCE + Reach) ||
+               DistanceSquared(Mirrored, Arena.StartLocations[Slot]) < FMath::Square(START_CLEARANCE + Reach))
+                return false;
+        }
+
+        for(const FCubeArenaBox& Obstacle : Arena.Obstacles)
+        {
+            if(DistanceSquared(Center, Obstacle.Center) < FMath::Square(2.0f * Reach + OBSTACLE_GAP))
+                return false;
+        }
+
+        return true;
+    }
+
+    /** Places an obstacle and its mirror image. */
+    void AddObstaclePair(FCubeGeneratedArena& Arena, const FVector2D& Center, const FVector2D& Axis, float HalfSize)
+    {
+        AddBox(Arena.Obstacles, Center, Axis, FVector2D(HalfSize, HalfSize));
+        AddBox(Arena.Obstacles, FVector2D(-Center.X, Center.Y), FVector2D(-Axis.X, Axis.Y), FVector2D(HalfSize, HalfSize));
+    }
+}
+
+void CubeArenaGenerator::ParseParams(const TCHAR* CommandLine, FCubeArenaParams& InOutParams)
+{
+    float Length;
+
+    if(FParse::Value(CommandLine, TEXT("ArenaLength="), Length))
+    {
+        InOutParams.HalfLength = Length * 0.5f;
+    }
+
+    if(FParse::Value(CommandLine, TEXT("ArenaHeight="), Length))
+    {
+        InOutParams.HalfHeight = Length * 0.5f;
+    }
+
+    if(FParse::Value(CommandLine, TEXT("GoalHeight="), Length))
+    {
+        InOutParams.GoalHalfHeight = Length * 0.5f;
+    }
+
+    if(FParse::Value(CommandLine, TEXT("ObstacleSize="), Length))
+    {
+        InOutParams.ObstacleHalfSize = Length * 0.5f;
+    }
+
+    FParse::Value(CommandLine, TEXT("CornerRadius="), InOutParams.CornerRadius);
+    FParse::Value(CommandLine, TEXT("Obstacles="), InOutParams.NumObstacles);
+    FParse::Value(CommandLine, TEXT("ArenaSeed="), InOutParams.Seed);
+
+    FString Layout;
+
+    if(FParse::Value(CommandLine, TEXT("ObstacleLayout="), Layout))
+    {
+        InOutParams.ObstacleLayout = (Layout == TEXT("Grid")) ? ECubeObstacleLayout::Grid
+                                   : (Layout == TEXT("Scattered")) ? ECubeObstacleLayout::Scattered : ECubeObstacleLayout::None;
+    }
+
+    // Asking for obstacles without a layout scatters them
+    if(InOutParams.NumObstacles > 0 && InOutParams.ObstacleLayout == ECubeObstacleLayout::None && Layout.IsEmpty())
+    {
+        InOutParams.ObstacleLayout = ECubeObstacleLayout::Scattered;
+    }
+}
+
+void CubeArenaGenerator::Generate(const FCubeArenaParams& Params, FCubeGeneratedArena& OutArena)
+{
+    const float HalfLength = FMath::Max(Params.HalfLength, MIN_HALF_LENGTH);
+    const float HalfHeight = FMath::Max(Params.HalfHeight, MIN_HALF_HEIGHT);
+    const float GoalHalfHeight = FMath::Clamp(Params.GoalHalfHeight, MIN_GOAL_HALF_HEIGHT, HalfHeight);
+    const float CornerRadius = FMath::Clamp(Params.CornerRadius, 0.0f, FMath::Min(HalfLength, HalfHeight - GoalHalfHeight));
+    const float HalfThickness = WALL_THICKNESS * 0.5f;
+
+    FCubeSimArena& Arena = OutArena.Arena;
+    Arena.LeftGoalLineY = -HalfLength;
+    Arena.RightGoalLineY = HalfLength;
+    Arena.FloorZ = -HalfHeight;
+    Arena.CeilingZ = HalfHeight;
+    Arena.GoalCenterZ = 0.0f;
+    Arena.GoalHalfHeight = GoalHalfHeight;
+
+    OutArena.NumPlayers = FMath::Clamp(Params.NumPlayers, 1, FCubePlayerRegistry::MAX_PLAYERS);
+    CubeSim::GetDefaultStartLocations(Arena, OutArena.NumPlayers, OutArena.StartLocations);
+
+    // The floor and ceiling reach the corners, or cover the ends of the side walls if the corners are square
+    TArray<FCubeArenaBox>& Walls = OutArena.Walls;
+    Walls.Reset(6 + 6 + 4 * CORNER_PIECES);
+
+    const float StraightHalfLength = (CornerRadius > 0.0f) ? HalfLength - CornerRadius : HalfLength + WALL_THICKNESS;
+    const FVector2D Horizontal(1.0f, 0.0f);
+
+    AddBox(Walls, FVector2D(0.0f, -HalfHeight - HalfThickness), Horizontal, FVector2D(StraightHalfLength, HalfThickness));
+    AddBox(Walls, FVector2D(0.0f, HalfHeight + HalfThickness), Horizontal, FVector2D(StraightHalfLength, HalfThickness));
+
+    const float SideWallEnd = HalfHeight - CornerRadius;
+
+    for(int32 Team = 0; Team < FCubePlayerRegistry::TEAM_COUNT; Team++)
+    {
+        const float Side = (Team == 0) ? -1.0f : 1.0f;
+
+        // The goal line, below and above the goal mouth
+        const float SideWallHalfLength = (SideWallEnd - GoalHalfHeight) * 0.5f;
+        const float SideWallCenter = (SideWallEnd + GoalHalfHeight) * 0.5f;
+
+        AddBox(Walls, FVector2D(Side * (HalfLength + HalfThickness), -SideWallCenter), Horizontal, FVector2D(HalfThickness, SideWallHalfLength));
+        AddBox(Walls, FVector2D(Side * (HalfLength + HalfThickness), SideWallCenter), Horizontal, FVector2D(HalfThickness, SideWallHalfLength));
+
+        // The goal pocket: its back, floor and ceiling
+        const float PocketHalfDepth = GOAL_DEPTH * 0.5f;
+
+        AddBox(Walls, FVector2D(Side * (HalfLength + GOAL_DEPTH + HalfThickness), 0.0f), Horizontal,
+               FVector2D(HalfThickness, GoalHalfHeight + WALL_THICKNESS));
+        AddBox(Walls, FVector2D(Side * (HalfLength + PocketHalfDepth), -GoalHalfHeight - HalfThickness), Horizontal,
+               FVector2D(PocketHalfDepth, HalfThickness));
+        AddBox(Walls, FVector2D(Side * (HalfLength + PocketHalfDepth), GoalHalfHeight + HalfThickness), Horizontal,
+               FVector2D(PocketHalfDepth, HalfThickness));
+
+        if(CornerRadius > 0.0f)
+        {
+            const FVector2D Outward(Side, 0.0f);
+            AddCorner(Walls, FVector2D(Side * (HalfLength - CornerRadius), -SideWallEnd), CornerRadius, FVector2D(0.0f, -1.0f), Outward);
+            AddCorner(Walls, FVector2D(Side * (HalfLength - CornerRadius), SideWallEnd), CornerRadius, FVector2D(0.0f, 1.0f), Outward);
+        }
+    }
+
+    // Lay the obstacles out in the left half, between the goal area and the center line, and mirror them
+    TArray<FCubeArenaBox>& Obstacles = OutArena.Obstacles;
+    const int32 NumPairs = FMath::Clamp(Params.NumObstacles, 0, MAX_OBSTACLES) / 2;
+    Obstacles.Reset(2 * NumPairs);
+
+    const float HalfSize = FMath::Max(Params.ObstacleHalfSize, 1.0f);
+    // A square pillar reaches at most its half-diagonal from its center, whatever its angle
+    const float Reach = HalfSize * FMath::Sqrt(2.0f);
+    const float MinX = Arena.LeftGoalLineY + GOAL_CLEARANCE + Reach;
+    const float MaxX = -Reach - OBSTACLE_GAP * 0.5f;
+    const float MinZ = Arena.FloorZ + Reach + OBSTACLE_GAP;
+    const float MaxZ = Arena.CeilingZ - Reach - OBSTACLE_GAP;
+
+    if(NumPairs == 0 || MinX > MaxX || MinZ > MaxZ)
+        return;
+
+    if(Params.ObstacleLayout == ECubeObstacleLayout::Grid)
+    {
+        int32 NumColumns = 1;
+
+        while(NumColumns * NumColumns < NumPairs)
+        {
+            NumColumns++;
+        }
+
+        const int32 NumRows = (NumPairs + NumColumns - 1) / NumColumns;
+
+        for(int32 Pair = 0; Pair < NumPairs; Pair++)
+        {
+            const int32 Column = Pair % NumColumns;
+            const int32 Row = Pair / NumColumns;
+            const FVector2D Center(MinX + (MaxX - MinX) * (Column + 0.5f) / NumColumns, MinZ + (MaxZ - MinZ) * (Row + 0.5f) / NumRows);
+
+            if(CanPlaceObstacle(OutArena, Center, Reach))
+            {
+                AddObstaclePair(OutArena, Center, Horizontal, HalfSize);
+            }
+        }
+    }
+    else if(Params.ObstacleLayout == ECubeObstacleLayout::Scattered)
+    {
+        FCubeRandomStream Stream(Params.Seed, ECubeRandomStream::Arena);
+
+        for(int32 Pair = 0; Pair < NumPairs; Pair++)
+        {
+            for(int32 Attempt = 0; Attempt < MAX_PLACEMENT_ATTEMPTS; Attempt++)
+            {
+                const FVector2D Center(Stream.GetRange(MinX, MaxX), Stream.GetRange(MinZ, MaxZ));
+                const FVector2D Axis = CubeSim::SafeNormal(FVector2D(Stream.GetRange(-1.0f, 1.0f), Stream.GetRange(-1.0f, 1.0f)));
+
+                if(CanPlaceObstacle(OutArena, Center, Reach))
+                {
+                    AddObstaclePair(OutArena, Center, (Axis.X != 0.0f || Axis.Y != 0.0f) ? Axis : Horizontal, HalfSize);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void CubeArenaGenerator::GetCorners(const FCubeArenaBox& Box, FVector2D OutCorners[4])
+{
+    const FVector2D Along(Box.Axis.X * Box.HalfSize.X, Box.Axis.Y * Box.HalfSize.X);
+    const FVector2D Across(-Box.Axis.Y * Box.HalfSize.Y, Box.Axis.X * Box.HalfSize.Y);
+
+    OutCorners[0] = Box.Center - Along - Across;
+    OutCorners[1] = Box.Center + Along - Across;
+    OutCorners[2] = Box.Center + Along + Across;
+    OutCorners[3] = Box.Center - Along + Across;
+}
+
+void CubeArenaGenerator::AddCollision(const FCubeGeneratedArena& Arena, TArray<FCubeArenaPrimitive>& Primitives)
+{
+    FVector2D Corners[4];
+
+    for(int32 Set = 0; Set < 2; Set++)
+    {
+        for(const FCubeArenaBox& Box : (Set == 0) ? Arena.Walls : Arena.Obstacles)
+        {
+            GetCorners(Box, Corners);
+
+            for(int32 Corner = 0; Corner < 4; Corner++)
+            {
+                FCubeArenaGeometry::AddSegment(Primitives, Corners[Corner], Corners[(Corner + 1) % 4]);
+            }
+        }
+    }
+}
+
+void CubeArenaGenerator::BuildGeometry(const FCubeGeneratedArena& Arena, FCubeArenaGeometry& OutGeometry)
+{
+    TArray<FCubeArenaPrimitive> Primitives;
+    Primitives.Reserve(4 * (Arena.Walls.Num() + Arena.Obstacles.Num()));
+    AddCollision(Arena, Primitives);
+
+    OutGeometry.Build(Primitives, Arena.Arena, 0.0f);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CubeMatchSim.h"
+#include "CubeArenaGeometryFormat.h"
+
+/** How the obstacles of a generated arena are laid out. Each layout is mirrored across the center line, so that both
+  * teams play the same field. */
+namespace ECubeObstacleLayout
+{
+    enum Type
+    {
+        /** No obstacles. */
+        None,
+        /** A regular grid of upright pillars in each half. */
+        Grid,
+        /** Pillars at random places and angles. */
+        Scattered,
+
+        Count
+    };
+}
+
+/** The parameters of a generated arena. Sizes are in world units, in the plane of the game. */
+struct FCubeArenaParams
+{
+    /** The distance from the center to each goal line, and from the center to the floor and ceiling. */
+    float HalfLength = 800.0f;
+    float HalfHeight = 250.0f;
+    /** The half-height of the goal mouths. */
+    float GoalHalfHeight = 100.0f;
+    /** The radius of the four corners of the field. Zero for square corners. */
+    float CornerRadius = 0.0f;
+    ECubeObstacleLayout::Type ObstacleLayout = ECubeObstacleLayout::None;
+    /** The number of obstacles, rounded down to an even number by the mirroring. */
+    int32 NumObstacles = 0;
+    /** The half-size of the square pillars. */
+    float ObstacleHalfSize = 40.0f;
+    /** The number of players, whose start locations are kept clear of obstacles. */
+    int32 NumPlayers = 2;
+    /** The seed of the obstacles' layout. */
+    uint64 Seed = 0;
+};
+
+/** A box in the plane of the game, extruded along X when spawned. */
+struct FCubeArenaBox
+{
+    FVector2D Center;
+    /** The unit direction of the box's first side. The second side is perpendicular to it. */
+    FVector2D Axis;
+    /** Half the length of each side. */
+    FVector2D HalfSize;
+};
+
+/** A generated arena, in plain data: enough for the match simulation on its own, and for AGeneratedArena to spawn it. */
+struct FCubeGeneratedArena
+{
+    FCubeSimArena Arena;
+    /** The walls around the field: floor, ceiling, goal lines, goal pockets and corners. */
+    TArray<FCubeArenaBox> Walls;
+    TArray<FCubeArenaBox> Obstacles;
+    int32 NumPlayers;
+    FVector2D StartLocations[FCubePlayerRegistry::MAX_PLAYERS];
+};
+
+/**
+ * Builds arenas from a few parameters, so that training and balancing can play many arena variants without authoring
+ * or cooking maps. Every wall and obstacle is a box: the simulation collides with the exact outlines that the physics
+ * scene collides with once AGeneratedArena spawns them, and rounded corners are made of short boxes. Generation only
+ * uses +, -, *, / and sqrt, so a seed gives the same arena on every machine, and takes a few microseconds.
+ */
+namespace CubeArenaGenerator
+{
+    /** The thickness of the walls. */
+    static constexpr float WALL_THICKNESS = 50.0f;
+    /** How far the goal pockets reach behind the goal lines. */
+    static constexpr float GOAL_DEPTH = 120.0f;
+    /** The number of boxes making up a rounded corner. A power of two, as their directions are found by bisection. */
+    static constexpr int32 CORNER_PIECES = 8;
+
+    /** Reads the parameters given on a command line (-ArenaSeed=, -ArenaLength=, -ArenaHeight=, -GoalHeight=,
+      * -CornerRadius=, -Obstacles=, -ObstacleSize=, -ObstacleLayout=None|Grid|Scattered). Lengths are full lengths.
+      * Parameters which are not given keep their value. */
+    CUBEPROJECT_API void ParseParams(const TCHAR* CommandLine, FCubeArenaParams& InOutParams);
+
+    /** Generates an arena. Parameters out of range are clamped to the nearest playable value. */
+    CUBEPROJECT_API void Generate(const FCubeArenaParams& Params, FCubeGeneratedArena& OutArena);
+
+    /** Returns the corners of a box, counterclockwise. */
+    CUBEPROJECT_API void GetCorners(const FCubeArenaBox& Box, FVector2D OutCorners[4]);
+
+    /** Adds the outlines of the walls and obstacles of an arena to a set of primitives. */
+    CUBEPROJECT_API void AddCollision(const FCubeGeneratedArena& Arena, TArray<FCubeArenaPrimitive>& Primitives);
+
+    /** Builds the collision of an arena for the match simulation. */
+    CUBEPROJECT_API void BuildGeometry(const FCubeGeneratedArena& Arena, class FCubeArenaGeometry& OutGeometry);
+}
@@ -0,0 +1,632 @@
+#include "CubeProject.h"
+#include "CubeArenaGeometry.h"
+#include "CubeStrictFloat.h"
+
+namespace
+{
+    /** Circles closer than this to a wall are pushed along the wall's normal rather than away from the closest point. */
+    const float MIN_CONTACT_DISTANCE = 1.e-4f;
+    /** A swept circle closer than this to a wall is in contact with it. The distance to a wall is found differently by the
+      * contact and sweep tests, so a circle just touching a wall could otherwise slip past both by a rounding error. */
+    const float CONTACT_SKIN = 0.01f;
+
+    FORCEINLINE float Dot(const FVector2D& A, const FVector2D& B) { return A.X * B.X + A.Y * B.Y; }
+    FORCEINLINE FVector2D Perpendicular(const FVector2D& Vector) { return FVector2D(-Vector.Y, Vector.X); }
+    FORCEINLINE FVector2D GetA(const FCubeArenaPrimitive& Primitive) { return FVector2D(Primitive.AY, Primitive.AZ); }
+    FORCEINLINE FVector2D GetB(const FCubeArenaPrimitive& Primitive) { return FVector2D(Primitive.BY, Primitive.BZ); }
+
+    /** Returns the ends of an arc. */
+    void GetArcEnds(const FCubeArenaPrimitive& Arc, FVector2D& OutFirst, FVector2D& OutSecond)
+    {
+        const FVector2D Center = GetA(Arc);
+        const FVector2D Middle = GetB(Arc);
+        const FVector2D Side = Perpendicular(Middle);
+        const FVector2D Along = Middle * (Arc.CosHalfAngle * Arc.Radius);
+        const FVector2D Across = Side * (Arc.SinHalfAngle * Arc.Radius);
+
+        OutFirst = Center + Along + Across;
+        OutSecond = Center + Along - Across;
+    }
+
+    /** Returns true if the direction from the center of an arc lies within the arc. */
+    FORCEINLINE bool IsWithinArc(const FCubeArenaPrimitive& Arc, const FVector2D& Direction)
+    {
+        return Dot(Direction, GetB(Arc)) >= Arc.CosHalfAngle;
+    }
+
+    /** Returns the point of a primitive closest to the given point, and the wall's normal to use if the point lies on it. */
+    FVector2D GetClosestPoint(const FCubeArenaPrimitive& Primitive, const FVector2D& Point, FVector2D& OutFallbackNormal)
+    {
+        const FVector2D A = GetA(Primitive);
+
+        if(Primitive.Type == ECubeArenaPrimitive::Segment)
+        {
+            const FVector2D Edge = GetB(Primitive) - A;
+            const float EdgeSizeSquared = Dot(Edge, Edge);
+            const float Time = (EdgeSizeSquared > 0.0f) ? FMath::Clamp(Dot(Point - A, Edge) / EdgeSizeSquared, 0.0f, 1.0f) : 0.0f;
+
+            OutFallbackNormal = CubeSim::SafeNormal(Perpendicular(Edge));
+            return A + Edge * Time;
+        }
+
+        const FVector2D Offset = Point - A;
+        const float Distance = CubeSim::Size(Offset);
+        const FVector2D Direction = (Distance > MIN_CONTACT_DISTANCE) ? Offset / Distance : GetB(Primitive);
+
+        OutFallbackNormal = Direction;
+
+        if(IsWithinArc(Primitive, Direction))
+            return A + Direction * Primitive.Radius;
+
+        FVector2D First;
+        FVector2D Second;
+        GetArcEnds(Primitive, First, Second);
+
+        const FVector2D ToFirst = Point - First;
+        const FVector2D ToSecond = Point - Second;
+        return (Dot(ToFirst, ToFirst) <= Dot(ToSecond, ToSecond)) ? First : Second;
+    }
+
+    /** Returns true if a circle overlaps a primitive, with the contact. */
+    bool OverlapPrimitive(const FCubeArenaPrimitive& Primitive, const FVector2D& Center, float Radius, FVector2D& OutNormal, float& OutDepth)
+    {
+        FVector2D FallbackNormal;
+        const FVector2D Closest = GetClosestPoint(Primitive, Center, FallbackNormal);
+        const FVector2D Offset = Center - Closest;
+        const float DistanceSquared = Dot(Offset, Offset);
+
+        if(DistanceSquared >= Radius * Radius)
+            return false;
+
+        const float Distance = FMath::Sqrt(DistanceSquared);
+        OutNormal = (Distance > MIN_CONTACT_DISTANCE) ? Offset / Distance : FallbackNormal;
+        OutDepth = Radius - Distance;
+        return true;
+    }
+
+    /** Returns the first time in [0, MaxTime) at which a moving point enters a circle from outside, or MaxTime. */
+    float EnterCircle(const FVector2D& Start, const FVector2D& Delta, const FVector2D& Center, float Radius, float MaxTime)
+    {
+        const FVector2D Offset = Start - Center;
+        const float A = Dot(Delta, Delta);
+        const float B = Dot(Offset, Delta);
+        const float C = Dot(Offset, Offset) - Radius * Radius;
+
+        // Starting inside, or moving away
+        if(C < 0.0f || B >= 0.0f || A <= 0.0f)
+            return MaxTime;
+
+        const float Discriminant = B * B - A * C;
+
+        if(Discriminant < 0.0f)
+            return MaxTime;
+
+        const float Time = (-B - FMath::Sqrt(Discriminant)) / A;
+        return (Time >= 0.0f && Time < MaxTime) ? Time : MaxTime;
+    }
+
+    /** Returns the time in [0, MaxTime) at which a moving point leaves a circle, whether it starts inside it or passes
+      * through it, or MaxTime. */
+    float LeaveCircle(const FVector2D& Start, const FVector2D& Delta, const FVector2D& Center, float Radius, float MaxTime)
+    {
+        const FVector2D Offset = Start - Center;
+        const float A = Dot(Delta, Delta);
+        const float B = Dot(Offset, Delta);
+        const float C = Dot(Offset, Offset) - Radius * Radius;
+        const float Discriminant = B * B - A * C;
+
+        if(Discriminant < 0.0f || A <= 0.0f)
+            return MaxTime;
+
+        const float Time = (-B + FMath::Sqrt(Discriminant)) / A;
+        return (Time >= 0.0f && Time < MaxTime) ? Time : MaxTime;
+    }
+
+    /** Sweeps a circle which does not overlap the primitive against it. Returns true if it hits it before MaxTime, and
+      * lowers MaxTime to the time of the hit. */
+    bool SweepPrimitive(const FCubeArenaPrimitive& Primitive, const FVector2D& Start, const FVector2D& Delta, float Radius, float& InOutTime,
+                        FVector2D& OutNormal)
+    {
+        const FVector2D A = GetA(Primitive);
+        float Time = InOutTime;
+        FVector2D Normal = FVector2D::ZeroVector;
+
+        // The circle touches a primitive when its center touches the primitive inflated by the radius: the ends of a
+        // primitive inflate to circles, and its body to two parallel segments or two concentric arcs
+        FVector2D Ends[2];
+
+        if(Primitive.Type == ECubeArenaPrimitive::Segment)
+        {
+            const FVector2D B = GetB(Primitive);
+            const FVector2D Edge = B - A;
+            const float EdgeSize = CubeSim::Size(Edge);
+
+            Ends[0] = A;
+            Ends[1] = B;
+
+            if(EdgeSize > 0.0f)
+            {
+                const FVector2D EdgeDirection = Edge / EdgeSize;
+                FVector2D Side = Perpendicular(EdgeDirection);
+                float StartDistance = Dot(Start - A, Side);
+                float Approach = Dot(Delta, Side);
+
+                // Face the side the circle starts on
+                if(StartDistance < 0.0f)
+                {
+                    Side = -Side;
+                    StartDistance = -StartDistance;
+                    Approach = -Approach;
+                }
+
+                if(Approach < 0.0f)
+                {
+                    const float FaceTime = (Radius - StartDistance) / Approach;
+
+                    if(FaceTime >= 0.0f && FaceTime < Time)
+                    {
+                        const float Along = Dot(Start + Delta * FaceTime - A, EdgeDirection);
+
+                        if(Along >= 0.0f && Along <= EdgeSize)
+                        {
+                            Time = FaceTime;
+                            Normal = Side;
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            GetArcEnds(Primitive, Ends[0], Ends[1]);
+
+            // The circle touches the outer side of the arc as it enters the arc's circle, and the inner side as it leaves it
+            const float OuterTime = EnterCircle(Start, Delta, A, Primitive.Radius + Radius, Time);
+
+            if(OuterTime < Time)
+            {
+                const FVector2D Direction = CubeSim::SafeNormal(Start + Delta * OuterTime - A);
+
+                if(IsWithinArc(Primitive, Direction))
+                {
+                    Time = OuterTime;
+                    Normal = Direction;
+                }
+            }
+
+            if(Primitive.Radius > Radius)
+            {
+                const float InnerTime = LeaveCircle(Start, Delta, A, Primitive.Radius - Radius, Time);
+
+                if(InnerTime < Time)
+                {
+                    const FVector2D Direction = CubeSim::SafeNormal(Start + Delta * InnerTime - A);
+
+                    if(IsWithinArc(Primitive, Direction))
+                    {
+                        Time = InnerTime;
+                        Normal = -Direction;
+                    }
+                }
+            }
+        }
+
+        for(const FVector2D& End : Ends)
+        {
+            const float EndTime = EnterCircle(Start, Delta, End, Radius, Time);
+
+            if(EndTime < Time)
+            {
+                Time = EndTime;
+                Normal = CubeSim::SafeNormal(Start + Delta * EndTime - End);
+            }
+        }
+
+        if(Time >= InOutTime)
+            return false;
+
+        InOutTime = Time;
+        OutNormal = Normal;
+        return true;
+    }
+
+    /** Returns true if the boxes overlap. */
+    FORCEINLINE bool Overlaps(const FCubeArenaBvhNode& Node, const FVector2D& Min, const FVector2D& Max)
+    {
+        return Node.MinY <= Max.X && Node.MaxY >= Min.X && Node.MinZ <= Max.Y && Node.MaxZ >= Min.Y;
+    }
+
+    /** Returns true if a segment enters the node's box, inflated by the given radius, before MaxTime. The inverse of the
+      * delta is infinite on an axis along which the segment does not move. */
+    bool IntersectsNode(const FCubeArenaBvhNode& Node, const FVector2D& Start, const FVector2D& InverseDelta, float Radius, float MaxTime)
+    {
+        float EnterTime = 0.0f;
+        float ExitTime = MaxTime;
+        const float Starts[2] = { Start.X, Start.Y };
+        const float InverseDeltas[2] = { InverseDelta.X, InverseDelta.Y };
+        const float Mins[2] = { Node.MinY - Radius, Node.MinZ - Radius };
+        const float Maxs[2] = { Node.MaxY + Radius, Node.MaxZ + Radius };
+
+        for(int32 Axis = 0; Axis < 2; Axis++)
+        {
+            if(FMath::Abs(InverseDeltas[Axis]) >= BIG_NUMBER)
+            {
+                if(Starts[Axis] < Mins[Axis] || Starts[Axis] > Maxs[Axis])
+                    return false;
+
+                continue;
+            }
+
+            float Near = (Mins[Axis] - Starts[Axis]) * InverseDeltas[Axis];
+            float Far = (Maxs[Axis] - Starts[Axis]) * InverseDeltas[Axis];
+
+            if(Near > Far)
+            {
+                Swap(Near, Far);
+            }
+
+            EnterTime = FMath::Max(EnterTime, Near);
+            ExitTime = FMath::Min(ExitTime, Far);
+
+            if(EnterTime > ExitTime)
+                return false;
+        }
+
+        return true;
+    }
+}
+
+FCubeArenaGeometry::FCubeArenaGeometry()
+    : PlaneX(0.0f)
+{
+}
+
+void FCubeArenaGeometry::Build(const TArray<FCubeArenaPrimitive>& InPrimitives, const FCubeSimArena& InArena, float InPlaneX)
+{
+    Arena = InArena;
+    PlaneX = InPlaneX;
+    Primitives.Reset();
+    Nodes.Reset();
+
+    if(InPrimitives.Num() == 0)
+        return;
+
+    TArray<FBuildEntry> Entries;
+    Entries.SetNumUninitialized(InPrimitives.Num());
+
+    for(int32 Index = 0; Index < InPrimitives.Num(); Index++)
+    {
+        FBuildEntry& Entry = Entries[Index];
+        Entry.Primitive = InPrimitives[Index];
+        GetBounds(Entry.Primitive, Entry.Min, Entry.Max);
+        Entry.Centroid = (Entry.Min + Entry.Max) * 0.5f;
+    }
+
+    // A binary tree with leaves of at least half the maximum size has fewer than this many nodes
+    Nodes.Reserve(2 * FMath::DivideAndRoundUp(Entries.Num(), MAX_LEAF_PRIMITIVES / 2));
+    BuildNode(Entries, 0, Entries.Num());
+
+    Primitives.SetNumUninitialized(Entries.Num());
+
+    for(int32 Index = 0; Index < Entries.Num(); Index++)
+    {
+        Primitives[Index] = Entries[Index].Primitive;
+    }
+}
+
+int32 FCubeArenaGeometry::BuildNode(TArray<FBuildEntry>& Entries, int32 First, int32 Num)
+{
+    const int32 NodeIndex = Nodes.AddUninitialized();
+    FVector2D Min = Entries[First].Min;
+    FVector2D Max = Entries[First].Max;
+    FVector2D CentroidMin = Entries[First].Centroid;
+    FVector2D CentroidMax = Entries[First].Centroid;
+
+    for(int32 Index = First + 1; Index < First + Num; Index++)
+    {
+        Min = FVector2D(FMath::Min(Min.X, Entries[Index].Min.X), FMath::Min(Min.Y, Entries[Index].Min.Y));
+        Max = FVector2D(FMath::Max(Max.X, Entries[Index].Max.X), FMath::Max(Max.Y, Entries[Index].Max.Y));
+        CentroidMin = FVector2D(FMath::Min(CentroidMin.X, Entries[Index].Centroid.X), FMath::Min(CentroidMin.Y, Entries[Index].Centroid.Y));
+        CentroidMax = FVector2D(FMath::Max(CentroidMax.X, Entries[Index].Centroid.X), FMath::Max(CentroidMax.Y, Entries[Index].Centroid.Y));
+    }
+
+    FCubeArenaBvhNode Node;
+    Node.MinY = Min.X;
+    Node.MinZ = Min.Y;
+    Node.MaxY = Max.X;
+    Node.MaxZ = Max.Y;
+
+    if(Num <= MAX_LEAF_PRIMITIVES)
+    {
+        Node.Index = First;
+        Node.NumPrimitives = Num;
+        Nodes[NodeIndex] = Node;
+        return NodeIndex;
+    }
+
+    // Split the primitives at the median of their centroids along the longest axis of the centroids' bounds
+    const bool bSplitY = (CentroidMax.X - CentroidMin.X) >= (CentroidMax.Y - CentroidMin.Y);
+
+    Sort(Entries.GetData() + First, Num, [bSplitY](const FBuildEntry& A, const FBuildEntry& B)
+    {
+        return bSplitY ? A.Centroid.X < B.Centroid.X : A.Centroid.Y < B.Centroid.Y;
+    });
+
+    const int32 NumLeft = Num / 2;
+    BuildNode(Entries, First, NumLeft);
+
+    Node.Index = BuildNode(Entries, First + NumLeft, Num - NumLeft);
+    Node.NumPrimitives = 0;
+    Nodes[NodeIndex] = Node;
+    return NodeIndex;
+}
+
+void FCubeArenaGeometry::GetBounds(const FCubeArenaPrimitive& Primitive, FVector2D& OutMin, FVector2D& OutMax)
+{
+    const FVector2D A = GetA(Primitive);
+
+    if(Primitive.Type == ECubeArenaPrimitive::Segment)
+    {
+        const FVector2D B = GetB(Primitive);
+        OutMin = FVector2D(FMath::Min(A.X, B.X), FMath::Min(A.Y, B.Y));
+        OutMax = FVector2D(FMath::Max(A.X, B.X), FMath::Max(A.Y, B.Y));
+    }
+    else
+    {
+        // The bounds of the whole circle: arcs are few, and most are full circles
+        OutMin = A - FVector2D(Primitive.Radius, Primitive.Radius);
+        OutMax = A + FVector2D(Primitive.Radius, Primitive.Radius);
+    }
+}
+
+bool FCubeArenaGeometry::SweepCircle(const FVector2D& Start, const FVector2D& Delta, float Radius, FCubeArenaHit& OutHit) const
+{
+    if(Nodes.Num() == 0)
+        return false;
+
+    const FVector2D InverseDelta(Delta.X != 0.0f ? 1.0f / Delta.X : BIG_NUMBER, Delta.Y != 0.0f ? 1.0f / Delta.Y : BIG_NUMBER);
+
+    // The sweep ends at time 1, unless it hits a wall earlier. Nodes entered after the earliest hit so far are skipped.
+    float Time = 1.0f;
+    FVector2D Normal = FVector2D::ZeroVector;
+    int32 HitPrimitive = INDEX_NONE;
+
+    int32 Stack[MAX_DEPTH];
+    int32 StackSize = 0;
+    Stack[StackSize++] = 0;
+
+    while(StackSize > 0)
+    {
+        const int32 NodeIndex = Stack[--StackSize];
+        const FCubeArenaBvhNode& Node = Nodes[NodeIndex];
+
+        if(!IntersectsNode(Node, Start, InverseDelta, Radius, Time))
+            continue;
+
+        if(Node.NumPrimitives == 0)
+        {
+            Stack[StackSize++] = Node.Index;
+            Stack[StackSize++] = NodeIndex + 1;
+            continue;
+        }
+
+        for(int32 Index = Node.Index; Index < Node.Index + Node.NumPrimitives; Index++)
+        {
+            const FCubeArenaPrimitive& Primitive = Primitives[Index];
+            FVector2D ContactNormal;
+            float Depth;
+
+            // A circle touching a wall is stopped at once if it moves into it, and let out if it moves out of it
+            if(OverlapPrimitive(Primitive, Start, Radius + CONTACT_SKIN, ContactNormal, Depth))
+            {
+                if(Dot(Delta, ContactNormal) < 0.0f)
+                {
+                    OutHit.Time = 0.0f;
+                    OutHit.Normal = ContactNormal;
+                    OutHit.Primitive = Index;
+                    return true;
+                }
+
+                continue;
+            }
+
+            if(SweepPrimitive(Primitive, Start, Delta, Radius, Time, Normal))
+            {
+                HitPrimitive = Index;
+            }
+        }
+    }
+
+    if(HitPrimitive == INDEX_NONE)
+        return false;
+
+    OutHit.Time = Time;
+    OutHit.Normal = Normal;
+    OutHit.Primitive = HitPrimitive;
+    return true;
+}
+
+bool FCubeArenaGeometry::OverlapCircle(const FVector2D& Center, float Radius, FCubeArenaContact& OutContact) const
+{
+    if(Nodes.Num() == 0)
+        return false;
+
+    const FVector2D Min = Center - FVector2D(Radius, Radius);
+    const FVector2D Max = Center + FVector2D(Radius, Radius);
+    bool bOverlaps = false;
+
+    int32 Stack[MAX_DEPTH];
+    int32 StackSize = 0;
+    Stack[StackSize++] = 0;
+
+    while(StackSize > 0)
+    {
+        const int32 NodeIndex = Stack[--StackSize];
+        const FCubeArenaBvhNode& Node = Nodes[NodeIndex];
+
+        if(!Overlaps(Node, Min, Max))
+            continue;
+
+        if(Node.NumPrimitives == 0)
+        {
+            Stack[StackSize++] = Node.Index;
+            Stack[StackSize++] = NodeIndex + 1;
+            continue;
+        }
+
+        for(int32 Index = Node.Index; Index < Node.Index + Node.NumPrimitives; Index++)
+        {
+            FVector2D Normal;
+            float Depth;
+
+            if(OverlapPrimitive(Primitives[Index], Center, Radius, Normal, Depth) && (!bOverlaps || Depth > OutContact.Depth))
+            {
+                OutContact.Normal = Normal;
+                OutContact.Depth = Depth;
+                OutContact.Primitive = Index;
+                bOverlaps = true;
+            }
+        }
+    }
+
+    return bOverlaps;
+}
+
+FVector2D FCubeArenaGeometry::PushOut(FVector2D& Center, float Radius) const
+{
+    FVector2D NormalSum = FVector2D::ZeroVector;
+    FCubeArenaContact Contact;
+
+    for(int32 Iteration = 0; Iteration < MAX_PUSH_OUT_ITERATIONS && OverlapCircle(Center, Radius, Contact); Iteration++)
+    {
+        Center = Center + Contact.Normal * Contact.Depth;
+        NormalSum = NormalSum + Contact.Normal;
+    }
+
+    return NormalSum;
+}
+
+void FCubeArenaGeometry::AddSegment(TArray<FCubeArenaPrimitive>& Primitives, const FVector2D& Start, const FVector2D& End)
+{
+    FCubeArenaPrimitive& Primitive = Primitives[Primitives.AddZeroed()];
+    Primitive.AY = Start.X;
+    Primitive.AZ = Start.Y;
+    Primitive.BY = End.X;
+    Primitive.BZ = End.Y;
+    Primitive.Type = ECubeArenaPrimitive::Segment;
+}
+
+void FCubeArenaGeometry::AddArc(TArray<FCubeArenaPrimitive>& Primitives, const FVector2D& Center, float Radius, const FVector2D& MiddleDirection,
+                                float HalfAngle)
+{
+    const FVector2D Middle = CubeSim::SafeNormal(MiddleDirection);
+    const bool bFullCircle = HalfAngle >= PI;
+
+    FCubeArenaPrimitive& Primitive = Primitives[Primitives.AddZeroed()];
+    Primitive.AY = Center.X;
+    Primitive.AZ = Center.Y;
+    Primitive.BY = Middle.IsZero() ? 1.0f : Middle.X;
+    Primitive.BZ = Middle.IsZero() ? 0.0f : Middle.Y;
+    Primitive.Radius = Radius;
+    Primitive.CosHalfAngle = bFullCircle ? -1.0f : FMath::Cos(HalfAngle);
+    Primitive.SinHalfAngle = bFullCircle ? 0.0f : FMath::Sin(HalfAngle);
+    Primitive.Type = ECubeArenaPrimitive::Arc;
+}
+
+void FCubeArenaGeometry::AddBox(TArray<FCubeArenaPrimitive>& Primitives, const FCubeSimArena& Arena)
+{
+    const FVector2D BottomLeft(Arena.LeftGoalLineY, Arena.FloorZ);
+    const FVector2D BottomRight(Arena.RightGoalLineY, Arena.FloorZ);
+    const FVector2D TopRight(Arena.RightGoalLineY, Arena.CeilingZ);
+    const FVector2D TopLeft(Arena.LeftGoalLineY, Arena.CeilingZ);
+
+    AddSegment(Primitives, BottomLeft, BottomRight);
+    AddSegment(Primitives, BottomRight, TopRight);
+    AddSegment(Primitives, TopRight, TopLeft);
+    AddSegment(Primitives, TopLeft, BottomLeft);
+}
+
+bool FCubeArenaGeometry::SaveToFile(const FString& FileName) const
+{
+    TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*FileName));
+
+    if(!Writer)
+        return false;
+
+    FCubeArenaGeometryHeader Header;
+    FMemory::Memzero(Header);
+    Header.Magic = FCubeArenaGeometryHeader::MAGIC;
+    Header.Version = FCubeArenaGeometryHeader::VERSION;
+    Header.NumPrimitives = Primitives.Num();
+    Header.NumNodes = Nodes.Num();
+    Header.PlaneX = PlaneX;
+    Header.LeftGoalLineY = Arena.LeftGoalLineY;
+    Header.RightGoalLineY = Arena.RightGoalLineY;
+    Header.FloorZ = Arena.FloorZ;
+    Header.CeilingZ = Arena.CeilingZ;
+    Header.GoalCenterZ = Arena.GoalCenterZ;
+    Header.GoalHalfHeight = Arena.GoalHalfHeight;
+
+    Writer->Serialize(&Header, sizeof(Header));
+    Writer->Serialize((void*)Primitives.GetData(), Primitives.Num() * sizeof(FCubeArenaPrimitive));
+    Writer->Serialize((void*)Nodes.GetData(), Nodes.Num() * sizeof(FCubeArenaBvhNode));
+
+    return Writer->Close();
+}
+
+bool FCubeArenaGeometry::LoadFromFile(const FString& FileName)
+{
+    TArray<uint8> Data;
+
+    if(!FFileHelper::LoadFileToArray(Data, *FileName, FILEREAD_Silent) || Data.Num() < (int32)sizeof(FCubeArenaGeometryHeader))
+        return false;
+
+    FCubeArenaGeometryHeader Header;
+    FMemory::Memcpy(&Header, Data.GetData(), sizeof(Header));
+
+    const int64 ExpectedSize = sizeof(Header) + (int64)Header.NumPrimitives * sizeof(FCubeArenaPrimitive) + (int64)Header.NumNodes * sizeof(FCubeArenaBvhNode);
+
+    if(Header.Magic != FCubeArenaGeometryHeader::MAGIC || Header.Version != FCubeArenaGeometryHeader::VERSION || Data.Num() != ExpectedSize)
+        return false;
+
+    TArray<FCubeArenaPrimitive> NewPrimitives;
+    TArray<FCubeArenaBvhNode> NewNodes;
+    NewPrimitives.SetNumUninitialized(Header.NumPrimitives);
+    NewNodes.SetNumUninitialized(Header.NumNodes);
+    FMemory::Memcpy(NewPrimitives.GetData(), Data.GetData() + sizeof(Header), Header.NumPrimitives * sizeof(FCubeArenaPrimitive));
+    FMemory::Memcpy(NewNodes.GetData(), Data.GetData() + sizeof(Header) + Header.NumPrimitives * sizeof(FCubeArenaPrimitive),
+                    Header.NumNodes * sizeof(FCubeArenaBvhNode));
+
+    // Reject hierarchies a query could not traverse safely: children after their parent, leaves within the primitives
+    for(int32 NodeIndex = 0; NodeIndex < NewNodes.Num(); NodeIndex++)
+    {
+        const FCubeArenaBvhNode& Node = NewNodes[NodeIndex];
+        const bool bValidLeaf = Node.NumPrimitives > 0 && Node.Index >= 0 && Node.Index + Node.NumPrimitives <= NewPrimitives.Num();
+        const bool bValidInner = Node.NumPrimitives == 0 && NodeIndex + 1 < Node.Index && Node.Index < NewNodes.Num();
+
+        if(!bValidLeaf && !bValidInner)
+            return false;
+    }
+
+    for(const FCubeArenaPrimitive& Primitive : NewPrimitives)
+    {
+        if(Primitive.Type >= ECubeArenaPrimitive::Count)
+            return false;
+    }
+
+    Primitives = MoveTemp(NewPrimitives);
+    Nodes = MoveTemp(NewNodes);
+    PlaneX = Header.PlaneX;
+    Arena.LeftGoalLineY = Header.LeftGoalLineY;
+    Arena.RightGoalLineY = Header.RightGoalLineY;
+    Arena.FloorZ = Header.FloorZ;
+    Arena.CeilingZ = Header.CeilingZ;
+    Arena.GoalCenterZ = Header.GoalCenterZ;
+    Arena.GoalHalfHeight = Header.GoalHalfHeight;
+    return true;
+}
+
+FString FCubeArenaGeometry::GetFileName(const FString& MapName)
+{
+    return FPaths::GameContentDir() / TEXT("ArenaCollision") / (MapName + TEXT(".gsag"));
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "CubeArenaGeometryFormat.h"
+#include "CubeMatchSim.h"
+
+/** The first wall hit by a swept circle. */
+struct FCubeArenaHit
+{
+    /** The fraction of the sweep at which the circle touches the wall, in [0, 1]. */
+    float Time;
+    /** The normal of the wall at the point of contact, pointing towards the circle. */
+    FVector2D Normal;
+    /** The index of the primitive hit. */
+    int32 Primitive;
+};
+
+/** The deepest wall overlapped by a circle. */
+struct FCubeArenaContact
+{
+    /** The direction in which to move the circle out of the wall. */
+    FVector2D Normal;
+    /** How far to move the circle out of the wall. */
+    float Depth;
+    /** The index of the primitive overlapped. */
+    int32 Primitive;
+};
+
+/**
+ * The walls of an arena as a set of segments and arcs in the YZ plane of the game, cooked from the collision of the
+ * arena's level by UCookArenaCollisionCommandlet (see CubeArenaGeometryFormat.h). The primitives are indexed by a bounding
+ * volume hierarchy whose nodes and leaves are stored contiguously, so that a query only touches a few cache lines, and
+ * queries never allocate. Used instead of PhysX scene queries wherever the game needs the walls without a world: by the
+ * match simulation (see FCubeSimConfig::Geometry), hence the bots' predictions and the dedicated match server.
+ *
+ * Queries only use +, -, *, / and sqrt, so their results are bit-identical on every machine.
+ */
+class CUBEPROJECT_API FCubeArenaGeometry
+{
+public:
+    /** The most primitives stored in a leaf of the hierarchy. */
+    static constexpr int32 MAX_LEAF_PRIMITIVES = 4;
+    /** The deepest hierarchy a query can traverse. Median splits keep hierarchies far shallower. */
+    static constexpr int32 MAX_DEPTH = 64;
+    /** The most times PushOut() moves a circle out of a wall. */
+    static constexpr int32 MAX_PUSH_OUT_ITERATIONS = 4;
+
+    FCubeArenaGeometry();
+
+    /** Replaces the walls with the given primitives, and builds the hierarchy indexing them. */
+    void Build(const TArray<FCubeArenaPrimitive>& InPrimitives, const FCubeSimArena& InArena, float InPlaneX);
+
+    /** Writes the cooked walls to a file. Returns false if the file could not be written. */
+    bool SaveToFile(const FString& FileName) const;
+
+    /** Reads cooked walls from a file. Returns false if the file could not be read or is not valid. */
+    bool LoadFromFile(const FString& FileName);
+
+    /** Returns the file holding the cooked walls of the given map, in Content/ArenaCollision. */
+    static FString GetFileName(const FString& MapName);
+
+    /** Sweeps a circle along the given delta. Returns true if it hits a wall, with the first hit. A circle which already
+      * overlaps a wall hits it at time zero if it moves into it, and ignores it if it moves out of it. */
+    bool SweepCircle(const FVector2D& Start, const FVector2D& Delta, float Radius, FCubeArenaHit& OutHit) const;
+
+    /** Returns true if a circle overlaps a wall, with the deepest contact. */
+    bool OverlapCircle(const FVector2D& Center, float Radius, FCubeArenaContact& OutContact) const;
+
+    /** Moves a circle out of the walls it overlaps. Returns the sum of the normals of the walls, or zero if the circle
+      * overlapped none. */
+    FVector2D PushOut(FVector2D& Center, float Radius) const;
+
+    /** Adds a segment to a set of primitives. */
+    static void AddSegment(TArray<FCubeArenaPrimitive>& Primitives, const FVector2D& Start, const FVector2D& End);
+
+    /** Adds an arc to a set of primitives. The arc spans the given half-angle, in radians, on each side of its middle. */
+    static void AddArc(TArray<FCubeArenaPrimitive>& Primitives, const FVector2D& Center, float Radius, const FVector2D& MiddleDirection,
+                       float HalfAngle);
+
+    /** Adds the four walls of an arena's box to a set of primitives. */
+    static void AddBox(TArray<FCubeArenaPrimitive>& Primitives, const FCubeSimArena& Arena);
+
+    /** Returns the goal lines, floor, ceiling and goal mouths of the arena. */
+    FORCEINLINE const FCubeSimArena& GetArena() const { return Arena; }
+
+    /** Returns the X coordinate of the plane the walls were sliced by. */
+    FORCEINLINE float GetPlaneX() const { return PlaneX; }
+
+    FORCEINLINE int32 NumPrimitives() const { return Primitives.Num(); }
+    FORCEINLINE int32 NumNodes() const { return Nodes.Num(); }
+
+private:
+    /** A primitive and its bounds while the hierarchy is built. */
+    struct FBuildEntry
+    {
+        FCubeArenaPrimitive Primitive;
+        FVector2D Min;
+        FVector2D Max;
+        FVector2D Centroid;
+    };
+
+    /** Builds the node covering the given entries, and its children. Returns the node's index. */
+    int32 BuildNode(TArray<FBuildEntry>& Entries, int32 First, int32 Num);
+
+    /** Returns the bounds of a primitive. */
+    static void GetBounds(const FCubeArenaPrimitive& Primitive, FVector2D& OutMin, FVector2D& OutMax);
+
+    /** The walls, in the order of the leaves of the hierarchy. */
+    TArray<FCubeArenaPrimitive> Primitives;
+    /** The nodes of the hierarchy, depth-first. The root is the first node. */
+    TArray<FCubeArenaBvhNode> Nodes;
+
+    FCubeSimArena Arena;
+    float PlaneX;
+};
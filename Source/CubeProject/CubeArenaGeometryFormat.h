@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ * Layout of an arena's cooked collision (.gsag file), written by UCookArenaCollisionCommandlet and read by
+ * FCubeArenaGeometry. The walls of the arena are sliced by the plane of the game, which leaves a set of segments and arcs
+ * in the YZ plane. The primitives are stored in the order of the leaves of a bounding volume hierarchy, so that the
+ * primitives of a leaf are contiguous, and the nodes are stored depth-first: the left child of a node follows it.
+ *
+ *   FCubeArenaGeometryHeader
+ *   FCubeArenaPrimitive[NumPrimitives]
+ *   FCubeArenaBvhNode[NumNodes]
+ *
+ * The file is loaded with one read per array. All values are little-endian and the structures are written as-is,
+ * without padding.
+ */
+
+/** The types of FCubeArenaPrimitive. */
+namespace ECubeArenaPrimitive
+{
+    enum Type : uint8
+    {
+        /** A segment from A to B. Segments are two-sided. */
+        Segment,
+        /** The part of the circle of center A and the given radius whose directions from the center are within the
+          * half-angle of direction B. A full circle has a half-angle cosine of -1. */
+        Arc,
+
+        Count
+    };
+}
+
+#pragma pack(push, 1)
+
+/** A segment or arc of the arena's walls, in the YZ plane. */
+struct FCubeArenaPrimitive
+{
+    /** The start of a segment, or the center of an arc. */
+    float AY;
+    float AZ;
+    /** The end of a segment, or the unit direction of the middle of an arc. */
+    float BY;
+    float BZ;
+    /** The radius of an arc. Zero for a segment. */
+    float Radius;
+    /** The cosine and sine of the half-angle of an arc. */
+    float CosHalfAngle;
+    float SinHalfAngle;
+    /** The ECubeArenaPrimitive type. */
+    uint8 Type;
+    uint8 Padding[3];
+};
+
+/** A node of the bounding volume hierarchy. An inner node's left child is the next node, and its right child is at
+  * 'Index'. A leaf holds the primitives from 'Index' to 'Index + NumPrimitives'. */
+struct FCubeArenaBvhNode
+{
+    float MinY;
+    float MinZ;
+    float MaxY;
+    float MaxZ;
+    int32 Index;
+    /** The number of primitives of a leaf, or zero for an inner node. */
+    int32 NumPrimitives;
+};
+
+/** Written once at the start of the file. */
+struct FCubeArenaGeometryHeader
+{
+    static constexpr uint32 MAGIC = 0x47415347; // "GSAG"
+    static constexpr uint16 VERSION = 1;
+
+    uint32 Magic;
+    uint16 Version;
+    uint16 Padding;
+    uint32 NumPrimitives;
+    uint32 NumNodes;
+    /** The X coordinate of the plane the walls were sliced by. */
+    float PlaneX;
+    /** The goal lines, floor, ceiling and goal mouths of the arena, as in FCubeSimArena. */
+    float LeftGoalLineY;
+    float RightGoalLineY;
+    float FloorZ;
+    float CeilingZ;
+    float GoalCenterZ;
+    float GoalHalfHeight;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(FCubeArenaPrimitive) == 32, "A primitive must fill half a cache line");
+static_assert(sizeof(FCubeArenaBvhNode) == 24, "The cooked arena layout must not depend on the platform");
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "CubeSimRules.h"
+// The rules below are defined in this header, so they must be compiled with strict floating-point math in every includer
+#include "CubeStrictFloat.h"
+
+/**
+ * The balls the game ships, as policy types whose tuning is known at compile time. A profile has the members of
+ * FCubeBallRules as static constexpr constants, so the templates of CubeBallPhysics accept either: instantiated with a
+ * profile, the compiler folds the tuning into the code; instantiated with FCubeBallRules, they read the tuning designers
+ * set on the ball's UPROPERTYs. Both give bit-identical results for the same tuning.
+ *
+ * BP_Ball_Old, which the BP_Ball redirectors point to, is an actor moved by a UProjectileMovementComponent rather than an
+ * ABall, so it has no profile. The hit cooldown is ABall::MULTIPLE_HIT_COOLDOWN for every ball, and is converted to ticks
+ * in FCubeSimConfig.
+ */
+
+/** The defaults of ABall and FCubeBallRules. */
+struct FCubeDefaultBallProfile
+{
+    static constexpr float DefaultSpeed = 300.0f;
+    static constexpr float MinSpeed = 300.0f;
+    static constexpr float MaxSpeed = 600.0f;
+    static constexpr float PlayerSpeedBounceFactor = 0.001f;
+    static constexpr float CosAngleToIgnorePlayerVelocity = -0.173648178f;
+};
+
+/** BP_Ball_Large, the ball spawned by ACubeProjectGameMode: faster, and much more sensitive to the players' velocity. */
+struct FCubeLargeBallProfile
+{
+    static constexpr float DefaultSpeed = 500.0f;
+    static constexpr float MinSpeed = 300.0f;
+    static constexpr float MaxSpeed = 800.0f;
+    static constexpr float PlayerSpeedBounceFactor = 0.02f;
+    static constexpr float CosAngleToIgnorePlayerVelocity = -0.173648178f;
+};
+
+namespace ECubeBallProfile
+{
+    enum Type
+    {
+        Default,
+        Large,
+        /** The tuning matches no profile, e.g. because a designer is tweaking it. */
+        Count
+    };
+}
+
+/**
+ * The ball rules of CubeSimRules.h as inline templates, so that callers which know the ball's profile get the rules
+ * specialized for it. CubeSimRules.cpp implements the non-template rules with them. As they compute gameplay state, this
+ * header includes CubeStrictFloat.h before defining them, which makes the rest of every includer strict as well.
+ */
+namespace CubeBallPhysics
+{
+    /** The inline form of CubeSim::Size(). */
+    FORCEINLINE float Size(const FVector2D& Vector)
+    {
+        return FMath::Sqrt(Vector.X * Vector.X + Vector.Y * Vector.Y);
+    }
+
+    /** The inline form of CubeSim::SafeNormal(). */
+    FORCEINLINE FVector2D SafeNormal(const FVector2D& Vector)
+    {
+        const float SizeSquared = Vector.X * Vector.X + Vector.Y * Vector.Y;
+
+        if(SizeSquared < CubeSim::SAFE_NORMAL_TOLERANCE_SQUARED)
+            return FVector2D::ZeroVector;
+
+        // Divide by the correctly rounded square root instead of using FMath::InvSqrt(), whose estimate depends on the CPU
+        const float Scale = 1.0f / FMath::Sqrt(SizeSquared);
+        return FVector2D(Vector.X * Scale, Vector.Y * Scale);
+    }
+
+    /** The inline form of CubeSim::ClampSize(). */
+    FORCEINLINE FVector2D ClampSize(const FVector2D& Vector, float MinSize, float MaxSize)
+    {
+        const float VectorSize = Size(Vector);
+
+        if(VectorSize < SMALL_NUMBER)
+            return FVector2D::ZeroVector;
+
+        const float ClampedSize = FMath::Clamp(VectorSize, MinSize, MaxSize);
+
+        if(ClampedSize == VectorSize)
+            return Vector;
+
+        const float Scale = ClampedSize / VectorSize;
+        return FVector2D(Vector.X * Scale, Vector.Y * Scale);
+    }
+
+    /** See CubeSim::GetBallVelocity(). */
+    template<typename TBallRules>
+    FORCEINLINE FVector2D GetBallVelocity(const FVector2D& Direction, float Speed, const TBallRules& Rules)
+    {
+        return ClampSize(FVector2D(Direction.X * Speed, Direction.Y * Speed), Rules.MinSpeed, Rules.MaxSpeed);
+    }
+
+    /** See CubeSim::AddPlayerVelocity(). */
+    template<typename TBallRules>
+    FORCEINLINE FVector2D AddPlayerVelocity(const FVector2D& Direction, const FVector2D& PlayerVelocity, const TBallRules& Rules)
+    {
+        return FVector2D(Direction.X + PlayerVelocity.X * Rules.PlayerSpeedBounceFactor, Direction.Y + PlayerVelocity.Y * Rules.PlayerSpeedBounceFactor);
+    }
+
+    /** See CubeSim::BounceOffPlayer(). */
+    template<typename TBallRules>
+    FORCEINLINE FVector2D BounceOffPlayer(const FVector2D& BallLocation, const FVector2D& PlayerLocation, const FVector2D& PlayerVelocity,
+                                          const TBallRules& Rules)
+    {
+        // The ball bounces away from the player's center
+        const FVector2D BounceDirection = SafeNormal(BallLocation - PlayerLocation);
+        const FVector2D PlayerDirection = SafeNormal(PlayerVelocity);
+        const float Cos = BounceDirection.X * PlayerDirection.X + BounceDirection.Y * PlayerDirection.Y;
+
+        // If the player moves against the bounce, adding its velocity would send the ball in a random direction. Both
+        // directions are computed so that the compiler can select one without branching.
+        const FVector2D FollowDirection = AddPlayerVelocity(BounceDirection, PlayerVelocity, Rules);
+        return (Cos < Rules.CosAngleToIgnorePlayerVelocity) ? BounceDirection : FollowDirection;
+    }
+
+    /** Returns the rules of a profile, e.g. to configure a match simulation with it. */
+    template<typename TProfile>
+    FCubeBallRules MakeRules()
+    {
+        FCubeBallRules Rules;
+        Rules.DefaultSpeed = TProfile::DefaultSpeed;
+        Rules.MinSpeed = TProfile::MinSpeed;
+        Rules.MaxSpeed = TProfile::MaxSpeed;
+        Rules.PlayerSpeedBounceFactor = TProfile::PlayerSpeedBounceFactor;
+        Rules.CosAngleToIgnorePlayerVelocity = TProfile::CosAngleToIgnorePlayerVelocity;
+        return Rules;
+    }
+
+    /** Returns the profile whose tuning is exactly the given rules, or ECubeBallProfile::Count if none is. */
+    CUBEPROJECT_API ECubeBallProfile::Type FindProfile(const FCubeBallRules& Rules);
+
+    /** Calls Func with the profile matching the rules if there is one, or with the rules themselves. Func is typically a
+      * generic lambda, which is then instantiated once per profile plus once for the designers' tuning. */
+    template<typename TFunc>
+    FORCEINLINE auto VisitProfile(const FCubeBallRules& Rules, TFunc&& Func) -> decltype(Func(Rules))
+    {
+        switch(FindProfile(Rules))
+        {
+        case ECubeBallProfile::Default:
+            return Func(FCubeDefaultBallProfile());
+        case ECubeBallProfile::Large:
+            return Func(FCubeLargeBallProfile());
+        default:
+            return Func(Rules);
+        }
+    }
+}
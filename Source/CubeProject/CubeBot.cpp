@@ -0,0 +1,62 @@
+#include "CubeProject.h"
+#include "CubeBot.h"
+#include "CubeSimRules.h"
+#include "CubeMatchSim.h"
+#include "CubeStrictFloat.h"
+
+FCubeBotInput FCubeScriptedBot::Think(const FCubeBotContext& Context)
+{
+    FCubeBotInput Input;
+
+    // Aim for a point behind the ball, on the line between the opponent's goal and the ball. The strict gameplay math keeps
+    // the bot's decisions the same on every machine in the determinism mode.
+    const FVector2D BallToGoal = CubeSim::SafeNormal(Context.OpponentGoalLocation - Context.BallLocation);
+    const FVector2D ApproachPoint = Context.BallLocation - BallToGoal * APPROACH_DISTANCE;
+
+    const FVector2D PawnToBall = Context.BallLocation - Context.PawnLocation;
+    const FVector2D PawnToApproachPoint = ApproachPoint - Context.PawnLocation;
+
+    // Once behind the ball, drive through it. Otherwise, go around it to the approach point.
+    const bool bBehindBall = FVector2D::DotProduct(CubeSim::SafeNormal(PawnToBall), BallToGoal) > 0.5f;
+    const FVector2D MoveDirection = CubeSim::SafeNormal(bBehindBall ? PawnToBall : PawnToApproachPoint);
+
+    Input.MoveX = MoveDirection.X;
+    Input.MoveY = MoveDirection.Y;
+    Input.bSpin = Context.bCanSpin && bBehindBall && CubeSim::Size(PawnToBall) < SPIN_DISTANCE;
+
+    return Input;
+}
+
+void FCubeBot::MakeSimContext(const FCubeMatchState& State, const FCubeSimConfig& Config, int32 Slot, FCubeBotContext& OutContext)
+{
+    const FVector2D LeftGoalLocation(Config.Arena.LeftGoalLineY, Config.Arena.GoalCenterZ);
+    const FVector2D RightGoalLocation(Config.Arena.RightGoalLineY, Config.Arena.GoalCenterZ);
+
+    OutContext.Slot = Slot;
+    OutContext.Team = FCubePlayerRegistry::GetTeam(Slot);
+    OutContext.PawnLocation = State.Pawns[Slot].Location;
+    OutContext.PawnVelocity = State.Pawns[Slot].Velocity;
+    OutContext.bCanSpin = State.Pawns[Slot].SpinCooldownTicks == 0;
+    OutContext.BallLocation = State.Ball.Location;
+    OutContext.BallVelocity = CubeSim::GetBallVelocity(State.Ball.Direction, State.Ball.Speed, Config.BallRules);
+    OutContext.OwnGoalLocation = (OutContext.Team == 0) ? LeftGoalLocation : RightGoalLocation;
+    OutContext.OpponentGoalLocation = (OutContext.Team == 0) ? RightGoalLocation : LeftGoalLocation;
+    OutContext.DeltaTime = Config.TickDuration;
+    OutContext.MatchState = &State;
+    OutContext.SimConfig = &Config;
+    OutContext.MatchSeed = 0;
+}
+
+void FCubeScriptedBot::GetSimInputs(const FCubeMatchState& State, const FCubeSimConfig& Config, FCubeSimInput* Inputs)
+{
+    FCubeScriptedBot ScriptedBot;
+    FCubeBotContext Context;
+
+    for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+    {
+        MakeSimContext(State, Config, Slot, Context);
+
+        const FCubeBotInput Input = ScriptedBot.Think(Context);
+        Inputs[Slot] = CubeSim::MakeInput(Input.MoveX, Input.MoveY, Input.bSpin);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+/** What a bot knows about the match when it decides how to move. Since the game is played on the YZ plane, the X and Y
+  * components of each vector hold the world's Y (horizontal) and Z (vertical) coordinates. */
+struct FCubeBotContext
+{
+    /** The slot of the player controlled by the bot. */
+    int32 Slot;
+    /** The team of the player controlled by the bot. Team 0 defends the left goal. */
+    int32 Team;
+    /** The bot's pawn. */
+    FVector2D PawnLocation;
+    FVector2D PawnVelocity;
+    /** True if the pawn can spin (i.e., it is not already spinning). */
+    bool bCanSpin;
+    /** The ball. */
+    FVector2D BallLocation;
+    FVector2D BallVelocity;
+    /** The centers of the goal defended by the bot and of the goal it attacks. */
+    FVector2D OwnGoalLocation;
+    FVector2D OpponentGoalLocation;
+    /** The time elapsed since the last decision, in seconds. */
+    float DeltaTime;
+    /** A snapshot of the match and the arena, for bots which look ahead with the match simulation. NULL if unavailable. */
+    const struct FCubeMatchState* MatchState;
+    const struct FCubeSimConfig* SimConfig;
+    /** The seed of the match's random streams. */
+    uint64 MatchSeed;
+};
+
+/** The input produced by a bot. Applied to the pawn exactly like player input. */
+struct FCubeBotInput
+{
+    /** The horizontal and vertical movement axes, in [-1, 1]. */
+    float MoveX = 0.0f;
+    float MoveY = 0.0f;
+    /** True to release the spin button this tick. */
+    bool bSpin = false;
+};
+
+/**
+ * Controls a player's pawn in place of a human. Bots are assigned to player slots through
+ * ACubeProjectGameMode::SetBot() and are ticked by the game mode while the game is being played.
+ */
+class CUBEPROJECT_API FCubeBot
+{
+public:
+    virtual ~FCubeBot() {}
+
+    /** Returns the input to apply to the bot's pawn this tick. */
+    virtual FCubeBotInput Think(const FCubeBotContext& Context) = 0;
+
+    /** Fills the context of the bot controlling the given slot of a simulated match. */
+    static void MakeSimContext(const struct FCubeMatchState& State, const struct FCubeSimConfig& Config, int32 Slot, FCubeBotContext& OutContext);
+};
+
+/**
+ * A simple bot with a fixed strategy: get behind the ball, push it towards the opponent's goal and spin when it is close.
+ * Its decisions only depend on the state of the match, so scripted matches play out the same way every time.
+ */
+class CUBEPROJECT_API FCubeScriptedBot : public FCubeBot
+{
+public:
+    /** How far behind the ball the bot places itself before pushing, in world units. */
+    static constexpr float APPROACH_DISTANCE = 60.0f;
+    /** The bot spins when the ball is closer than this distance, in world units. */
+    static constexpr float SPIN_DISTANCE = 110.0f;
+
+    virtual FCubeBotInput Think(const FCubeBotContext& Context) override;
+
+    /** Fills the input of every player of a simulated match with the decision of the scripted bot. */
+    static void GetSimInputs(const struct FCubeMatchState& State, const struct FCubeSimConfig& Config, struct FCubeSimInput* Inputs);
+};
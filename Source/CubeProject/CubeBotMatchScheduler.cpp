@@ -0,0 +1,102 @@
+#include "CubeProject.h"
+#include "CubeBotMatchScheduler.h"
+#include "CubeHostedMatch.h"
+#include "ParallelFor.h"
+
+FCubeBotMatchScheduler::FCubeBotMatchScheduler(float InTickDuration, double InMatchBudgetSeconds)
+    : TickDuration(InTickDuration)
+    , MatchBudgetSeconds(InMatchBudgetSeconds)
+    , UpdateCount(0)
+{
+}
+
+FCubeBotMatchScheduler::~FCubeBotMatchScheduler()
+{
+    for(FEntry& Entry : Entries)
+    {
+        delete Entry.Match;
+    }
+}
+
+void FCubeBotMatchScheduler::AddMatch(FCubeHostedMatch* Match, double Time)
+{
+    FEntry& Entry = Entries[Entries.AddZeroed()];
+    Entry.Match = Match;
+    Entry.StartTime = Time;
+}
+
+void FCubeBotMatchScheduler::Update(double Time)
+{
+    Order.Reset();
+
+    for(int32 Index = 0; Index < Entries.Num(); Index++)
+    {
+        FEntry& Entry = Entries[Index];
+        const uint64 TicksDue = (uint64)FMath::Max((Time - Entry.StartTime) / TickDuration, 0.0);
+
+        if(TicksDue <= Entry.TicksDone)
+            continue;
+
+        Entry.OwedTicks = (int32)FMath::Min<uint64>(TicksDue - Entry.TicksDone, MAX_int32);
+        Stats.MaxOwedTicks = FMath::Max(Stats.MaxOwedTicks, Entry.OwedTicks);
+
+        // Don't try to catch up with time a match will never make up for
+        if(Entry.OwedTicks > MAX_OWED_TICKS)
+        {
+            Stats.TicksDropped += Entry.OwedTicks - MAX_OWED_TICKS;
+            Entry.TicksDone += Entry.OwedTicks - MAX_OWED_TICKS;
+            Entry.OwedTicks = MAX_OWED_TICKS;
+        }
+
+        Order.Add(Index);
+    }
+
+    // Serve the matches furthest behind first. Ties are broken by a rotating index so that no match is always served last.
+    const uint32 Rotation = UpdateCount++;
+    const int32 NumEntries = Entries.Num();
+
+    Order.Sort([this, Rotation, NumEntries](int32 A, int32 B)
+    {
+        if(Entries[A].OwedTicks != Entries[B].OwedTicks)
+            return Entries[A].OwedTicks > Entries[B].OwedTicks;
+
+        return (A + Rotation) % NumEntries < (B + Rotation) % NumEntries;
+    });
+
+    // Each match is only touched by the worker stepping it, so matches share nothing but the read-only configuration
+    ParallelFor(Order.Num(), [this](int32 OrderIndex)
+    {
+        FEntry& Entry = Entries[Order[OrderIndex]];
+        const double StartTime = FPlatformTime::Seconds();
+        const int32 TicksToRun = FMath::Min(Entry.OwedTicks, MAX_CATCH_UP_TICKS);
+        double Now = StartTime;
+
+        Entry.TicksRun = 0;
+        Entry.bOverran = false;
+
+        while(Entry.TicksRun < TicksToRun)
+        {
+            Entry.Match->Tick();
+            Entry.TicksRun++;
+            Now = FPlatformTime::Seconds();
+
+            if(Now - StartTime > MatchBudgetSeconds && Entry.TicksRun < TicksToRun)
+            {
+                Entry.bOverran = true;
+                break;
+            }
+        }
+
+        Entry.BusySeconds = Now - StartTime;
+    });
+
+    for(int32 Index : Order)
+    {
+        FEntry& Entry = Entries[Index];
+        Entry.TicksDone += Entry.TicksRun;
+
+        Stats.TicksSimulated += Entry.TicksRun;
+        Stats.BusySeconds += Entry.BusySeconds;
+        Stats.BudgetOverruns += Entry.bOverran ? 1 : 0;
+    }
+}
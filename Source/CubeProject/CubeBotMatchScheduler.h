@@ -0,0 +1,83 @@
+#pragma once
+
+class FCubeHostedMatch;
+
+/** The work done by an FCubeBotMatchScheduler since it started. */
+struct FCubeBotMatchSchedulerStats
+{
+    /** The number of simulation ticks run, over all matches. */
+    uint64 TicksSimulated = 0;
+    /** The number of ticks skipped by matches which fell more than MAX_OWED_TICKS behind. */
+    uint64 TicksDropped = 0;
+    /** The number of times a match stopped catching up because it spent its time budget for the frame. */
+    uint64 BudgetOverruns = 0;
+    /** The CPU time spent stepping the matches, summed over the workers, in seconds. */
+    double BusySeconds = 0.0;
+    /** The largest number of ticks any match was owed at the start of a frame. */
+    int32 MaxOwedTicks = 0;
+};
+
+/**
+ * Hosts many matches in one process, each an isolated FCubeHostedMatch, and steps them in real time on the task graph's
+ * workers. Every match is owed one tick per FCubeSimConfig::TickDuration since it was added. At each update, the matches
+ * owed the most ticks are stepped first, and each match runs until it is caught up (at most MAX_CATCH_UP_TICKS) or until
+ * it spent its time budget for the update. A match which is expensive to step, e.g., one played by search bots, thus falls
+ * behind on its own instead of delaying every other match, and gets ahead of the queue at the next update.
+ */
+class CUBEPROJECT_API FCubeBotMatchScheduler
+{
+public:
+    /** The most ticks a match runs in one update. */
+    static constexpr int32 MAX_CATCH_UP_TICKS = 4;
+    /** A match owed more ticks than this skips the extra ticks instead of trying to catch up. */
+    static constexpr int32 MAX_OWED_TICKS = 60;
+
+    /**
+     * @param InTickDuration The duration of a simulation tick, in seconds.
+     * @param InMatchBudgetSeconds The time a match may spend catching up in one update, in seconds.
+     */
+    FCubeBotMatchScheduler(float InTickDuration, double InMatchBudgetSeconds);
+
+    /** Deletes the hosted matches. */
+    ~FCubeBotMatchScheduler();
+
+    /** Adds a match to the scheduler, which takes its ownership. The match is owed its first tick at the given time. */
+    void AddMatch(FCubeHostedMatch* Match, double Time);
+
+    /** Steps the matches owed ticks at the given time (in FPlatformTime::Seconds()). Blocks until they are done. */
+    void Update(double Time);
+
+    /** Returns the number of matches hosted. */
+    FORCEINLINE int32 Num() const { return Entries.Num(); }
+
+    /** Returns the hosted match at the given index. */
+    FORCEINLINE const FCubeHostedMatch& GetMatch(int32 Index) const { return *Entries[Index].Match; }
+
+    /** Returns the work done since the scheduler started. */
+    FORCEINLINE const FCubeBotMatchSchedulerStats& GetStats() const { return Stats; }
+
+private:
+    /** A hosted match and its schedule. */
+    struct FEntry
+    {
+        FCubeHostedMatch* Match;
+        /** The time the match was added. */
+        double StartTime;
+        /** The number of ticks run or dropped since the match was added. */
+        uint64 TicksDone;
+        /** The ticks owed at the start of the current update, and the results of the update. */
+        int32 OwedTicks;
+        int32 TicksRun;
+        double BusySeconds;
+        bool bOverran;
+    };
+
+    float TickDuration;
+    double MatchBudgetSeconds;
+    TArray<FEntry> Entries;
+    /** The indices of the entries stepped in the current update, most owed first. */
+    TArray<int32> Order;
+    /** The number of updates so far. Rotates the order of matches owed the same number of ticks. */
+    uint32 UpdateCount;
+    FCubeBotMatchSchedulerStats Stats;
+};
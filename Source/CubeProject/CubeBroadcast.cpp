@@ -0,0 +1,274 @@
+#include "CubeProject.h"
+#include "CubeBroadcast.h"
+
+namespace
+{
+    /** The maximum number of values of a field. */
+    constexpr int32 MAX_FIELD_VALUES = 3;
+
+    /** Returns the values of a field of the state. */
+    int32 GetFieldValues(const FCubeBroadcastState& State, int32 Field, int32* OutValues)
+    {
+        switch(Field)
+        {
+            case ECubeBroadcastField::GameState:
+                OutValues[0] = State.GameState;
+                return 1;
+            case ECubeBroadcastField::Scores:
+                OutValues[0] = State.Scores[0];
+                OutValues[1] = State.Scores[1];
+                return 2;
+            case ECubeBroadcastField::NumPlayers:
+                OutValues[0] = State.NumPlayers;
+                return 1;
+            case ECubeBroadcastField::Ball:
+                OutValues[0] = State.BallY;
+                OutValues[1] = State.BallZ;
+                return 2;
+            default:
+            {
+                const int32 Slot = Field - ECubeBroadcastField::FirstPawn;
+                OutValues[0] = State.PawnY[Slot];
+                OutValues[1] = State.PawnZ[Slot];
+                OutValues[2] = State.PawnRoll[Slot];
+                return 3;
+            }
+        }
+    }
+
+    /** Sets the values of a field of the state. Values wrap around to the size of the field. */
+    void SetFieldValues(FCubeBroadcastState& State, int32 Field, const int32* Values)
+    {
+        switch(Field)
+        {
+            case ECubeBroadcastField::GameState:
+                State.GameState = (uint8)Values[0];
+                break;
+            case ECubeBroadcastField::Scores:
+                State.Scores[0] = (uint8)Values[0];
+                State.Scores[1] = (uint8)Values[1];
+                break;
+            case ECubeBroadcastField::NumPlayers:
+                State.NumPlayers = (uint8)Values[0];
+                break;
+            case ECubeBroadcastField::Ball:
+                State.BallY = (int16)Values[0];
+                State.BallZ = (int16)Values[1];
+                break;
+            default:
+            {
+                const int32 Slot = Field - ECubeBroadcastField::FirstPawn;
+                State.PawnY[Slot] = (int16)Values[0];
+                State.PawnZ[Slot] = (int16)Values[1];
+                State.PawnRoll[Slot] = (uint16)Values[2];
+                break;
+            }
+        }
+    }
+
+    /** Appends a signed value as a zigzag varint: small values of either sign take a single byte. */
+    void WriteVarint(TArray<uint8>& Data, int32 Value)
+    {
+        uint32 Bits = ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+
+        while(Bits >= 0x80)
+        {
+            Data.Add((uint8)(Bits | 0x80));
+            Bits >>= 7;
+        }
+
+        Data.Add((uint8)Bits);
+    }
+
+    /** Reads a zigzag varint. Returns false if it runs past the end of the data. */
+    bool ReadVarint(const uint8*& Data, const uint8* End, int32& OutValue)
+    {
+        uint32 Bits = 0;
+
+        for(int32 Shift = 0; Shift < 35; Shift += 7)
+        {
+            if(Data == End)
+                return false;
+
+            const uint8 Byte = *Data++;
+            Bits |= (uint32)(Byte & 0x7F) << Shift;
+
+            if((Byte & 0x80) == 0)
+            {
+                OutValue = (int32)(Bits >> 1) ^ -(int32)(Bits & 1);
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+FCubeBroadcastEncoder::FCubeBroadcastEncoder()
+    : FramesUntilKeyframe(0)
+{
+    FMemory::Memzero(PreviousState);
+}
+
+void FCubeBroadcastEncoder::Encode(const FCubeBroadcastState& State, const TArray<FCubeBroadcastEvent>& Events, TArray<uint8>& OutFrame)
+{
+    // Only the first frame encoded into the array allocates
+    OutFrame.Reset();
+    OutFrame.Reserve(CUBE_BROADCAST_MAX_FRAME_SIZE);
+    OutFrame.AddZeroed(sizeof(FCubeBroadcastFrameHeader) + sizeof(uint32));
+
+    // A keyframe is a delta from a state of zeros, in which every field is present
+    const bool bKeyframe = (FramesUntilKeyframe <= 0);
+    FCubeBroadcastState ZeroState;
+    FMemory::Memzero(ZeroState);
+    const FCubeBroadcastState& BaseState = bKeyframe ? ZeroState : PreviousState;
+
+    uint32 FieldMask = 0;
+
+    for(int32 Field = 0; Field < ECubeBroadcastField::Count; Field++)
+    {
+        int32 Values[MAX_FIELD_VALUES];
+        int32 BaseValues[MAX_FIELD_VALUES];
+        const int32 NumValues = GetFieldValues(State, Field, Values);
+        GetFieldValues(BaseState, Field, BaseValues);
+
+        if(!bKeyframe && FMemory::Memcmp(Values, BaseValues, NumValues * sizeof(int32)) == 0)
+            continue;
+
+        FieldMask |= 1u << Field;
+
+        for(int32 Value = 0; Value < NumValues; Value++)
+        {
+            WriteVarint(OutFrame, Values[Value] - BaseValues[Value]);
+        }
+    }
+
+    const int32 NumEvents = FMath::Min(Events.Num(), CUBE_BROADCAST_MAX_EVENTS);
+    OutFrame.Append((const uint8*)Events.GetData(), NumEvents * sizeof(FCubeBroadcastEvent));
+
+    FCubeBroadcastFrameHeader Header;
+    Header.Size = (uint16)OutFrame.Num();
+    Header.Type = bKeyframe ? FCubeBroadcastFrameHeader::TYPE_KEYFRAME : FCubeBroadcastFrameHeader::TYPE_DELTA;
+    Header.NumEvents = (uint8)NumEvents;
+    Header.Tick = State.Tick;
+
+    FMemory::Memcpy(OutFrame.GetData(), &Header, sizeof(Header));
+    FMemory::Memcpy(OutFrame.GetData() + sizeof(Header), &FieldMask, sizeof(FieldMask));
+
+    PreviousState = State;
+    FramesUntilKeyframe = bKeyframe ? CUBE_BROADCAST_KEYFRAME_INTERVAL - 1 : FramesUntilKeyframe - 1;
+}
+
+FCubeBroadcastDecoder::FCubeBroadcastDecoder()
+    : bHasKeyframe(false)
+{
+    FMemory::Memzero(State);
+}
+
+bool FCubeBroadcastDecoder::Decode(const uint8* Frame, int32 Size, TArray<FCubeBroadcastEvent>* OutEvents)
+{
+    if(OutEvents)
+    {
+        OutEvents->Reset();
+    }
+
+    if(Size < (int32)(sizeof(FCubeBroadcastFrameHeader) + sizeof(uint32)))
+        return false;
+
+    FCubeBroadcastFrameHeader Header;
+    uint32 FieldMask;
+    FMemory::Memcpy(&Header, Frame, sizeof(Header));
+    FMemory::Memcpy(&FieldMask, Frame + sizeof(Header), sizeof(FieldMask));
+
+    if(Header.Size != Size || (Header.Type != FCubeBroadcastFrameHeader::TYPE_KEYFRAME && Header.Type != FCubeBroadcastFrameHeader::TYPE_DELTA))
+        return false;
+
+    const bool bKeyframe = (Header.Type == FCubeBroadcastFrameHeader::TYPE_KEYFRAME);
+
+    // A delta is meaningless without the state it applies to
+    if(!bKeyframe && !bHasKeyframe)
+        return true;
+
+    FCubeBroadcastState NewState;
+
+    if(bKeyframe)
+    {
+        FMemory::Memzero(NewState);
+    }
+    else
+    {
+        NewState = State;
+    }
+
+    const uint8* Data = Frame + sizeof(Header) + sizeof(FieldMask);
+    const uint8* End = Frame + Size - Header.NumEvents * sizeof(FCubeBroadcastEvent);
+
+    if(End < Data)
+        return false;
+
+    for(int32 Field = 0; Field < ECubeBroadcastField::Count; Field++)
+    {
+        if((FieldMask & (1u << Field)) == 0)
+            continue;
+
+        int32 Values[MAX_FIELD_VALUES];
+        const int32 NumValues = GetFieldValues(NewState, Field, Values);
+
+        for(int32 Value = 0; Value < NumValues; Value++)
+        {
+            int32 Change;
+
+            if(!ReadVarint(Data, End, Change))
+                return false;
+
+            Values[Value] += Change;
+        }
+
+        SetFieldValues(NewState, Field, Values);
+    }
+
+    if(Data != End)
+        return false;
+
+    NewState.Tick = Header.Tick;
+    State = NewState;
+    bHasKeyframe = true;
+
+    if(OutEvents)
+    {
+        OutEvents->SetNumUninitialized(Header.NumEvents);
+        FMemory::Memcpy(OutEvents->GetData(), End, Header.NumEvents * sizeof(FCubeBroadcastEvent));
+    }
+
+    return true;
+}
+
+int32 CubeBroadcast::GetFrameSize(const uint8* Data, int32 Size)
+{
+    if(Size < (int32)sizeof(uint16))
+        return 0;
+
+    uint16 FrameSize;
+    FMemory::Memcpy(&FrameSize, Data, sizeof(FrameSize));
+    return FrameSize;
+}
+
+bool CubeBroadcast::IsKeyframe(const uint8* Frame)
+{
+    return ((const FCubeBroadcastFrameHeader*)Frame)->Type == FCubeBroadcastFrameHeader::TYPE_KEYFRAME;
+}
+
+int16 CubeBroadcast::QuantizeLocation(float Location)
+{
+    return (int16)FMath::Clamp(FMath::RoundToInt(Location * 4.0f), (int32)MIN_int16, (int32)MAX_int16);
+}
+
+float CubeBroadcast::DequantizeLocation(int16 Location)
+{
+    return Location * 0.25f;
+}
+
+uint16 CubeBroadcast::QuantizeAngle(float Degrees)
+{
+    return (uint16)(FMath::RoundToInt(Degrees * (65536.0f / 360.0f)) & 0xFFFF);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CubeBroadcastFormat.h"
+
+/** Encodes the state of each tick into a broadcast frame (see CubeBroadcastFormat.h). */
+class CUBEPROJECT_API FCubeBroadcastEncoder
+{
+public:
+    FCubeBroadcastEncoder();
+
+    /** Encodes the state and events of a tick, replacing the contents of OutFrame. The frame is a keyframe every
+      * CUBE_BROADCAST_KEYFRAME_INTERVAL ticks, or after ForceKeyframe(), and a delta from the previously encoded state
+      * otherwise. A frame never exceeds CUBE_BROADCAST_MAX_FRAME_SIZE, so encoding into the same array again doesn't allocate. */
+    void Encode(const FCubeBroadcastState& State, const TArray<FCubeBroadcastEvent>& Events, TArray<uint8>& OutFrame);
+
+    /** Makes the next frame a keyframe, e.g., when the connection to the relay is restored. */
+    FORCEINLINE void ForceKeyframe() { FramesUntilKeyframe = 0; }
+
+private:
+    /** The state encoded in the last frame. */
+    FCubeBroadcastState PreviousState;
+    /** The number of frames to encode before the next keyframe. */
+    int32 FramesUntilKeyframe;
+};
+
+/** Rebuilds the broadcast state from a stream of frames. */
+class CUBEPROJECT_API FCubeBroadcastDecoder
+{
+public:
+    FCubeBroadcastDecoder();
+
+    /**
+     * Applies a whole frame to the current state. Delta frames received before the first keyframe are skipped.
+     * @param OutEvents If not NULL, receives the events of the frame.
+     * @return false if the frame is malformed.
+     */
+    bool Decode(const uint8* Frame, int32 Size, TArray<FCubeBroadcastEvent>* OutEvents = NULL);
+
+    /** Returns true once a keyframe was decoded. */
+    FORCEINLINE bool HasKeyframe() const { return bHasKeyframe; }
+
+    /** Returns the state decoded from the last frame. */
+    FORCEINLINE const FCubeBroadcastState& GetState() const { return State; }
+
+private:
+    FCubeBroadcastState State;
+    bool bHasKeyframe;
+};
+
+namespace CubeBroadcast
+{
+    /** Returns the size of the frame starting at the given bytes, or zero if its header is not complete yet. */
+    CUBEPROJECT_API int32 GetFrameSize(const uint8* Data, int32 Size);
+
+    /** Returns true if the frame starting at the given bytes is a keyframe. */
+    CUBEPROJECT_API bool IsKeyframe(const uint8* Frame);
+
+    /** Quantizes a location in world units to quarters of a unit, and back. */
+    CUBEPROJECT_API int16 QuantizeLocation(float Location);
+    CUBEPROJECT_API float DequantizeLocation(int16 Location);
+
+    /** Quantizes an angle in degrees to 1/65536 of a turn. */
+    CUBEPROJECT_API uint16 QuantizeAngle(float Degrees);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+/**
+ * Wire format of the spectator broadcast stream. The game encodes one frame per tick and sends the frames to a relay
+ * (see UBroadcastRelayCommandlet), which forwards the bytes unchanged to every subscriber. A frame is:
+ *
+ *   FCubeBroadcastFrameHeader
+ *   uint32 mask of the fields present in the frame (ECubeBroadcastField)
+ *   For each field present, in field order: the change of each of its values as a zigzag varint
+ *   FCubeBroadcastEvent for each event of the tick
+ *
+ * A delta frame stores the changes since the state decoded from the previous frame, so a subscriber must start from a
+ * keyframe. A keyframe stores every field, as changes from a state of zeros. The game sends a keyframe every
+ * CUBE_BROADCAST_KEYFRAME_INTERVAL ticks, and the relay starts every new subscriber at the last keyframe it received.
+ * Locations are quantized to 1/4 world unit and the pawns' roll to 1/65536 of a turn. All values are little-endian.
+ */
+
+/** The fields of FCubeBroadcastState tracked by a delta frame. Each pawn is one field: its location and roll. */
+namespace ECubeBroadcastField
+{
+    enum Type
+    {
+        GameState,
+        Scores,
+        NumPlayers,
+        Ball,
+        FirstPawn,
+
+        Count = FirstPawn + 8
+    };
+}
+
+/** The state of a match as seen by a spectator, quantized for the broadcast. */
+struct FCubeBroadcastState
+{
+    uint32 Tick;
+    /** The EGameState of the game. */
+    uint8 GameState;
+    uint8 Scores[2];
+    uint8 NumPlayers;
+    /** The ball's location, in quarters of a world unit. */
+    int16 BallY;
+    int16 BallZ;
+    /** Each pawn's location, in quarters of a world unit, and its roll, in 1/65536 of a turn. */
+    int16 PawnY[8];
+    int16 PawnZ[8];
+    uint16 PawnRoll[8];
+};
+
+/** A gameplay event broadcast along with the tick in which it happened. Uses the types of the match event log. */
+struct FCubeBroadcastEvent
+{
+    /** The EMatchEventType of the event. */
+    uint8 Type;
+    /** The slot of the player involved in the event, or -1. */
+    int8 Slot;
+    /** Extra data depending on the type of the event (see EMatchEventType). */
+    int16 Param;
+    /** The location of the event, in quarters of a world unit. */
+    int16 LocationY;
+    int16 LocationZ;
+};
+
+#pragma pack(push, 1)
+
+/** Written at the start of every frame. */
+struct FCubeBroadcastFrameHeader
+{
+    static constexpr uint8 TYPE_KEYFRAME = 1;
+    static constexpr uint8 TYPE_DELTA = 2;
+
+    /** The size of the frame, header included. */
+    uint16 Size;
+    uint8 Type;
+    /** The number of events in the frame. */
+    uint8 NumEvents;
+    /** The tick of the frame's state. */
+    uint32 Tick;
+};
+
+#pragma pack(pop)
+
+/** The number of ticks between two keyframes. */
+static constexpr int32 CUBE_BROADCAST_KEYFRAME_INTERVAL = 60;
+/** The maximum number of events in a frame. Further events of the same tick are not broadcast. */
+static constexpr int32 CUBE_BROADCAST_MAX_EVENTS = 32;
+/** The largest frame the encoder produces: a keyframe with the maximum number of events. */
+static constexpr int32 CUBE_BROADCAST_MAX_FRAME_SIZE = 1024;
@@ -0,0 +1,170 @@
+#include "CubeProject.h"
+#include "CubeBroadcastPublisher.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+const TCHAR* FCubeBroadcastPublisher::DEFAULT_RELAY_ADDRESS = TEXT("127.0.0.1:7790");
+
+FCubeBroadcastPublisher::FCubeBroadcastPublisher(const FString& InRelayAddress)
+    : Frames(QUEUE_CAPACITY)
+    , FreeSlots(QUEUE_CAPACITY)
+    , RelayAddress(InRelayAddress)
+    , Socket(NULL)
+    , bWaitingForKeyframe(true)
+{
+    // Allocate every frame now, so that publishing a tick never allocates
+    FrameSlots.SetNum(QUEUE_CAPACITY - 1);
+
+    for(int32 Slot = 0; Slot < FrameSlots.Num(); Slot++)
+    {
+        FrameSlots[Slot].Reserve(CUBE_BROADCAST_MAX_FRAME_SIZE);
+        FreeSlots.Enqueue(Slot);
+    }
+
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, TEXT("CubeBroadcastPublisher"), 0, TPri_BelowNormal);
+}
+
+FCubeBroadcastPublisher::~FCubeBroadcastPublisher()
+{
+    Stop();
+
+    if(Thread)
+    {
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+}
+
+void FCubeBroadcastPublisher::Publish(const FCubeBroadcastState& State, const TArray<FCubeBroadcastEvent>& Events)
+{
+    if(KeyframeRequested.Set(0) != 0)
+    {
+        Encoder.ForceKeyframe();
+    }
+
+    // Every frame is waiting to be sent: drop this one. A dropped frame breaks the chain of deltas, so the stream restarts
+    // from a keyframe.
+    int32 Slot = INDEX_NONE;
+
+    if(!FreeSlots.Dequeue(Slot))
+    {
+        Encoder.ForceKeyframe();
+        WakeEvent->Trigger();
+        return;
+    }
+
+    // There are fewer slots than the queue holds, so the frame is always queued
+    Encoder.Encode(State, Events, FrameSlots[Slot]);
+    Frames.Enqueue(Slot);
+    WakeEvent->Trigger();
+}
+
+uint32 FCubeBroadcastPublisher::Run()
+{
+    while(StopRequested.GetValue() == 0)
+    {
+        if(!Socket && !Connect())
+        {
+            // Keep the queue short while the relay is away, and try again a bit later
+            int32 Slot = INDEX_NONE;
+
+            while(Frames.Dequeue(Slot))
+            {
+                FreeSlots.Enqueue(Slot);
+            }
+
+            WakeEvent->Wait(1000);
+            continue;
+        }
+
+        int32 Slot = INDEX_NONE;
+
+        if(!Frames.Dequeue(Slot))
+        {
+            WakeEvent->Wait(100);
+            continue;
+        }
+
+        const TArray<uint8>& Frame = FrameSlots[Slot];
+
+        if(!bWaitingForKeyframe || CubeBroadcast::IsKeyframe(Frame.GetData()))
+        {
+            bWaitingForKeyframe = false;
+
+            // The socket is blocking: this thread only waits on the relay
+            int32 BytesSent = 0;
+
+            while(BytesSent < Frame.Num())
+            {
+                int32 Sent = 0;
+
+                if(!Socket->Send(Frame.GetData() + BytesSent, Frame.Num() - BytesSent, Sent))
+                {
+                    UE_LOG(LogCubeProject, Warning, TEXT("Lost the connection to the broadcast relay at %s"), *RelayAddress);
+                    Disconnect();
+                    break;
+                }
+
+                BytesSent += Sent;
+            }
+        }
+
+        // The frame is sent, or dropped: the game thread can encode into its slot again
+        FreeSlots.Enqueue(Slot);
+    }
+
+    Disconnect();
+    return 0;
+}
+
+void FCubeBroadcastPublisher::Stop()
+{
+    StopRequested.Set(1);
+    WakeEvent->Trigger();
+}
+
+bool FCubeBroadcastPublisher::Connect()
+{
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+    FString Host;
+    FString Port;
+    bool bIsValid = false;
+
+    if(!RelayAddress.Split(TEXT(":"), &Host, &Port))
+        return false;
+
+    Address->SetIp(*Host, bIsValid);
+    Address->SetPort(FCString::Atoi(*Port));
+
+    if(!bIsValid)
+        return false;
+
+    Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("CubeBroadcastPublisher"), false);
+
+    if(!Socket || !Socket->Connect(*Address))
+    {
+        Disconnect();
+        return false;
+    }
+
+    // Start the new connection with a keyframe, since the relay may have lost the state of the previous one
+    UE_LOG(LogCubeProject, Display, TEXT("Broadcasting the match to the relay at %s"), *RelayAddress);
+    bWaitingForKeyframe = true;
+    KeyframeRequested.Set(1);
+    return true;
+}
+
+void FCubeBroadcastPublisher::Disconnect()
+{
+    if(Socket)
+    {
+        Socket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        Socket = NULL;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CubeBroadcast.h"
+
+/**
+ * Sends the spectator broadcast of the match to a relay (see UBroadcastRelayCommandlet). The game thread encodes each tick
+ * once, into a frame slot allocated up front, and queues the frame; a background thread connects to the relay and sends
+ * the frames, so a slow or missing relay never stalls the game. Enabled with -Broadcast[=<address:port>].
+ */
+class CUBEPROJECT_API FCubeBroadcastPublisher : public FRunnable
+{
+public:
+    /** The relay's address when none is given on the command line. */
+    static const TCHAR* DEFAULT_RELAY_ADDRESS;
+    /** The size of the queues of frame slots. As a queue holds one item less than its size, QUEUE_CAPACITY - 1 frames can
+      * wait to be sent. */
+    static constexpr uint32 QUEUE_CAPACITY = 256;
+
+    /** Starts the thread which sends the frames to the relay at the given address ("ip:port"). */
+    explicit FCubeBroadcastPublisher(const FString& InRelayAddress);
+
+    /** Stops the sender thread. */
+    virtual ~FCubeBroadcastPublisher();
+
+    /** Encodes the state and events of a tick and queues the frame for the relay. Never blocks. Game thread only. */
+    void Publish(const FCubeBroadcastState& State, const TArray<FCubeBroadcastEvent>& Events);
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    /** Sender thread: connects to the relay. Returns false if the relay can't be reached. */
+    bool Connect();
+
+    /** Sender thread: closes the connection to the relay. */
+    void Disconnect();
+
+    /** Game thread: encodes the frames. */
+    FCubeBroadcastEncoder Encoder;
+    /** The frames, allocated once. The game thread encodes a frame into a free slot and queues its index; the sender
+      * thread hands the slot back once the frame is sent. */
+    TArray<TArray<uint8>> FrameSlots;
+    /** The indices of the slots holding a frame waiting to be sent, in order. */
+    TCircularQueue<int32> Frames;
+    /** The indices of the slots the game thread can encode a frame into. */
+    TCircularQueue<int32> FreeSlots;
+
+    /** The relay's address. */
+    FString RelayAddress;
+    /** Sender thread: the connection to the relay, or NULL. */
+    FSocket* Socket;
+    /** Sender thread: true until a keyframe is sent on the current connection. Frames before it are dropped. */
+    bool bWaitingForKeyframe;
+
+    /** Set by the sender thread when it connects, so that the game thread encodes a keyframe for the new connection. */
+    FThreadSafeCounter KeyframeRequested;
+    /** The thread sending the frames. */
+    FRunnableThread* Thread;
+    /** Wakes the sender thread once a frame is queued. */
+    FEvent* WakeEvent;
+    /** Set to stop the sender thread. */
+    FThreadSafeCounter StopRequested;
+};
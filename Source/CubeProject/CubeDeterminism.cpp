@@ -0,0 +1,178 @@
+#include "CubeProject.h"
+#include "CubeDeterminism.h"
+#include "CubeStrictFloat.h"
+
+/** Odd constants used to spread the streams and counters over the 64-bit space. */
+static const uint64 STREAM_MULTIPLIER = 0xD1B54A32D192ED03ull;
+static const uint64 COUNTER_MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+FCubeRandomStream::FCubeRandomStream()
+    : Key(0)
+    , Counter(0)
+{
+}
+
+FCubeRandomStream::FCubeRandomStream(uint64 MatchSeed, ECubeRandomStream::Type Stream)
+    : Key(Mix(MatchSeed ^ (STREAM_MULTIPLIER * (uint64)(Stream + 1))))
+    , Counter(0)
+{
+}
+
+uint32 FCubeRandomStream::GetUnsignedInt()
+{
+    const uint64 Value = Mix(Key + Counter * COUNTER_MULTIPLIER);
+    Counter++;
+
+    // The high bits are the best mixed
+    return (uint32)(Value >> 32);
+}
+
+float FCubeRandomStream::GetFraction()
+{
+    // 24 bits fit exactly in a float's mantissa, so the conversion and scaling are exact on every platform
+    return (float)(GetUnsignedInt() >> 8) * (1.0f / 16777216.0f);
+}
+
+float FCubeRandomStream::GetRange(float Min, float Max)
+{
+    const float Fraction = GetFraction();
+    const float Range = Max - Min;
+    const float Offset = Range * Fraction;
+
+    return Min + Offset;
+}
+
+uint64 FCubeRandomStream::Mix(uint64 Value)
+{
+    Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+    return Value ^ (Value >> 31);
+}
+
+FCubeStateHasher::FCubeStateHasher(TArray<FCubeStateField>* InFields)
+    : Hash(0xCBF29CE484222325ull)
+    , NumFields(0)
+    , Fields(InFields)
+{
+    if(Fields)
+    {
+        Fields->Reset();
+    }
+}
+
+void FCubeStateHasher::AddBits(const TCHAR* Name, int32 Index, uint32 Bits)
+{
+    // Include the field's position so that swapping two fields changes the hash
+    Hash = FCubeRandomStream::Mix(Hash ^ ((uint64)Bits | ((uint64)NumFields << 32)));
+    NumFields++;
+
+    if(Fields)
+    {
+        FCubeStateField Field;
+        Field.Name = Name;
+        Field.Index = Index;
+        Field.Bits = Bits;
+        Fields->Add(Field);
+    }
+}
+
+void FCubeStateHasher::AddFloat(const TCHAR* Name, int32 Index, float Value)
+{
+    uint32 Bits;
+    FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+
+    // -0 and +0 compare equal, so they must hash the same
+    if(Bits == 0x80000000u)
+    {
+        Bits = 0;
+    }
+
+    AddBits(Name, Index, Bits);
+}
+
+void FCubeStateHasher::AddPlaneVector(const TCHAR* NameY, const TCHAR* NameZ, int32 Index, const FVector& Value)
+{
+    AddFloat(NameY, Index, Value.Y);
+    AddFloat(NameZ, Index, Value.Z);
+}
+
+FCubeDesyncTrace::FCubeDesyncTrace()
+    : Writer(NULL)
+    , Seed(0)
+    , NumFields(INDEX_NONE)
+{
+}
+
+FCubeDesyncTrace::~FCubeDesyncTrace()
+{
+    End();
+}
+
+bool FCubeDesyncTrace::Begin(const FString& FileName, uint64 InSeed)
+{
+    End();
+
+    Writer = IFileManager::Get().CreateFileWriter(*FileName);
+
+    if(!Writer)
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("Could not create the desync trace %s"), *FileName);
+        return false;
+    }
+
+    Seed = InSeed;
+    NumFields = INDEX_NONE;
+    return true;
+}
+
+void FCubeDesyncTrace::Record(uint32 Tick, uint64 Hash, const TArray<FCubeStateField>& Fields)
+{
+    if(!Writer)
+        return;
+
+    if(NumFields == INDEX_NONE)
+    {
+        WriteHeader(Fields);
+    }
+
+    check(Fields.Num() == NumFields);
+
+    *Writer << Tick;
+    *Writer << Hash;
+
+    for(const FCubeStateField& Field : Fields)
+    {
+        uint32 Bits = Field.Bits;
+        *Writer << Bits;
+    }
+}
+
+void FCubeDesyncTrace::End()
+{
+    if(Writer)
+    {
+        Writer->Close();
+        delete Writer;
+        Writer = NULL;
+    }
+}
+
+void FCubeDesyncTrace::WriteHeader(const TArray<FCubeStateField>& Fields)
+{
+    uint32 Magic = MAGIC;
+    uint32 Version = VERSION;
+    NumFields = Fields.Num();
+
+    *Writer << Magic;
+    *Writer << Version;
+    *Writer << Seed;
+    *Writer << NumFields;
+
+    for(const FCubeStateField& Field : Fields)
+    {
+        FString Name = Field.Name;
+        int32 Index = Field.Index;
+        *Writer << Name;
+        *Writer << Index;
+    }
+}
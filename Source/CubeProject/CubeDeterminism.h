@@ -0,0 +1,133 @@
+#pragma once
+
+/** The independent random streams of a match. Each stream draws from its own sequence, so adding draws to one stream
+  * (e.g., a new bot behaviour) never shifts the values drawn by another (e.g., the kickoff directions). */
+namespace ECubeRandomStream
+{
+    enum Type
+    {
+        /** The direction of the ball at each kickoff. */
+        Kickoff,
+        /** Decisions made by bots. */
+        Bots,
+        /** Inputs generated by tools (fuzzing, soak tests). */
+        Tools,
+        /** The layout of generated arenas. */
+        Arena,
+
+        Count
+    };
+}
+
+/**
+ * Counter-based random number generator. The n-th value of a stream is a hash of the match seed, the stream and n, so a
+ * stream is fully described by its key and counter: it can be copied, saved or rewound without replaying earlier draws,
+ * and gives the same values on every machine. Values are converted to floats with integer operations only.
+ */
+class CUBEPROJECT_API FCubeRandomStream
+{
+public:
+    FCubeRandomStream();
+    FCubeRandomStream(uint64 MatchSeed, ECubeRandomStream::Type Stream);
+
+    /** Returns the next 32 random bits. */
+    uint32 GetUnsignedInt();
+
+    /** Returns the next random value in [0, 1). The value is a multiple of 2^-24, so it is exactly representable. */
+    float GetFraction();
+
+    /** Returns the next random value in [Min, Max). */
+    float GetRange(float Min, float Max);
+
+    /** Returns the number of values drawn from the stream. */
+    FORCEINLINE uint64 GetCounter() const { return Counter; }
+    /** Moves the stream to the given position, e.g., when resuming a saved match. */
+    FORCEINLINE void SetCounter(uint64 InCounter) { Counter = InCounter; }
+
+    /** Mixes the bits of a 64-bit value (the SplitMix64 finalizer). */
+    static uint64 Mix(uint64 Value);
+
+private:
+    /** The hash of the match seed and stream. */
+    uint64 Key;
+    /** The number of values drawn. */
+    uint64 Counter;
+};
+
+/** A field hashed by FCubeStateHasher. Only recorded when a desync trace is being written. */
+struct FCubeStateField
+{
+    /** The name of the field. Always a string literal. */
+    const TCHAR* Name;
+    /** The index of the field's owner (e.g., the player slot), or INDEX_NONE. */
+    int32 Index;
+    /** The bits of the field's value. */
+    uint32 Bits;
+};
+
+/**
+ * Computes a 64-bit hash of the gameplay state from the exact bits of each field. Floats are hashed by their bit pattern
+ * (with -0 folded into +0), so two runs only share a hash if every field is bit-identical. When given an array, the
+ * hasher also records every field so that a desync check can report which one diverged first.
+ */
+class CUBEPROJECT_API FCubeStateHasher
+{
+public:
+    explicit FCubeStateHasher(TArray<FCubeStateField>* InFields = NULL);
+
+    /** Hashes the raw bits of a field. */
+    void AddBits(const TCHAR* Name, int32 Index, uint32 Bits);
+
+    FORCEINLINE void AddInt(const TCHAR* Name, int32 Index, int32 Value) { AddBits(Name, Index, (uint32)Value); }
+    FORCEINLINE void AddBool(const TCHAR* Name, int32 Index, bool bValue) { AddBits(Name, Index, bValue ? 1 : 0); }
+    void AddFloat(const TCHAR* Name, int32 Index, float Value);
+
+    /** Hashes both components of a vector in the game's plane, as the fields "<Name>.Y" and "<Name>.Z". */
+    void AddPlaneVector(const TCHAR* NameY, const TCHAR* NameZ, int32 Index, const FVector& Value);
+
+    /** Returns the hash of the fields added so far. */
+    FORCEINLINE uint64 GetHash() const { return Hash; }
+
+private:
+    uint64 Hash;
+    int32 NumFields;
+    TArray<FCubeStateField>* Fields;
+};
+
+/**
+ * Writes the hash and fields of the gameplay state at every simulation tick of a match to a file, so that two runs of the
+ * same match (on two machines, or two parallel workers) can be compared with the DesyncCheck commandlet.
+ *
+ * File layout: a header (magic, version, seed, field count, then the name and index of every field), then one record per
+ * tick holding the tick, the 64-bit hash and the bits of every field. All values are little-endian.
+ */
+class CUBEPROJECT_API FCubeDesyncTrace
+{
+public:
+    /** Identifies a desync trace file ("GSDT"). */
+    static constexpr uint32 MAGIC = 0x54445347;
+    static constexpr uint32 VERSION = 1;
+
+    FCubeDesyncTrace();
+    ~FCubeDesyncTrace();
+
+    /** Starts a new trace file, closing the previous one. */
+    bool Begin(const FString& FileName, uint64 Seed);
+
+    /** Writes the state of one tick. The fields must be the same at every tick of a match. */
+    void Record(uint32 Tick, uint64 Hash, const TArray<FCubeStateField>& Fields);
+
+    /** Closes the trace file. */
+    void End();
+
+    /** Returns true if a trace file is open. */
+    FORCEINLINE bool IsRecording() const { return Writer != NULL; }
+
+private:
+    /** Writes the header once the fields of the first tick are known. */
+    void WriteHeader(const TArray<FCubeStateField>& Fields);
+
+    FArchive* Writer;
+    uint64 Seed;
+    int32 NumFields;
+};
@@ -0,0 +1,150 @@
+#include "CubeProject.h"
+#include "CubeEffectPool.h"
+#include "CubeMetrics.h"
+#include "MallocCounter.h"
+
+namespace
+{
+    /** Returns true if the component still plays its effect. */
+    FORCEINLINE bool IsPlaying(UAudioComponent* Component) { return Component->IsPlaying(); }
+    FORCEINLINE bool IsPlaying(UParticleSystemComponent* Component) { return Component->IsActive(); }
+}
+
+FCubeEffectPool::FCubeEffectPool(AActor* InOwner)
+    : Owner(InOwner)
+{
+    for(FEffect& Effect : Effects)
+    {
+        Effect.NextSound = 0;
+        Effect.NextParticles = 0;
+    }
+}
+
+FCubeEffectPool::~FCubeEffectPool()
+{
+    // The components are owned by the actor, which destroys them with itself. Only stop what is still playing.
+    for(FEffect& Effect : Effects)
+    {
+        for(UAudioComponent* Sound : Effect.Sounds)
+        {
+            if(Sound && !Sound->IsPendingKill())
+            {
+                Sound->Stop();
+            }
+        }
+
+        for(UParticleSystemComponent* Particles : Effect.Particles)
+        {
+            if(Particles && !Particles->IsPendingKill())
+            {
+                Particles->DeactivateSystem();
+            }
+        }
+    }
+}
+
+void FCubeEffectPool::AddEffect(ECubeEffect::Type EffectType, USoundBase* Sound, UParticleSystem* Particles, int32 Capacity)
+{
+    FEffect& Effect = Effects[EffectType];
+    UWorld* World = Owner->GetWorld();
+
+    for(int32 Index = 0; Sound && Index < Capacity; Index++)
+    {
+        UAudioComponent* Component = NewObject<UAudioComponent>(Owner);
+        Component->bAutoActivate = false;
+        Component->bAutoDestroy = false;
+        Component->SetSound(Sound);
+        Component->RegisterComponentWithWorld(World);
+        Effect.Sounds.Add(Component);
+    }
+
+    for(int32 Index = 0; Particles && Index < Capacity; Index++)
+    {
+        UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(Owner);
+        Component->bAutoActivate = false;
+        Component->bAutoDestroy = false;
+        Component->SetTemplate(Particles);
+        Component->RegisterComponentWithWorld(World);
+        Effect.Particles.Add(Component);
+    }
+
+    UpdateMetrics();
+}
+
+template<typename ComponentType>
+int32 FCubeEffectPool::TakeComponent(const TArray<ComponentType*>& Components, int32& Next)
+{
+    int32 Index = Next;
+
+    for(int32 Offset = 0; Offset < Components.Num(); Offset++)
+    {
+        const int32 Candidate = (Next + Offset) % Components.Num();
+
+        if(!IsPlaying(Components[Candidate]))
+        {
+            Index = Candidate;
+            break;
+        }
+    }
+
+    Next = (Index + 1) % Components.Num();
+    return Index;
+}
+
+void FCubeEffectPool::Play(ECubeEffect::Type EffectType, const FVector& SoundLocation, const FVector& ParticleLocation)
+{
+    FEffect& Effect = Effects[EffectType];
+
+    // The audio device and the particle system keep their own bookkeeping for every effect they start, which is not
+    // gameplay code's to avoid
+    FEngineAllocationScope EngineAllocationScope;
+
+    if(Effect.Sounds.Num() > 0)
+    {
+        UAudioComponent* Sound = Effect.Sounds[TakeComponent(Effect.Sounds, Effect.NextSound)];
+        Sound->SetWorldLocation(SoundLocation);
+        Sound->Play();
+    }
+
+    if(Effect.Particles.Num() > 0)
+    {
+        UParticleSystemComponent* Particles = Effect.Particles[TakeComponent(Effect.Particles, Effect.NextParticles)];
+        Particles->SetWorldLocation(ParticleLocation);
+        Particles->Activate(true);
+    }
+
+    UpdateMetrics();
+}
+
+void FCubeEffectPool::UpdateMetrics() const
+{
+    int32 NumActive = 0;
+    int32 Capacity = 0;
+
+    for(const FEffect& Effect : Effects)
+    {
+        for(UAudioComponent* Sound : Effect.Sounds)
+        {
+            NumActive += IsPlaying(Sound) ? 1 : 0;
+        }
+
+        for(UParticleSystemComponent* Particles : Effect.Particles)
+        {
+            NumActive += IsPlaying(Particles) ? 1 : 0;
+        }
+
+        Capacity += Effect.Sounds.Num() + Effect.Particles.Num();
+    }
+
+    FCubeMetrics::SetGauge(ECubeGauge::EffectPoolActive, NumActive);
+    FCubeMetrics::SetGauge(ECubeGauge::EffectPoolCapacity, Capacity);
+}
+
+void FCubeEffectPool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    for(FEffect& Effect : Effects)
+    {
+        Collector.AddReferencedObjects(Effect.Sounds);
+        Collector.AddReferencedObjects(Effect.Particles);
+    }
+}
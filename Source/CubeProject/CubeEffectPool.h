@@ -0,0 +1,70 @@
+#pragma once
+
+/** The effects played during a match. Each effect has a sound, a particle system, or both. */
+namespace ECubeEffect
+{
+    enum Type
+    {
+        BallHitWall,
+        BallHitPlayer,
+        /** The ball entering a goal, with the ball's explosion. */
+        Goal,
+        PlayerSpin,
+        WinGame,
+
+        Count
+    };
+}
+
+/**
+ * Plays the sounds and particle effects of a match with components created once, when the game mode begins play, instead
+ * of spawning a component for every bounce. Each effect has a ring of components: a component is reused once its effect
+ * is done, and the oldest one is restarted if every component of the ring is still playing. Hence, playing an effect
+ * never creates an object, and the number of components in use is exported through the EffectPool gauges.
+ */
+class CUBEPROJECT_API FCubeEffectPool : public FGCObject
+{
+public:
+    /** The number of components of each effect. Spins get one per player, since every player may spin at once. */
+    static constexpr int32 DEFAULT_CAPACITY = 4;
+
+    /** Creates the pool. The components are owned by the given actor, which is usually the game mode. */
+    explicit FCubeEffectPool(AActor* InOwner);
+    virtual ~FCubeEffectPool();
+
+    /** Creates the components of an effect. Either asset may be NULL, in which case that part of the effect is not played. */
+    void AddEffect(ECubeEffect::Type Effect, USoundBase* Sound, UParticleSystem* Particles, int32 Capacity = DEFAULT_CAPACITY);
+
+    /** Plays an effect, with its sound and its particles at different locations. */
+    void Play(ECubeEffect::Type Effect, const FVector& SoundLocation, const FVector& ParticleLocation);
+
+    /** Plays an effect at the given location. */
+    FORCEINLINE void Play(ECubeEffect::Type Effect, const FVector& Location) { Play(Effect, Location, Location); }
+
+    /** Sets the EffectPool gauges to the number of components playing and the total number of components. */
+    void UpdateMetrics() const;
+
+    // FGCObject interface
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+private:
+    /** The components of an effect. */
+    struct FEffect
+    {
+        TArray<UAudioComponent*> Sounds;
+        TArray<UParticleSystemComponent*> Particles;
+        /** The next component to use in each ring. */
+        int32 NextSound;
+        int32 NextParticles;
+    };
+
+    /** Returns the index of the component to use next in a ring: the first one which is done from the ring's start, or the
+      * start itself if every component is playing. */
+    template<typename ComponentType>
+    static int32 TakeComponent(const TArray<ComponentType*>& Components, int32& Next);
+
+    /** The actor owning the components. */
+    AActor* Owner;
+
+    FEffect Effects[ECubeEffect::Count];
+};
@@ -0,0 +1,455 @@
+#include "CubeProject.h"
+#include "CubeFuzz.h"
+#include "CubeMatchSave.h"
+#include "CubeProjectGameState.h"
+
+namespace
+{
+    /** The longest time an input is held in a fuzzed case, in ticks. */
+    const int32 MAX_HOLD_TICKS = 30;
+    /** The number of tries at placing the ball out of the walls of a generated arena before it is placed at the center. */
+    const int32 MAX_PLACEMENT_TRIES = 8;
+
+    /** Returns a random integer in [0, Max). */
+    int32 RandomInt(FCubeRandomStream& Stream, int32 Max)
+    {
+        return (int32)(Stream.GetUnsignedInt() % (uint32)Max);
+    }
+
+    bool RandomChance(FCubeRandomStream& Stream, float Probability)
+    {
+        return Stream.GetFraction() < Probability;
+    }
+
+    /** Returns a random unit vector. */
+    FVector2D RandomDirection(FCubeRandomStream& Stream)
+    {
+        const FVector2D Direction = CubeSim::SafeNormal(FVector2D(Stream.GetRange(-1.0f, 1.0f), Stream.GetRange(-1.0f, 1.0f)));
+        return (Direction.X != 0.0f || Direction.Y != 0.0f) ? Direction : FVector2D(1.0f, 0.0f);
+    }
+
+    /** Returns a random location where a circle of the given radius fits in the arena's box. */
+    FVector2D RandomLocation(FCubeRandomStream& Stream, const FCubeSimArena& Arena, float Radius)
+    {
+        return FVector2D(Stream.GetRange(Arena.LeftGoalLineY + Radius, Arena.RightGoalLineY - Radius),
+                         Stream.GetRange(Arena.FloorZ + Radius, Arena.CeilingZ - Radius));
+    }
+
+    /** Returns a random movement input: none, one of the eight directions, any direction or a barely moved stick. */
+    FVector2D RandomMove(FCubeRandomStream& Stream)
+    {
+        switch(RandomInt(Stream, 4))
+        {
+            case 0:
+                return FVector2D::ZeroVector;
+            case 1:
+                return FVector2D((float)(RandomInt(Stream, 3) - 1), (float)(RandomInt(Stream, 3) - 1));
+            case 2:
+                return FVector2D(Stream.GetRange(-1.0f, 1.0f), Stream.GetRange(-1.0f, 1.0f));
+            default:
+                return FVector2D(Stream.GetRange(-0.05f, 0.05f), Stream.GetRange(-0.05f, 0.05f));
+        }
+    }
+
+    bool IsFinite(const FVector2D& Vector)
+    {
+        return FMath::IsFinite(Vector.X) && FMath::IsFinite(Vector.Y);
+    }
+
+    bool IsNeutral(const FCubeSimInput& Input)
+    {
+        return Input.MoveX == 0 && Input.MoveY == 0 && !Input.bSpin;
+    }
+
+    FCubeFuzzFailure MakeFailure(ECubeFuzzInvariant::Type Invariant, int32 Tick, int32 Slot, float Value)
+    {
+        FCubeFuzzFailure Failure;
+        Failure.Invariant = Invariant;
+        Failure.Tick = Tick;
+        Failure.Slot = Slot;
+        Failure.Value = Value;
+        return Failure;
+    }
+
+    /** Checks the invariants after a tick. The tick at which each pawn last spun is updated. */
+    bool CheckTick(const FCubeReplayPlayer& Player, const FCubeSimEvents& Events, int32 Tick, int32* LastSpinTicks, FCubeFuzzFailure& OutFailure)
+    {
+        const FCubeMatchState& State = Player.GetState();
+        const FCubeSimConfig& Config = Player.GetConfig();
+        const FCubeSimArena& Arena = Config.Arena;
+        const FCubeSimBall& Ball = State.Ball;
+
+        if(!IsFinite(Ball.Location) || !IsFinite(Ball.Direction) || !FMath::IsFinite(Ball.Speed))
+        {
+            OutFailure = MakeFailure(ECubeFuzzInvariant::Finite, Tick, INDEX_NONE, Ball.Speed);
+            return false;
+        }
+
+        for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+        {
+            if(!IsFinite(State.Pawns[Slot].Location) || !IsFinite(State.Pawns[Slot].Velocity))
+            {
+                OutFailure = MakeFailure(ECubeFuzzInvariant::Finite, Tick, Slot, State.Pawns[Slot].Velocity.X);
+                return false;
+            }
+        }
+
+        for(int32 Team = 0; Team < FCubePlayerRegistry::TEAM_COUNT; Team++)
+        {
+            if(State.Scores[Team] > Player.GetScoreToWin())
+            {
+                OutFailure = MakeFailure(ECubeFuzzInvariant::ScoreToWin, Tick, INDEX_NONE, State.Scores[Team]);
+                return false;
+            }
+        }
+
+        // A goal resets the field and the cooldowns, or ends the match with the ball in the goal
+        if(Events.ScoringTeam != INDEX_NONE)
+        {
+            for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+            {
+                LastSpinTicks[Slot] = MIN_int32 / 2;
+            }
+
+            return true;
+        }
+
+        // A pawn's cooldown is only ever set to its full length by a spin
+        const int32 SpinCooldownTicks = Config.SpinCooldownTicks;
+
+        for(int32 Slot = 0; Slot < State.NumPlayers && SpinCooldownTicks > 0; Slot++)
+        {
+            if(State.Pawns[Slot].SpinCooldownTicks != SpinCooldownTicks)
+                continue;
+
+            if(Tick - LastSpinTicks[Slot] <= SpinCooldownTicks)
+            {
+                OutFailure = MakeFailure(ECubeFuzzInvariant::SpinCooldown, Tick, Slot, (float)(Tick - LastSpinTicks[Slot]));
+                return false;
+            }
+
+            LastSpinTicks[Slot] = Tick;
+        }
+
+        const float BallSpeed = CubeSim::Size(CubeSim::GetBallVelocity(Ball.Direction, Ball.Speed, Config.BallRules));
+
+        if(BallSpeed < Config.BallRules.MinSpeed * (1.0f - CubeFuzz::SPEED_TOLERANCE) || BallSpeed > Config.BallRules.MaxSpeed * (1.0f + CubeFuzz::SPEED_TOLERANCE))
+        {
+            OutFailure = MakeFailure(ECubeFuzzInvariant::BallSpeed, Tick, INDEX_NONE, BallSpeed);
+            return false;
+        }
+
+        const float Radius = Config.BallRadius - CubeFuzz::POSITION_TOLERANCE;
+        const bool bPastGoalLine = Ball.Location.X - Radius < Arena.LeftGoalLineY || Ball.Location.X + Radius > Arena.RightGoalLineY;
+
+        if(bPastGoalLine && FMath::Abs(Ball.Location.Y - Arena.GoalCenterZ) < Arena.GoalHalfHeight)
+        {
+            OutFailure = MakeFailure(ECubeFuzzInvariant::NoGoalTunneling, Tick, INDEX_NONE, Ball.Location.X);
+            return false;
+        }
+
+        if(bPastGoalLine || Ball.Location.Y - Radius < Arena.FloorZ || Ball.Location.Y + Radius > Arena.CeilingZ)
+        {
+            OutFailure = MakeFailure(ECubeFuzzInvariant::BallInArena, Tick, INDEX_NONE, bPastGoalLine ? Ball.Location.X : Ball.Location.Y);
+            return false;
+        }
+
+        return true;
+    }
+
+    /** Cuts the inputs after the given number of ticks. */
+    void Truncate(FCubeReplay& Case, int32 NumTicks)
+    {
+        if(NumTicks < Case.NumTicks())
+        {
+            Case.Inputs.SetNum(NumTicks * Case.Start.NumPlayers);
+        }
+    }
+
+    /** Replaces a case with a smaller one if it breaks the same invariant. Returns true if it does. */
+    bool TryCandidate(FCubeReplay& Case, FCubeFuzzFailure& Failure, FCubeReplay& Candidate, int32& InOutNumRuns)
+    {
+        FCubeFuzzFailure CandidateFailure;
+        uint64 TicksPlayed = 0;
+        InOutNumRuns++;
+
+        if(CubeFuzz::CheckCase(Candidate, CandidateFailure, TicksPlayed) || CandidateFailure.Invariant != Failure.Invariant)
+            return false;
+
+        Case = Candidate;
+        Failure = CandidateFailure;
+        Truncate(Case, Failure.Tick + 1);
+        return true;
+    }
+
+    /** Returns a copy of a case without the given player. The players after it move down a slot, and change team. */
+    void RemovePlayer(const FCubeReplay& Case, int32 RemovedSlot, FCubeReplay& OutCandidate)
+    {
+        const int32 NumPlayers = Case.Start.NumPlayers;
+        const int32 NumTicks = Case.NumTicks();
+
+        OutCandidate.Start = Case.Start;
+        OutCandidate.bGeneratedArena = Case.bGeneratedArena;
+        OutCandidate.ArenaParams = Case.ArenaParams;
+        OutCandidate.Start.NumPlayers = (uint8)(NumPlayers - 1);
+        OutCandidate.ArenaParams.NumPlayers = NumPlayers - 1;
+
+        for(int32 Slot = RemovedSlot; Slot < NumPlayers - 1; Slot++)
+        {
+            OutCandidate.Start.Pawns[Slot] = Case.Start.Pawns[Slot + 1];
+        }
+
+        FMemory::Memzero(OutCandidate.Start.Pawns[NumPlayers - 1]);
+
+        int8& LastPlayerHit = OutCandidate.Start.Ball.LastPlayerHit;
+        LastPlayerHit = (LastPlayerHit == RemovedSlot) ? (int8)INDEX_NONE : (LastPlayerHit > RemovedSlot) ? (int8)(LastPlayerHit - 1) : LastPlayerHit;
+
+        OutCandidate.Inputs.Reset(NumTicks * (NumPlayers - 1));
+
+        for(int32 Tick = 0; Tick < NumTicks; Tick++)
+        {
+            for(int32 Slot = 0; Slot < NumPlayers; Slot++)
+            {
+                if(Slot != RemovedSlot)
+                {
+                    OutCandidate.Inputs.Add(Case.GetInputs(Tick)[Slot]);
+                }
+            }
+        }
+    }
+}
+
+void CubeFuzz::GenerateCase(uint64 Seed, int32 NumTicks, FCubeReplay& OutCase)
+{
+    FCubeRandomStream Stream(Seed, ECubeRandomStream::Tools);
+    const int32 NumPlayers = 1 + RandomInt(Stream, FCubePlayerRegistry::MAX_PLAYERS);
+
+    // Play a quarter of the cases in generated arenas, whose cooked walls collide differently from the default box
+    FCubeSimConfig Config;
+    FCubeGeneratedArena GeneratedArena;
+    FCubeArenaGeometry Geometry;
+
+    OutCase.bGeneratedArena = RandomChance(Stream, 0.25f);
+    OutCase.ArenaParams = FCubeArenaParams();
+    OutCase.ArenaParams.NumPlayers = NumPlayers;
+
+    if(OutCase.bGeneratedArena)
+    {
+        FCubeArenaParams& Params = OutCase.ArenaParams;
+        Params.HalfLength = Stream.GetRange(500.0f, 1200.0f);
+        Params.HalfHeight = Stream.GetRange(150.0f, 400.0f);
+        Params.GoalHalfHeight = Stream.GetRange(40.0f, Params.HalfHeight);
+        Params.CornerRadius = RandomChance(Stream, 0.5f) ? Stream.GetRange(0.0f, 150.0f) : 0.0f;
+        Params.ObstacleLayout = (ECubeObstacleLayout::Type)RandomInt(Stream, ECubeObstacleLayout::Count);
+        Params.NumObstacles = RandomInt(Stream, 13);
+        Params.ObstacleHalfSize = Stream.GetRange(15.0f, 60.0f);
+        Params.Seed = Stream.GetUnsignedInt();
+
+        CubeArenaGenerator::Generate(Params, GeneratedArena);
+        CubeArenaGenerator::BuildGeometry(GeneratedArena, Geometry);
+        Config.Arena = GeneratedArena.Arena;
+        Config.Geometry = &Geometry;
+    }
+
+    const FCubeSimArena& Arena = Config.Arena;
+
+    FCubeMatchState State;
+    FMemory::Memzero(State);
+    State.NumPlayers = NumPlayers;
+
+    FVector2D StartLocations[FCubePlayerRegistry::MAX_PLAYERS];
+    CubeSim::GetDefaultStartLocations(Arena, NumPlayers, StartLocations);
+
+    const int32 ScoreToWin = 1 + RandomInt(Stream, 5);
+    State.Scores[0] = (uint8)RandomInt(Stream, ScoreToWin);
+    State.Scores[1] = (uint8)RandomInt(Stream, ScoreToWin);
+
+    for(int32 Slot = 0; Slot < NumPlayers; Slot++)
+    {
+        FCubeSimPawn& Pawn = State.Pawns[Slot];
+        Pawn.Location = RandomLocation(Stream, Arena, Config.PawnRadius);
+        Pawn.Velocity = RandomDirection(Stream) * Stream.GetRange(0.0f, 1.5f * Config.PawnRules.MaxSpeed);
+        Pawn.SpinCooldownTicks = (uint16)RandomInt(Stream, Config.SpinCooldownTicks + 1);
+    }
+
+    // Spawn the ball anywhere, at a pawn's center, or just touching a pawn. Like the kickoff spot, it is always inside the
+    // arena and clear of the walls.
+    FCubeSimBall& Ball = State.Ball;
+    FCubeArenaContact Contact;
+
+    for(int32 Try = 0;; Try++)
+    {
+        if(Try == MAX_PLACEMENT_TRIES)
+        {
+            Ball.Location = FVector2D::ZeroVector;
+            break;
+        }
+
+        const int32 Placement = RandomInt(Stream, 3);
+        const FCubeSimPawn& NearPawn = State.Pawns[RandomInt(Stream, NumPlayers)];
+
+        if(Placement == 1)
+        {
+            Ball.Location = NearPawn.Location;
+        }
+        else if(Placement == 2)
+        {
+            Ball.Location = NearPawn.Location + RandomDirection(Stream) * ((Config.BallRadius + Config.PawnRadius) * Stream.GetRange(0.9f, 1.0f));
+        }
+        else
+        {
+            Ball.Location = RandomLocation(Stream, Arena, Config.BallRadius);
+        }
+
+        const bool bInArena = Ball.Location.X - Config.BallRadius >= Arena.LeftGoalLineY && Ball.Location.X + Config.BallRadius <= Arena.RightGoalLineY
+                           && Ball.Location.Y - Config.BallRadius >= Arena.FloorZ && Ball.Location.Y + Config.BallRadius <= Arena.CeilingZ;
+
+        if(bInArena && !(Config.Geometry && Config.Geometry->OverlapCircle(Ball.Location, Config.BallRadius, Contact)))
+            break;
+    }
+
+    // The ball's direction is not a unit vector once a pawn's velocity was added to it
+    Ball.Direction = RandomDirection(Stream) * Stream.GetRange(0.5f, 1.5f);
+    Ball.Speed = Stream.GetRange(Config.BallRules.MinSpeed, Config.BallRules.MaxSpeed);
+    Ball.HitCooldownTicks = (uint16)RandomInt(Stream, Config.HitCooldownTicks + 1);
+    Ball.LastPlayerHit = RandomChance(Stream, 0.5f) ? (int8)RandomInt(Stream, NumPlayers) : (int8)INDEX_NONE;
+
+    FCubeMatchSaveRecord& Start = OutCase.Start;
+    CubeMatchSave::InitRecord(Start);
+    CubeMatchSave::CaptureSimState(State, Config, StartLocations, Start);
+    Start.Seed = Seed;
+    Start.FlowState = EGameState::PLAYING;
+    Start.ScoreToWin = (uint8)ScoreToWin;
+
+    // Each player holds random inputs for random durations, mashing the spin button now and then
+    OutCase.Inputs.SetNumZeroed(NumTicks * NumPlayers);
+
+    for(int32 Slot = 0; Slot < NumPlayers; Slot++)
+    {
+        for(int32 Tick = 0; Tick < NumTicks;)
+        {
+            const int32 HoldTicks = 1 + RandomInt(Stream, MAX_HOLD_TICKS);
+            const FVector2D Move = RandomMove(Stream);
+            const float SpinProbability = RandomChance(Stream, 0.3f) ? 0.5f : 0.02f;
+
+            for(int32 HoldEnd = FMath::Min(Tick + HoldTicks, NumTicks); Tick < HoldEnd; Tick++)
+            {
+                OutCase.Inputs[Tick * NumPlayers + Slot] = CubeSim::MakeInput(Move.X, Move.Y, RandomChance(Stream, SpinProbability));
+            }
+        }
+    }
+}
+
+bool CubeFuzz::CheckCase(const FCubeReplay& Case, FCubeFuzzFailure& OutFailure, uint64& InOutTicksPlayed)
+{
+    FCubeReplayPlayer Player(Case);
+
+    // A pawn which starts with some cooldown left spun before the case started
+    const int32 SpinCooldownTicks = Player.GetConfig().SpinCooldownTicks;
+    int32 LastSpinTicks[FCubePlayerRegistry::MAX_PLAYERS];
+
+    for(int32 Slot = 0; Slot < Case.Start.NumPlayers; Slot++)
+    {
+        const int32 CooldownLeft = Case.Start.Pawns[Slot].SpinCooldownTicks;
+        LastSpinTicks[Slot] = (CooldownLeft > 0) ? -1 - (SpinCooldownTicks - CooldownLeft) : MIN_int32 / 2;
+    }
+
+    while(!Player.IsOver())
+    {
+        const int32 Tick = Player.GetNumTicksPlayed();
+        const FCubeSimEvents Events = Player.Tick();
+
+        if(!CheckTick(Player, Events, Tick, LastSpinTicks, OutFailure))
+        {
+            InOutTicksPlayed += Player.GetNumTicksPlayed();
+            return false;
+        }
+    }
+
+    InOutTicksPlayed += Player.GetNumTicksPlayed();
+    return true;
+}
+
+int32 CubeFuzz::Shrink(FCubeReplay& InOutCase, FCubeFuzzFailure& InOutFailure)
+{
+    int32 NumRuns = 0;
+    FCubeReplay Candidate;
+
+    Truncate(InOutCase, InOutFailure.Tick + 1);
+
+    // Remove the players which take no part in the failure
+    for(int32 Slot = InOutCase.Start.NumPlayers - 1; Slot >= 0 && InOutCase.Start.NumPlayers > 1 && NumRuns < MAX_SHRINK_RUNS; Slot--)
+    {
+        RemovePlayer(InOutCase, FMath::Min(Slot, InOutCase.Start.NumPlayers - 1), Candidate);
+        TryCandidate(InOutCase, InOutFailure, Candidate, NumRuns);
+    }
+
+    // Remove ticks, in chunks of halving size, then clear the inputs of the remaining ones, all players at once
+    for(int32 Pass = 0; Pass < 2; Pass++)
+    {
+        for(int32 ChunkTicks = InOutCase.NumTicks() / 2; ChunkTicks >= 1 && NumRuns < MAX_SHRINK_RUNS; ChunkTicks /= 2)
+        {
+            for(int32 FirstTick = 0; FirstTick < InOutCase.NumTicks() && NumRuns < MAX_SHRINK_RUNS;)
+            {
+                const int32 NumPlayers = InOutCase.Start.NumPlayers;
+                const int32 ChunkEnd = FMath::Min(FirstTick + ChunkTicks, InOutCase.NumTicks());
+
+                Candidate = InOutCase;
+
+                if(Pass == 0)
+                {
+                    Candidate.Inputs.RemoveAt(FirstTick * NumPlayers, (ChunkEnd - FirstTick) * NumPlayers, false);
+                }
+                else
+                {
+                    bool bAllNeutral = true;
+
+                    for(int32 Index = FirstTick * NumPlayers; Index < ChunkEnd * NumPlayers; Index++)
+                    {
+                        bAllNeutral &= IsNeutral(Candidate.Inputs[Index]);
+                        Candidate.Inputs[Index] = FCubeSimInput();
+                    }
+
+                    if(bAllNeutral)
+                    {
+                        FirstTick = ChunkEnd;
+                        continue;
+                    }
+                }
+
+                // A removed chunk is tried again at the same place, as the ticks after it moved up
+                if(!TryCandidate(InOutCase, InOutFailure, Candidate, NumRuns) || Pass == 1)
+                {
+                    FirstTick = ChunkEnd;
+                }
+            }
+        }
+    }
+
+    // Clear each remaining input, or at least its spin
+    for(int32 Index = 0; Index < InOutCase.Inputs.Num() && NumRuns < MAX_SHRINK_RUNS; Index++)
+    {
+        if(IsNeutral(InOutCase.Inputs[Index]))
+            continue;
+
+        Candidate = InOutCase;
+        Candidate.Inputs[Index] = FCubeSimInput();
+
+        if(!TryCandidate(InOutCase, InOutFailure, Candidate, NumRuns) && InOutCase.Inputs[Index].bSpin)
+        {
+            Candidate = InOutCase;
+            Candidate.Inputs[Index].bSpin = false;
+            TryCandidate(InOutCase, InOutFailure, Candidate, NumRuns);
+        }
+    }
+
+    return NumRuns;
+}
+
+const TCHAR* CubeFuzz::GetInvariantName(ECubeFuzzInvariant::Type Invariant)
+{
+    static const TCHAR* Names[ECubeFuzzInvariant::Count] = { TEXT("Finite"), TEXT("BallSpeed"), TEXT("BallInArena"), TEXT("NoGoalTunneling"),
+                                                             TEXT("SpinCooldown"), TEXT("ScoreToWin") };
+
+    return Names[Invariant];
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CubeReplay.h"
+
+/** The gameplay invariants checked by the fuzzer after every tick. */
+namespace ECubeFuzzInvariant
+{
+    enum Type
+    {
+        /** Every position, direction, velocity and speed is a finite number. */
+        Finite,
+        /** The ball moves at a speed within [MinSpeed, MaxSpeed], as clamped by ABall::UpdateVelocity(). */
+        BallSpeed,
+        /** The ball stays between the floor, the ceiling and the goal lines. */
+        BallInArena,
+        /** The ball only crosses a goal line inside its mouth by scoring. */
+        NoGoalTunneling,
+        /** A pawn never spins again before its spin cooldown elapses. */
+        SpinCooldown,
+        /** No team scores more than the score to win. */
+        ScoreToWin,
+
+        Count
+    };
+}
+
+/** The first invariant broken by a fuzzed case. */
+struct FCubeFuzzFailure
+{
+    ECubeFuzzInvariant::Type Invariant;
+    /** The index of the tick after which the invariant was broken. */
+    int32 Tick;
+    /** The slot of the pawn which broke the invariant, or INDEX_NONE. */
+    int32 Slot;
+    /** The value which broke the invariant, e.g., the ball's speed. */
+    float Value;
+};
+
+/**
+ * Property-based fuzzing of the match simulation. Each case is drawn from a seed: the number of players, the arena (the
+ * default one or a generated one), the score, the positions and velocities of the ball and pawns, including degenerate
+ * ones such as a ball at a pawn's center, and the inputs of every player, held for random durations with spins mashed.
+ * The case is played with FCubeReplayPlayer and the invariants are checked after every tick. A failing case is shrunk to
+ * the shortest inputs and fewest players which still break the same invariant, and saved as a replay.
+ */
+namespace CubeFuzz
+{
+    /** The distance by which the ball may overlap a wall or goal line, to allow for the rounding of the collision. */
+    static constexpr float POSITION_TOLERANCE = 0.5f;
+    /** The relative error allowed on the ball's speed bounds. */
+    static constexpr float SPEED_TOLERANCE = 0.001f;
+    /** The maximum number of times a failing case is played while it is shrunk. */
+    static constexpr int32 MAX_SHRINK_RUNS = 4000;
+
+    /** Draws a case of the given number of ticks from a seed. */
+    CUBEPROJECT_API void GenerateCase(uint64 Seed, int32 NumTicks, FCubeReplay& OutCase);
+
+    /** Plays a case and checks the invariants after every tick. Returns false, with the first invariant broken, if the case
+      * fails. Adds the number of ticks played to InOutTicksPlayed. */
+    CUBEPROJECT_API bool CheckCase(const FCubeReplay& Case, FCubeFuzzFailure& OutFailure, uint64& InOutTicksPlayed);
+
+    /** Shrinks a failing case: cuts the inputs after the failure, removes ticks and players, and clears inputs, as long as
+      * the case still breaks the same invariant. Returns the number of times the case was played. */
+    CUBEPROJECT_API int32 Shrink(FCubeReplay& InOutCase, FCubeFuzzFailure& InOutFailure);
+
+    /** Returns the name of an invariant. */
+    CUBEPROJECT_API const TCHAR* GetInvariantName(ECubeFuzzInvariant::Type Invariant);
+}
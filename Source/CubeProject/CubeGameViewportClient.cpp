@@ -0,0 +1,73 @@
+#include "CubeProject.h"
+#include "CubeGameViewportClient.h"
+#include "CubePlayerRegistry.h"
+#include "GameFramework/InputSettings.h"
+
+bool UCubeGameViewportClient::InputKey(FViewport* InViewport, int32 ControllerId, FKey Key, EInputEvent EventType, float AmountDepressed,
+                                       bool bGamepad)
+{
+    // Gamepads already send their input to the controller they belong to. Only keyboard keys need to be routed.
+    if(!bGamepad && !Key.IsGamepadKey())
+    {
+        if(!bKeySlotsBuilt)
+        {
+            BuildKeySlots();
+        }
+
+        const int32* KeySlot = KeySlots.Find(Key);
+
+        // Only route the key if the player owning it has joined the game. Otherwise, let the first player handle it.
+        if(KeySlot && GetGameInstance() && GetGameInstance()->FindLocalPlayerFromControllerId(*KeySlot))
+        {
+            ControllerId = *KeySlot;
+        }
+    }
+
+    return Super::InputKey(InViewport, ControllerId, Key, EventType, AmountDepressed, bGamepad);
+}
+
+void UCubeGameViewportClient::BuildKeySlots()
+{
+    const UInputSettings* InputSettings = GetDefault<UInputSettings>();
+
+    for(const FInputAxisKeyMapping& AxisMapping : InputSettings->AxisMappings)
+    {
+        const int32 Slot = GetSlotFromMappingName(AxisMapping.AxisName);
+
+        if(Slot != INDEX_NONE && !AxisMapping.Key.IsGamepadKey())
+        {
+            KeySlots.Add(AxisMapping.Key, Slot);
+        }
+    }
+
+    for(const FInputActionKeyMapping& ActionMapping : InputSettings->ActionMappings)
+    {
+        const int32 Slot = GetSlotFromMappingName(ActionMapping.ActionName);
+
+        if(Slot != INDEX_NONE && !ActionMapping.Key.IsGamepadKey())
+        {
+            KeySlots.Add(ActionMapping.Key, Slot);
+        }
+    }
+
+    bKeySlotsBuilt = true;
+}
+
+int32 UCubeGameViewportClient::GetSlotFromMappingName(const FName& MappingName)
+{
+    const FString Name = MappingName.ToString();
+    const int32 SuffixIndex = Name.Find(TEXT("_P"), ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+
+    if(SuffixIndex == INDEX_NONE)
+        return INDEX_NONE;
+
+    // The mappings are numbered from 1 ("_P1") whereas the player slots are numbered from 0
+    const FString PlayerNumber = Name.Mid(SuffixIndex + 2);
+
+    if(!PlayerNumber.IsNumeric())
+        return INDEX_NONE;
+
+    const int32 Slot = FCString::Atoi(*PlayerNumber) - 1;
+
+    return FCubePlayerRegistry::IsValidSlot(Slot) ? Slot : INDEX_NONE;
+}
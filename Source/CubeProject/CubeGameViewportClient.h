@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Engine/GameViewportClient.h"
+#include "CubeGameViewportClient.generated.h"
+
+/**
+ * Game viewport which lets several local players share the keyboard. Unreal sends every keyboard key to the first
+ * local player. This viewport sends each key mapped to a "_P<n>" input (e.g., "MoveY_P2") to the controller of player n,
+ * so that every pawn only needs to bind its own input.
+ */
+UCLASS()
+class CUBEPROJECT_API UCubeGameViewportClient : public UGameViewportClient
+{
+    GENERATED_BODY()
+
+public:
+    /** Routes keyboard keys to the controller of the player they are mapped to before handling them as usual. */
+    virtual bool InputKey(FViewport* InViewport, int32 ControllerId, FKey Key, EInputEvent EventType, float AmountDepressed = 1.f,
+                          bool bGamepad = false) override;
+
+private:
+    /** Fills 'KeySlots' using the "_P<n>" axis and action mappings in the input settings. */
+    void BuildKeySlots();
+
+    /** Returns the player slot encoded in the given mapping name (e.g., 1 for "MoveY_P2"), or INDEX_NONE if there is none. */
+    static int32 GetSlotFromMappingName(const FName& MappingName);
+
+    /** Stores the player slot owning each keyboard key. */
+    TMap<FKey, int32> KeySlots;
+
+    /** True once 'KeySlots' has been built from the input settings. */
+    bool bKeySlotsBuilt = false;
+};
@@ -0,0 +1,266 @@
+#include "CubeProject.h"
+#include "CubeGoldenReplay.h"
+#include "CubeHostedMatch.h"
+
+namespace
+{
+    /** The longest a noisy bot holds a random input, in ticks. */
+    constexpr int32 MAX_HOLD_TICKS = 30;
+    /** The probability that a noisy bot releases the spin button on a tick during which it holds a random input. */
+    constexpr float SPIN_PROBABILITY = 0.2f;
+
+    /** Returns the bot input which the match turns into the given input. */
+    FCubeBotInput ToBotInput(const FCubeSimInput& SimInput)
+    {
+        const FVector2D Move = SimInput.GetMove();
+
+        FCubeBotInput Input;
+        Input.MoveX = Move.X;
+        Input.MoveY = Move.Y;
+        Input.bSpin = SimInput.bSpin;
+        return Input;
+    }
+
+    /** A scripted bot which leaves its strategy for random inputs now and then, and records every input it gives. */
+    class FCubeRecordingBot : public FCubeBot
+    {
+    public:
+        FCubeRecordingBot(uint64 Seed, float InNoise, TArray<FCubeSimInput>& InInputs)
+            : NoiseStream(Seed, ECubeRandomStream::Tools)
+            , Noise(InNoise)
+            , HoldTicksLeft(0)
+            , Inputs(InInputs)
+        {
+        }
+
+        virtual FCubeBotInput Think(const FCubeBotContext& Context) override
+        {
+            if(HoldTicksLeft == 0 && Noise > 0.0f && NoiseStream.GetFraction() < Noise)
+            {
+                HoldTicksLeft = 1 + (int32)(NoiseStream.GetUnsignedInt() % MAX_HOLD_TICKS);
+                HeldInput.MoveX = NoiseStream.GetRange(-1.0f, 1.0f);
+                HeldInput.MoveY = NoiseStream.GetRange(-1.0f, 1.0f);
+            }
+
+            FCubeBotInput Input;
+
+            if(HoldTicksLeft > 0)
+            {
+                HoldTicksLeft--;
+                Input = HeldInput;
+                Input.bSpin = NoiseStream.GetFraction() < SPIN_PROBABILITY;
+            }
+            else
+            {
+                Input = ScriptedBot.Think(Context);
+            }
+
+            // Record the input as the match applies it, and give the match what the replay will give it
+            const FCubeSimInput SimInput = CubeSim::MakeInput(Input.MoveX, Input.MoveY, Input.bSpin);
+            Inputs.Add(SimInput);
+            return ToBotInput(SimInput);
+        }
+
+    private:
+        FCubeScriptedBot ScriptedBot;
+        FCubeRandomStream NoiseStream;
+        float Noise;
+        int32 HoldTicksLeft;
+        FCubeBotInput HeldInput;
+        /** The inputs of the replay, to which every bot of the match adds its input in slot order. */
+        TArray<FCubeSimInput>& Inputs;
+    };
+
+    /** A bot which gives back the inputs of a player of a replay, one per simulation step. */
+    class FCubeReplayBot : public FCubeBot
+    {
+    public:
+        FCubeReplayBot(const FCubeReplay& InReplay, int32 InSlot)
+            : Replay(InReplay)
+            , Slot(InSlot)
+            , NextTick(0)
+        {
+        }
+
+        virtual FCubeBotInput Think(const FCubeBotContext& Context) override
+        {
+            if(NextTick >= Replay.NumTicks())
+                return FCubeBotInput();
+
+            return ToBotInput(Replay.GetInputs(NextTick++)[Slot]);
+        }
+
+    private:
+        const FCubeReplay& Replay;
+        int32 Slot;
+        int32 NextTick;
+    };
+
+    /** Ticks a match, and records its goals and, if bHashStates, its state after every tick. */
+    void PlayTicks(FCubeHostedMatch& Match, int32 NumTicks, bool bHashStates, FCubeGoldenValues& OutValues)
+    {
+        const FCubeMatchState& State = Match.GetState();
+        const uint32 StartTick = State.Tick;
+
+        OutValues.Goals.Reset();
+        OutValues.Hashes.Reset();
+
+        if(bHashStates)
+        {
+            OutValues.Hashes.Reserve(NumTicks);
+        }
+
+        for(int32 Tick = 0; Tick < NumTicks; Tick++)
+        {
+            const uint8 PreviousScores[FCubePlayerRegistry::TEAM_COUNT] = { State.Scores[0], State.Scores[1] };
+
+            Match.Tick();
+
+            // The scores only go down when the next match starts
+            for(int32 Team = 0; Team < FCubePlayerRegistry::TEAM_COUNT; Team++)
+            {
+                if(State.Scores[Team] > PreviousScores[Team])
+                {
+                    FCubeGoldenGoal& Goal = OutValues.Goals[OutValues.Goals.AddUninitialized()];
+                    Goal.Tick = (uint32)Tick;
+                    Goal.Team = (uint8)Team;
+                    Goal.Scores[0] = State.Scores[0];
+                    Goal.Scores[1] = State.Scores[1];
+                }
+            }
+
+            if(bHashStates)
+            {
+                FCubeStateHasher Hasher;
+                Match.HashState(Hasher);
+                OutValues.Hashes.Add(Hasher.GetHash());
+            }
+        }
+
+        OutValues.NumSteps = (int32)(State.Tick - StartTick);
+        OutValues.NumCompletedMatches = Match.GetNumCompletedMatches();
+        OutValues.FinalScores[0] = State.Scores[0];
+        OutValues.FinalScores[1] = State.Scores[1];
+    }
+}
+
+FString CubeGoldenReplay::GetCorpusDir()
+{
+    return FPaths::GameContentDir() / TEXT("GoldenReplays");
+}
+
+void CubeGoldenReplay::Record(const FCubeGoldenScenario& Scenario, FCubeReplay& OutReplay, FCubeGoldenValues& OutValues)
+{
+    OutReplay.bGeneratedArena = Scenario.bGeneratedArena;
+    OutReplay.ArenaParams = Scenario.ArenaParams;
+    OutReplay.ArenaParams.NumPlayers = Scenario.NumPlayers;
+    OutReplay.Inputs.Reset();
+
+    FCubeSimConfig Config;
+    FCubeArenaGeometry Geometry;
+    CubeReplay::MakeConfig(OutReplay, Config, Geometry);
+
+    FCubeHostedMatch Match(Config, Scenario.NumPlayers, Scenario.ScoreToWin, Scenario.Seed);
+    Match.Save(OutReplay.Start);
+
+    for(int32 Slot = 0; Slot < Scenario.NumPlayers; Slot++)
+    {
+        const uint64 BotSeed = FCubeRandomStream::Mix(Scenario.Seed + Slot + 1);
+        Match.SetBot(Slot, MakeShareable(new FCubeRecordingBot(BotSeed, Scenario.Noise, OutReplay.Inputs)));
+    }
+
+    PlayTicks(Match, Scenario.NumTicks, true, OutValues);
+}
+
+void CubeGoldenReplay::Play(const FCubeReplay& Replay, int32 NumTicks, bool bHashStates, FCubeGoldenValues& OutValues)
+{
+    FCubeSimConfig Config;
+    FCubeArenaGeometry Geometry;
+    CubeReplay::MakeConfig(Replay, Config, Geometry);
+
+    FCubeHostedMatch Match(Config, Replay.Start.NumPlayers, Replay.Start.ScoreToWin, Replay.Start.Seed);
+    Match.Resume(Replay.Start);
+
+    for(int32 Slot = 0; Slot < Replay.Start.NumPlayers; Slot++)
+    {
+        Match.SetBot(Slot, MakeShareable(new FCubeReplayBot(Replay, Slot)));
+    }
+
+    PlayTicks(Match, NumTicks, bHashStates, OutValues);
+}
+
+void CubeGoldenReplay::Write(const FCubeGoldenValues& Values, TArray<uint8>& OutData)
+{
+    FCubeGoldenHeader Header;
+    FMemory::Memzero(Header);
+    Header.Magic = FCubeGoldenHeader::MAGIC;
+    Header.Version = FCubeGoldenHeader::VERSION;
+    Header.HeaderSize = (uint16)sizeof(FCubeGoldenHeader);
+    Header.NumTicks = (uint32)Values.Hashes.Num();
+    Header.NumSteps = (uint32)Values.NumSteps;
+    Header.NumGoals = (uint32)Values.Goals.Num();
+    Header.NumCompletedMatches = (uint32)Values.NumCompletedMatches;
+    Header.FinalScores[0] = Values.FinalScores[0];
+    Header.FinalScores[1] = Values.FinalScores[1];
+
+    const int32 GoalsSize = Values.Goals.Num() * sizeof(FCubeGoldenGoal);
+    const int32 HashesSize = Values.Hashes.Num() * sizeof(uint64);
+    OutData.SetNumUninitialized(sizeof(Header) + GoalsSize + HashesSize);
+
+    FMemory::Memcpy(OutData.GetData(), &Header, sizeof(Header));
+    FMemory::Memcpy(OutData.GetData() + sizeof(Header), Values.Goals.GetData(), GoalsSize);
+    FMemory::Memcpy(OutData.GetData() + sizeof(Header) + GoalsSize, Values.Hashes.GetData(), HashesSize);
+}
+
+bool CubeGoldenReplay::Read(const uint8* Data, int32 Size, FCubeGoldenValues& OutValues)
+{
+    if(Size < (int32)sizeof(FCubeGoldenHeader))
+        return false;
+
+    FCubeGoldenHeader Header;
+    FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+    if(Header.Magic != FCubeGoldenHeader::MAGIC || Header.Version != FCubeGoldenHeader::VERSION || Header.HeaderSize != sizeof(Header))
+        return false;
+
+    const int64 GoalsSize = (int64)Header.NumGoals * sizeof(FCubeGoldenGoal);
+    const int64 HashesSize = (int64)Header.NumTicks * sizeof(uint64);
+
+    if(Size != (int64)sizeof(Header) + GoalsSize + HashesSize)
+        return false;
+
+    OutValues.NumSteps = (int32)Header.NumSteps;
+    OutValues.NumCompletedMatches = (int32)Header.NumCompletedMatches;
+    OutValues.FinalScores[0] = Header.FinalScores[0];
+    OutValues.FinalScores[1] = Header.FinalScores[1];
+
+    OutValues.Goals.SetNumUninitialized(Header.NumGoals);
+    FMemory::Memcpy(OutValues.Goals.GetData(), Data + sizeof(Header), GoalsSize);
+
+    for(const FCubeGoldenGoal& Goal : OutValues.Goals)
+    {
+        if(Goal.Tick >= Header.NumTicks || Goal.Team >= FCubePlayerRegistry::TEAM_COUNT)
+            return false;
+    }
+
+    OutValues.Hashes.SetNumUninitialized(Header.NumTicks);
+    FMemory::Memcpy(OutValues.Hashes.GetData(), Data + sizeof(Header) + GoalsSize, HashesSize);
+    return true;
+}
+
+bool CubeGoldenReplay::SaveToFile(const FCubeGoldenValues& Values, const FString& FileName)
+{
+    TArray<uint8> Data;
+    Write(Values, Data);
+    return FFileHelper::SaveArrayToFile(Data, *FileName);
+}
+
+bool CubeGoldenReplay::LoadFromFile(const FString& FileName, FCubeGoldenValues& OutValues)
+{
+    TArray<uint8> Data;
+
+    if(!FFileHelper::LoadFileToArray(Data, *FileName, FILEREAD_Silent))
+        return false;
+
+    return Read(Data.GetData(), Data.Num(), OutValues);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CubeGoldenReplayFormat.h"
+#include "CubeReplay.h"
+
+/** What a replay produced when played through the game flow (see CubeGoldenReplayFormat.h). */
+struct FCubeGoldenValues
+{
+    /** The number of simulation steps played. */
+    int32 NumSteps = 0;
+    /** The number of matches played to the end. */
+    int32 NumCompletedMatches = 0;
+    /** The scores after the last tick. */
+    uint8 FinalScores[2] = { 0, 0 };
+    TArray<FCubeGoldenGoal> Goals;
+    /** The hash of the match's state after every tick. Empty if the states were not hashed. */
+    TArray<uint64> Hashes;
+};
+
+/** A match of the golden corpus. */
+struct FCubeGoldenScenario
+{
+    /** The name of the scenario's files. */
+    const TCHAR* Name;
+    int32 NumPlayers;
+    int32 ScoreToWin;
+    /** The number of match ticks recorded. */
+    int32 NumTicks;
+    /** The seed of the match, and of the bots' noise. */
+    uint64 Seed;
+    /** True to play in the arena generated from ArenaParams, rather than in the default arena. */
+    bool bGeneratedArena;
+    FCubeArenaParams ArenaParams;
+    /** The probability that a bot leaves its strategy for random inputs, each time it has the choice. */
+    float Noise;
+};
+
+/**
+ * CubeSim golden replays: recorded matches which are played back through the game flow of FCubeHostedMatch (kickoff
+ * countdowns, resets, goals and restarts) and the match simulation, which applies the same rules as ABall and ACubePawn
+ * (see CubeSimRules.h). A match played back must give the same goals at the same ticks, the same final scores and the
+ * same state hash after every tick as when it was recorded; otherwise, a change altered the gameplay.
+ *
+ * They replay the simulation only, not the game: no world is created, so ABall, ACubePawn and ACubeProjectGameMode never
+ * run, and the corpus does not catch their regressions. A change which only affects the actors, e.g. how
+ * ABall::NotifyHit() reads the hit, or how the game mode applies inputs and schedules the game flow, keeps the corpus
+ * green. The actors apply the rules of CubeSimRules.h as well, so a change to a rule shows up here for both. The actors
+ * are checked in the game by -ActorSaveCheck (see CubeActorSaveCheck.h).
+ */
+namespace CubeGoldenReplay
+{
+    /** Returns the directory of the checked-in corpus. */
+    CUBEPROJECT_API FString GetCorpusDir();
+
+    /** Plays a scenario with scripted bots, which leave their strategy for random inputs now and then, and returns its
+      * replay and golden values. */
+    CUBEPROJECT_API void Record(const FCubeGoldenScenario& Scenario, FCubeReplay& OutReplay, FCubeGoldenValues& OutValues);
+
+    /** Plays a replay back through the game flow for the given number of match ticks. The state is only hashed after every
+      * tick if bHashStates is true. Once the replay runs out of inputs, every player stands still. */
+    CUBEPROJECT_API void Play(const FCubeReplay& Replay, int32 NumTicks, bool bHashStates, FCubeGoldenValues& OutValues);
+
+    /** Replaces the given bytes with the golden values. */
+    CUBEPROJECT_API void Write(const FCubeGoldenValues& Values, TArray<uint8>& OutData);
+
+    /** Reads golden values. Returns false if they are not valid. */
+    CUBEPROJECT_API bool Read(const uint8* Data, int32 Size, FCubeGoldenValues& OutValues);
+
+    /** Writes golden values to a file. Returns false if the file could not be written. */
+    CUBEPROJECT_API bool SaveToFile(const FCubeGoldenValues& Values, const FString& FileName);
+
+    /** Reads golden values from a file. Returns false if the file could not be read or is not valid. */
+    CUBEPROJECT_API bool LoadFromFile(const FString& FileName, FCubeGoldenValues& OutValues);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * Layout of the golden values of a replay (.gsgd file, next to the .gsrp file of the same name): what the game flow and
+ * simulation produced when the replay was recorded, so that any later change to the gameplay is caught by playing the
+ * replay again (see CubeGoldenReplay.h). A golden file is an FCubeGoldenHeader, followed by NumGoals FCubeGoldenGoal and
+ * NumTicks 64-bit hashes of the match's state (see FCubeHostedMatch::HashState()), one after each tick of the match.
+ *
+ * Like replays, golden files only use fixed-size integers, without padding. All values are little-endian. A reader
+ * rejects a file whose version or header size differ from its own.
+ */
+
+#pragma pack(push, 1)
+
+/** A goal scored during the replay. */
+struct FCubeGoldenGoal
+{
+    /** The index of the match tick during which the goal was scored. */
+    uint32 Tick;
+    /** The team which scored. */
+    uint8 Team;
+    /** The scores after the goal. */
+    uint8 Scores[2];
+};
+
+/** The start of a golden file. */
+struct FCubeGoldenHeader
+{
+    static constexpr uint32 MAGIC = 0x44475347; // "GSGD"
+    static constexpr uint16 VERSION = 1;
+
+    uint32 Magic;
+    uint16 Version;
+    /** The size of the header, to reject files written with another layout under the same version. */
+    uint16 HeaderSize;
+
+    /** The number of match ticks played, including those during which the game flow waited. */
+    uint32 NumTicks;
+    /** The number of simulation steps among them, which is the number of ticks of the replay. */
+    uint32 NumSteps;
+    uint32 NumGoals;
+    /** The number of matches played to the end. */
+    uint32 NumCompletedMatches;
+    /** The scores after the last tick. */
+    uint8 FinalScores[2];
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(FCubeGoldenGoal) == 7, "The golden goal layout must not depend on the platform");
+static_assert(sizeof(FCubeGoldenHeader) == 26, "The golden file layout must not depend on the platform");
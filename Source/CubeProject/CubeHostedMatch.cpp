@@ -0,0 +1,158 @@
+#include "CubeProject.h"
+#include "CubeHostedMatch.h"
+#include "CubeMatchSave.h"
+
+FCubeHostedMatch::FCubeHostedMatch(const FCubeSimConfig& InConfig, int32 NumPlayers, int32 InScoreToWin, uint64 InSeed)
+    : Config(InConfig)
+    , FlowState(EGameState::RESET)
+    , KickoffStream(InSeed, ECubeRandomStream::Kickoff)
+    , Seed(InSeed)
+    , ScoreToWin(FMath::Max(InScoreToWin, 1))
+    , LastScoringTeam(INDEX_NONE)
+    , NumCompletedMatches(0)
+{
+    FMemory::Memzero(State);
+    State.NumPlayers = FMath::Clamp(NumPlayers, 1, FCubePlayerRegistry::MAX_PLAYERS);
+    CubeSim::GetDefaultStartLocations(Config.Arena, State.NumPlayers, StartLocations);
+
+    for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+    {
+        Bots[Slot] = MakeShareable(new FCubeScriptedBot());
+    }
+}
+
+void FCubeHostedMatch::SetBot(int32 Slot, TSharedPtr<FCubeBot> Bot)
+{
+    if(Slot >= 0 && Slot < State.NumPlayers && Bot.IsValid())
+    {
+        Bots[Slot] = Bot;
+    }
+}
+
+void FCubeHostedMatch::Tick()
+{
+    switch(FlowState)
+    {
+        case EGameState::RESET:
+        {
+            CubeSim::ResetField(State, StartLocations);
+
+            TimerWheel.Cancel(FlowTimerHandle);
+            FlowTimerHandle = TimerWheel.Schedule(ACubeProjectGameState::SecondsToTicks(ACubeProjectGameState::GAME_START_TIMER_DURATION),
+                                                  FSimpleDelegate::CreateRaw(this, &FCubeHostedMatch::OnGameStart));
+            FlowState = EGameState::WAITING_TO_START;
+            break;
+        }
+        case EGameState::PUSH_BALL:
+        {
+            // Push the ball away from the team which scored last, like ACubeProjectGameMode::PushBall()
+            CubeSim::Kickoff(State, Config, KickoffStream, LastScoringTeam != 1);
+            FlowState = EGameState::PLAYING;
+            break;
+        }
+        case EGameState::PLAYING:
+        {
+            FCubeSimInput Inputs[FCubePlayerRegistry::MAX_PLAYERS];
+            FCubeBotContext Context;
+
+            for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+            {
+                FCubeBot::MakeSimContext(State, Config, Slot, Context);
+                Context.MatchSeed = Seed;
+
+                const FCubeBotInput Input = Bots[Slot]->Think(Context);
+                Inputs[Slot] = CubeSim::MakeInput(Input.MoveX, Input.MoveY, Input.bSpin);
+            }
+
+            const FCubeSimEvents Events = CubeSim::Step(State, Config, Inputs);
+
+            if(Events.ScoringTeam != INDEX_NONE)
+            {
+                LastScoringTeam = Events.ScoringTeam;
+                FlowState = (State.Scores[Events.ScoringTeam] >= ScoreToWin) ? EGameState::GAME_OVER : EGameState::RESET;
+            }
+
+            break;
+        }
+        case EGameState::GAME_OVER:
+        {
+            NumCompletedMatches++;
+
+            TimerWheel.Cancel(FlowTimerHandle);
+            FlowTimerHandle = TimerWheel.Schedule(RESTART_DELAY_TICKS, FSimpleDelegate::CreateRaw(this, &FCubeHostedMatch::OnRestart));
+            FlowState = EGameState::WAITING_TO_RESTART;
+            break;
+        }
+        default:
+            // Wait for a timer to move the match to its next state
+            break;
+    }
+
+    TimerWheel.Advance();
+}
+
+void FCubeHostedMatch::OnGameStart()
+{
+    FlowState = EGameState::PUSH_BALL;
+}
+
+void FCubeHostedMatch::OnRestart()
+{
+    State.Scores[0] = 0;
+    State.Scores[1] = 0;
+    LastScoringTeam = INDEX_NONE;
+    FlowState = EGameState::RESET;
+}
+
+void FCubeHostedMatch::Save(FCubeMatchSaveRecord& OutRecord) const
+{
+    CubeMatchSave::InitRecord(OutRecord);
+    CubeMatchSave::CaptureSimState(State, Config, StartLocations, OutRecord);
+
+    OutRecord.Seed = Seed;
+    OutRecord.KickoffDraws = KickoffStream.GetCounter();
+    OutRecord.FlowState = (uint8)FlowState;
+    OutRecord.FlowTimerTicks = TimerWheel.GetRemainingTicks(FlowTimerHandle);
+    OutRecord.ScoreToWin = (uint8)FMath::Min(ScoreToWin, (int32)MAX_uint8);
+    OutRecord.LastScoringTeam = (int8)LastScoringTeam;
+}
+
+bool FCubeHostedMatch::Resume(const FCubeMatchSaveRecord& Record)
+{
+    if(Record.NumPlayers != State.NumPlayers)
+        return false;
+
+    CubeMatchSave::RestoreSimState(Record, State, StartLocations);
+
+    Seed = Record.Seed;
+    KickoffStream = FCubeRandomStream(Seed, ECubeRandomStream::Kickoff);
+    KickoffStream.SetCounter(Record.KickoffDraws);
+    FlowState = (EGameState::Type)Record.FlowState;
+    ScoreToWin = Record.ScoreToWin;
+    LastScoringTeam = Record.LastScoringTeam;
+
+    // The timers can't be saved with their callbacks: schedule the flow's timer again with the ticks it had left
+    TimerWheel.Clear();
+    FlowTimerHandle.Invalidate();
+
+    if(FlowState == EGameState::WAITING_TO_START)
+    {
+        FlowTimerHandle = TimerWheel.Schedule(Record.FlowTimerTicks, FSimpleDelegate::CreateRaw(this, &FCubeHostedMatch::OnGameStart));
+    }
+    else if(FlowState == EGameState::WAITING_TO_RESTART)
+    {
+        FlowTimerHandle = TimerWheel.Schedule(Record.FlowTimerTicks, FSimpleDelegate::CreateRaw(this, &FCubeHostedMatch::OnRestart));
+    }
+
+    return true;
+}
+
+void FCubeHostedMatch::HashState(FCubeStateHasher& Hasher) const
+{
+    CubeSim::HashState(State, Hasher);
+
+    Hasher.AddInt(TEXT("Match.State"), INDEX_NONE, FlowState);
+    Hasher.AddInt(TEXT("Match.FlowTimer"), INDEX_NONE, (int32)TimerWheel.GetRemainingTicks(FlowTimerHandle));
+    Hasher.AddInt(TEXT("Match.KickoffDraws"), INDEX_NONE, (int32)KickoffStream.GetCounter());
+    Hasher.AddInt(TEXT("Match.LastScoringTeam"), INDEX_NONE, LastScoringTeam);
+}
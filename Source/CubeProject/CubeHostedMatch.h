@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CubeMatchSim.h"
+#include "CubeBot.h"
+#include "GameplayTimerWheel.h"
+#include "CubeProjectGameState.h"
+#include "CubeMatchSaveFormat.h"
+
+/**
+ * A bot match stepped by FCubeBotMatchScheduler. It holds what ACubeProjectGameMode and ACubeProjectGameState hold for
+ * the match of the game (the ball, pawns, scores, game flow and timers) without any actor, so that one process can host
+ * many isolated matches. The match moves through the same states as the game: it kicks off after GAME_START_TIMER_DURATION, resets
+ * after every goal, and starts over RESTART_DELAY_TICKS after a team reaches the score to win. Every player is a bot.
+ */
+class CUBEPROJECT_API FCubeHostedMatch
+{
+public:
+    /** The number of ticks between the end of a match and the start of the next one. */
+    static constexpr uint32 RESTART_DELAY_TICKS = 3 * ACubeProjectGameState::SIMULATION_TICK_RATE;
+
+    /**
+     * @param InConfig The arena and tuning of the match. Shared by every match of the scheduler; it must outlive the match.
+     * @param NumPlayers The number of players. Each slot is controlled by a scripted bot until SetBot() is called.
+     * @param InSeed The seed of the match's random streams.
+     */
+    FCubeHostedMatch(const FCubeSimConfig& InConfig, int32 NumPlayers, int32 InScoreToWin, uint64 InSeed);
+
+    /** Assigns a bot to the player in the given slot. */
+    void SetBot(int32 Slot, TSharedPtr<FCubeBot> Bot);
+
+    /** Advances the match by one simulation tick. */
+    void Tick();
+
+    /** Saves the state of the match, between two ticks. */
+    void Save(FCubeMatchSaveRecord& OutRecord) const;
+
+    /** Replaces the state of the match with a saved one. The match plays on exactly as the saved match would have, as long
+      * as it has the same configuration and bots. Returns false if the save has another number of players. */
+    bool Resume(const FCubeMatchSaveRecord& Record);
+
+    /** Adds the gameplay state of the match, game flow and timers included, to the given hash. */
+    void HashState(FCubeStateHasher& Hasher) const;
+
+    /** Returns the gameplay state of the match. */
+    FORCEINLINE const FCubeMatchState& GetState() const { return State; }
+
+    /** Returns the state of the game flow. */
+    FORCEINLINE EGameState::Type GetFlowState() const { return FlowState; }
+
+    /** Returns the number of matches played to the end. */
+    FORCEINLINE int32 GetNumCompletedMatches() const { return NumCompletedMatches; }
+
+private:
+    /** Called by the timer started in the RESET state. Kicks off the match. */
+    void OnGameStart();
+
+    /** Called by the timer started in the GAME_OVER state. Starts the next match. */
+    void OnRestart();
+
+    /** The arena and tuning of the match. */
+    const FCubeSimConfig& Config;
+    /** The ball, pawns and scores. */
+    FCubeMatchState State;
+    /** Where the pawns are placed when the field is reset. */
+    FVector2D StartLocations[FCubePlayerRegistry::MAX_PLAYERS];
+    /** The bot controlling each player. */
+    TSharedPtr<FCubeBot> Bots[FCubePlayerRegistry::MAX_PLAYERS];
+
+    /** The state of the game flow, as in ACubeProjectGameState. */
+    EGameState::Type FlowState;
+    /** Schedules the game flow's timers. */
+    FGameplayTimerWheel TimerWheel;
+    FGameplayTimerHandle FlowTimerHandle;
+
+    /** Chooses the direction of each kickoff. */
+    FCubeRandomStream KickoffStream;
+    /** The seed of the match's random streams, given to the bots. */
+    uint64 Seed;
+    /** The score a team needs to win. */
+    int32 ScoreToWin;
+    /** The team which scored last, or INDEX_NONE. The ball is pushed towards the other team at the kickoff. */
+    int32 LastScoringTeam;
+    /** The number of matches played to the end. */
+    int32 NumCompletedMatches;
+};
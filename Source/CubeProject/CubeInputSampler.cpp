@@ -0,0 +1,336 @@
+#include "CubeProject.h"
+#include "CubeInputSampler.h"
+#include "CubeSimRules.h"
+#include "GameFramework/InputSettings.h"
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <XInput.h>
+#include "HideWindowsPlatformTypes.h"
+#endif
+
+namespace
+{
+    /** The gamepad stick axes, stored in FBinding::Code for analog bindings. */
+    enum EGamepadAxis
+    {
+        GAMEPAD_LEFT_X,
+        GAMEPAD_LEFT_Y,
+        GAMEPAD_RIGHT_X,
+        GAMEPAD_RIGHT_Y
+    };
+
+    /** The number of gamepads XInput can read. */
+    constexpr int32 MAX_GAMEPADS = 4;
+    /** The time between two attempts to read a disconnected gamepad, in seconds. */
+    constexpr double GAMEPAD_RETRY_INTERVAL = 1.0;
+
+    /** A gamepad key which can be read with XInput. */
+    struct FGamepadKey
+    {
+        const FKey* Key;
+        uint32 Code;
+        bool bAnalog;
+    };
+
+    /** The gamepad keys which can be bound, and their XInput button mask or stick axis. */
+    const FGamepadKey GAMEPAD_KEYS[] =
+    {
+        { &EKeys::Gamepad_LeftX, GAMEPAD_LEFT_X, true },
+        { &EKeys::Gamepad_LeftY, GAMEPAD_LEFT_Y, true },
+        { &EKeys::Gamepad_RightX, GAMEPAD_RIGHT_X, true },
+        { &EKeys::Gamepad_RightY, GAMEPAD_RIGHT_Y, true },
+        { &EKeys::Gamepad_DPad_Up, 0x0001, false },
+        { &EKeys::Gamepad_DPad_Down, 0x0002, false },
+        { &EKeys::Gamepad_DPad_Left, 0x0004, false },
+        { &EKeys::Gamepad_DPad_Right, 0x0008, false },
+        { &EKeys::Gamepad_Special_Right, 0x0010, false },
+        { &EKeys::Gamepad_Special_Left, 0x0020, false },
+        { &EKeys::Gamepad_LeftShoulder, 0x0100, false },
+        { &EKeys::Gamepad_RightShoulder, 0x0200, false },
+        { &EKeys::Gamepad_FaceButton_Bottom, 0x1000, false },
+        { &EKeys::Gamepad_FaceButton_Right, 0x2000, false },
+        { &EKeys::Gamepad_FaceButton_Left, 0x4000, false },
+        { &EKeys::Gamepad_FaceButton_Top, 0x8000, false }
+    };
+}
+
+bool FCubeInputSampler::IsSupported()
+{
+    return PLATFORM_WINDOWS != 0;
+}
+
+FCubeInputSampler::FCubeInputSampler(int32 InNumSlots, int32 InSyntheticSlot)
+    : NumSlots(FMath::Clamp(InNumSlots, 0, FCubePlayerRegistry::MAX_PLAYERS))
+    , SyntheticSlot(InSyntheticSlot)
+    , SyntheticStream(FPlatformTime::Cycles())
+    , SyntheticReleaseTime(0.0)
+    , SyntheticDirection(1.0f)
+    , Events(QUEUE_CAPACITY)
+    , Thread(NULL)
+{
+    FMemory::Memzero(LastMove, sizeof(LastMove));
+    FMemory::Memzero(bLastSpinDown, sizeof(bLastSpinDown));
+    FMemory::Memzero(GamepadRetryTimes, sizeof(GamepadRetryTimes));
+
+    // The keyboard bindings are suffixed with the player's number; the gamepad bindings belong to the pad of the same index
+    for(int32 Slot = 0; Slot < NumSlots; Slot++)
+    {
+        AddBindings(Slot, *FString::Printf(TEXT("MoveX_P%d"), Slot + 1), TARGET_MOVE_X, false);
+        AddBindings(Slot, *FString::Printf(TEXT("MoveY_P%d"), Slot + 1), TARGET_MOVE_Y, false);
+        AddBindings(Slot, *FString::Printf(TEXT("Spin_P%d"), Slot + 1), TARGET_SPIN, false);
+        AddBindings(Slot, TEXT("MoveX"), TARGET_MOVE_X, true);
+        AddBindings(Slot, TEXT("MoveY"), TARGET_MOVE_Y, true);
+        AddBindings(Slot, TEXT("Spin"), TARGET_SPIN, true);
+    }
+
+    if(SyntheticSlot >= NumSlots)
+    {
+        SyntheticSlot = INDEX_NONE;
+    }
+
+    if(IsSupported() || SyntheticSlot != INDEX_NONE)
+    {
+        Thread = FRunnableThread::Create(this, TEXT("CubeInputSampler"), 0, TPri_Highest);
+    }
+}
+
+FCubeInputSampler::~FCubeInputSampler()
+{
+    Stop();
+
+    if(Thread)
+    {
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+}
+
+void FCubeInputSampler::AddBindings(int32 Slot, FName MappingName, EInputTarget Target, bool bGamepad)
+{
+    const UInputSettings* InputSettings = GetDefault<UInputSettings>();
+    TArray<TPair<FKey, float>> Keys;
+
+    if(Target == TARGET_SPIN)
+    {
+        for(const FInputActionKeyMapping& Mapping : InputSettings->ActionMappings)
+        {
+            if(Mapping.ActionName == MappingName)
+            {
+                Keys.Add(TPairInitializer<FKey, float>(Mapping.Key, 1.0f));
+            }
+        }
+    }
+    else
+    {
+        for(const FInputAxisKeyMapping& Mapping : InputSettings->AxisMappings)
+        {
+            if(Mapping.AxisName == MappingName)
+            {
+                Keys.Add(TPairInitializer<FKey, float>(Mapping.Key, Mapping.Scale));
+            }
+        }
+    }
+
+    for(const TPair<FKey, float>& Key : Keys)
+    {
+        FBinding Binding;
+        Binding.Slot = (uint8)Slot;
+        Binding.Target = (uint8)Target;
+        Binding.Scale = Key.Value;
+
+        if(Key.Key.IsGamepadKey())
+        {
+            if(!bGamepad || Slot >= MAX_GAMEPADS)
+                continue;
+
+            const FGamepadKey* GamepadKey = NULL;
+
+            for(const FGamepadKey& Candidate : GAMEPAD_KEYS)
+            {
+                if(*Candidate.Key == Key.Key)
+                {
+                    GamepadKey = &Candidate;
+                }
+            }
+
+            if(!GamepadKey)
+                continue;
+
+            Binding.Code = GamepadKey->Code;
+            Binding.Gamepad = (int8)Slot;
+            Binding.bAnalog = GamepadKey->bAnalog;
+        }
+        else
+        {
+            // Keys without a key code are characters, whose code is also their virtual key code on Windows
+            const uint32* KeyCode = NULL;
+            const uint32* CharCode = NULL;
+            FInputKeyManager::Get().GetCodesFromKey(Key.Key, KeyCode, CharCode);
+
+            if(bGamepad || (!KeyCode && !CharCode))
+                continue;
+
+            Binding.Code = KeyCode ? *KeyCode : *CharCode;
+            Binding.Gamepad = INDEX_NONE;
+            Binding.bAnalog = false;
+        }
+
+        Bindings.Add(Binding);
+    }
+}
+
+uint32 FCubeInputSampler::Run()
+{
+    double NextSampleTime = FPlatformTime::Seconds();
+
+    while(StopRequested.GetValue() == 0)
+    {
+        Sample();
+
+        // Sleep most of the interval, then yield until the next sample is due: sleeps alone are too coarse for 1 kHz
+        NextSampleTime += SAMPLE_INTERVAL;
+        double Now = FPlatformTime::Seconds();
+
+        if(Now - NextSampleTime > 0.1)
+        {
+            // Don't try to make up for a long stall
+            NextSampleTime = Now;
+        }
+
+        while(Now < NextSampleTime)
+        {
+            const double Remaining = NextSampleTime - Now;
+            FPlatformProcess::Sleep(Remaining > 0.0005 ? (float)(Remaining - 0.0005) : 0.0f);
+            Now = FPlatformTime::Seconds();
+        }
+    }
+
+    return 0;
+}
+
+void FCubeInputSampler::Stop()
+{
+    StopRequested.Set(1);
+}
+
+void FCubeInputSampler::Sample()
+{
+    const double Time = FPlatformTime::Seconds();
+    float Move[FCubePlayerRegistry::MAX_PLAYERS][2] = {};
+    bool bSpinDown[FCubePlayerRegistry::MAX_PLAYERS] = {};
+
+    if(SyntheticSlot != INDEX_NONE)
+    {
+        SampleSynthetic(Time, Move, bSpinDown);
+    }
+    else
+    {
+        SampleDevices(Time, Move, bSpinDown);
+    }
+
+    // Queue the players whose input changed
+    for(int32 Slot = 0; Slot < NumSlots; Slot++)
+    {
+        // Only the steps are queued: the pawn clamps the length of the movement when it applies it
+        FCubeInputEvent Event;
+        Event.Time = Time;
+        Event.Slot = (uint8)Slot;
+        Event.MoveX = CubeSim::QuantizeAxis(Move[Slot][TARGET_MOVE_X]);
+        Event.MoveY = CubeSim::QuantizeAxis(Move[Slot][TARGET_MOVE_Y]);
+        Event.bSpinReleased = bLastSpinDown[Slot] && !bSpinDown[Slot];
+
+        if(Event.MoveX == LastMove[Slot][0] && Event.MoveY == LastMove[Slot][1] && !Event.bSpinReleased)
+        {
+            bLastSpinDown[Slot] = bSpinDown[Slot];
+            continue;
+        }
+
+        // A dropped change is queued again at the next sample, once the game thread caught up. The button is still
+        // considered down, so that a dropped release is detected again as well.
+        if(!Events.Enqueue(Event))
+        {
+            NumDroppedEvents.Increment();
+            continue;
+        }
+
+        bLastSpinDown[Slot] = bSpinDown[Slot];
+        LastMove[Slot][0] = Event.MoveX;
+        LastMove[Slot][1] = Event.MoveY;
+    }
+}
+
+void FCubeInputSampler::SampleSynthetic(double Time, float Move[][2], bool* bSpinDown)
+{
+    // Press the spin button at random intervals, so that releases fall anywhere within a frame, and reverse the
+    // movement at each release so that the effect of every spin is visible
+    if(Time >= SyntheticReleaseTime + SYNTHETIC_HOLD_TIME)
+    {
+        SyntheticReleaseTime = Time + SyntheticStream.FRandRange(SYNTHETIC_MIN_INTERVAL, SYNTHETIC_MAX_INTERVAL);
+        SyntheticDirection = -SyntheticDirection;
+    }
+
+    Move[SyntheticSlot][TARGET_MOVE_X] = SyntheticDirection;
+    bSpinDown[SyntheticSlot] = (Time >= SyntheticReleaseTime - SYNTHETIC_HOLD_TIME && Time < SyntheticReleaseTime);
+}
+
+void FCubeInputSampler::SampleDevices(double Time, float Move[][2], bool* bSpinDown)
+{
+#if PLATFORM_WINDOWS
+    // Only read the devices while the game has the focus, like the engine's input
+    if(FPlatformProcess::IsThisApplicationForeground())
+    {
+        XINPUT_STATE Gamepads[MAX_GAMEPADS];
+        bool bGamepadConnected[MAX_GAMEPADS] = {};
+
+        for(int32 Gamepad = 0; Gamepad < FMath::Min(NumSlots, MAX_GAMEPADS); Gamepad++)
+        {
+            if(Time < GamepadRetryTimes[Gamepad])
+                continue;
+
+            bGamepadConnected[Gamepad] = (XInputGetState(Gamepad, &Gamepads[Gamepad]) == ERROR_SUCCESS);
+
+            if(!bGamepadConnected[Gamepad])
+            {
+                GamepadRetryTimes[Gamepad] = Time + GAMEPAD_RETRY_INTERVAL;
+            }
+        }
+
+        for(const FBinding& Binding : Bindings)
+        {
+            float Value = 0.0f;
+
+            if(Binding.Gamepad == INDEX_NONE)
+            {
+                Value = (GetAsyncKeyState(Binding.Code) & 0x8000) ? 1.0f : 0.0f;
+            }
+            else if(bGamepadConnected[Binding.Gamepad])
+            {
+                const XINPUT_GAMEPAD& Gamepad = Gamepads[Binding.Gamepad].Gamepad;
+
+                if(Binding.bAnalog)
+                {
+                    const SHORT Sticks[] = { Gamepad.sThumbLX, Gamepad.sThumbLY, Gamepad.sThumbRX, Gamepad.sThumbRY };
+                    const float DeadZone = (Binding.Code <= GAMEPAD_LEFT_Y) ? XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE : XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE;
+                    const float Stick = FMath::Clamp(Sticks[Binding.Code] / 32767.0f, -1.0f, 1.0f);
+
+                    Value = (FMath::Abs(Stick) * 32767.0f > DeadZone) ? Stick : 0.0f;
+                }
+                else
+                {
+                    Value = (Gamepad.wButtons & Binding.Code) ? 1.0f : 0.0f;
+                }
+            }
+
+            if(Binding.Target == TARGET_SPIN)
+            {
+                bSpinDown[Binding.Slot] |= (Value != 0.0f);
+            }
+            else
+            {
+                Move[Binding.Slot][Binding.Target] += Value * Binding.Scale;
+            }
+        }
+    }
+#endif
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "CubePlayerRegistry.h"
+
+/** A change of a player's input, sampled by FCubeInputSampler. */
+struct FCubeInputEvent
+{
+    /** When the change was sampled, in FPlatformTime::Seconds(). */
+    double Time;
+    /** The slot of the player. */
+    uint8 Slot;
+    /** The movement axes from this time on, quantized to 1/127 like the inputs of the match simulation. */
+    int8 MoveX;
+    int8 MoveY;
+    /** True if the spin button was released at this time. */
+    bool bSpinReleased;
+};
+
+/**
+ * Samples the keyboard and gamepads on a dedicated thread every SAMPLE_INTERVAL seconds, instead of once per frame, and
+ * queues every change of a player's input with the time it happened. The game thread pops the events each frame and
+ * applies them at their sub-frame time (see ACubeProjectGameMode::ApplySampledInputs()), so that a key press counts from
+ * the moment it happened rather than from the next frame, and short taps between two frames aren't lost.
+ *
+ * The keys are read from the same mappings as the pawns' input bindings: "MoveX_P<n>", "MoveY_P<n>" and "Spin_P<n>" for
+ * the keyboard, and "MoveX", "MoveY" and "Spin" for the gamepad whose index is the player's slot. Devices can only be
+ * read outside of the game thread on Windows (GetAsyncKeyState and XInput); elsewhere, IsSupported() returns false and
+ * the pawns keep their per-frame input.
+ *
+ * In the synthetic mode, the sampler generates the input of one player instead of reading the devices, on any platform:
+ * the player moves and releases the spin button at random times. Used to measure the input latency without a player
+ * (see FCubeLatencyTracker).
+ */
+class CUBEPROJECT_API FCubeInputSampler : public FRunnable
+{
+public:
+    /** The time between two samples, in seconds (1 kHz). */
+    static constexpr double SAMPLE_INTERVAL = 0.001;
+    /** The maximum number of events waiting for the game thread. */
+    static constexpr uint32 QUEUE_CAPACITY = 1024;
+    /** The synthetic mode holds the spin button for SYNTHETIC_HOLD_TIME seconds, and releases it every SYNTHETIC_MIN_INTERVAL
+      * to SYNTHETIC_MAX_INTERVAL seconds. */
+    static constexpr float SYNTHETIC_HOLD_TIME = 0.05f;
+    static constexpr float SYNTHETIC_MIN_INTERVAL = 0.5f;
+    static constexpr float SYNTHETIC_MAX_INTERVAL = 0.9f;
+
+    /** Returns true if the devices can be sampled on this platform. */
+    static bool IsSupported();
+
+    /** Reads the input mappings of the given number of player slots and starts sampling. Game thread only.
+      * @param InSyntheticSlot If set, the slot whose input is generated by the synthetic mode. */
+    explicit FCubeInputSampler(int32 InNumSlots, int32 InSyntheticSlot = INDEX_NONE);
+
+    /** Stops the sampling thread. */
+    virtual ~FCubeInputSampler();
+
+    /** Game thread: pops the oldest event. Returns false if there is none. Events are popped in the order of their time. */
+    FORCEINLINE bool PopEvent(FCubeInputEvent& OutEvent) { return Events.Dequeue(OutEvent); }
+
+    /** Returns the number of events dropped because the game thread did not pop them in time. */
+    FORCEINLINE int32 GetNumDroppedEvents() const { return NumDroppedEvents.GetValue(); }
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    /** What a key drives. */
+    enum EInputTarget
+    {
+        TARGET_MOVE_X,
+        TARGET_MOVE_Y,
+        TARGET_SPIN
+    };
+
+    /** A key bound to a player's input. */
+    struct FBinding
+    {
+        /** The platform's code of the key. For gamepads, a button mask or a stick axis (see CubeInputSampler.cpp). */
+        uint32 Code;
+        /** The gamepad read, or INDEX_NONE for the keyboard. */
+        int8 Gamepad;
+        /** True if the code is a gamepad stick axis rather than a button. */
+        bool bAnalog;
+        uint8 Slot;
+        uint8 Target;
+        float Scale;
+    };
+
+    /** Adds the bindings of the given mapping name for a slot. */
+    void AddBindings(int32 Slot, FName MappingName, EInputTarget Target, bool bGamepad);
+
+    /** Reads every device once and queues the changes. */
+    void Sample();
+
+    /** Reads the input of every player from the devices. */
+    void SampleDevices(double Time, float Move[][2], bool* bSpinDown);
+
+    /** Generates the input of the synthetic player. */
+    void SampleSynthetic(double Time, float Move[][2], bool* bSpinDown);
+
+    /** The keys read for each player. */
+    TArray<FBinding> Bindings;
+    /** The number of player slots sampled. */
+    int32 NumSlots;
+
+    /** The slot whose input is generated, or INDEX_NONE to read the devices. */
+    int32 SyntheticSlot;
+    /** Sampling thread: chooses the times of the synthetic releases. */
+    FRandomStream SyntheticStream;
+    /** Sampling thread: the time of the next synthetic release, and the direction of the synthetic movement. */
+    double SyntheticReleaseTime;
+    float SyntheticDirection;
+
+    /** Sampling thread: the last input sampled for each slot. */
+    int8 LastMove[FCubePlayerRegistry::MAX_PLAYERS][2];
+    bool bLastSpinDown[FCubePlayerRegistry::MAX_PLAYERS];
+    /** Sampling thread: the time each gamepad was last found disconnected. Disconnected pads are slow to query. */
+    double GamepadRetryTimes[FCubePlayerRegistry::MAX_PLAYERS];
+
+    /** The changes waiting for the game thread. */
+    TCircularQueue<FCubeInputEvent> Events;
+    FThreadSafeCounter NumDroppedEvents;
+
+    /** The sampling thread. */
+    FRunnableThread* Thread;
+    /** Set to stop the sampling thread. */
+    FThreadSafeCounter StopRequested;
+};
@@ -0,0 +1,155 @@
+#include "CubeProject.h"
+#include "CubeLatencyTracker.h"
+#include "SlateBasics.h"
+
+/** The names of the stages, as logged. */
+static const TCHAR* STAGE_NAMES[ECubeLatencyStage::Count] =
+{
+    TEXT("Input"),
+    TEXT("Dispatch"),
+    TEXT("SpinEvent"),
+    TEXT("Thrust"),
+    TEXT("RenderSubmit"),
+    TEXT("Present")
+};
+
+FCubeLatencyTracker* FCubeLatencyTracker::Instance = NULL;
+
+FCubeLatencyTracker::FCubeLatencyTracker()
+    : CurrentTrace(INDEX_NONE)
+    , NextId(1)
+    , CompletedTraces(QUEUE_CAPACITY)
+    , bPresentHooked(false)
+    , NextLogTime(FPlatformTime::Seconds() + LOG_INTERVAL)
+{
+    Instance = this;
+}
+
+FCubeLatencyTracker::~FCubeLatencyTracker()
+{
+    if(bPresentHooked && FSlateApplication::IsInitialized() && FSlateApplication::Get().GetRenderer().IsValid())
+    {
+        FSlateApplication::Get().GetRenderer()->OnBackBufferReadyToPresent().Remove(PresentHandle);
+    }
+
+    LogDistributions();
+    Instance = NULL;
+}
+
+uint32 FCubeLatencyTracker::BeginInput(double InputTime)
+{
+    CurrentTrace = FrameTraces.AddZeroed();
+
+    FTrace& Trace = FrameTraces[CurrentTrace];
+    Trace.Id = NextId++;
+    Trace.FrameNumber = GFrameCounter;
+    Trace.StageTimes[ECubeLatencyStage::Input] = InputTime;
+
+    return Trace.Id;
+}
+
+void FCubeLatencyTracker::MarkStage(ECubeLatencyStage::Type Stage)
+{
+    if(Instance && Instance->CurrentTrace != INDEX_NONE)
+    {
+        Instance->FrameTraces[Instance->CurrentTrace].StageTimes[Stage] = FPlatformTime::Seconds();
+    }
+}
+
+void FCubeLatencyTracker::EndFrame()
+{
+    check(IsInGameThread());
+
+    CurrentTrace = INDEX_NONE;
+
+    // Listen to the presents once the Slate renderer exists. Without one, e.g., with the null renderer, traces end at submission.
+    if(!bPresentHooked && FSlateApplication::IsInitialized() && FSlateApplication::Get().GetRenderer().IsValid() && !GUsingNullRHI)
+    {
+        PresentHandle = FSlateApplication::Get().GetRenderer()->OnBackBufferReadyToPresent().AddRaw(this, &FCubeLatencyTracker::OnBackBufferReadyToPresent);
+        bPresentHooked = true;
+    }
+
+    // Only the inputs which had an effect are followed to the display: a spin can be refused while the pawn is spinning
+    FrameTraces.RemoveAllSwap([](const FTrace& Trace) { return Trace.StageTimes[ECubeLatencyStage::Thrust] == 0.0; });
+
+    if(FrameTraces.Num() > 0)
+    {
+        // The command is queued before the frame's rendering commands, so the render thread runs it as it starts on the frame
+        ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
+            CubeLatencySubmit,
+            FCubeLatencyTracker*, Tracker, this,
+            TArray<FTrace>, Traces, FrameTraces,
+        {
+            Tracker->OnRenderSubmit(Traces);
+        });
+
+        FrameTraces.Reset();
+    }
+
+    // Record the inputs which reached the display
+    FTrace Trace;
+
+    while(CompletedTraces.Dequeue(Trace))
+    {
+        for(int32 Stage = ECubeLatencyStage::Dispatch; Stage < ECubeLatencyStage::Count; Stage++)
+        {
+            if(Trace.StageTimes[Stage] > 0.0)
+            {
+                Histograms[Stage].Record((uint64)FMath::Max((Trace.StageTimes[Stage] - Trace.StageTimes[ECubeLatencyStage::Input]) * 1000000.0, 0.0));
+            }
+        }
+    }
+
+    if(FPlatformTime::Seconds() >= NextLogTime)
+    {
+        LogDistributions();
+        NextLogTime = FPlatformTime::Seconds() + LOG_INTERVAL;
+    }
+}
+
+void FCubeLatencyTracker::LogDistributions() const
+{
+    for(int32 Stage = ECubeLatencyStage::Dispatch; Stage < ECubeLatencyStage::Count; Stage++)
+    {
+        const FFrameTimeHistogram& Histogram = Histograms[Stage];
+
+        if(Histogram.GetCount() == 0)
+            continue;
+
+        UE_LOG(LogCubeProject, Display, TEXT("Input to %s latency over %llu inputs: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms"),
+               STAGE_NAMES[Stage], Histogram.GetCount(), Histogram.GetPercentileMilliseconds(50.0f), Histogram.GetPercentileMilliseconds(95.0f),
+               Histogram.GetPercentileMilliseconds(99.0f), Histogram.GetMaxMilliseconds());
+    }
+}
+
+void FCubeLatencyTracker::OnRenderSubmit(const TArray<FTrace>& Traces)
+{
+    const double Time = FPlatformTime::Seconds();
+
+    for(FTrace Trace : Traces)
+    {
+        Trace.StageTimes[ECubeLatencyStage::RenderSubmit] = Time;
+
+        if(bPresentHooked && SubmittedTraces.Num() < (int32)QUEUE_CAPACITY)
+        {
+            SubmittedTraces.Add(Trace);
+        }
+        else
+        {
+            CompletedTraces.Enqueue(Trace);
+        }
+    }
+}
+
+void FCubeLatencyTracker::OnBackBufferReadyToPresent(SWindow& Window, const FTexture2DRHIRef& BackBuffer)
+{
+    const double Time = FPlatformTime::Seconds();
+
+    for(FTrace& Trace : SubmittedTraces)
+    {
+        Trace.StageTimes[ECubeLatencyStage::Present] = Time;
+        CompletedTraces.Enqueue(Trace);
+    }
+
+    SubmittedTraces.Reset();
+}
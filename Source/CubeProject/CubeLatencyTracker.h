@@ -0,0 +1,108 @@
+#pragma once
+
+#include "FrameTimeHistogram.h"
+
+/** The stages an input goes through, from the device to the display. */
+namespace ECubeLatencyStage
+{
+    enum Type
+    {
+        /** The input happened: the time stamped by the input sampler, or the start of the frame which received it. */
+        Input,
+        /** The game thread dispatched the input to the pawn (ACubePawn::ReleaseActionButton()). */
+        Dispatch,
+        /** The pawn started its Spin Blueprint event. */
+        SpinEvent,
+        /** ACubePawn::AddThrust() changed the pawn's velocity. */
+        Thrust,
+        /** The render thread started on the frame which shows the effect of the input. */
+        RenderSubmit,
+        /** The frame showing the effect was ready to be presented. */
+        Present,
+
+        Count
+    };
+}
+
+/**
+ * Traces inputs from the device to the frame which first shows their effect, and logs the distribution of the latency of
+ * each stage. Each traced input gets an id when it reaches the game thread; gameplay code stamps the stages of the input
+ * being dispatched with MarkStage(), and the ids of the inputs which had an effect during a frame are carried to the render
+ * thread with that frame's render commands, and stamped once the frame is submitted and presented.
+ *
+ * Spin releases are traced, since their effect is immediate. Enabled with -LatencyTrace, or with -SyntheticInput which
+ * also makes the input sampler generate the inputs. With the null renderer (-nullrhi), there is no present: the latency is
+ * measured up to the submission of the frame.
+ */
+class CUBEPROJECT_API FCubeLatencyTracker
+{
+public:
+    /** The time between two logs of the distributions, in seconds. */
+    static constexpr double LOG_INTERVAL = 10.0;
+    /** The maximum number of traced inputs in flight between the game thread and the display. */
+    static constexpr uint32 QUEUE_CAPACITY = 256;
+
+    FCubeLatencyTracker();
+
+    /** Logs the distributions. The render thread must not hold any trace anymore (see FlushRenderingCommands()). */
+    ~FCubeLatencyTracker();
+
+    /** Returns the tracker, or NULL if the latency isn't traced. */
+    static FORCEINLINE FCubeLatencyTracker* Get() { return Instance; }
+
+    /** Game thread: starts tracing an input which happened at the given time (in FPlatformTime::Seconds()), and makes it
+      * the input being dispatched until EndInput(). Returns the id of the input. */
+    uint32 BeginInput(double InputTime);
+
+    /** Game thread: ends the dispatch of the current input. */
+    FORCEINLINE void EndInput() { CurrentTrace = INDEX_NONE; }
+
+    /** Game thread: stamps the input being dispatched, if any, with the given stage. */
+    static void MarkStage(ECubeLatencyStage::Type Stage);
+
+    /** Game thread: sends the inputs which had an effect during this frame to the render thread, and records the latency of
+      * the inputs which reached the display. Called at the end of every ACubeProjectGameState::Tick(). */
+    void EndFrame();
+
+    /** Logs the distribution of the latency from the input to each stage. */
+    void LogDistributions() const;
+
+private:
+    /** The times of an input's stages. A stage which was not reached is zero. */
+    struct FTrace
+    {
+        uint32 Id;
+        uint64 FrameNumber;
+        double StageTimes[ECubeLatencyStage::Count];
+    };
+
+    /** Render thread: stamps the traces of a frame as submitted. */
+    void OnRenderSubmit(const TArray<FTrace>& Traces);
+
+    /** Render thread: stamps the submitted traces as presented. */
+    void OnBackBufferReadyToPresent(SWindow& Window, const FTexture2DRHIRef& BackBuffer);
+
+    /** The traces of the inputs dispatched during the current frame. */
+    TArray<FTrace> FrameTraces;
+    /** The index of the input being dispatched in FrameTraces, or INDEX_NONE. */
+    int32 CurrentTrace;
+    /** The id of the next input. */
+    uint32 NextId;
+
+    /** Render thread: the traces submitted but not presented yet. */
+    TArray<FTrace> SubmittedTraces;
+    /** The traces done with, from the render thread to the game thread. */
+    TCircularQueue<FTrace> CompletedTraces;
+
+    /** True once the tracker listens to the presents of the Slate renderer. */
+    bool bPresentHooked;
+    FDelegateHandle PresentHandle;
+
+    /** The latency from the input to each stage. */
+    FFrameTimeHistogram Histograms[ECubeLatencyStage::Count];
+    /** The time of the next log of the distributions. */
+    double NextLogTime;
+
+    /** The tracker, while one exists. */
+    static FCubeLatencyTracker* Instance;
+};
@@ -0,0 +1,130 @@
+#include "CubeProject.h"
+#include "CubeLiveBridge.h"
+
+const TCHAR* FCubeLiveBridge::DEFAULT_NAME = TEXT("CubeProjectLiveBridge");
+
+FCubeLiveBridge::FCubeLiveBridge()
+    : SharedMemory(NULL)
+    , Region(NULL)
+    , NumTornReads(0)
+{
+}
+
+FCubeLiveBridge::~FCubeLiveBridge()
+{
+    Close();
+}
+
+bool FCubeLiveBridge::Open(const FString& Name, bool bCreate)
+{
+    Close();
+
+    const uint32 AccessMode = FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write;
+    SharedMemory = FPlatformMemory::MapNamedSharedMemoryRegion(Name, bCreate, AccessMode, sizeof(FCubeLiveBridgeRegion));
+
+    if(!SharedMemory)
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("Could not map the live bridge region '%s'"), *Name);
+        return false;
+    }
+
+    Region = (FCubeLiveBridgeRegion*)SharedMemory->GetAddress();
+
+    if(bCreate)
+    {
+        // The header is written last, so that a tool polling the region never sees a valid header over stale indices
+        FMemory::Memzero(Region, sizeof(FCubeLiveBridgeRegion));
+        Region->Header.Version = FCubeLiveBridgeHeader::VERSION;
+        Region->Header.RegionSize = sizeof(FCubeLiveBridgeRegion);
+        Region->Header.InputRingSize = FCubeLiveBridgeRegion::INPUT_RING_SIZE;
+        FPlatformMisc::MemoryBarrier();
+        Region->Header.Magic = FCubeLiveBridgeHeader::MAGIC;
+    }
+    else if(Region->Header.Magic != FCubeLiveBridgeHeader::MAGIC || Region->Header.Version != FCubeLiveBridgeHeader::VERSION ||
+            Region->Header.RegionSize != sizeof(FCubeLiveBridgeRegion))
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("The live bridge region '%s' was not created by this version of the game"), *Name);
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void FCubeLiveBridge::Close()
+{
+    if(SharedMemory)
+    {
+        FPlatformMemory::UnmapNamedSharedMemoryRegion(SharedMemory);
+    }
+
+    SharedMemory = NULL;
+    Region = NULL;
+}
+
+void FCubeLiveBridge::PublishState(const FCubeLiveState& State)
+{
+    // An odd sequence tells the readers that the state is being written
+    const uint32 Sequence = Region->StateSequence;
+
+    Region->StateSequence = Sequence + 1;
+    FPlatformMisc::MemoryBarrier();
+
+    FMemory::Memcpy(&Region->State, &State, sizeof(FCubeLiveState));
+
+    FPlatformMisc::MemoryBarrier();
+    Region->StateSequence = Sequence + 2;
+}
+
+bool FCubeLiveBridge::PopInput(FCubeLiveInput& OutInput)
+{
+    const uint32 ReadIndex = Region->InputReadIndex;
+
+    if(ReadIndex == Region->InputWriteIndex)
+        return false;
+
+    // Read the entry only after seeing the index which published it, and free its slot only once it is copied
+    FPlatformMisc::MemoryBarrier();
+    OutInput = Region->Inputs[ReadIndex % FCubeLiveBridgeRegion::INPUT_RING_SIZE];
+    FPlatformMisc::MemoryBarrier();
+
+    Region->InputReadIndex = ReadIndex + 1;
+    return true;
+}
+
+bool FCubeLiveBridge::ReadState(FCubeLiveState& OutState) const
+{
+    for(int32 Attempt = 0; Attempt < MAX_READ_ATTEMPTS; Attempt++)
+    {
+        const uint32 SequenceBefore = Region->StateSequence;
+        FPlatformMisc::MemoryBarrier();
+
+        FMemory::Memcpy(&OutState, &Region->State, sizeof(FCubeLiveState));
+
+        FPlatformMisc::MemoryBarrier();
+        const uint32 SequenceAfter = Region->StateSequence;
+
+        // The copy is consistent if no write was in progress when it started, and none started before it ended
+        if((SequenceBefore & 1) == 0 && SequenceBefore == SequenceAfter)
+            return true;
+
+        NumTornReads++;
+    }
+
+    return false;
+}
+
+bool FCubeLiveBridge::PushInput(const FCubeLiveInput& Input)
+{
+    const uint32 WriteIndex = Region->InputWriteIndex;
+
+    if(WriteIndex - Region->InputReadIndex >= FCubeLiveBridgeRegion::INPUT_RING_SIZE)
+        return false;
+
+    // Publish the index only once the entry is written
+    Region->Inputs[WriteIndex % FCubeLiveBridgeRegion::INPUT_RING_SIZE] = Input;
+    FPlatformMisc::MemoryBarrier();
+
+    Region->InputWriteIndex = WriteIndex + 1;
+    return true;
+}
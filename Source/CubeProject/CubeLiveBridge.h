@@ -0,0 +1,54 @@
+#pragma once
+
+#include "CubeLiveBridgeFormat.h"
+
+/**
+ * Maps the shared-memory region of the live state bridge (see CubeLiveBridgeFormat.h). The game creates the region and
+ * publishes its state every frame while tools open it to read the state and push inputs. Neither side ever waits for the
+ * other: the state is guarded by a sequence lock, and the inputs go through a lock-free single-producer ring.
+ */
+class CUBEPROJECT_API FCubeLiveBridge
+{
+public:
+    /** The name of the region when none is given with -LiveBridge=<name>. */
+    static const TCHAR* DEFAULT_NAME;
+    /** The number of times ReadState() copies the state before giving up, if the game keeps writing it. */
+    static constexpr int32 MAX_READ_ATTEMPTS = 64;
+
+    FCubeLiveBridge();
+    ~FCubeLiveBridge();
+
+    /** Maps the region with the given name. The game creates the region; tools open the region created by the game.
+      * Returns false if the region can't be mapped or, when opened, if it was created by another version of the game. */
+    bool Open(const FString& Name, bool bCreate);
+
+    /** Unmaps the region. */
+    void Close();
+
+    /** Returns true if the region is mapped. */
+    FORCEINLINE bool IsOpen() const { return Region != NULL; }
+
+    /** Game side: writes the state for the readers. */
+    void PublishState(const FCubeLiveState& State);
+
+    /** Game side: pops the oldest input pushed by the tool. Returns false if there is none. */
+    bool PopInput(FCubeLiveInput& OutInput);
+
+    /** Tool side: copies a consistent snapshot of the state. Returns false if every attempt overlapped a write, which
+      * only happens if the reader is descheduled for a long time. */
+    bool ReadState(FCubeLiveState& OutState) const;
+
+    /** Tool side: pushes an input for the game. Returns false if the ring is full. */
+    bool PushInput(const FCubeLiveInput& Input);
+
+    /** Returns the number of copies ReadState() had to retry because they overlapped a write. */
+    FORCEINLINE uint32 GetNumTornReads() const { return NumTornReads; }
+
+private:
+    /** The mapped region, or NULL. */
+    FPlatformMemory::FSharedMemoryRegion* SharedMemory;
+    /** The region's layout, at the start of the mapped memory. */
+    FCubeLiveBridgeRegion* Region;
+    /** The number of reads which had to be retried. */
+    mutable uint32 NumTornReads;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+/**
+ * Layout of the shared-memory region through which the game publishes its live state to external tools (bots, broadcast
+ * overlays, analytics agents) and receives their inputs. The layout only uses fixed-size integers and floats, and keeps
+ * the same offsets on every platform, so a tool written in any language can map the region and read it directly.
+ *
+ *   FCubeLiveBridgeHeader                        (cache line 0)
+ *   StateSequence, FCubeLiveState                (from cache line 1)
+ *   InputWriteIndex                              (own cache line, written by the tool)
+ *   InputReadIndex                               (own cache line, written by the game)
+ *   FCubeLiveInput[INPUT_RING_SIZE]
+ *
+ * The state is guarded by a sequence lock. The game increments StateSequence before and after writing the state, so the
+ * sequence is odd while a write is in progress. A reader copies the state, then checks that the sequence was even and did
+ * not change during the copy; otherwise it copies again. Readers never write to the region and never block the game.
+ *
+ * The inputs are a single-producer/single-consumer ring: one tool pushes inputs by writing the entry at InputWriteIndex and
+ * then incrementing the index, and the game pops them at the start of every frame. Both indices only grow; the entry of
+ * index I is stored at I % INPUT_RING_SIZE.
+ */
+
+/** The size of a cache line, fixed so that the layout doesn't depend on the platform. */
+static constexpr int32 CUBE_LIVE_BRIDGE_CACHE_LINE = 64;
+
+/** The state of a pawn, as published by the game. */
+struct FCubeLivePawnState
+{
+    float LocationY;
+    float LocationZ;
+    float VelocityY;
+    float VelocityZ;
+    /** Non-zero while the pawn is spinning. */
+    uint32 bSpinning;
+    /** The sequence number of the last input received for this pawn through the bridge. Lets a tool measure the round
+      * trip of its inputs. */
+    uint32 LastInputSequence;
+};
+
+/** The state of the match, published by the game every frame. */
+struct FCubeLiveState
+{
+    /** The number of frames the game has published. */
+    uint32 FrameNumber;
+    /** The simulation tick of the current match. */
+    uint32 MatchTick;
+    /** The EGameState of the game. */
+    int32 GameState;
+    /** The score of each team. */
+    int32 Scores[2];
+    /** The number of pawns in use. */
+    int32 NumPlayers;
+    float BallLocationY;
+    float BallLocationZ;
+    float BallVelocityY;
+    float BallVelocityZ;
+    /** The ball's speed, as set by its last bounce (see ABall::GetSpeed()). */
+    float BallSpeed;
+    FCubeLivePawnState Pawns[8];
+};
+
+/** An input sent by a tool to a pawn. Applied exactly like the input of a bot (see ACubeProjectGameMode::TickBots()). */
+struct FCubeLiveInput
+{
+    /** Echoed in FCubeLivePawnState::LastInputSequence once the game receives the input. */
+    uint32 Sequence;
+    /** The slot of the player to control. */
+    int8 Slot;
+    /** The movement axes, in steps of 1/127. The pawn keeps moving with these axes until the next input. */
+    int8 MoveX;
+    int8 MoveY;
+    /** Non-zero to release the spin button once. */
+    uint8 bSpin;
+};
+
+/** Written once by the game when it creates the region. */
+struct FCubeLiveBridgeHeader
+{
+    static constexpr uint32 MAGIC = 0x424C5347; // "GSLB"
+    static constexpr uint32 VERSION = 1;
+
+    uint32 Magic;
+    uint32 Version;
+    /** The size of the whole region, in bytes. */
+    uint32 RegionSize;
+    /** The number of entries in the input ring. */
+    uint32 InputRingSize;
+};
+
+/** The whole shared-memory region. */
+struct FCubeLiveBridgeRegion
+{
+    static constexpr uint32 INPUT_RING_SIZE = 256;
+
+    FCubeLiveBridgeHeader Header;
+    uint8 HeaderPadding[CUBE_LIVE_BRIDGE_CACHE_LINE - sizeof(FCubeLiveBridgeHeader)];
+
+    /** Odd while the game writes the state. */
+    volatile uint32 StateSequence;
+    FCubeLiveState State;
+    uint8 StatePadding[CUBE_LIVE_BRIDGE_CACHE_LINE - (sizeof(uint32) + sizeof(FCubeLiveState)) % CUBE_LIVE_BRIDGE_CACHE_LINE];
+
+    /** The number of inputs pushed by the tool. */
+    volatile uint32 InputWriteIndex;
+    uint8 InputWritePadding[CUBE_LIVE_BRIDGE_CACHE_LINE - sizeof(uint32)];
+
+    /** The number of inputs popped by the game. */
+    volatile uint32 InputReadIndex;
+    uint8 InputReadPadding[CUBE_LIVE_BRIDGE_CACHE_LINE - sizeof(uint32)];
+
+    FCubeLiveInput Inputs[INPUT_RING_SIZE];
+};
+
+static_assert(sizeof(FCubeLiveState) == 236, "The live state layout is shared with external tools");
+static_assert(sizeof(FCubeLiveBridgeRegion) % CUBE_LIVE_BRIDGE_CACHE_LINE == 0, "The live bridge region must be a whole number of cache lines");
@@ -0,0 +1,131 @@
+#include "CubeProject.h"
+#include "CubeMatchSave.h"
+#include "CubeMatchSim.h"
+#include "CubeProjectGameState.h"
+
+void CubeMatchSave::InitRecord(FCubeMatchSaveRecord& OutRecord)
+{
+    FMemory::Memzero(OutRecord);
+    OutRecord.Magic = FCubeMatchSaveRecord::MAGIC;
+    OutRecord.Version = FCubeMatchSaveRecord::VERSION;
+    OutRecord.Size = (uint16)sizeof(FCubeMatchSaveRecord);
+    OutRecord.LastScoringTeam = INDEX_NONE;
+    OutRecord.Ball.LastPlayerHit = INDEX_NONE;
+}
+
+void CubeMatchSave::Write(const FCubeMatchSaveRecord& Record, TArray<uint8>& OutData)
+{
+    OutData.SetNumUninitialized(sizeof(Record));
+    FMemory::Memcpy(OutData.GetData(), &Record, sizeof(Record));
+}
+
+bool CubeMatchSave::Read(const uint8* Data, int32 Size, FCubeMatchSaveRecord& OutRecord)
+{
+    if(Size != (int32)sizeof(FCubeMatchSaveRecord))
+        return false;
+
+    FCubeMatchSaveRecord Record;
+    FMemory::Memcpy(&Record, Data, sizeof(Record));
+
+    if(Record.Magic != FCubeMatchSaveRecord::MAGIC || Record.Version != FCubeMatchSaveRecord::VERSION || Record.Size != sizeof(Record))
+        return false;
+
+    // Only a match between its first reset and its restart can be resumed, with players which all exist
+    if(Record.FlowState < EGameState::RESET || Record.FlowState > EGameState::WAITING_TO_RESTART)
+        return false;
+
+    if(Record.NumPlayers < 1 || Record.NumPlayers > FCubePlayerRegistry::MAX_PLAYERS || Record.ScoreToWin < 1)
+        return false;
+
+    if(Record.LastScoringTeam < INDEX_NONE || Record.LastScoringTeam >= FCubePlayerRegistry::TEAM_COUNT)
+        return false;
+
+    if(Record.Ball.LastPlayerHit < INDEX_NONE || Record.Ball.LastPlayerHit >= Record.NumPlayers)
+        return false;
+
+    OutRecord = Record;
+    return true;
+}
+
+bool CubeMatchSave::SaveToFile(const FCubeMatchSaveRecord& Record, const FString& FileName)
+{
+    TArray<uint8> Data;
+    Write(Record, Data);
+    return FFileHelper::SaveArrayToFile(Data, *FileName);
+}
+
+bool CubeMatchSave::LoadFromFile(const FString& FileName, FCubeMatchSaveRecord& OutRecord)
+{
+    TArray<uint8> Data;
+
+    if(!FFileHelper::LoadFileToArray(Data, *FileName, FILEREAD_Silent))
+        return false;
+
+    return Read(Data.GetData(), Data.Num(), OutRecord);
+}
+
+FString CubeMatchSave::GetFileName(const FString& SaveName)
+{
+    return FPaths::GameSavedDir() / TEXT("Matches") / (SaveName + TEXT(".gsms"));
+}
+
+void CubeMatchSave::CaptureSimState(const FCubeMatchState& State, const FCubeSimConfig& Config, const FVector2D* StartLocations,
+                                    FCubeMatchSaveRecord& OutRecord)
+{
+    OutRecord.Tick = State.Tick;
+    OutRecord.NumPlayers = (uint8)State.NumPlayers;
+    OutRecord.Scores[0] = State.Scores[0];
+    OutRecord.Scores[1] = State.Scores[1];
+
+    const FVector2D BallVelocity = CubeSim::GetBallVelocity(State.Ball.Direction, State.Ball.Speed, Config.BallRules);
+
+    FCubeSavedBall& Ball = OutRecord.Ball;
+    Ball.LocationY = State.Ball.Location.X;
+    Ball.LocationZ = State.Ball.Location.Y;
+    Ball.DirectionY = State.Ball.Direction.X;
+    Ball.DirectionZ = State.Ball.Direction.Y;
+    Ball.Speed = State.Ball.Speed;
+    Ball.VelocityY = BallVelocity.X;
+    Ball.VelocityZ = BallVelocity.Y;
+    Ball.HitCooldownTicks = State.Ball.HitCooldownTicks;
+    Ball.LastPlayerHit = State.Ball.LastPlayerHit;
+    Ball.bEnabled = 1;
+
+    for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+    {
+        FCubeSavedPawn& Pawn = OutRecord.Pawns[Slot];
+        Pawn.StartY = StartLocations[Slot].X;
+        Pawn.StartZ = StartLocations[Slot].Y;
+        Pawn.LocationY = State.Pawns[Slot].Location.X;
+        Pawn.LocationZ = State.Pawns[Slot].Location.Y;
+        Pawn.VelocityY = State.Pawns[Slot].Velocity.X;
+        Pawn.VelocityZ = State.Pawns[Slot].Velocity.Y;
+        Pawn.bSpinning = State.Pawns[Slot].SpinCooldownTicks > 0 ? 1 : 0;
+        Pawn.SpinCooldownTicks = State.Pawns[Slot].SpinCooldownTicks;
+    }
+}
+
+void CubeMatchSave::RestoreSimState(const FCubeMatchSaveRecord& Record, FCubeMatchState& OutState, FVector2D* OutStartLocations)
+{
+    FMemory::Memzero(OutState);
+    OutState.Tick = Record.Tick;
+    OutState.NumPlayers = Record.NumPlayers;
+    OutState.Scores[0] = Record.Scores[0];
+    OutState.Scores[1] = Record.Scores[1];
+
+    const FCubeSavedBall& Ball = Record.Ball;
+    OutState.Ball.Location = FVector2D(Ball.LocationY, Ball.LocationZ);
+    OutState.Ball.Direction = FVector2D(Ball.DirectionY, Ball.DirectionZ);
+    OutState.Ball.Speed = Ball.Speed;
+    OutState.Ball.HitCooldownTicks = Ball.HitCooldownTicks;
+    OutState.Ball.LastPlayerHit = Ball.LastPlayerHit;
+
+    for(int32 Slot = 0; Slot < Record.NumPlayers; Slot++)
+    {
+        const FCubeSavedPawn& Pawn = Record.Pawns[Slot];
+        OutStartLocations[Slot] = FVector2D(Pawn.StartY, Pawn.StartZ);
+        OutState.Pawns[Slot].Location = FVector2D(Pawn.LocationY, Pawn.LocationZ);
+        OutState.Pawns[Slot].Velocity = FVector2D(Pawn.VelocityY, Pawn.VelocityZ);
+        OutState.Pawns[Slot].SpinCooldownTicks = Pawn.SpinCooldownTicks;
+    }
+}
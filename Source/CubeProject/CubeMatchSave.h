@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CubeMatchSaveFormat.h"
+
+struct FCubeMatchState;
+struct FCubeSimConfig;
+
+/** Writes and reads saved matches (see CubeMatchSaveFormat.h). A save of the game or of a hosted match can be resumed by
+  * either, as long as the arena and number of players are the same. */
+namespace CubeMatchSave
+{
+    /** Clears a record and fills its header. */
+    CUBEPROJECT_API void InitRecord(FCubeMatchSaveRecord& OutRecord);
+
+    /** Replaces the given bytes with the record. */
+    CUBEPROJECT_API void Write(const FCubeMatchSaveRecord& Record, TArray<uint8>& OutData);
+
+    /** Reads a record, and checks that it describes a match which can be resumed. Returns false if it does not. */
+    CUBEPROJECT_API bool Read(const uint8* Data, int32 Size, FCubeMatchSaveRecord& OutRecord);
+
+    /** Writes a record to a file. Returns false if the file could not be written. */
+    CUBEPROJECT_API bool SaveToFile(const FCubeMatchSaveRecord& Record, const FString& FileName);
+
+    /** Reads a record from a file. Returns false if the file could not be read or is not a valid save. */
+    CUBEPROJECT_API bool LoadFromFile(const FString& FileName, FCubeMatchSaveRecord& OutRecord);
+
+    /** Returns the file in which the game saves the match of the given name. */
+    CUBEPROJECT_API FString GetFileName(const FString& SaveName);
+
+    /** Copies the ball, pawns, scores and tick of a match simulation to a record, along with the pawns' start locations. The
+      * ball's velocity is derived from its direction and speed with the given tuning. */
+    CUBEPROJECT_API void CaptureSimState(const FCubeMatchState& State, const FCubeSimConfig& Config, const FVector2D* StartLocations,
+                                         FCubeMatchSaveRecord& OutRecord);
+
+    /** Copies the ball, pawns, scores and tick of a record to a match simulation, along with the pawns' start locations. */
+    CUBEPROJECT_API void RestoreSimState(const FCubeMatchSaveRecord& Record, FCubeMatchState& OutState, FVector2D* OutStartLocations);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * Layout of a saved match (.gsms file), from which a match in progress can be resumed later or in another process. A save
+ * is a single FCubeMatchSaveRecord, written as-is: it holds no pointers, names or UObjects, so it is written and read with
+ * one copy. Everything the match needs to play on is stored, timers included: a timer is stored as the number of ticks
+ * left before it fires, and scheduled again when the match is resumed.
+ *
+ * The record only uses fixed-size integers and floats, without padding. All values are little-endian. A reader rejects a
+ * record whose version or size differ from its own.
+ */
+
+#pragma pack(push, 1)
+
+/** The saved state of the ball. */
+struct FCubeSavedBall
+{
+    float LocationY;
+    float LocationZ;
+    /** The direction in which the ball moves, and its speed before it is clamped to the ball's speed range. */
+    float DirectionY;
+    float DirectionZ;
+    float Speed;
+    /** The velocity of the ball's physics body. Only used by the game; the match simulation derives it from the direction
+      * and speed. */
+    float VelocityY;
+    float VelocityZ;
+    /** The ticks left before the last player hit can hit the ball again. */
+    uint16 HitCooldownTicks;
+    /** The slot of the last player who hit the ball, or -1 if the ball last hit something else. */
+    int8 LastPlayerHit;
+    /** Non-zero if the ball is on the field. The ball is disabled between the end of a match and the next one. */
+    uint8 bEnabled;
+};
+
+/** The saved state of a pawn. */
+struct FCubeSavedPawn
+{
+    /** Where the pawn is placed when the field is reset. */
+    float StartY;
+    float StartZ;
+    float LocationY;
+    float LocationZ;
+    float VelocityY;
+    float VelocityZ;
+    /** The last movement input of the pawn, quantized to 1/127. Only used by the game's determinism mode. */
+    int8 InputX;
+    int8 InputY;
+    /** Non-zero while the pawn is spinning. */
+    uint8 bSpinning;
+    uint8 Padding;
+    /** The ticks left before the pawn can spin again. */
+    uint16 SpinCooldownTicks;
+};
+
+/** A saved match. */
+struct FCubeMatchSaveRecord
+{
+    static constexpr uint32 MAGIC = 0x534D5347; // "GSMS"
+    static constexpr uint16 VERSION = 1;
+
+    uint32 Magic;
+    uint16 Version;
+    /** The size of the record, to reject files written with another layout under the same version. */
+    uint16 Size;
+
+    /** The seed of the match's random streams, and the number of values drawn from the kickoff stream. */
+    uint64 Seed;
+    uint64 KickoffDraws;
+    /** The number of ticks simulated since the match started. */
+    uint32 Tick;
+    /** The game time which was not simulated yet when the match was saved, less than one tick. */
+    float PendingTime;
+
+    /** The EGameState of the match. */
+    uint8 FlowState;
+    /** The ticks left before the game flow's timer (the kickoff countdown or the restart delay) fires, or zero. */
+    uint32 FlowTimerTicks;
+
+    uint8 NumPlayers;
+    uint8 Scores[2];
+    uint8 ScoreToWin;
+    /** The team which scored last, or -1. The ball is pushed towards the other team at the next kickoff. */
+    int8 LastScoringTeam;
+    /** Bit N is set if the right team scored the Nth goal of the match. Only tracked by the game, for the rating engine. */
+    uint32 GoalSequence;
+
+    FCubeSavedBall Ball;
+    FCubeSavedPawn Pawns[8];
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(FCubeMatchSaveRecord) == 318, "The saved match layout must not depend on the platform");
@@ -0,0 +1,292 @@
+#include "CubeProject.h"
+#include "CubeMatchSim.h"
+#include "CubeBallPhysics.h"
+#include "CubeArenaGeometry.h"
+#include "CubeStrictFloat.h"
+
+/** Keeps a circle of the given radius inside the arena's box. Returns the normal of the wall hit, or zero. */
+static FVector2D ClampToArena(FVector2D& Location, const FCubeSimArena& Arena, float Radius)
+{
+    FVector2D Normal = FVector2D::ZeroVector;
+
+    if(Location.X - Radius < Arena.LeftGoalLineY)
+    {
+        Location.X = Arena.LeftGoalLineY + Radius;
+        Normal.X = 1.0f;
+    }
+    else if(Location.X + Radius > Arena.RightGoalLineY)
+    {
+        Location.X = Arena.RightGoalLineY - Radius;
+        Normal.X = -1.0f;
+    }
+
+    if(Location.Y - Radius < Arena.FloorZ)
+    {
+        Location.Y = Arena.FloorZ + Radius;
+        Normal.Y = 1.0f;
+    }
+    else if(Location.Y + Radius > Arena.CeilingZ)
+    {
+        Location.Y = Arena.CeilingZ - Radius;
+        Normal.Y = -1.0f;
+    }
+
+    return Normal;
+}
+
+/** Returns the team which scores with the ball at the given location, or INDEX_NONE. A ball touching a goal line inside a
+  * goal mouth enters the goal's trigger. The left goal is defended by team 0. */
+static int32 GetScoringTeam(const FVector2D& Location, const FCubeSimArena& Arena, float Radius)
+{
+    if(FMath::Abs(Location.Y - Arena.GoalCenterZ) >= Arena.GoalHalfHeight)
+        return INDEX_NONE;
+
+    if(Location.X - Radius < Arena.LeftGoalLineY)
+        return 1;
+
+    if(Location.X + Radius > Arena.RightGoalLineY)
+        return 0;
+
+    return INDEX_NONE;
+}
+
+/** Keeps a circle of the given radius out of the cooked walls. Returns the direction in which it was pushed, or zero. */
+static FVector2D PushOutOfWalls(FVector2D& Location, const FCubeArenaGeometry& Geometry, float Radius)
+{
+    const FVector2D NormalSum = Geometry.PushOut(Location, Radius);
+    return (NormalSum.X != 0.0f || NormalSum.Y != 0.0f) ? CubeSim::SafeNormal(NormalSum) : FVector2D::ZeroVector;
+}
+
+void CubeSim::ResetField(FCubeMatchState& State, const FVector2D* StartLocations)
+{
+    State.Ball.Location = FVector2D::ZeroVector;
+    State.Ball.Direction = FVector2D::ZeroVector;
+    State.Ball.Speed = 0.0f;
+    State.Ball.HitCooldownTicks = 0;
+    State.Ball.LastPlayerHit = INDEX_NONE;
+
+    for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+    {
+        State.Pawns[Slot].Location = StartLocations[Slot];
+        State.Pawns[Slot].Velocity = FVector2D::ZeroVector;
+        State.Pawns[Slot].SpinCooldownTicks = 0;
+    }
+}
+
+void CubeSim::GetDefaultStartLocations(const FCubeSimArena& Arena, int32 NumPlayers, FVector2D* OutStartLocations)
+{
+    for(int32 Slot = 0; Slot < NumPlayers; Slot++)
+    {
+        const int32 Team = FCubePlayerRegistry::GetTeam(Slot);
+        const int32 TeamSize = (NumPlayers + 1 - Team) / FCubePlayerRegistry::TEAM_COUNT;
+        const int32 IndexInTeam = Slot / FCubePlayerRegistry::TEAM_COUNT;
+
+        OutStartLocations[Slot].X = 0.5f * ((Team == 0) ? Arena.LeftGoalLineY : Arena.RightGoalLineY);
+        OutStartLocations[Slot].Y = Arena.FloorZ + (Arena.CeilingZ - Arena.FloorZ) * (IndexInTeam + 1) / (TeamSize + 1);
+    }
+}
+
+void CubeSim::Kickoff(FCubeMatchState& State, const FCubeSimConfig& Config, FCubeRandomStream& KickoffStream, bool bMoveRight)
+{
+    State.Ball.Direction = GetKickoffDirection(KickoffStream, bMoveRight);
+    State.Ball.Speed = Config.BallRules.DefaultSpeed;
+}
+
+/** Advances the match by one tick, with the ball's tuning given by a profile or by the config (see CubeBallPhysics.h). */
+template<typename TBallRules>
+static FCubeSimEvents StepMatch(FCubeMatchState& State, const FCubeSimConfig& Config, const TBallRules& BallRules, const FCubeSimInput* Inputs)
+{
+    FCubeSimEvents Events;
+    const FCubeSimArena& Arena = Config.Arena;
+    const float DeltaTime = Config.TickDuration;
+
+    State.Tick++;
+
+    // Move the pawns in slot order, like ACubeProjectGameMode::StepDeterministic(). Pawns don't collide with each other.
+    for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+    {
+        FCubeSimPawn& Pawn = State.Pawns[Slot];
+        const FVector2D Input = Inputs[Slot].GetMove();
+
+        if(Pawn.SpinCooldownTicks > 0)
+        {
+            Pawn.SpinCooldownTicks--;
+        }
+        else if(Inputs[Slot].bSpin)
+        {
+            Pawn.Velocity = CubeSim::AddSpinThrust(Pawn.Velocity, Input, Config.PawnRules);
+            Pawn.SpinCooldownTicks = Config.SpinCooldownTicks;
+        }
+
+        Pawn.Velocity = CubeSim::UpdatePawnVelocity(Pawn.Velocity, Input, Config.PawnRules, DeltaTime);
+        Pawn.Location = CubeSim::Integrate(Pawn.Location, Pawn.Velocity, DeltaTime);
+
+        // Slide along the walls: drop the part of the velocity going into the wall hit
+        if(Config.Geometry)
+        {
+            const FVector2D WallNormal = PushOutOfWalls(Pawn.Location, *Config.Geometry, Config.PawnRadius);
+            const float IntoWall = Pawn.Velocity.X * WallNormal.X + Pawn.Velocity.Y * WallNormal.Y;
+
+            if(IntoWall < 0.0f)
+            {
+                Pawn.Velocity = FVector2D(Pawn.Velocity.X - WallNormal.X * IntoWall, Pawn.Velocity.Y - WallNormal.Y * IntoWall);
+            }
+
+            continue;
+        }
+
+        const FVector2D WallNormal = ClampToArena(Pawn.Location, Arena, Config.PawnRadius);
+
+        if(WallNormal.X != 0.0f)
+        {
+            Pawn.Velocity.X = 0.0f;
+        }
+
+        if(WallNormal.Y != 0.0f)
+        {
+            Pawn.Velocity.Y = 0.0f;
+        }
+    }
+
+    // Move the ball
+    FCubeSimBall& Ball = State.Ball;
+
+    if(Ball.HitCooldownTicks > 0)
+    {
+        Ball.HitCooldownTicks--;
+    }
+
+    // Against cooked walls, the ball is swept like ABall's movement and stops where it touches the first wall
+    const FVector2D BallVelocity = CubeBallPhysics::GetBallVelocity(Ball.Direction, Ball.Speed, BallRules);
+    FCubeArenaHit WallHit;
+    bool bHitCookedWall = false;
+
+    if(Config.Geometry)
+    {
+        const FVector2D Delta = CubeSim::Integrate(FVector2D::ZeroVector, BallVelocity, DeltaTime);
+        bHitCookedWall = Config.Geometry->SweepCircle(Ball.Location, Delta, Config.BallRadius, WallHit);
+        Ball.Location = bHitCookedWall ? FVector2D(Ball.Location.X + Delta.X * WallHit.Time, Ball.Location.Y + Delta.Y * WallHit.Time)
+                                       : FVector2D(Ball.Location.X + Delta.X, Ball.Location.Y + Delta.Y);
+    }
+    else
+    {
+        Ball.Location = CubeSim::Integrate(Ball.Location, BallVelocity, DeltaTime);
+    }
+
+    Events.ScoringTeam = GetScoringTeam(Ball.Location, Arena, Config.BallRadius);
+
+    if(Events.ScoringTeam != INDEX_NONE)
+    {
+        State.Scores[Events.ScoringTeam]++;
+        return Events;
+    }
+
+    const FVector2D WallNormal = Config.Geometry ? (bHitCookedWall ? WallHit.Normal : FVector2D::ZeroVector)
+                                                 : ClampToArena(Ball.Location, Arena, Config.BallRadius);
+
+    if(WallNormal.X != 0.0f || WallNormal.Y != 0.0f)
+    {
+        Ball.Direction = CubeSim::BounceOffWall(Ball.Direction, CubeBallPhysics::SafeNormal(WallNormal));
+        Ball.LastPlayerHit = INDEX_NONE;
+        Events.bWallHit = true;
+    }
+
+    // Bounce the ball off the first pawn it touches, with the same cooldown rule as ABall::OnHitPlayer()
+    const float ContactDistance = Config.BallRadius + Config.PawnRadius;
+
+    for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+    {
+        const FCubeSimPawn& Pawn = State.Pawns[Slot];
+        const FVector2D PawnToBall = Ball.Location - Pawn.Location;
+        const float DistanceSquared = PawnToBall.X * PawnToBall.X + PawnToBall.Y * PawnToBall.Y;
+
+        if(DistanceSquared >= ContactDistance * ContactDistance)
+            continue;
+
+        if(Ball.LastPlayerHit == Slot && Ball.HitCooldownTicks > 0)
+            continue;
+
+        Ball.Direction = CubeBallPhysics::BounceOffPlayer(Ball.Location, Pawn.Location, Pawn.Velocity, BallRules);
+        Ball.Speed = BallRules.DefaultSpeed;
+        Ball.HitCooldownTicks = Config.HitCooldownTicks;
+        Ball.LastPlayerHit = (int8)Slot;
+
+        // Push the ball out of the pawn, as the sweep would have stopped it at the point of contact
+        const FVector2D ContactNormal = CubeBallPhysics::SafeNormal(PawnToBall);
+        const FVector2D PushedLocation(Pawn.Location.X + ContactNormal.X * ContactDistance, Pawn.Location.Y + ContactNormal.Y * ContactDistance);
+
+        // Cooked walls are thin: the ball is swept out of the pawn so that it can't be pushed through a wall
+        const FVector2D PushDelta(PushedLocation.X - Ball.Location.X, PushedLocation.Y - Ball.Location.Y);
+
+        if(Config.Geometry && Config.Geometry->SweepCircle(Ball.Location, PushDelta, Config.BallRadius, WallHit))
+        {
+            Ball.Location = FVector2D(Ball.Location.X + PushDelta.X * WallHit.Time, Ball.Location.Y + PushDelta.Y * WallHit.Time);
+        }
+        else
+        {
+            Ball.Location = PushedLocation;
+        }
+
+        Events.PlayerHit = Slot;
+
+        // The push may carry the ball into a goal, or out of the default arena, whose walls are not swept
+        Events.ScoringTeam = GetScoringTeam(Ball.Location, Arena, Config.BallRadius);
+
+        if(Events.ScoringTeam != INDEX_NONE)
+        {
+            State.Scores[Events.ScoringTeam]++;
+        }
+        else if(!Config.Geometry)
+        {
+            ClampToArena(Ball.Location, Arena, Config.BallRadius);
+        }
+
+        break;
+    }
+
+    return Events;
+}
+
+FCubeSimEvents CubeSim::Step(FCubeMatchState& State, const FCubeSimConfig& Config, const FCubeSimInput* Inputs)
+{
+    // Run the simulation specialized for the ball's profile, whose tuning is folded into the code
+    return CubeBallPhysics::VisitProfile(Config.BallRules, [&](const auto& BallRules)
+    {
+        return StepMatch(State, Config, BallRules, Inputs);
+    });
+}
+
+void CubeSim::HashState(const FCubeMatchState& State, FCubeStateHasher& Hasher)
+{
+    Hasher.AddInt(TEXT("Sim.Tick"), INDEX_NONE, (int32)State.Tick);
+    Hasher.AddInt(TEXT("Sim.Score"), 0, State.Scores[0]);
+    Hasher.AddInt(TEXT("Sim.Score"), 1, State.Scores[1]);
+    Hasher.AddFloat(TEXT("Sim.Ball.Location.Y"), INDEX_NONE, State.Ball.Location.X);
+    Hasher.AddFloat(TEXT("Sim.Ball.Location.Z"), INDEX_NONE, State.Ball.Location.Y);
+    Hasher.AddFloat(TEXT("Sim.Ball.Direction.Y"), INDEX_NONE, State.Ball.Direction.X);
+    Hasher.AddFloat(TEXT("Sim.Ball.Direction.Z"), INDEX_NONE, State.Ball.Direction.Y);
+    Hasher.AddFloat(TEXT("Sim.Ball.Speed"), INDEX_NONE, State.Ball.Speed);
+    Hasher.AddInt(TEXT("Sim.Ball.LastPlayerHit"), INDEX_NONE, State.Ball.LastPlayerHit);
+    Hasher.AddInt(TEXT("Sim.Ball.HitCooldown"), INDEX_NONE, State.Ball.HitCooldownTicks);
+
+    for(int32 Slot = 0; Slot < State.NumPlayers; Slot++)
+    {
+        const FCubeSimPawn& Pawn = State.Pawns[Slot];
+
+        Hasher.AddFloat(TEXT("Sim.Pawn.Location.Y"), Slot, Pawn.Location.X);
+        Hasher.AddFloat(TEXT("Sim.Pawn.Location.Z"), Slot, Pawn.Location.Y);
+        Hasher.AddFloat(TEXT("Sim.Pawn.Velocity.Y"), Slot, Pawn.Velocity.X);
+        Hasher.AddFloat(TEXT("Sim.Pawn.Velocity.Z"), Slot, Pawn.Velocity.Y);
+        Hasher.AddInt(TEXT("Sim.Pawn.SpinCooldown"), Slot, Pawn.SpinCooldownTicks);
+    }
+}
+
+FCubeSimInput CubeSim::MakeInput(float MoveX, float MoveY, bool bSpin)
+{
+    // Only the steps are stored: the length of the movement is clamped when it is applied, as for the actors
+    FCubeSimInput Input;
+    Input.MoveX = QuantizeAxis(MoveX);
+    Input.MoveY = QuantizeAxis(MoveY);
+    Input.bSpin = bSpin;
+    return Input;
+}
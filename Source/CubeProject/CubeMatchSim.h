@@ -0,0 +1,120 @@
+#pragma once
+
+#include "CubeSimRules.h"
+#include "CubePlayerRegistry.h"
+
+/** The shape of the field, as seen by the match simulation: a box whose left and right walls each have a goal mouth. */
+struct FCubeSimArena
+{
+    /** The horizontal position of the left and right goal lines. */
+    float LeftGoalLineY = -800.0f;
+    float RightGoalLineY = 800.0f;
+    /** The height of the floor and ceiling. */
+    float FloorZ = -250.0f;
+    float CeilingZ = 250.0f;
+    /** The height of the center of each goal mouth, and the half-height of the mouths. */
+    float GoalCenterZ = 0.0f;
+    float GoalHalfHeight = 100.0f;
+};
+
+/** Everything a match simulation needs besides its state: the arena and the tuning of the ball and pawns. */
+struct FCubeSimConfig
+{
+    FCubeSimArena Arena;
+    FCubeBallRules BallRules;
+    FCubePawnRules PawnRules;
+    /** The collision radii of the ball and pawns. */
+    float BallRadius = 25.0f;
+    float PawnRadius = 40.0f;
+    /** The length of the cooldowns, in simulation ticks. */
+    uint16 SpinCooldownTicks = 24;
+    uint16 HitCooldownTicks = 60;
+    /** The duration of a simulation tick, in seconds. */
+    float TickDuration = 1.0f / 60.0f;
+    /** The cooked walls of the arena the match is played in, or NULL to play in the box described by Arena. Not owned. */
+    const class FCubeArenaGeometry* Geometry = NULL;
+};
+
+/** The state of the ball in a match simulation. */
+struct FCubeSimBall
+{
+    FVector2D Location;
+    FVector2D Direction;
+    float Speed;
+    /** The ticks left before the last player hit can hit the ball again. */
+    uint16 HitCooldownTicks;
+    /** The slot of the last player who hit the ball, or INDEX_NONE if the ball last hit a wall. */
+    int8 LastPlayerHit;
+};
+
+/** The state of a pawn in a match simulation. */
+struct FCubeSimPawn
+{
+    FVector2D Location;
+    FVector2D Velocity;
+    /** The ticks left before the pawn can spin again. Zero if the pawn is not spinning. */
+    uint16 SpinCooldownTicks;
+};
+
+/** The input of a player for one simulation tick. Axes are in the steps of CubeSim::QuantizeAxis(), as in the determinism mode. */
+struct FCubeSimInput
+{
+    int8 MoveX = 0;
+    int8 MoveY = 0;
+    bool bSpin = false;
+
+    /** Returns the movement input as a vector, with its length clamped to 1. */
+    FORCEINLINE FVector2D GetMove() const { return CubeSim::GetInputMove(MoveX, MoveY); }
+};
+
+/**
+ * The gameplay state of a match, small enough to be copied in a few nanoseconds (about 200 bytes, no pointers or
+ * UObjects). Stepped by CubeSim::Step(), which applies the same rules as the actors (see CubeSimRules.h) on the simplified
+ * arena described by FCubeSimArena. Used by bots to look ahead, and by tools which simulate many matches at once.
+ */
+struct FCubeMatchState
+{
+    /** The number of ticks simulated. */
+    uint32 Tick;
+    /** The number of players. Slots are filled contiguously from zero; even slots play on the left team. */
+    int32 NumPlayers;
+    /** The goals scored by each team. */
+    uint8 Scores[FCubePlayerRegistry::TEAM_COUNT];
+    FCubeSimBall Ball;
+    FCubeSimPawn Pawns[FCubePlayerRegistry::MAX_PLAYERS];
+};
+
+/** What happened during a simulation tick. */
+struct FCubeSimEvents
+{
+    /** The team which scored, or INDEX_NONE. */
+    int32 ScoringTeam = INDEX_NONE;
+    /** The slot of the player who hit the ball, or INDEX_NONE. */
+    int32 PlayerHit = INDEX_NONE;
+    /** True if the ball bounced off a wall. */
+    bool bWallHit = false;
+};
+
+namespace CubeSim
+{
+    /** Places the ball at the center and the pawns at the given start locations, with nothing moving. */
+    CUBEPROJECT_API void ResetField(FCubeMatchState& State, const FVector2D* StartLocations);
+
+    /** Fills the start location of each player for a match played without a level: each team lines up halfway between
+      * the center and its own goal, its players spread evenly between the floor and the ceiling. */
+    CUBEPROJECT_API void GetDefaultStartLocations(const FCubeSimArena& Arena, int32 NumPlayers, FVector2D* OutStartLocations);
+
+    /** Launches the ball from the center towards the right or left of the field. */
+    CUBEPROJECT_API void Kickoff(FCubeMatchState& State, const FCubeSimConfig& Config, FCubeRandomStream& KickoffStream, bool bMoveRight);
+
+    /** Advances the match by one tick with the given input for each player. Returns what happened during the tick. When a
+      * team scores, the score is updated but the field is not reset: that is left to the caller. If the ball's rules are
+      * those of a ball profile, the simulation specialized for the profile runs, with the same results. */
+    CUBEPROJECT_API FCubeSimEvents Step(FCubeMatchState& State, const FCubeSimConfig& Config, const FCubeSimInput* Inputs);
+
+    /** Adds every field of the state to the given hash. */
+    CUBEPROJECT_API void HashState(const FCubeMatchState& State, FCubeStateHasher& Hasher);
+
+    /** Converts a movement input to its quantized form. */
+    CUBEPROJECT_API FCubeSimInput MakeInput(float MoveX, float MoveY, bool bSpin);
+}
@@ -0,0 +1,276 @@
+#include "CubeProject.h"
+#include "CubeMctsBot.h"
+#include "ParallelFor.h"
+#include "CubeStrictFloat.h"
+
+/** The movement of each action, before the spin is added. Action N moves in direction N % 9 and spins if N >= 9. */
+static const float ACTION_DIRECTIONS[9][2] =
+{
+    { 0.0f, 0.0f },
+    { 1.0f, 0.0f }, { 0.70710678f, 0.70710678f }, { 0.0f, 1.0f }, { -0.70710678f, 0.70710678f },
+    { -1.0f, 0.0f }, { -0.70710678f, -0.70710678f }, { 0.0f, -1.0f }, { 0.70710678f, -0.70710678f }
+};
+
+/** The number of actions stored on the path of an iteration, the root included. */
+static constexpr int32 MAX_PATH_LENGTH = FCubeMctsBot::HORIZON_TICKS / FCubeMctsBot::ACTION_TICKS + 1;
+
+static FCubeSimInput GetActionInput(int32 Action)
+{
+    const float* Direction = ACTION_DIRECTIONS[Action % 9];
+    return CubeSim::MakeInput(Direction[0], Direction[1], Action >= 9);
+}
+
+/** Simulates the given action of the player in the given slot. Returns the team which scored, or INDEX_NONE. */
+static int32 SimulateAction(FCubeMatchState& State, const FCubeSimConfig& Config, int32 Slot, int32 Action)
+{
+    const FCubeSimInput ActionInput = GetActionInput(Action);
+    FCubeSimInput Inputs[FCubePlayerRegistry::MAX_PLAYERS];
+
+    for(int32 Tick = 0; Tick < FCubeMctsBot::ACTION_TICKS; Tick++)
+    {
+        FCubeScriptedBot::GetSimInputs(State, Config, Inputs);
+
+        // The spin button is only released once per action
+        Inputs[Slot] = ActionInput;
+        Inputs[Slot].bSpin = ActionInput.bSpin && Tick == 0;
+
+        const FCubeSimEvents Events = CubeSim::Step(State, Config, Inputs);
+
+        if(Events.ScoringTeam != INDEX_NONE)
+            return Events.ScoringTeam;
+    }
+
+    return INDEX_NONE;
+}
+
+FCubeMctsBot::FCubeMctsBot(float InBudgetMilliseconds, int32 InIterationsPerWorker, int32 InNumWorkers)
+    : BudgetSeconds(InBudgetMilliseconds / 1000.0)
+    , IterationsPerWorker(InIterationsPerWorker)
+    , RequestedNumWorkers(InNumWorkers)
+{
+}
+
+FCubeBotInput FCubeMctsBot::Think(const FCubeBotContext& Context)
+{
+    FCubeBotInput Input;
+
+    if(!Context.MatchState || !Context.SimConfig)
+        return Input;
+
+    const uint32 Tick = Context.MatchState->Tick;
+    const bool bDecide = !bHasDecided || Tick < DecisionTick || Tick - DecisionTick >= (uint32)ACTION_TICKS;
+
+    if(bDecide)
+    {
+        // Create the workers and their node pools on the first decision, once the task graph knows its number of threads
+        if(Workers.Num() == 0)
+        {
+            const int32 NumWorkers = (RequestedNumWorkers > 0) ? RequestedNumWorkers : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+            Workers.SetNum(NumWorkers);
+
+            for(FWorker& Worker : Workers)
+            {
+                Worker.Nodes.Reserve(MAX_NODES_PER_WORKER);
+            }
+
+            bHasDecided = false;
+        }
+
+        // Give each worker its own stream, derived from the match seed, so that decisions can be replayed from the seed
+        if(!bHasDecided || WorkersSeed != Context.MatchSeed)
+        {
+            for(int32 Index = 0; Index < Workers.Num(); Index++)
+            {
+                const uint64 WorkerSeed = FCubeRandomStream::Mix(Context.MatchSeed + ((uint64)Context.Slot << 32) + (uint64)Index);
+                Workers[Index].Stream = FCubeRandomStream(WorkerSeed, ECubeRandomStream::Bots);
+            }
+
+            WorkersSeed = Context.MatchSeed;
+        }
+
+        const bool bFixedIterations = IterationsPerWorker > 0;
+        const double Deadline = bFixedIterations ? DBL_MAX : FPlatformTime::Seconds() + BudgetSeconds;
+        const int32 MaxIterations = bFixedIterations ? IterationsPerWorker : MAX_int32;
+
+        ParallelFor(Workers.Num(), [&](int32 Index)
+        {
+            Search(Workers[Index], *Context.MatchState, *Context.SimConfig, Context.Slot, Deadline, MaxIterations);
+        });
+
+        // Merge the root statistics of every tree in worker order, and play the action visited most
+        int32 RootVisits[NUM_ACTIONS] = { 0 };
+        LastIterationCount = 0;
+
+        for(const FWorker& Worker : Workers)
+        {
+            const FNode& Root = Worker.Nodes[0];
+
+            for(int32 Action = 0; Action < NUM_ACTIONS; Action++)
+            {
+                if(Root.Children[Action] != INDEX_NONE)
+                {
+                    RootVisits[Action] += Worker.Nodes[Root.Children[Action]].Visits;
+                }
+            }
+
+            LastIterationCount += Worker.Iterations;
+        }
+
+        CurrentAction = 0;
+
+        for(int32 Action = 1; Action < NUM_ACTIONS; Action++)
+        {
+            if(RootVisits[Action] > RootVisits[CurrentAction])
+            {
+                CurrentAction = Action;
+            }
+        }
+
+        DecisionTick = Tick;
+        bHasDecided = true;
+    }
+
+    const float* Direction = ACTION_DIRECTIONS[CurrentAction % 9];
+    Input.MoveX = Direction[0];
+    Input.MoveY = Direction[1];
+    Input.bSpin = bDecide && CurrentAction >= 9;
+
+    return Input;
+}
+
+void FCubeMctsBot::Search(FWorker& Worker, const FCubeMatchState& RootState, const FCubeSimConfig& Config, int32 Slot, double Deadline,
+                          int32 MaxIterations) const
+{
+    // Reuse the node pool of the previous decision
+    Worker.Nodes.Reset();
+    Worker.Iterations = 0;
+    AddNode(Worker);
+
+    while(Worker.Iterations < MaxIterations && (Deadline == DBL_MAX || FPlatformTime::Seconds() < Deadline))
+    {
+        RunIteration(Worker, RootState, Config, Slot);
+        Worker.Iterations++;
+    }
+}
+
+void FCubeMctsBot::RunIteration(FWorker& Worker, const FCubeMatchState& RootState, const FCubeSimConfig& Config, int32 Slot) const
+{
+    FCubeMatchState State = RootState;
+    int32 Path[MAX_PATH_LENGTH];
+    int32 PathLength = 0;
+    int32 NodeIndex = 0;
+    int32 Ticks = 0;
+    int32 ScoringTeam = INDEX_NONE;
+
+    Path[PathLength++] = NodeIndex;
+
+    // Walk down the tree until a node has an action which was never tried, and try it
+    while(Ticks < HORIZON_TICKS && ScoringTeam == INDEX_NONE)
+    {
+        // Start from a random action, so that the workers expand their trees in different orders
+        const int32 FirstAction = (int32)(Worker.Stream.GetUnsignedInt() % NUM_ACTIONS);
+        int32 UntriedAction = INDEX_NONE;
+
+        for(int32 Offset = 0; Offset < NUM_ACTIONS; Offset++)
+        {
+            const int32 Action = (FirstAction + Offset) % NUM_ACTIONS;
+
+            if(Worker.Nodes[NodeIndex].Children[Action] == INDEX_NONE)
+            {
+                UntriedAction = Action;
+                break;
+            }
+        }
+
+        if(UntriedAction != INDEX_NONE)
+        {
+            const int32 Child = AddNode(Worker);
+
+            // Once the pool is full, the tree stops growing and the iteration rolls out from the current node
+            if(Child == INDEX_NONE)
+                break;
+
+            Worker.Nodes[NodeIndex].Children[UntriedAction] = Child;
+            Path[PathLength++] = Child;
+            ScoringTeam = SimulateAction(State, Config, Slot, UntriedAction);
+            Ticks += ACTION_TICKS;
+            break;
+        }
+
+        // Every action was tried: select the child with the best upper confidence bound. The exploration term uses
+        // sqrt(N) / (1 + n) instead of sqrt(ln(N) / n), since log() is not correctly rounded on every platform.
+        const FNode& Node = Worker.Nodes[NodeIndex];
+        const float ExplorationScale = EXPLORATION * FMath::Sqrt((float)Node.Visits);
+        int32 BestAction = 0;
+        float BestScore = -MAX_FLT;
+
+        for(int32 Action = 0; Action < NUM_ACTIONS; Action++)
+        {
+            const FNode& Child = Worker.Nodes[Node.Children[Action]];
+            const float Score = Child.TotalValue / Child.Visits + ExplorationScale / (1.0f + Child.Visits);
+
+            if(Score > BestScore)
+            {
+                BestScore = Score;
+                BestAction = Action;
+            }
+        }
+
+        NodeIndex = Node.Children[BestAction];
+        Path[PathLength++] = NodeIndex;
+        ScoringTeam = SimulateAction(State, Config, Slot, BestAction);
+        Ticks += ACTION_TICKS;
+    }
+
+    // Play random actions up to the horizon
+    while(Ticks < HORIZON_TICKS && ScoringTeam == INDEX_NONE)
+    {
+        ScoringTeam = SimulateAction(State, Config, Slot, (int32)(Worker.Stream.GetUnsignedInt() % NUM_ACTIONS));
+        Ticks += ACTION_TICKS;
+    }
+
+    const int32 Team = FCubePlayerRegistry::GetTeam(Slot);
+    const float Value = (ScoringTeam == INDEX_NONE) ? Evaluate(State, Config, Team) : (ScoringTeam == Team ? 1.0f : -1.0f);
+
+    for(int32 Index = 0; Index < PathLength; Index++)
+    {
+        FNode& Node = Worker.Nodes[Path[Index]];
+        Node.Visits++;
+        Node.TotalValue += Value;
+    }
+}
+
+int32 FCubeMctsBot::AddNode(FWorker& Worker)
+{
+    // The pool is reserved up front, so adding a node never allocates during a search
+    if(Worker.Nodes.Num() >= MAX_NODES_PER_WORKER)
+        return INDEX_NONE;
+
+    const int32 Index = Worker.Nodes.AddUninitialized();
+    FNode& Node = Worker.Nodes[Index];
+
+    for(int32 Action = 0; Action < NUM_ACTIONS; Action++)
+    {
+        Node.Children[Action] = INDEX_NONE;
+    }
+
+    Node.Visits = 0;
+    Node.TotalValue = 0.0f;
+    return Index;
+}
+
+float FCubeMctsBot::Evaluate(const FCubeMatchState& State, const FCubeSimConfig& Config, int32 Team)
+{
+    // Without a goal, a state is as good as the ball is deep in the opponent's half and moving towards its goal. The value
+    // stays below the value of a goal.
+    const FCubeSimArena& Arena = Config.Arena;
+    const float AttackDirection = (Team == 0) ? 1.0f : -1.0f;
+    const float FieldCenter = (Arena.LeftGoalLineY + Arena.RightGoalLineY) * 0.5f;
+    const float HalfFieldWidth = (Arena.RightGoalLineY - Arena.LeftGoalLineY) * 0.5f;
+    const FVector2D BallVelocity = CubeSim::GetBallVelocity(State.Ball.Direction, State.Ball.Speed, Config.BallRules);
+
+    const float Progress = (State.Ball.Location.X - FieldCenter) / HalfFieldWidth * AttackDirection;
+    const float Momentum = BallVelocity.X / Config.BallRules.MaxSpeed * AttackDirection;
+
+    return FMath::Clamp(Progress * 0.6f + Momentum * 0.3f, -0.9f, 0.9f);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CubeBot.h"
+#include "CubeMatchSim.h"
+
+/**
+ * A bot which plans with Monte Carlo tree search on the match simulation (see CubeMatchSim.h). Every few ticks, it copies
+ * the state of the match and grows search trees on several worker threads in parallel until its time budget runs out.
+ * Each tree node is one of the bot's actions held for ACTION_TICKS ticks; the other players follow the scripted bot's
+ * strategy. The action visited most across all trees is played until the next decision.
+ *
+ * The trees are searched in parallel from the root: each worker owns its tree, node pool and random stream, so workers
+ * never share memory during a search, and their root statistics are merged once they are done. The strength of the bot
+ * thus grows with the number of cores. In the determinism mode, the budget is a fixed number of iterations on a fixed
+ * number of workers instead, and the bot's decisions only depend on the match seed.
+ */
+class CUBEPROJECT_API FCubeMctsBot : public FCubeBot
+{
+public:
+    /** The number of actions: no move or one of 8 directions, with or without a spin. */
+    static constexpr int32 NUM_ACTIONS = 18;
+    /** The number of simulation ticks each action is held for. */
+    static constexpr int32 ACTION_TICKS = 6;
+    /** The number of simulation ticks looked ahead by each iteration. */
+    static constexpr int32 HORIZON_TICKS = 90;
+    /** The maximum number of nodes in each worker's tree. */
+    static constexpr int32 MAX_NODES_PER_WORKER = 4096;
+    /** Balances exploration and exploitation when selecting a child node (the UCT constant). */
+    static constexpr float EXPLORATION = 0.7f;
+    /** The search budget of the bot in the determinism mode: a fixed number of iterations on a fixed number of workers. */
+    static constexpr int32 DETERMINISTIC_ITERATIONS = 64;
+    static constexpr int32 DETERMINISTIC_WORKERS = 4;
+
+    /**
+     * @param InBudgetMilliseconds The wall-clock time spent searching at each decision. Ignored if InIterationsPerWorker is set.
+     * @param InIterationsPerWorker If greater than zero, each worker runs exactly this many iterations per decision.
+     * @param InNumWorkers The number of trees searched in parallel. If zero, one per task graph worker plus the game thread.
+     */
+    FCubeMctsBot(float InBudgetMilliseconds = 2.0f, int32 InIterationsPerWorker = 0, int32 InNumWorkers = 0);
+
+    virtual FCubeBotInput Think(const FCubeBotContext& Context) override;
+
+    /** Returns the number of iterations run by all workers at the last decision. */
+    FORCEINLINE int32 GetLastIterationCount() const { return LastIterationCount; }
+
+private:
+    /** A node of a worker's search tree. */
+    struct FNode
+    {
+        /** The index of the child reached with each action, or INDEX_NONE if it was not expanded yet. */
+        int32 Children[NUM_ACTIONS];
+        int32 Visits;
+        float TotalValue;
+    };
+
+    /** The tree and statistics of one worker. */
+    struct FWorker
+    {
+        TArray<FNode> Nodes;
+        FCubeRandomStream Stream;
+        int32 Iterations;
+    };
+
+    /** Grows the given worker's tree from the given state until the deadline or the iteration count is reached. */
+    void Search(FWorker& Worker, const FCubeMatchState& RootState, const FCubeSimConfig& Config, int32 Slot, double Deadline,
+                int32 MaxIterations) const;
+
+    /** Runs one iteration: selection, expansion, a random rollout to the horizon and backpropagation. */
+    void RunIteration(FWorker& Worker, const FCubeMatchState& RootState, const FCubeSimConfig& Config, int32 Slot) const;
+
+    /** Adds a node with no children to the worker's tree. Returns INDEX_NONE if the tree is full. */
+    static int32 AddNode(FWorker& Worker);
+
+    /** Returns the value of a state for the given team, in [-1, 1]. */
+    static float Evaluate(const FCubeMatchState& State, const FCubeSimConfig& Config, int32 Team);
+
+    /** The wall-clock time spent searching at each decision, in seconds. */
+    double BudgetSeconds;
+    /** The number of iterations run by each worker per decision, or zero to search until the budget runs out. */
+    int32 IterationsPerWorker;
+    /** The number of workers requested, or zero to use every task graph worker. */
+    int32 RequestedNumWorkers;
+
+    TArray<FWorker> Workers;
+    /** The match seed the workers' random streams were created from. */
+    uint64 WorkersSeed = 0;
+    /** The action played until the next decision, and the tick at which it was chosen. */
+    int32 CurrentAction = 0;
+    uint32 DecisionTick = 0;
+    bool bHasDecided = false;
+    /** The number of iterations run at the last decision. */
+    int32 LastIterationCount = 0;
+};
@@ -0,0 +1,195 @@
+#include "CubeProject.h"
+#include "CubeMetrics.h"
+
+namespace
+{
+    /** The name and description of each counter. */
+    const TCHAR* CounterNames[ECubeCounter::Count][2] =
+    {
+        { TEXT("cube_ticks_simulated_total"),     TEXT("Simulation ticks advanced by the game state.") },
+        { TEXT("cube_matches_completed_total"),   TEXT("Matches played until a team reached the score to win.") },
+        { TEXT("cube_goals_total"),               TEXT("Goals scored.") },
+        { TEXT("cube_ball_player_hits_total"),    TEXT("Bounces of the ball off a player.") },
+        { TEXT("cube_ball_wall_hits_total"),      TEXT("Bounces of the ball off a wall.") },
+        { TEXT("cube_spins_total"),               TEXT("Spins performed by the players.") }
+    };
+
+    /** The name and description of each gauge. */
+    const TCHAR* GaugeNames[ECubeGauge::Count][2] =
+    {
+        { TEXT("cube_effect_pool_active"),        TEXT("Sound and particle components playing in the gameplay effect pool.") },
+        { TEXT("cube_effect_pool_capacity"),      TEXT("Sound and particle components in the gameplay effect pool.") },
+        { TEXT("cube_players"),                   TEXT("Players in the current match.") },
+        { TEXT("cube_game_state"),                TEXT("The current EGameState.") }
+    };
+
+    /** The name and description of each histogram. */
+    const TCHAR* HistogramNames[ECubeHistogram::Count][2] =
+    {
+        { TEXT("cube_frame_time_seconds"),        TEXT("The duration of each frame.") },
+        { TEXT("cube_reset_to_playing_seconds"),  TEXT("The time from entering RESET to entering PLAYING.") }
+    };
+
+    /** The upper bound of each bucket of each histogram, in seconds. Unused buckets are zero. */
+    const double HistogramBounds[ECubeHistogram::Count][FCubeMetrics::MAX_BUCKETS] =
+    {
+        { 0.004, 0.008, 0.012, 0.0167, 0.020, 0.025, 0.0333, 0.050, 0.100, 0.250 },
+        { 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 5.0, 10.0 }
+    };
+
+    /** The thread-local slot storing each thread's shard. */
+    uint32 ShardTlsSlot = 0;
+    /** The head of the list of every shard. */
+    void* volatile ShardListHead = NULL;
+    /** The value of each gauge. */
+    volatile int64 Gauges[ECubeGauge::Count];
+
+    /** Returns the number of finite buckets of a histogram. */
+    int32 GetNumBuckets(ECubeHistogram::Type Histogram)
+    {
+        int32 NumBuckets = 0;
+
+        while(NumBuckets < FCubeMetrics::MAX_BUCKETS && HistogramBounds[Histogram][NumBuckets] > 0.0)
+        {
+            NumBuckets++;
+        }
+
+        return NumBuckets;
+    }
+}
+
+void FCubeMetrics::Startup()
+{
+    ShardTlsSlot = FPlatformTLS::AllocTlsSlot();
+}
+
+void FCubeMetrics::Shutdown()
+{
+    FShard* Shard = (FShard*)FPlatformAtomics::InterlockedExchangePtr((void**)&ShardListHead, NULL);
+
+    while(Shard)
+    {
+        FShard* Next = Shard->Next;
+        delete Shard;
+        Shard = Next;
+    }
+
+    if(FPlatformTLS::IsValidTlsSlot(ShardTlsSlot))
+    {
+        FPlatformTLS::FreeTlsSlot(ShardTlsSlot);
+        ShardTlsSlot = 0;
+    }
+}
+
+FCubeMetrics::FShard* FCubeMetrics::GetShard()
+{
+    FShard* Shard = (FShard*)FPlatformTLS::GetTlsValue(ShardTlsSlot);
+
+    if(Shard)
+        return Shard;
+
+    Shard = new FShard;
+    FMemory::Memzero(Shard, sizeof(FShard));
+    FPlatformTLS::SetTlsValue(ShardTlsSlot, Shard);
+
+    // Push the shard at the head of the list. Shards are never removed while the game runs, so the list can't suffer from ABA.
+    void* Head;
+
+    do
+    {
+        Head = ShardListHead;
+        Shard->Next = (FShard*)Head;
+    }
+    while(FPlatformAtomics::InterlockedCompareExchangePointer((void**)&ShardListHead, Shard, Head) != Head);
+
+    return Shard;
+}
+
+void FCubeMetrics::IncrementCounter(ECubeCounter::Type Counter, int64 Amount)
+{
+    FShard* Shard = GetShard();
+    Shard->Counters[Counter] = Shard->Counters[Counter] + Amount;
+}
+
+void FCubeMetrics::SetGauge(ECubeGauge::Type Gauge, int64 Value)
+{
+    Gauges[Gauge] = Value;
+}
+
+void FCubeMetrics::ObserveHistogram(ECubeHistogram::Type Histogram, double Seconds)
+{
+    FShard* Shard = GetShard();
+    const int32 NumBuckets = GetNumBuckets(Histogram);
+    int32 Bucket = 0;
+
+    while(Bucket < NumBuckets && Seconds > HistogramBounds[Histogram][Bucket])
+    {
+        Bucket++;
+    }
+
+    Shard->HistogramBuckets[Histogram][Bucket] = Shard->HistogramBuckets[Histogram][Bucket] + 1;
+    Shard->HistogramSums[Histogram] = Shard->HistogramSums[Histogram] + (int64)(Seconds * 1000000.0);
+}
+
+FString FCubeMetrics::Export()
+{
+    // Merge the shards. A shard may be written during the merge: its values are then read either before or after the
+    // write, which only shifts the increment to the next scrape.
+    int64 Counters[ECubeCounter::Count] = { 0 };
+    int64 HistogramBuckets[ECubeHistogram::Count][MAX_BUCKETS + 1] = { { 0 } };
+    int64 HistogramSums[ECubeHistogram::Count] = { 0 };
+
+    for(FShard* Shard = (FShard*)ShardListHead; Shard; Shard = Shard->Next)
+    {
+        for(int32 Counter = 0; Counter < ECubeCounter::Count; Counter++)
+        {
+            Counters[Counter] += Shard->Counters[Counter];
+        }
+
+        for(int32 Histogram = 0; Histogram < ECubeHistogram::Count; Histogram++)
+        {
+            for(int32 Bucket = 0; Bucket <= MAX_BUCKETS; Bucket++)
+            {
+                HistogramBuckets[Histogram][Bucket] += Shard->HistogramBuckets[Histogram][Bucket];
+            }
+
+            HistogramSums[Histogram] += Shard->HistogramSums[Histogram];
+        }
+    }
+
+    FString Text;
+
+    for(int32 Counter = 0; Counter < ECubeCounter::Count; Counter++)
+    {
+        Text += FString::Printf(TEXT("# HELP %s %s\n# TYPE %s counter\n%s %lld\n"), CounterNames[Counter][0], CounterNames[Counter][1],
+                                CounterNames[Counter][0], CounterNames[Counter][0], Counters[Counter]);
+    }
+
+    for(int32 Gauge = 0; Gauge < ECubeGauge::Count; Gauge++)
+    {
+        Text += FString::Printf(TEXT("# HELP %s %s\n# TYPE %s gauge\n%s %lld\n"), GaugeNames[Gauge][0], GaugeNames[Gauge][1],
+                                GaugeNames[Gauge][0], GaugeNames[Gauge][0], Gauges[Gauge]);
+    }
+
+    for(int32 Histogram = 0; Histogram < ECubeHistogram::Count; Histogram++)
+    {
+        const TCHAR* Name = HistogramNames[Histogram][0];
+        const int32 NumBuckets = GetNumBuckets((ECubeHistogram::Type)Histogram);
+        int64 CumulativeCount = 0;
+
+        Text += FString::Printf(TEXT("# HELP %s %s\n# TYPE %s histogram\n"), Name, HistogramNames[Histogram][1], Name);
+
+        // Prometheus buckets are cumulative: each one counts every value up to its bound
+        for(int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+        {
+            CumulativeCount += HistogramBuckets[Histogram][Bucket];
+            Text += FString::Printf(TEXT("%s_bucket{le=\"%g\"} %lld\n"), Name, HistogramBounds[Histogram][Bucket], CumulativeCount);
+        }
+
+        CumulativeCount += HistogramBuckets[Histogram][NumBuckets];
+        Text += FString::Printf(TEXT("%s_bucket{le=\"+Inf\"} %lld\n%s_sum %.6f\n%s_count %lld\n"), Name, CumulativeCount, Name,
+                                HistogramSums[Histogram] / 1000000.0, Name, CumulativeCount);
+    }
+
+    return Text;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+/** The counters exported by FCubeMetrics. Counters only grow; dashboards derive rates (e.g., hits per second) from them. */
+namespace ECubeCounter
+{
+    enum Type
+    {
+        /** Simulation ticks advanced by the game state. */
+        TicksSimulated,
+        /** Matches played until a team reached the score to win. */
+        MatchesCompleted,
+        Goals,
+        /** Bounces of the ball off players and off walls. */
+        PlayerHits,
+        WallHits,
+        Spins,
+
+        Count
+    };
+}
+
+/** The gauges exported by FCubeMetrics. A gauge holds the last value it was set to. */
+namespace ECubeGauge
+{
+    enum Type
+    {
+        /** The sound and particle components playing and available in the gameplay effect pool (FCubeEffectPool). */
+        EffectPoolActive,
+        EffectPoolCapacity,
+        /** The number of players in the current match. */
+        Players,
+        /** The current EGameState. */
+        GameState,
+
+        Count
+    };
+}
+
+/** The histograms exported by FCubeMetrics. Values are in seconds, and each histogram has fixed bucket bounds so that the
+  * histograms of many instances can be summed into fleet-wide percentiles. */
+namespace ECubeHistogram
+{
+    enum Type
+    {
+        /** The duration of every frame. */
+        FrameTime,
+        /** The time between entering RESET and entering PLAYING, i.e., the pause after each goal. */
+        ResetToPlaying,
+
+        Count
+    };
+}
+
+/**
+ * Process-wide gameplay metrics, exported in the Prometheus text format by FCubeMetricsServer. Counters and histograms are
+ * accumulated per thread: each thread only ever writes to its own shard, without locks or atomic read-modify-writes, and
+ * the shards are merged when the metrics are exported. Shards are added to a lock-free list the first time a thread
+ * records a metric, and live until the module shuts down.
+ */
+class CUBEPROJECT_API FCubeMetrics
+{
+public:
+    /** The maximum number of finite buckets of a histogram. */
+    static constexpr int32 MAX_BUCKETS = 12;
+
+    /** Allocates the thread-local slot used to find each thread's shard. Called when the module starts. */
+    static void Startup();
+
+    /** Frees every shard. Called when the module shuts down, once no other thread records metrics. */
+    static void Shutdown();
+
+    /** Adds to a counter. */
+    static void IncrementCounter(ECubeCounter::Type Counter, int64 Amount = 1);
+
+    /** Sets a gauge. */
+    static void SetGauge(ECubeGauge::Type Gauge, int64 Value);
+
+    /** Adds a value, in seconds, to a histogram. */
+    static void ObserveHistogram(ECubeHistogram::Type Histogram, double Seconds);
+
+    /** Merges the shards of every thread and returns every metric in the Prometheus text exposition format. */
+    static FString Export();
+
+private:
+    /** The metrics recorded by one thread. Only written by its thread; read by Export() on any thread. */
+    struct FShard
+    {
+        volatile int64 Counters[ECubeCounter::Count];
+        /** The number of values which fell in each bucket, the last bucket holding the values above every bound. */
+        volatile int64 HistogramBuckets[ECubeHistogram::Count][MAX_BUCKETS + 1];
+        /** The sum of the values of each histogram, in microseconds, so that it is read and written in one instruction. */
+        volatile int64 HistogramSums[ECubeHistogram::Count];
+        /** The next shard in the list of every shard. */
+        FShard* Next;
+    };
+
+    /** Returns the calling thread's shard, creating it on the first call. */
+    static FShard* GetShard();
+};
@@ -0,0 +1,134 @@
+#include "CubeProject.h"
+#include "CubeMetricsServer.h"
+#include "CubeMetrics.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+FCubeMetricsServer* FCubeMetricsServer::Instance = NULL;
+
+void FCubeMetricsServer::StartServer()
+{
+    int32 Port = 0;
+
+    if(Instance || !FParse::Value(FCommandLine::Get(), TEXT("MetricsPort="), Port))
+        return;
+
+    ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    FSocket* ListenSocket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("CubeMetricsServer"), false);
+
+    // Only listen on the loopback interface: the metrics are scraped by an agent running on the same host
+    TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr(0x7F000001, Port);
+
+    if(!ListenSocket || !ListenSocket->SetReuseAddr(true) || !ListenSocket->Bind(*Address) || !ListenSocket->Listen(8))
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("Could not serve the metrics on port %d"), Port);
+
+        if(ListenSocket)
+        {
+            SocketSubsystem->DestroySocket(ListenSocket);
+        }
+
+        return;
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("Serving the metrics on http://127.0.0.1:%d/metrics"), Port);
+    Instance = new FCubeMetricsServer(ListenSocket);
+}
+
+void FCubeMetricsServer::StopServer()
+{
+    delete Instance;
+    Instance = NULL;
+}
+
+FCubeMetricsServer::FCubeMetricsServer(FSocket* InListenSocket)
+    : ListenSocket(InListenSocket)
+{
+    Thread = FRunnableThread::Create(this, TEXT("CubeMetricsServer"), 0, TPri_BelowNormal);
+}
+
+FCubeMetricsServer::~FCubeMetricsServer()
+{
+    Stop();
+
+    if(Thread)
+    {
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+
+    ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+}
+
+uint32 FCubeMetricsServer::Run()
+{
+    while(StopRequested.GetValue() == 0)
+    {
+        // Wake up regularly to check whether the server was stopped
+        bool bHasPendingConnection = false;
+
+        if(!ListenSocket->WaitForPendingConnection(bHasPendingConnection, FTimespan::FromMilliseconds(100)) || !bHasPendingConnection)
+            continue;
+
+        FSocket* Client = ListenSocket->Accept(TEXT("CubeMetricsClient"));
+
+        if(Client)
+        {
+            ServeClient(Client);
+            Client->Close();
+            ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Client);
+        }
+    }
+
+    return 0;
+}
+
+void FCubeMetricsServer::Stop()
+{
+    StopRequested.Set(1);
+}
+
+void FCubeMetricsServer::ServeClient(FSocket* Client)
+{
+    // Read the request until the end of its headers. A client which sends nothing for a second is dropped.
+    uint8 Request[MAX_REQUEST_SIZE];
+    int32 RequestSize = 0;
+
+    while(RequestSize < MAX_REQUEST_SIZE && Client->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(1)))
+    {
+        int32 BytesRead = 0;
+
+        if(!Client->Recv(Request + RequestSize, MAX_REQUEST_SIZE - RequestSize, BytesRead) || BytesRead == 0)
+            return;
+
+        RequestSize += BytesRead;
+
+        if(RequestSize >= 4 && FMemory::Memcmp(Request + RequestSize - 4, "\r\n\r\n", 4) == 0)
+            break;
+    }
+
+    const FTCHARToUTF8 Body(*FCubeMetrics::Export());
+    const FTCHARToUTF8 Header(*FString::Printf(TEXT("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\n")
+                                                 TEXT("Connection: close\r\n\r\n"), Body.Length()));
+
+    // Send the header and the body, which may take several calls on a slow client
+    const uint8* Buffers[2] = { (const uint8*)Header.Get(), (const uint8*)Body.Get() };
+    const int32 Sizes[2] = { Header.Length(), Body.Length() };
+
+    for(int32 Buffer = 0; Buffer < 2; Buffer++)
+    {
+        int32 BytesSent = 0;
+
+        while(BytesSent < Sizes[Buffer])
+        {
+            int32 Sent = 0;
+
+            // A client which disconnected or stopped reading is dropped, rather than retried forever
+            if(!Client->Send(Buffers[Buffer] + BytesSent, Sizes[Buffer] - BytesSent, Sent) || Sent <= 0)
+                return;
+
+            BytesSent += Sent;
+        }
+    }
+}
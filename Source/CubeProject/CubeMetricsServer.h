@@ -0,0 +1,40 @@
+#pragma once
+
+/**
+ * Serves the metrics of FCubeMetrics over HTTP on a local TCP port, for Prometheus to scrape. Enabled with
+ * -MetricsPort=<port>; each instance on a host needs its own port. The server runs on its own thread and only reads the
+ * metrics' shards, so a scrape never stalls the game thread.
+ */
+class CUBEPROJECT_API FCubeMetricsServer : public FRunnable
+{
+public:
+    /** The longest request read from a client, in bytes. The request itself is ignored: every path serves the metrics. */
+    static constexpr int32 MAX_REQUEST_SIZE = 4096;
+
+    /** Starts the server if -MetricsPort is on the command line. Called when the module starts. */
+    static void StartServer();
+
+    /** Stops the server. Called when the module shuts down. */
+    static void StopServer();
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    explicit FCubeMetricsServer(FSocket* InListenSocket);
+    virtual ~FCubeMetricsServer();
+
+    /** Reads a request from a client, sends the metrics and closes the connection. */
+    void ServeClient(FSocket* Client);
+
+    /** The server, if started. */
+    static FCubeMetricsServer* Instance;
+
+    /** The socket accepting the connections. */
+    FSocket* ListenSocket;
+    /** The thread serving the clients. */
+    FRunnableThread* Thread;
+    /** Set to stop the server's thread. */
+    FThreadSafeCounter StopRequested;
+};
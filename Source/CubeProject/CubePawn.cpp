@@ -4,11 +4,17 @@
 #include "CubePawn.h"
 #include "CubePawnMovementComponent.h"
 #include "CubeProjectGameMode.h"
+#include "CubeProjectGameState.h"
+#include "CubePlayerRegistry.h"
+#include "CubeMatchSim.h"
+#include "CubeLatencyTracker.h"
+#include "MallocCounter.h"
+#include "CubeMatchSaveFormat.h"
 
 ACubePawn::ACubePawn()
 {
-    // Call the pawn's Tick() function every frame
-    PrimaryActorTick.bCanEverTick = true;
+    // The pawn has nothing to update every frame. Its spin cooldown is scheduled on the gameplay timer wheel.
+    PrimaryActorTick.bCanEverTick = false;
 
     // Set the default values for the pawn's spin
     BaseSpinDuration = 0.4f;
@@ -38,43 +44,27 @@ void ACubePawn::BeginPlay()
     StartPosition = GetActorLocation();
 }
 
-void ACubePawn::Tick(float DeltaTime)
-{
-    Super::Tick(DeltaTime);
-
-    // If the pawn is spinning
-    if (bSpinning)
-    {
-        // If the spinning cooldown has elapsed
-        if (SpinTime > SpinCooldown)
-        {
-            // Inform the pawn that it has done spinning, and that it can spin again
-            bSpinning = false;
-            SpinTime = 0;
-        }
-
-        // Increment the amount of time the pawn has been spinning
-        SpinTime += DeltaTime;
-    }
-}
-
 void ACubePawn::SetupPlayerInputComponent(class UInputComponent* InputComponent)
 {
     Super::SetupPlayerInputComponent(InputComponent);
 
+    // Store the slot of the controlling player. Keyboard keys belonging to this slot are routed to this pawn's controller
+    // by UCubeGameViewportClient, so each pawn only binds its own input.
+    PlayerSlot = FCubePlayerRegistry::GetSlot(Controller);
+    const int32 PlayerNumber = FMath::Max(PlayerSlot, 0) + 1;
+    
     // Bind the button inputs to the correct member functions.
-    InputComponent->BindAction("Spin_P1", IE_Released, this, &ACubePawn::OnReleaseActionButton);
-    // Since only one pawn can receive input from the keyboard, we bind the buttons for both players using this single pawn class
-    InputComponent->BindAction("Spin_P2", IE_Released, this, &ACubePawn::OnReleaseActionButton_P2);
+    InputComponent->BindAction(*FString::Printf(TEXT("Spin_P%d"), PlayerNumber), IE_Released, this, &ACubePawn::OnSpinInput);
+    InputComponent->BindAction("Spin", IE_Released, this, &ACubePawn::OnSpinInput);
     InputComponent->BindAction("Restart", IE_Released, this, &ACubePawn::RestartGame);
     InputComponent->BindAction("StartGame", IE_Released, this, &ACubePawn::StartGame);
     
-    // Bind the axis inputs to the correct member functions.
-    InputComponent->BindAxis("MoveY_P1", this, &ACubePawn::MoveY);
-    InputComponent->BindAxis("MoveX_P1", this, &ACubePawn::MoveX);
-    // Since only one pawn can receive input from the keyboard, we bind the axes for both players using this single pawn class
-    InputComponent->BindAxis("MoveY_P2", this, &ACubePawn::MoveY_P2);
-    InputComponent->BindAxis("MoveX_P2", this, &ACubePawn::MoveX_P2);
+    // Bind the axis inputs to the correct member functions. The un-suffixed axes are mapped to gamepads, which already
+    // send their input to the controller they belong to.
+    InputComponent->BindAxis(*FString::Printf(TEXT("MoveY_P%d"), PlayerNumber), this, &ACubePawn::OnKeyboardMoveYInput);
+    InputComponent->BindAxis(*FString::Printf(TEXT("MoveX_P%d"), PlayerNumber), this, &ACubePawn::OnKeyboardMoveXInput);
+    InputComponent->BindAxis("MoveY", this, &ACubePawn::OnGamepadMoveYInput);
+    InputComponent->BindAxis("MoveX", this, &ACubePawn::OnGamepadMoveXInput);
     
     if(GEngine)
         GEngine->AddOnScreenDebugMessage(-1,3.0f,FColor::Yellow,"Setup player input component");
@@ -87,53 +77,98 @@ UPawnMovementComponent* ACubePawn::GetMovementComponent() const
 
 void ACubePawn::MoveY(float AxisValue)
 {
-    // If the pawn's movement component exists and is updated by the root
-    if (PawnMovementComponent && (PawnMovementComponent->UpdatedComponent == RootComponent))
-    {
-        // Add an acceleration vector pointing up at the magnitude of the input axis 
-        PawnMovementComponent->AddInputVector(FVector::UpVector * AxisValue);
-    }
+    InputAxes.Y = AxisValue;
     
+    // Add an acceleration vector pointing up at the magnitude of the input axis
+    AddMovementComponentInput(FVector::UpVector * AxisValue);
 }
 
-/** Moves the second player 'Pawn_P2' in the y-direction. We do this because only a single pawn can receive keyboard input. Thus,
-  * this pawn is responsible for moving the second one too. */
-void ACubePawn::MoveY_P2(float AxisValue)
+void ACubePawn::MoveX(float AxisValue)
 {
-    // If the second player's pawn has been assigned, tell the second player that his y-input has changed
-    if(Pawn_P2)
-    {
-        // Delegate the MoveY call to the second player's pawn. This must be done through this class since
-        // only one pawn can receive keyboard input and thus must call the second pawn's methods manually
-        Pawn_P2->MoveY(AxisValue);
-    }
-
+    InputAxes.X = AxisValue;
+    AddMovementComponentInput(FVector::RightVector * AxisValue);
 }
 
-void ACubePawn::MoveX(float AxisValue)
+void ACubePawn::AddMovementComponentInput(const FVector& WorldInput)
 {
     // If the pawn's movement component exists and is being updated by the root component
     if (PawnMovementComponent && (PawnMovementComponent->UpdatedComponent == RootComponent))
     {
-        PawnMovementComponent->AddInputVector(FVector::RightVector * AxisValue);
+        PawnMovementComponent->AddInputVector(WorldInput);
     }
 }
 
-/** Moves the second player 'Pawn_P2' in the y-direction. We do this because only a single pawn can receive keyboard input. Thus,
-  * this pawn is responsible for moving the second one too. */
-void ACubePawn::MoveX_P2(float AxisValue)
+void ACubePawn::OnKeyboardMoveYInput(float AxisValue)
+{
+    KeyboardAxes.Y = AxisValue;
+    CombineBoundInput(FVector::UpVector * AxisValue);
+}
+
+void ACubePawn::OnKeyboardMoveXInput(float AxisValue)
+{
+    KeyboardAxes.X = AxisValue;
+    CombineBoundInput(FVector::RightVector * AxisValue);
+}
+
+void ACubePawn::OnGamepadMoveYInput(float AxisValue)
 {
-    // If the second player's pawn has been assigned, tell the second player that his x-input has changed
-    if(Pawn_P2)
+    GamepadAxes.Y = AxisValue;
+    CombineBoundInput(FVector::UpVector * AxisValue);
+}
+
+void ACubePawn::OnGamepadMoveXInput(float AxisValue)
+{
+    GamepadAxes.X = AxisValue;
+    CombineBoundInput(FVector::RightVector * AxisValue);
+}
+
+void ACubePawn::CombineBoundInput(const FVector& WorldInput)
+{
+    if(bInputSampled)
+        return;
+    
+    // Every source has sent its value once the last binding of the frame is called, so the axes then hold their sum. The
+    // movement component sums the inputs added to it the same way, and clamps them once it consumes them.
+    InputAxes.X = FMath::Clamp(KeyboardAxes.X + GamepadAxes.X, -1.0f, 1.0f);
+    InputAxes.Y = FMath::Clamp(KeyboardAxes.Y + GamepadAxes.Y, -1.0f, 1.0f);
+    AddMovementComponentInput(WorldInput);
+}
+
+void ACubePawn::OnSpinInput()
+{
+    // The key and the gamepad button are both bound: releasing both during a frame only spins once
+    if(bInputSampled || LastSpinInputFrame == GFrameCounter)
+        return;
+    
+    LastSpinInputFrame = GFrameCounter;
+    
+    FGameplayAllocationScope GameplayAllocationScope;
+    
+    // The engine doesn't stamp its input events: the release happened at the latest when the frame started
+    FCubeLatencyTracker* LatencyTracker = FCubeLatencyTracker::Get();
+    
+    if(LatencyTracker)
     {
-        Pawn_P2->MoveX(AxisValue);
+        LatencyTracker->BeginInput(FApp::GetCurrentTime());
+    }
+    
+    OnReleaseActionButton();
+    
+    if(LatencyTracker)
+    {
+        LatencyTracker->EndInput();
     }
 }
 
 void ACubePawn::OnReleaseActionButton()
 {
-    if(GEngine)
-        GEngine->AddOnScreenDebugMessage(-1,3.0f,FColor::White,"SPIN P1");
+    ReleaseActionButton(0.0f);
+}
+
+void ACubePawn::ReleaseActionButton(float LateSeconds)
+{
+    FCubeLatencyTracker::MarkStage(ECubeLatencyStage::Dispatch);
+    
     // If the pawn is already spinning, return. The pawn can't spin again until it is done its current spin.
     if (bSpinning)
         return; 
@@ -146,47 +181,164 @@ void ACubePawn::OnReleaseActionButton()
         SpinDirection = ERotationDirection::CounterClockwise;
 
     SpinCooldown = BaseSpinDuration;
+    FCubeLatencyTracker::MarkStage(ECubeLatencyStage::SpinEvent);
     Spin(1, BaseSpinDuration, SpinDirection);
-    AddThrust();
+    AddThrust(LateSeconds);
 
     // The pawn can't spin again until it is done its current spin
     bSpinning = true;
     
+    // The game mode only exists on the server; without it, the spin is neither timed nor recorded
     ACubeProjectGameMode* GameMode = GetWorld()->GetAuthGameMode<ACubeProjectGameMode>();
     
-    // Play the sound of the player spinning
-    if(GameMode->PlayerSpinSound)
+    if(!GameMode)
+        return;
+    
+    ACubeProjectGameState* GameState = GameMode->GetGameState<ACubeProjectGameState>();
+    
+    // Let the pawn spin again once the cooldown elapses
+    if(GameState)
     {
-        UGameplayStatics::PlaySoundAtLocation(GetWorld(),GameMode->PlayerSpinSound,GetActorLocation());
+        SpinCooldownTimerHandle = GameState->GetTimerWheel().Schedule(ACubeProjectGameState::SecondsToTicks(SpinCooldown), this,
+                                                                      &ACubePawn::OnSpinCooldownElapsed);
     }
     
-    // Play particles at the position the player is spinning
-    if(GameMode->PlayerSpinParticles)
+    // Record the spin in the match's event log
+    GameMode->RecordMatchEvent(EMatchEventType::Spin, PlayerSlot, GetActorLocation(), FVector::ZeroVector, PawnMovementComponent->Velocity.Size(),
+                               0.0f, SpinDirection);
+    
+    // Play the sound of the player spinning, with particles at the position the player is spinning
+    GameMode->PlayEffect(ECubeEffect::PlayerSpin, GetActorLocation());
+}
+
+void ACubePawn::OnSpinCooldownElapsed()
+{
+    // Inform the pawn that it has done spinning, and that it can spin again
+    bSpinning = false;
+    SpinCooldownTimerHandle.Invalidate();
+}
+
+void ACubePawn::AddThrust(float LateSeconds)
+{
+    // In the determinism mode, the input is only applied on the next simulation tick
+    const FVector2D Input = bDeterministic ? CubeSim::QuantizeInput(InputAxes.X, InputAxes.Y)
+                                           : CubeSim::ToPlane(PawnMovementComponent->GetLastInputVector());
+    const FVector2D Velocity = CubeSim::AddSpinThrust(CubeSim::ToPlane(PawnMovementComponent->Velocity), Input, GetRules());
+
+    const FVector2D ThrustVelocity = Velocity - CubeSim::ToPlane(PawnMovementComponent->Velocity);
+
+    PawnMovementComponent->Velocity = CubeSim::ToWorld(Velocity, PawnMovementComponent->Velocity.X);
+    FCubeLatencyTracker::MarkStage(ECubeLatencyStage::Thrust);
+    
+    // Catch up with the distance the thrust would have covered since the button was released. The determinism mode only
+    // applies input on tick boundaries.
+    if(LateSeconds > 0.0f && !bDeterministic)
     {
-        UGameplayStatics::SpawnEmitterAtLocation(GetWorld(),GameMode->PlayerSpinParticles,GetActorLocation());
+        const FVector Location = GetActorLocation();
+        SetActorLocation(CubeSim::ToWorld(CubeSim::ToPlane(Location) + ThrustVelocity * LateSeconds, Location.X), true);
     }
 }
 
-void ACubePawn::OnReleaseActionButton_P2()
+FCubePawnRules ACubePawn::GetRules() const
+{
+    FCubePawnRules Rules;
+    Rules.MaxSpeed = PawnMovementComponent->MaxSpeed;
+    Rules.Acceleration = PawnMovementComponent->Acceleration;
+    Rules.Deceleration = PawnMovementComponent->Deceleration;
+    Rules.TurningBoost = PawnMovementComponent->TurningBoost;
+    Rules.ThrustForce = BaseThrustForce;
+    return Rules;
+}
+
+void ACubePawn::CaptureSimState(FCubeSimPawn& OutPawn, const FGameplayTimerWheel& TimerWheel) const
 {
-    // If the second player's pawn has been assigned, tell the second player that his action button has been released
-    if(Pawn_P2)
+    OutPawn.Location = CubeSim::ToPlane(GetActorLocation());
+    OutPawn.Velocity = CubeSim::ToPlane(PawnMovementComponent->Velocity);
+    OutPawn.SpinCooldownTicks = (uint16)FMath::Min(TimerWheel.GetRemainingTicks(SpinCooldownTimerHandle), (uint32)MAX_uint16);
+}
+
+void ACubePawn::SaveState(FCubeSavedPawn& OutPawn, const FGameplayTimerWheel& TimerWheel) const
+{
+    FCubeSimPawn SimPawn;
+    CaptureSimState(SimPawn, TimerWheel);
+    
+    OutPawn.StartY = StartPosition.Y;
+    OutPawn.StartZ = StartPosition.Z;
+    OutPawn.LocationY = SimPawn.Location.X;
+    OutPawn.LocationZ = SimPawn.Location.Y;
+    OutPawn.VelocityY = SimPawn.Velocity.X;
+    OutPawn.VelocityZ = SimPawn.Velocity.Y;
+    // The input is stored in the steps of CubeSim::QuantizeAxis(), which quantizes it the same way once restored
+    OutPawn.InputX = CubeSim::QuantizeAxis(InputAxes.X);
+    OutPawn.InputY = CubeSim::QuantizeAxis(InputAxes.Y);
+    OutPawn.bSpinning = bSpinning ? 1 : 0;
+    OutPawn.Padding = 0;
+    OutPawn.SpinCooldownTicks = SimPawn.SpinCooldownTicks;
+}
+
+void ACubePawn::RestoreState(const FCubeSavedPawn& Pawn, FGameplayTimerWheel& TimerWheel)
+{
+    StartPosition = CubeSim::ToWorld(FVector2D(Pawn.StartY, Pawn.StartZ), StartPosition.X);
+    SetActorLocation(CubeSim::ToWorld(FVector2D(Pawn.LocationY, Pawn.LocationZ), GetActorLocation().X));
+    
+    PawnMovementComponent->ConsumeInputVector();
+    PawnMovementComponent->Velocity = CubeSim::ToWorld(FVector2D(Pawn.VelocityY, Pawn.VelocityZ));
+    InputAxes = FVector2D(Pawn.InputX / 127.0f, Pawn.InputY / 127.0f);
+    
+    bSpinning = (Pawn.bSpinning != 0);
+    TimerWheel.Cancel(SpinCooldownTimerHandle);
+    
+    if(Pawn.SpinCooldownTicks > 0)
     {
-        if(GEngine)
-            GEngine->AddOnScreenDebugMessage(-1,3.0f,FColor::White,"Pressed action button (P2)");
-        
-        // Tell the second player that his action button has been released. This must be done through this class since
-        // only one pawn can receive keyboard input
-        Pawn_P2->OnReleaseActionButton();
+        SpinCooldownTimerHandle = TimerWheel.Schedule(Pawn.SpinCooldownTicks, this, &ACubePawn::OnSpinCooldownElapsed);
     }
 }
 
-void ACubePawn::AddThrust()
+void ACubePawn::SetDeterministic(bool bInDeterministic)
 {
-    FVector CurrentInputDirection = PawnMovementComponent->GetLastInputVector().GetSafeNormal2D();
-    FVector ThrustForce = CurrentInputDirection * BaseThrustForce;
+    bDeterministic = bInDeterministic;
+    
+    // The movement component integrates with the frame's delta time, so it only moves the pawn outside of the determinism mode
+    PawnMovementComponent->SetComponentTickEnabled(!bDeterministic);
+}
 
-    PawnMovementComponent->Velocity = PawnMovementComponent->Velocity + ThrustForce;
+void ACubePawn::StepDeterministic(float DeltaTime)
+{
+    // Discard the input accumulated for the movement component, which isn't ticking
+    ConsumeMovementInputVector();
+    
+    const bool bInputIgnored = Controller && Controller->IsMoveInputIgnored();
+    const FVector2D Input = bInputIgnored ? FVector2D::ZeroVector : CubeSim::QuantizeInput(InputAxes.X, InputAxes.Y);
+    const FVector2D Velocity = CubeSim::UpdatePawnVelocity(CubeSim::ToPlane(PawnMovementComponent->Velocity), Input, GetRules(), DeltaTime);
+    
+    PawnMovementComponent->Velocity = CubeSim::ToWorld(Velocity);
+    
+    // Sweep the pawn to its new location, sliding along the surface it hits
+    const FVector Location = GetActorLocation();
+    const FVector2D Delta = CubeSim::Integrate(FVector2D::ZeroVector, Velocity, DeltaTime);
+    FHitResult Hit;
+    
+    SetActorLocation(CubeSim::ToWorld(CubeSim::ToPlane(Location) + Delta, Location.X), true, &Hit);
+    
+    if(Hit.bBlockingHit)
+    {
+        const FVector2D Slide = CubeSim::SlideAlongSurface(Delta, CubeSim::SafeNormal(CubeSim::ToPlane(Hit.Normal)), 1.0f - Hit.Time);
+        const FVector HitLocation = GetActorLocation();
+        
+        SetActorLocation(CubeSim::ToWorld(CubeSim::ToPlane(HitLocation) + Slide, HitLocation.X), true);
+    }
+}
+
+void ACubePawn::HashState(FCubeStateHasher& Hasher, const FGameplayTimerWheel& TimerWheel) const
+{
+    const FVector2D Input = CubeSim::QuantizeInput(InputAxes.X, InputAxes.Y);
+    
+    Hasher.AddPlaneVector(TEXT("Pawn.Location.Y"), TEXT("Pawn.Location.Z"), PlayerSlot, GetActorLocation());
+    Hasher.AddPlaneVector(TEXT("Pawn.Velocity.Y"), TEXT("Pawn.Velocity.Z"), PlayerSlot, PawnMovementComponent->Velocity);
+    Hasher.AddFloat(TEXT("Pawn.Input.X"), PlayerSlot, Input.X);
+    Hasher.AddFloat(TEXT("Pawn.Input.Y"), PlayerSlot, Input.Y);
+    Hasher.AddBool(TEXT("Pawn.Spinning"), PlayerSlot, bSpinning);
+    Hasher.AddInt(TEXT("Pawn.SpinCooldown"), PlayerSlot, (int32)TimerWheel.GetRemainingTicks(SpinCooldownTimerHandle));
 }
 
 void ACubePawn::StartGame()
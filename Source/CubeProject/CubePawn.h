@@ -3,6 +3,8 @@
 #pragma once
 
 #include "GameFramework/Pawn.h"
+#include "GameplayTimerWheel.h"
+#include "CubeSimRules.h"
 #include "CubePawn.generated.h"
 
 /** Denotes a rotation direction (either clockwise or counter-clockwise) */
@@ -28,9 +30,6 @@ public:
     // Called when the game starts or when spawned
     virtual void BeginPlay() override;
 
-    // Called every frame
-    virtual void Tick(float DeltaSeconds) override;
-
     // Called to bind input to functionality
     virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
 
@@ -44,15 +43,52 @@ public:
 
     /** Called when the user releases the spin button. */
     void OnReleaseActionButton();
+    
+    /** Spins the pawn for a release of the spin button which happened the given time ago, within the current frame. The
+      * pawn is moved as if the thrust of the spin had been added at that time. */
+    void ReleaseActionButton(float LateSeconds);
 
-    /** Adds a force to the pawn, making him move faster in his current movement direction. */
-    void AddThrust();
+    /** Adds a force to the pawn, making him move faster in his current movement direction. If the thrust is added late,
+      * the pawn is also moved by the distance the thrust would have covered in the meantime. */
+    void AddThrust(float LateSeconds = 0.0f);
+    
+    /** Sets whether the player's input is sampled by FCubeInputSampler. The pawn then ignores its per-frame input bindings,
+      * and the game mode calls MoveX(), MoveY() and ReleaseActionButton() with the sampled input instead. */
+    FORCEINLINE void SetInputSampled(bool bInInputSampled) { bInputSampled = bInInputSampled; }
     
     /** Called when a player scores. Resets the pawn at its starting position. */
     void Reset();
     
-    /** Sets the pawn controlled by player 2. Since only one pawn can be possessed by a keyboard, one pawn must control the other manually. */
-    FORCEINLINE void SetPawn_P2(ACubePawn* Pawn_P2) { this->Pawn_P2 = Pawn_P2; }
+    /** Enables or disables the determinism mode. In this mode, the pawn is moved by StepDeterministic() instead of its
+      * movement component. */
+    void SetDeterministic(bool bInDeterministic);
+    
+    /** Moves the pawn by one simulation tick in the determinism mode, using the last input it received. */
+    void StepDeterministic(float DeltaTime);
+    
+    /** Adds the pawn's gameplay state to the given hash. */
+    void HashState(FCubeStateHasher& Hasher, const FGameplayTimerWheel& TimerWheel) const;
+    
+    /** Returns the pawn's movement tuning in the form used by the gameplay rules. */
+    FCubePawnRules GetRules() const;
+    
+    /** Copies the pawn's gameplay state to its form in the match simulation. */
+    void CaptureSimState(struct FCubeSimPawn& OutPawn, const FGameplayTimerWheel& TimerWheel) const;
+    
+    /** Copies the pawn's state to a saved match. */
+    void SaveState(struct FCubeSavedPawn& OutPawn, const FGameplayTimerWheel& TimerWheel) const;
+    
+    /** Replaces the pawn's state with a saved one. The spin cooldown is scheduled again on the given wheel. */
+    void RestoreState(const struct FCubeSavedPawn& Pawn, FGameplayTimerWheel& TimerWheel);
+    
+    /** Returns the time the pawn waits between two spins, in seconds. */
+    FORCEINLINE float GetSpinDuration() const { return BaseSpinDuration; }
+    
+    /** Returns true if the pawn is spinning. The pawn can't spin again until it is done spinning. */
+    FORCEINLINE bool IsSpinning() const { return bSpinning; }
+    
+    /** Returns the slot of the player controlling this pawn, or INDEX_NONE if the pawn is not controlled by a local player. */
+    FORCEINLINE int32 GetPlayerSlot() const { return PlayerSlot; }
 
     /** 
      * Spins the actor 'RotationCount' times in 'Duration' seconds. This is implemented in Blueprint. 
@@ -82,22 +118,46 @@ public:
     float BaseThrustForce;
 
 private:
-    /** Moves the second player 'Pawn_P2' in the y-direction. We do this because only a single pawn can receive keyboard input. Thus,
-      * this pawn is responsible for moving the second one too. */
-    void MoveY_P2(float AxisValue);
-    /** Moves the second player 'Pawn_P2' in the y-direction. We do this because only a single pawn can receive keyboard input. Thus,
-      * this pawn is responsible for moving the second one too. */
-    void MoveX_P2(float AxisValue);
-    /** Called when the second player releases his action button. We need this method because only a single pawn can receive
-      * keyboard input. Hence, this pawn class is responsible for moving the second one too. */
-    void OnReleaseActionButton_P2();
     /** Called when the user presses the Start key in the main menu. Tells the current game mode to start the game. */
     void StartGame();
     /** Called when the user presses the Restart key. Tells the current game mode to restart the game. */
     void RestartGame();
     
-    /** The pawn possessed by the second player. Since only one pawn can be possessed by a keyboard, one pawn must control the other manually. */
-    ACubePawn* Pawn_P2;
+    /** Called by the input bindings of the player's keyboard keys and gamepad. Both are bound every frame, so each source
+      * keeps its own value and the pawn moves with their sum. Ignored if the input is sampled by FCubeInputSampler. */
+    void OnKeyboardMoveYInput(float AxisValue);
+    void OnKeyboardMoveXInput(float AxisValue);
+    void OnGamepadMoveYInput(float AxisValue);
+    void OnGamepadMoveXInput(float AxisValue);
+    void OnSpinInput();
+    
+    /** Sets the movement axes to the sum of the keyboard and gamepad axes, clamped to [-1, 1], and adds the input which
+      * just changed to the movement component. */
+    void CombineBoundInput(const FVector& WorldInput);
+    
+    /** Adds a movement input to the movement component, if it moves the pawn. */
+    void AddMovementComponentInput(const FVector& WorldInput);
+    
+    /** Called by the gameplay timer wheel once the spin cooldown elapses. Lets the pawn spin again. */
+    void OnSpinCooldownElapsed();
+    
+    /** The slot of the player controlling this pawn. Determines which of the "_P1" to "_P8" input mappings the pawn binds. */
+    int32 PlayerSlot = INDEX_NONE;
+    
+    /** The last value of the horizontal (X) and vertical (Y) movement axes. Used by the determinism mode. */
+    FVector2D InputAxes = FVector2D::ZeroVector;
+    /** The last value of the movement axes of the player's keyboard keys and gamepad, which InputAxes combines. */
+    FVector2D KeyboardAxes = FVector2D::ZeroVector;
+    FVector2D GamepadAxes = FVector2D::ZeroVector;
+    /** The frame during which the spin button was last released. A release of both the key and the gamepad button during
+      * the same frame is one spin. */
+    uint64 LastSpinInputFrame = MAX_uint64;
+    
+    /** If true, the pawn is moved by StepDeterministic() instead of its movement component. */
+    bool bDeterministic = false;
+    
+    /** If true, the player's input is sampled by FCubeInputSampler instead of being read from the input bindings. */
+    bool bInputSampled = false;
     
     /** The position at which the pawn was first spawned. This is where the pawn will be respawned after a goal. */
     FVector StartPosition;
@@ -105,9 +165,9 @@ private:
     /** If true, the pawn is currently spinning. The pawn can't spin again until it is done spinning. */
     bool bSpinning;
 
-    /** The amount of time the pawn has been spinning. */
-    float SpinTime;
     /** The amount of time to wait between two successive spins. */
     float SpinCooldown;
+    /** The timer which ends the spin cooldown. */
+    FGameplayTimerHandle SpinCooldownTimerHandle;
 
 };
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "CubeProject.h"
+#include "CubePerfBaseline.h"
+
+FString CubePerfBaseline::GetFileName()
+{
+    return FPaths::GameConfigDir() / TEXT("PerfBaseline.ini");
+}
+
+bool CubePerfBaseline::SetValues(const FString& FileName, const FString& Section, const TArray<FString>& Keys, const TArray<FString>& Values)
+{
+    check(Keys.Num() == Values.Num());
+
+    FString Text;
+    FFileHelper::LoadFileToString(Text, *FileName);
+
+    TArray<FString> Lines;
+    Text.ParseIntoArrayLines(Lines, false);
+
+    // Find the section's header, and the line after its last key. Comments and blank lines after the last key belong to the
+    // next section.
+    const FString Header = FString::Printf(TEXT("[%s]"), *Section);
+    int32 SectionStart = INDEX_NONE;
+    int32 SectionEnd = INDEX_NONE;
+
+    for(int32 Index = 0; Index < Lines.Num(); Index++)
+    {
+        const FString Line = Lines[Index].Trim().TrimTrailing();
+
+        if(SectionStart == INDEX_NONE)
+        {
+            if(Line == Header)
+            {
+                SectionStart = Index;
+                SectionEnd = Index + 1;
+            }
+        }
+        else if(Line.StartsWith(TEXT("[")))
+        {
+            break;
+        }
+        else if(!Line.IsEmpty() && !Line.StartsWith(TEXT(";")))
+        {
+            SectionEnd = Index + 1;
+        }
+    }
+
+    if(SectionStart == INDEX_NONE)
+    {
+        // Add the section at the end of the file, after a blank line
+        while(Lines.Num() > 0 && Lines.Last().Trim().IsEmpty())
+        {
+            Lines.Pop();
+        }
+
+        if(Lines.Num() > 0)
+        {
+            Lines.Add(FString());
+        }
+
+        Lines.Add(Header);
+        SectionStart = Lines.Num() - 1;
+        SectionEnd = Lines.Num();
+    }
+
+    for(int32 KeyIndex = 0; KeyIndex < Keys.Num(); KeyIndex++)
+    {
+        const FString NewLine = Keys[KeyIndex] + TEXT("=") + Values[KeyIndex];
+        bool bReplaced = false;
+
+        for(int32 Index = SectionStart + 1; Index < SectionEnd && !bReplaced; Index++)
+        {
+            FString Key;
+
+            if(!Lines[Index].Trim().StartsWith(TEXT(";")) && Lines[Index].Split(TEXT("="), &Key, NULL) && Key.Trim().TrimTrailing() == Keys[KeyIndex])
+            {
+                Lines[Index] = NewLine;
+                bReplaced = true;
+            }
+        }
+
+        if(!bReplaced)
+        {
+            Lines.Insert(NewLine, SectionEnd);
+            SectionEnd++;
+        }
+    }
+
+    FString NewText;
+
+    for(const FString& Line : Lines)
+    {
+        NewText += Line;
+        NewText += LINE_TERMINATOR;
+    }
+
+    return FFileHelper::SaveStringToFile(NewText, *FileName);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+/** Edits Config/PerfBaseline.ini, the baseline shared by the performance suite and the benchmark commandlets. The file is
+  * edited as text rather than written with FConfigFile::Write(), which would drop the comments documenting how each of its
+  * sections is recorded. */
+namespace CubePerfBaseline
+{
+    /** Returns the baseline file checked in with the game. */
+    CUBEPROJECT_API FString GetFileName();
+
+    /** Sets keys of a section of the baseline file to the given values. A key already in the section is replaced on its line,
+      * and the others are added after the section's last key. A missing section is added at the end of the file. Every other
+      * line, comments included, is kept as it is. Returns false if the file could not be written. */
+    CUBEPROJECT_API bool SetValues(const FString& FileName, const FString& Section, const TArray<FString>& Keys, const TArray<FString>& Values);
+}
@@ -0,0 +1,57 @@
+#include "CubeProject.h"
+#include "CubePerfProbe.h"
+
+void FCubePerfProbePostPhysicsTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+                                                        const FGraphEventRef& MyCompletionGraphEvent)
+{
+    if(Target && !Target->IsPendingKill())
+    {
+        Target->OnPostPhysics();
+    }
+}
+
+FString FCubePerfProbePostPhysicsTickFunction::DiagnosticMessage()
+{
+    return TEXT("ACubePerfProbe post-physics tick");
+}
+
+ACubePerfProbe::ACubePerfProbe()
+{
+    // Tick before physics starts. The second tick function runs once it is done.
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+    PostPhysicsTick.bCanEverTick = true;
+    PostPhysicsTick.TickGroup = TG_PostPhysics;
+    PostPhysicsTick.Target = this;
+
+    PrePhysicsCycles = 0;
+    PhysicsMilliseconds = 0.0f;
+}
+
+void ACubePerfProbe::BeginPlay()
+{
+    Super::BeginPlay();
+
+    PostPhysicsTick.Target = this;
+    PostPhysicsTick.RegisterTickFunction(GetLevel());
+}
+
+void ACubePerfProbe::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    PostPhysicsTick.UnRegisterTickFunction();
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void ACubePerfProbe::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    PrePhysicsCycles = FPlatformTime::Cycles();
+}
+
+void ACubePerfProbe::OnPostPhysics()
+{
+    PhysicsMilliseconds = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - PrePhysicsCycles);
+}
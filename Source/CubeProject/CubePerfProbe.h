@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "CubePerfProbe.generated.h"
+
+/** Tick function which notifies an ACubePerfProbe once the physics simulation of the frame is done. */
+struct FCubePerfProbePostPhysicsTickFunction : public FTickFunction
+{
+    /** The probe to notify. */
+    class ACubePerfProbe* Target;
+
+    // FTickFunction interface
+    virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+    virtual FString DiagnosticMessage() override;
+};
+
+/**
+ * Measures the time the world spends simulating physics each frame. Ticks once before physics (its primary tick) and once
+ * after (a second tick function), so the measured time also includes the actors ticking in between, which is small in
+ * this game. Spawned by FCubePerfSuite in every level it measures.
+ */
+UCLASS(NotPlaceable, Transient)
+class CUBEPROJECT_API ACubePerfProbe : public AActor
+{
+    GENERATED_BODY()
+
+public:
+    ACubePerfProbe();
+
+    // Called when the game starts or when spawned
+    virtual void BeginPlay() override;
+
+    // Called when the probe is destroyed or the level is unloaded
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    // Called every frame before physics
+    virtual void Tick(float DeltaSeconds) override;
+
+    /** Called once physics is done for the frame. */
+    void OnPostPhysics();
+
+    /** Returns the time spent simulating physics during the last frame, in milliseconds. */
+    FORCEINLINE float GetPhysicsMilliseconds() const { return PhysicsMilliseconds; }
+
+private:
+    /** Ticks the probe after physics. */
+    FCubePerfProbePostPhysicsTickFunction PostPhysicsTick;
+
+    /** The cycle counter when the probe ticked before physics. */
+    uint32 PrePhysicsCycles;
+
+    /** The time spent simulating physics during the last frame. */
+    float PhysicsMilliseconds;
+};
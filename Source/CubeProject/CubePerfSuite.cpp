@@ -0,0 +1,402 @@
+#include "CubeProject.h"
+#include "CubePerfSuite.h"
+#include "CubePerfProbe.h"
+#include "CubeProjectGameMode.h"
+#include "CubeProjectGameState.h"
+#include "CubeBot.h"
+#include "MallocCounter.h"
+#include "CubePerfBaseline.h"
+
+FCubePerfSuite* FCubePerfSuite::Instance = NULL;
+
+/** The default relative tolerance and absolute slack of each metric, used when Config/PerfBaseline.ini does not set them.
+  * A metric regresses when it exceeds Baseline * (1 + Tolerance) + Slack. */
+static const float DEFAULT_TOLERANCES[ECubePerfMetric::Count] = { 0.25f, 0.25f, 0.25f, 0.10f, 0.10f, 0.0f, 0.05f, 0.0f };
+static const float DEFAULT_SLACK[ECubePerfMetric::Count] = { 0.5f, 1.0f, 0.5f, 5.0f, 1.0f, 2.0f, 100.0f, 0.0f };
+
+/** The names of the baseline file's sections holding the tolerances and slack of each metric. */
+static const TCHAR* TOLERANCES_SECTION = TEXT("Tolerances");
+static const TCHAR* SLACK_SECTION = TEXT("Slack");
+
+void FCubePerfSuite::Start()
+{
+    if(!Instance)
+    {
+        Instance = new FCubePerfSuite();
+    }
+}
+
+void FCubePerfSuite::Stop()
+{
+    delete Instance;
+    Instance = NULL;
+}
+
+FCubePerfSuite::FCubePerfSuite()
+    : MapIndex(0)
+    , Phase(ECubePerfSuitePhase::LoadingMap)
+    , bMapRequested(false)
+    , MatchTime(0.0f)
+    , NumFrames(0)
+    , StartAllocations(0)
+    , StartAllocatedBytes(0)
+    , PeakActorCount(0)
+    , LastGameplayAllocations(0)
+    , bLastFramePlaying(false)
+    , PeakPlayingFrameAllocations(0)
+{
+    GConfig->GetArray(TEXT("CubePerfSuite"), TEXT("Maps"), Maps, GGameIni);
+
+    if(Maps.Num() == 0)
+    {
+        // Measure the main menu and every arena by default
+        Maps.Add(TEXT("MainMenu"));
+
+        for(int32 Index = 1; Index <= 17; Index++)
+        {
+            Maps.Add(FString::Printf(TEXT("Test_%02d"), Index));
+        }
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("PerfSuite: measuring %d levels"), Maps.Num());
+}
+
+void FCubePerfSuite::OnGameModeBeginPlay(ACubeProjectGameMode* InGameMode)
+{
+    GameMode = InGameMode;
+
+    if(Phase == ECubePerfSuitePhase::Done)
+        return;
+
+    // The game boots into its default level, which may not be the next one to measure
+    if(GetShortMapName(InGameMode->GetWorld()) != Maps[MapIndex])
+    {
+        Phase = ECubePerfSuitePhase::LoadingMap;
+        bMapRequested = false;
+        return;
+    }
+
+    // Let a scripted bot play in every slot
+    for(int32 Slot = 0; Slot < InGameMode->GetPlayerRegistry().Num(); Slot++)
+    {
+        InGameMode->SetBot(Slot, MakeShareable(new FCubeScriptedBot()));
+    }
+
+    Probe = InGameMode->GetWorld()->SpawnActor<ACubePerfProbe>();
+    Phase = ECubePerfSuitePhase::StartingMatch;
+}
+
+bool FCubePerfSuite::Tick(float DeltaTime)
+{
+    ACubeProjectGameMode* CurrentGameMode = GameMode.Get();
+
+    // Wait for a level to be loaded
+    if(!CurrentGameMode)
+        return true;
+
+    switch(Phase)
+    {
+        case ECubePerfSuitePhase::LoadingMap:
+        {
+            if(!bMapRequested)
+            {
+                UE_LOG(LogCubeProject, Display, TEXT("PerfSuite: loading %s"), *Maps[MapIndex]);
+                UGameplayStatics::OpenLevel(CurrentGameMode, FName(*Maps[MapIndex]));
+                bMapRequested = true;
+            }
+            break;
+        }
+        case ECubePerfSuitePhase::StartingMatch:
+        {
+            ACubeProjectGameState* GameState = CurrentGameMode->GetGameState<ACubeProjectGameState>();
+
+            // Start the match as if the user pressed the start key in the main menu
+            if(GameState && GameState->GetState() == EGameState::MAIN_MENU)
+            {
+                MatchTime = 0.0f;
+                NumFrames = 0;
+                GameThreadHistogram.Reset();
+                PhysicsHistogram.Reset();
+                PeakActorCount = 0;
+
+                FMallocCounter* MallocCounter = FMallocCounter::Get();
+                StartAllocations = MallocCounter ? MallocCounter->GetNumAllocations() : 0;
+                StartAllocatedBytes = MallocCounter ? MallocCounter->GetNumAllocatedBytes() : 0;
+                LastGameplayAllocations = MallocCounter ? MallocCounter->GetNumGameplayAllocations() : 0;
+                bLastFramePlaying = false;
+                PeakPlayingFrameAllocations = 0;
+
+                CurrentGameMode->StartGame();
+                Phase = ECubePerfSuitePhase::Measuring;
+            }
+            break;
+        }
+        case ECubePerfSuitePhase::Measuring:
+        {
+            SampleFrame(DeltaTime);
+
+            ACubeProjectGameState* GameState = CurrentGameMode->GetGameState<ACubeProjectGameState>();
+
+            if(GameState && GameState->GetState() == EGameState::WAITING_TO_RESTART)
+            {
+                FinishMap(true);
+            }
+            else if(MatchTime > MATCH_TIMEOUT)
+            {
+                UE_LOG(LogCubeProject, Warning, TEXT("PerfSuite: the match on %s did not end within %.0f seconds"), *Maps[MapIndex], MATCH_TIMEOUT);
+                FinishMap(false);
+            }
+            break;
+        }
+        case ECubePerfSuitePhase::Done:
+        {
+            break;
+        }
+    }
+
+    return true;
+}
+
+void FCubePerfSuite::SampleFrame(float DeltaTime)
+{
+    MatchTime += DeltaTime;
+    NumFrames++;
+
+    GameThreadHistogram.RecordMilliseconds(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+    if(Probe.IsValid())
+    {
+        PhysicsHistogram.RecordMilliseconds(Probe->GetPhysicsMilliseconds());
+    }
+
+    if(GameMode.IsValid())
+    {
+        PeakActorCount = FMath::Max(PeakActorCount, GameMode->GetWorld()->GetActorCount());
+    }
+
+    // Only the frames which start and end in PLAYING are held to the allocation target: a goal ends the rally, and with
+    // the last goal, the match's result is written to disk
+    const ACubeProjectGameState* GameState = GameMode.IsValid() ? GameMode->GetGameState<ACubeProjectGameState>() : NULL;
+    const bool bPlaying = GameState && GameState->GetState() == EGameState::PLAYING;
+
+    if(FMallocCounter* MallocCounter = FMallocCounter::Get())
+    {
+        const uint64 GameplayAllocations = MallocCounter->GetNumGameplayAllocations();
+
+        if(bPlaying && bLastFramePlaying)
+        {
+            PeakPlayingFrameAllocations = FMath::Max(PeakPlayingFrameAllocations, (int32)(GameplayAllocations - LastGameplayAllocations));
+        }
+
+        LastGameplayAllocations = GameplayAllocations;
+    }
+
+    bLastFramePlaying = bPlaying;
+}
+
+void FCubePerfSuite::FinishMap(bool bCompleted)
+{
+    FCubePerfResult Result;
+    Result.MapName = Maps[MapIndex];
+    Result.bCompleted = bCompleted;
+    Result.NumFrames = NumFrames;
+
+    const float FrameCount = (float)FMath::Max(NumFrames, 1);
+    FMallocCounter* MallocCounter = FMallocCounter::Get();
+
+    Result.Values[ECubePerfMetric::GameThreadP50] = GameThreadHistogram.GetPercentileMilliseconds(50.0f);
+    Result.Values[ECubePerfMetric::GameThreadP95] = GameThreadHistogram.GetPercentileMilliseconds(95.0f);
+    Result.Values[ECubePerfMetric::PhysicsP95] = PhysicsHistogram.GetPercentileMilliseconds(95.0f);
+    Result.Values[ECubePerfMetric::AllocationsPerFrame] = MallocCounter ? (MallocCounter->GetNumAllocations() - StartAllocations) / FrameCount : 0.0f;
+    Result.Values[ECubePerfMetric::AllocatedKBPerFrame] = MallocCounter ? (MallocCounter->GetNumAllocatedBytes() - StartAllocatedBytes) / 1024.0f / FrameCount
+                                                                         : 0.0f;
+    Result.Values[ECubePerfMetric::PeakActorCount] = (float)PeakActorCount;
+    Result.Values[ECubePerfMetric::PlayingFrameAllocations] = (float)PeakPlayingFrameAllocations;
+
+    int32 ObjectCount = 0;
+
+    for(TObjectIterator<UObject> ObjectIterator; ObjectIterator; ++ObjectIterator)
+    {
+        ObjectCount++;
+    }
+
+    Result.Values[ECubePerfMetric::ObjectCount] = (float)ObjectCount;
+
+    Results.Add(Result);
+
+    UE_LOG(LogCubeProject, Display, TEXT("PerfSuite: %s measured over %d frames (game thread p95 %.2f ms, physics p95 %.2f ms, %.1f allocations per frame, ")
+           TEXT("%d gameplay allocations in the worst PLAYING frame)"), *Result.MapName, NumFrames, Result.Values[ECubePerfMetric::GameThreadP95],
+           Result.Values[ECubePerfMetric::PhysicsP95], Result.Values[ECubePerfMetric::AllocationsPerFrame], PeakPlayingFrameAllocations);
+
+    // Move on to the next level
+    MapIndex++;
+    bMapRequested = false;
+
+    if(MapIndex < Maps.Num())
+    {
+        Phase = ECubePerfSuitePhase::LoadingMap;
+    }
+    else
+    {
+        FinishSuite();
+    }
+}
+
+void FCubePerfSuite::FinishSuite()
+{
+    Phase = ECubePerfSuitePhase::Done;
+
+    const FString BaselineFileName = CubePerfBaseline::GetFileName();
+
+    if(FParse::Param(FCommandLine::Get(), TEXT("UpdateBaseline")))
+    {
+        UpdateBaseline(BaselineFileName);
+    }
+
+    FConfigFile Baseline;
+    Baseline.Read(BaselineFileName);
+
+    // Write a line per level with its metrics and how they compare to the baseline
+    FString Csv = TEXT("Map,Completed,Frames");
+
+    for(int32 Metric = 0; Metric < ECubePerfMetric::Count; Metric++)
+    {
+        Csv += FString::Printf(TEXT(",%s"), GetMetricName((ECubePerfMetric::Type)Metric));
+    }
+
+    Csv += TEXT(",Status\n");
+
+    int32 NumRegressions = 0;
+
+    for(const FCubePerfResult& Result : Results)
+    {
+        FString Status;
+        NumRegressions += CompareToBaseline(Result, Baseline, Status);
+
+        if(!Result.bCompleted)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("PerfSuite: %s: the match did not complete"), *Result.MapName);
+            NumRegressions++;
+        }
+
+        if(Result.Values[ECubePerfMetric::PlayingFrameAllocations] > MAX_PLAYING_FRAME_ALLOCATIONS)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("PerfSuite: %s: gameplay code allocated %.0f times in a PLAYING frame (target %d). Run with -AllocTrace to log where."),
+                   *Result.MapName, Result.Values[ECubePerfMetric::PlayingFrameAllocations], MAX_PLAYING_FRAME_ALLOCATIONS);
+            NumRegressions++;
+        }
+
+        Csv += FString::Printf(TEXT("%s,%d,%d"), *Result.MapName, Result.bCompleted ? 1 : 0, Result.NumFrames);
+
+        for(int32 Metric = 0; Metric < ECubePerfMetric::Count; Metric++)
+        {
+            Csv += FString::Printf(TEXT(",%.3f"), Result.Values[Metric]);
+        }
+
+        Csv += FString::Printf(TEXT(",%s\n"), *Status);
+    }
+
+    const FString ReportFileName = FPaths::GameSavedDir() / TEXT("PerfSuite") / TEXT("Report.csv");
+    FFileHelper::SaveStringToFile(Csv, *ReportFileName);
+
+    if(NumRegressions > 0)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("PerfSuite: FAILED with %d regressions. Report written to %s"), NumRegressions, *ReportFileName);
+    }
+    else
+    {
+        UE_LOG(LogCubeProject, Display, TEXT("PerfSuite: PASSED. Report written to %s"), *ReportFileName);
+    }
+
+    CubeTestRun::RequestExit(NumRegressions > 0);
+}
+
+int32 FCubePerfSuite::CompareToBaseline(const FCubePerfResult& Result, const FConfigFile& Baseline, FString& OutStatus) const
+{
+    const FConfigSection* MapSection = Baseline.Find(Result.MapName);
+
+    // A level without a baseline fails, so that a level added to the suite can't go unchecked
+    if(!MapSection)
+    {
+        OutStatus = TEXT("NoBaseline");
+        UE_LOG(LogCubeProject, Error, TEXT("PerfSuite: %s has no baseline. Run with -UpdateBaseline on the reference machine to record one."),
+               *Result.MapName);
+        return 1;
+    }
+
+    int32 NumRegressions = 0;
+    OutStatus = TEXT("OK");
+
+    for(int32 Metric = 0; Metric < ECubePerfMetric::Count; Metric++)
+    {
+        const TCHAR* MetricName = GetMetricName((ECubePerfMetric::Type)Metric);
+        const FString* BaselineValue = MapSection->Find(MetricName);
+
+        if(!BaselineValue)
+            continue;
+
+        FString ToleranceString;
+        FString SlackString;
+        const float Tolerance = Baseline.GetString(TOLERANCES_SECTION, MetricName, ToleranceString) ? FCString::Atof(*ToleranceString)
+                                                                                                  : DEFAULT_TOLERANCES[Metric];
+        const float Slack = Baseline.GetString(SLACK_SECTION, MetricName, SlackString) ? FCString::Atof(*SlackString) : DEFAULT_SLACK[Metric];
+
+        const float Expected = FCString::Atof(**BaselineValue);
+        const float Limit = Expected * (1.0f + Tolerance) + Slack;
+
+        if(Result.Values[Metric] > Limit)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("PerfSuite: %s: %s regressed to %.3f (baseline %.3f, limit %.3f)"), *Result.MapName, MetricName,
+                   Result.Values[Metric], Expected, Limit);
+
+            OutStatus = NumRegressions == 0 ? FString::Printf(TEXT("Regressed:%s"), MetricName) : OutStatus + TEXT("+") + MetricName;
+            NumRegressions++;
+        }
+    }
+
+    return NumRegressions;
+}
+
+void FCubePerfSuite::UpdateBaseline(const FString& BaselineFileName) const
+{
+    // Only the levels' sections are replaced, so hand-tuned tolerances and the file's comments are kept
+    TArray<FString> Keys;
+    TArray<FString> Values;
+
+    for(const FCubePerfResult& Result : Results)
+    {
+        if(!Result.bCompleted)
+            continue;
+
+        Keys.Reset();
+        Values.Reset();
+
+        for(int32 Metric = 0; Metric < ECubePerfMetric::Count; Metric++)
+        {
+            Keys.Add(GetMetricName((ECubePerfMetric::Type)Metric));
+            Values.Add(FString::Printf(TEXT("%.3f"), Result.Values[Metric]));
+        }
+
+        if(!CubePerfBaseline::SetValues(BaselineFileName, Result.MapName, Keys, Values))
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("PerfSuite: could not write the baseline of %s to %s"), *Result.MapName, *BaselineFileName);
+            return;
+        }
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("PerfSuite: baseline written to %s"), *BaselineFileName);
+}
+
+FString FCubePerfSuite::GetShortMapName(const UWorld* World)
+{
+    return UWorld::RemovePIEPrefix(World->GetMapName());
+}
+
+const TCHAR* FCubePerfSuite::GetMetricName(ECubePerfMetric::Type Metric)
+{
+    static const TCHAR* Names[ECubePerfMetric::Count] = { TEXT("GameThreadP50"), TEXT("GameThreadP95"), TEXT("PhysicsP95"),
+                                                          TEXT("AllocationsPerFrame"), TEXT("AllocatedKBPerFrame"), TEXT("PeakActorCount"),
+                                                          TEXT("ObjectCount"), TEXT("PlayingFrameAllocations") };
+
+    return Names[Metric];
+}
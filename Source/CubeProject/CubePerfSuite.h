@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Ticker.h"
+#include "FrameTimeHistogram.h"
+
+class ACubeProjectGameMode;
+class ACubePerfProbe;
+
+/** The metrics measured for each level by FCubePerfSuite. Their names are the keys used in Config/PerfBaseline.ini. */
+namespace ECubePerfMetric
+{
+    enum Type
+    {
+        /** The median game thread time while the match is played, in milliseconds. */
+        GameThreadP50,
+        /** The 95th percentile of the game thread time while the match is played, in milliseconds. */
+        GameThreadP95,
+        /** The 95th percentile of the time spent simulating physics, in milliseconds. */
+        PhysicsP95,
+        /** The average number of game thread allocations per frame. */
+        AllocationsPerFrame,
+        /** The average number of kilobytes allocated on the game thread per frame. */
+        AllocatedKBPerFrame,
+        /** The largest number of actors in the level at any time during the match. */
+        PeakActorCount,
+        /** The number of UObjects alive at the end of the match. */
+        ObjectCount,
+        /** The largest number of allocations made by gameplay code in a frame played entirely in the PLAYING state. Must
+          * not exceed FCubePerfSuite::MAX_PLAYING_FRAME_ALLOCATIONS, whatever the baseline. */
+        PlayingFrameAllocations,
+
+        Count
+    };
+}
+
+/** The steps the suite goes through for each level. */
+namespace ECubePerfSuitePhase
+{
+    enum Type
+    {
+        /** Waiting for the next level to load. */
+        LoadingMap,
+        /** The level is loaded. Waiting for the game to reach the main menu to start the match. */
+        StartingMatch,
+        /** The bots are playing the match. */
+        Measuring,
+        /** Every level has been measured. */
+        Done
+    };
+}
+
+/** The metrics measured for one level. */
+struct FCubePerfResult
+{
+    /** The name of the level. */
+    FString MapName;
+    /** True if the match ended before the time limit. */
+    bool bCompleted;
+    /** The number of frames measured. */
+    int32 NumFrames;
+    /** The value of each ECubePerfMetric. */
+    float Values[ECubePerfMetric::Count];
+};
+
+/**
+ * Automated performance regression suite. Enabled with -PerfSuite, it loads each level of the game in turn, lets scripted
+ * bots play a full match in every player slot and measures the game thread, physics, allocations and object counts of
+ * each match. Once every level has been played, the results are written to Saved/PerfSuite/Report.csv and compared to
+ * the baseline checked in at Config/PerfBaseline.ini. Every regression, and every level without a baseline, is written to
+ * the log as an error and makes the game exit with a failing status (see CubeTestRun::RequestExit()). Gameplay code
+ * must also not allocate at all while the ball is in play: a level fails if any of its PLAYING frames allocates in an
+ * FGameplayAllocationScope. Adding -AllocTrace writes the callstacks of those allocations to the log at exit.
+ *
+ * Typical usage, for repeatable numbers on a build machine:
+ *   CubeProject -PerfSuite -nullrhi -unattended -benchmark -fps=60
+ *
+ * Adding -UpdateBaseline first writes the values measured on the completed levels to Config/PerfBaseline.ini. The levels
+ * to play are listed in the [CubePerfSuite] section of DefaultGame.ini.
+ */
+class CUBEPROJECT_API FCubePerfSuite : public FTickerObjectBase
+{
+public:
+    /** A match which lasts longer than this many seconds is stopped and reported as incomplete. */
+    static constexpr float MATCH_TIMEOUT = 300.0f;
+    /** The number of gameplay allocations allowed in a frame played entirely in the PLAYING state. */
+    static constexpr int32 MAX_PLAYING_FRAME_ALLOCATIONS = 0;
+
+    /** Creates the suite. Called at startup when -PerfSuite is on the command line. */
+    static void Start();
+    /** Destroys the suite. */
+    static void Stop();
+    /** Returns the running suite, or NULL if the game was not started with -PerfSuite. */
+    static FCubePerfSuite* Get() { return Instance; }
+
+    /** Called by the game mode once every player has been created. Starts measuring the level if it is the next one to measure. */
+    void OnGameModeBeginPlay(ACubeProjectGameMode* GameMode);
+
+    // FTickerObjectBase interface
+    virtual bool Tick(float DeltaTime) override;
+
+    /** Returns the name of a metric. */
+    static const TCHAR* GetMetricName(ECubePerfMetric::Type Metric);
+
+private:
+    FCubePerfSuite();
+
+    /** Records the metrics of the last frame. */
+    void SampleFrame(float DeltaTime);
+
+    /** Stores the result of the current level and moves on to the next one. */
+    void FinishMap(bool bCompleted);
+
+    /** Writes the report, compares the results to the baseline and exits the game. */
+    void FinishSuite();
+
+    /** Compares a result to its baseline. Returns the number of regressions, which are written to the log. */
+    int32 CompareToBaseline(const FCubePerfResult& Result, const class FConfigFile& Baseline, FString& OutStatus) const;
+
+    /** Writes the results of the completed levels to the baseline file. */
+    void UpdateBaseline(const FString& BaselineFileName) const;
+
+    /** Returns the name of the given level without its path or PIE prefix. */
+    static FString GetShortMapName(const UWorld* World);
+
+    /** The levels to measure, in order. */
+    TArray<FString> Maps;
+    /** The level being measured. */
+    int32 MapIndex;
+
+    /** The current step. */
+    ECubePerfSuitePhase::Type Phase;
+    /** True once the next level was asked to load. */
+    bool bMapRequested;
+
+    /** The game mode of the level being measured. */
+    TWeakObjectPtr<ACubeProjectGameMode> GameMode;
+    /** The probe measuring the physics time in the level being measured. */
+    TWeakObjectPtr<ACubePerfProbe> Probe;
+
+    /** The time spent playing the current match. */
+    float MatchTime;
+    /** The number of frames measured in the current match. */
+    int32 NumFrames;
+    /** The game thread and physics times of the current match. */
+    FFrameTimeHistogram GameThreadHistogram;
+    FFrameTimeHistogram PhysicsHistogram;
+    /** The game thread allocations when the current match started. */
+    uint64 StartAllocations;
+    uint64 StartAllocatedBytes;
+    /** The largest number of actors in the level during the current match. */
+    int32 PeakActorCount;
+    /** The gameplay allocations when the last frame ended, and whether the game state was PLAYING then. */
+    uint64 LastGameplayAllocations;
+    bool bLastFramePlaying;
+    /** The largest number of gameplay allocations in a PLAYING frame of the current match. */
+    int32 PeakPlayingFrameAllocations;
+
+    /** The results of every measured level. */
+    TArray<FCubePerfResult> Results;
+
+    /** The running suite. */
+    static FCubePerfSuite* Instance;
+};
@@ -0,0 +1,74 @@
+#include "CubeProject.h"
+#include "CubePlayerRegistry.h"
+#include "CubePawn.h"
+
+FCubePlayerRegistry::FCubePlayerRegistry()
+{
+    Clear();
+}
+
+void FCubePlayerRegistry::Register(int32 Slot, APlayerController* Controller, ACubePawn* Pawn)
+{
+    if(!IsValidSlot(Slot))
+        return;
+
+    Controllers[Slot] = Controller;
+    Pawns[Slot] = Pawn;
+    NumPlayers = FMath::Max(NumPlayers, Slot + 1);
+}
+
+void FCubePlayerRegistry::Clear()
+{
+    FMemory::Memzero(Controllers, sizeof(Controllers));
+    FMemory::Memzero(Pawns, sizeof(Pawns));
+    NumPlayers = 0;
+}
+
+void FCubePlayerRegistry::SetInputEnabled(bool bEnabled)
+{
+    for(int32 Slot = 0; Slot < NumPlayers; Slot++)
+    {
+        APlayerController* Controller = Controllers[Slot];
+
+        if(!Controller)
+            continue;
+
+        if(bEnabled)
+        {
+            Controller->ResetIgnoreMoveInput();
+        }
+        else
+        {
+            Controller->SetIgnoreMoveInput(true);
+        }
+    }
+}
+
+void FCubePlayerRegistry::ResetPawns()
+{
+    for(int32 Slot = 0; Slot < NumPlayers; Slot++)
+    {
+        if(Pawns[Slot])
+        {
+            Pawns[Slot]->Reset();
+        }
+    }
+}
+
+int32 FCubePlayerRegistry::GetSlot(const AController* Controller)
+{
+    const APlayerController* PlayerController = Cast<APlayerController>(Controller);
+
+    if(PlayerController)
+    {
+        // Each local player is created with a unique ControllerId, which we use directly as the player's slot
+        const ULocalPlayer* LocalPlayer = Cast<ULocalPlayer>(PlayerController->Player);
+
+        if(LocalPlayer && IsValidSlot(LocalPlayer->GetControllerId()))
+        {
+            return LocalPlayer->GetControllerId();
+        }
+    }
+
+    return INDEX_NONE;
+}
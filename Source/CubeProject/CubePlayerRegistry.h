@@ -0,0 +1,53 @@
+#pragma once
+
+class ACubePawn;
+
+/** Stores the controller and pawn for each local player taking part in a match. Players are indexed by their slot,
+  * which is the ControllerId of their local player. Even slots play on the left-hand team and odd slots on the right. */
+class CUBEPROJECT_API FCubePlayerRegistry
+{
+public:
+    /** The maximum number of players in a match (a 4v4 game). */
+    static constexpr int32 MAX_PLAYERS = 8;
+    /** The number of teams in a match. */
+    static constexpr int32 TEAM_COUNT = 2;
+
+    FCubePlayerRegistry();
+
+    /** Stores the controller and pawn used by the player in the given slot. */
+    void Register(int32 Slot, APlayerController* Controller, ACubePawn* Pawn);
+
+    /** Removes every player from the registry. */
+    void Clear();
+
+    /** Enables or disables the movement input of every registered player in one pass. */
+    void SetInputEnabled(bool bEnabled);
+
+    /** Resets every registered pawn at its starting position. */
+    void ResetPawns();
+
+    /** Returns the pawn in the given slot, or NULL if the slot is empty. */
+    FORCEINLINE ACubePawn* GetPawn(int32 Slot) const { return IsValidSlot(Slot) ? Pawns[Slot] : NULL; }
+    /** Returns the controller in the given slot, or NULL if the slot is empty. */
+    FORCEINLINE APlayerController* GetController(int32 Slot) const { return IsValidSlot(Slot) ? Controllers[Slot] : NULL; }
+
+    /** Returns the number of slots in use. Slots are always filled contiguously from zero. */
+    FORCEINLINE int32 Num() const { return NumPlayers; }
+
+    /** Returns true if the given slot index can hold a player. */
+    static FORCEINLINE bool IsValidSlot(int32 Slot) { return Slot >= 0 && Slot < MAX_PLAYERS; }
+    /** Returns the team of the player in the given slot. Team 0 starts on the left, team 1 on the right. */
+    static FORCEINLINE int32 GetTeam(int32 Slot) { return Slot % TEAM_COUNT; }
+
+    /** Returns the slot of the given controller, or INDEX_NONE if it is not a local player controller. The slot is the
+      * ControllerId of the controller's local player, so this lookup never iterates over the players in the world. */
+    static int32 GetSlot(const AController* Controller);
+
+private:
+    /** The controller for each player slot. */
+    APlayerController* Controllers[MAX_PLAYERS];
+    /** The pawn for each player slot. */
+    ACubePawn* Pawns[MAX_PLAYERS];
+    /** The number of slots in use. */
+    int32 NumPlayers;
+};
@@ -10,7 +10,13 @@ public class CubeProject : ModuleRules
 
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "UMG" });
 
-        PrivateDependencyModuleNames.AddRange(new string[] { "RHI", "RenderCore" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "RHI", "RenderCore", "Sockets" });
+
+        // The input sampler reads the gamepads directly with XInput
+        if ((Target.Platform == UnrealTargetPlatform.Win32) || (Target.Platform == UnrealTargetPlatform.Win64))
+        {
+            AddThirdPartyPrivateStaticDependencies(Target, "XInput");
+        }
 
         // Uncomment if you are using Slate UI
         // PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
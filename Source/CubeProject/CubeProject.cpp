@@ -1,5 +1,102 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "CubeProject.h"
+#include "MallocCounter.h"
+#include "CubePerfSuite.h"
+#include "CubeSoakTest.h"
+#include "CubeActorSaveCheck.h"
+#include "CubeMetrics.h"
+#include "CubeMetricsServer.h"
+#include "CookArenaCollisionCommandlet.h"
+#include "GameDelegates.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, CubeProject, "CubeProject" );
+/** True once a headless test run has failed. Turned into the process's exit status at shutdown. */
+static bool bTestRunFailed = false;
+
+/** The game's module. Sets up the systems which must exist before the first world is loaded. */
+class FCubeProjectModule : public FDefaultGameModuleImpl
+{
+public:
+    virtual void StartupModule() override
+    {
+        // Gameplay metrics are always recorded, and only served when a metrics port is given
+        FCubeMetrics::Startup();
+        FCubeMetricsServer::StartServer();
+        
+#if WITH_EDITOR
+        // Packaging cooks the collision of the arenas with the content, so that the staged files always match the maps
+        FGameDelegates::Get().GetCookModificationDelegate().BindStatic(&UCookArenaCollisionCommandlet::CookForPackaging);
+#endif
+        
+        // The performance suite reports the allocations made per frame, which requires counting them from startup
+        if(FParse::Param(FCommandLine::Get(), TEXT("PerfSuite")))
+        {
+            FMallocCounter::Install();
+            FCubePerfSuite::Start();
+        }
+        
+        // Play bot matches back to back for hours and watch for anything which keeps growing
+        if(FParse::Param(FCommandLine::Get(), TEXT("Soak")))
+        {
+            FCubeSoakTest::Start();
+        }
+        
+        // Save and resume bot matches at random points, and check that the actors play on identically
+        if(FParse::Param(FCommandLine::Get(), TEXT("ActorSaveCheck")))
+        {
+            FCubeActorSaveCheck::Start();
+        }
+        
+        // Record where gameplay code allocates, to find what breaks the zero allocation target of PLAYING frames
+        if(FParse::Param(FCommandLine::Get(), TEXT("AllocTrace")))
+        {
+            FMallocCounter::Install();
+            
+            if(FMallocCounter* MallocCounter = FMallocCounter::Get())
+            {
+                MallocCounter->SetCaptureCallsites(true);
+            }
+        }
+    }
+
+    virtual void ShutdownModule() override
+    {
+        if(FMallocCounter* MallocCounter = FMallocCounter::Get())
+        {
+            if(MallocCounter->IsCapturingCallsites())
+            {
+                MallocCounter->DumpGameplayCallsites(*GLog);
+            }
+        }
+        
+        FCubePerfSuite::Stop();
+        FCubeSoakTest::Stop();
+        FCubeActorSaveCheck::Stop();
+        FCubeMetricsServer::StopServer();
+        FCubeMetrics::Shutdown();
+        
+#if WITH_EDITOR
+        FGameDelegates::Get().GetCookModificationDelegate().Unbind();
+#endif
+        
+        // The engine exits with 0 from a requested exit. Once everything above has been written to the log, end the process
+        // with a critical error status instead, which fails the build machine's job.
+        if(bTestRunFailed)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("The test run failed. Exiting with an error status."));
+            GIsCriticalError = true;
+            GLog->Flush();
+            FPlatformMisc::RequestExit(true);
+        }
+    }
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FCubeProjectModule, CubeProject, "CubeProject" );
+
+DEFINE_LOG_CATEGORY(LogCubeProject);
+
+void CubeTestRun::RequestExit(bool bFailed)
+{
+    bTestRunFailed |= bFailed;
+    FPlatformMisc::RequestExit(false);
+}
@@ -4,3 +4,13 @@
 
 #include "Engine.h"
 
+/** Log category used by the game's systems (event logs, telemetry, tools). */
+DECLARE_LOG_CATEGORY_EXTERN(LogCubeProject, Log, All);
+
+/** Ends the headless test runs of the game (the performance suite, the soak test and the actor save check). */
+namespace CubeTestRun
+{
+    /** Asks the game to exit. If the run failed, the process exits with a nonzero status once the game has shut down, so
+      * that the build machine running it fails the job. */
+    CUBEPROJECT_API void RequestExit(bool bFailed);
+}
@@ -7,7 +7,25 @@
 #include "Goal.h"
 #include "Engine/TextRenderActor.h"
 #include "CubeProjectGameState.h"
+#include "CubeProjectHUD.h"
 #include "CubeProjectLevelScriptActor.h"
+#include "MatchEventLog.h"
+#include "MatchResultWriter.h"
+#include "CubeBot.h"
+#include "CubeMctsBot.h"
+#include "CubeLiveBridge.h"
+#include "CubeBroadcastPublisher.h"
+#include "CubeInputSampler.h"
+#include "CubeLatencyTracker.h"
+#include "CubeMetrics.h"
+#include "CubePerfSuite.h"
+#include "CubeSoakTest.h"
+#include "CubeActorSaveCheck.h"
+#include "MallocCounter.h"
+#include "CubeArenaGeometry.h"
+#include "CubeMatchSave.h"
+#include "CubeArenaGenerator.h"
+#include "GeneratedArena.h"
 
 /** The position in which the score text is displayed. (This is the position of the score on the right-hand side) */
 const FVector ACubeProjectGameMode::SCORE_TEXT_POSITION = FVector(0.0f,100.0f,252.0f);
@@ -46,11 +64,48 @@ ACubeProjectGameMode::ACubeProjectGameMode()
     DefaultPawnClass = Player1PawnClass;
     // Set the default class used to control game state
     GameStateClass = ACubeProjectGameState::StaticClass();
+    // Set the HUD which draws the frame time overlay
+    HUDClass = ACubeProjectHUD::StaticClass();
 
     // Spawn a spectator pawn initially. The actual player pawns are spawned manually in BeginPlay()
     //DefaultPawnClass = SpectatorClass;
 }
 
+void ACubeProjectGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+    Super::InitGame(MapName, Options, ErrorMessage);
+    
+    if(!FParse::Param(FCommandLine::Get(), TEXT("GenerateArena")))
+        return;
+    
+    // Keep the start of every player clear of the obstacles
+    FCubeArenaParams Params;
+    Params.NumPlayers = FMath::Clamp(PlayersPerTeam * FCubePlayerRegistry::TEAM_COUNT, FCubePlayerRegistry::TEAM_COUNT,
+                                     FCubePlayerRegistry::MAX_PLAYERS);
+    CubeArenaGenerator::ParseParams(FCommandLine::Get(), Params);
+    
+    // A seed given in the level's URL (e.g., by the soak test) takes precedence over the command line
+    if(HasOption(Options, TEXT("ArenaSeed")))
+    {
+        Params.Seed = FCString::Strtoui64(*ParseOption(Options, TEXT("ArenaSeed")), NULL, 10);
+    }
+    
+    const double StartTime = FPlatformTime::Seconds();
+    
+    GeneratedArena = new FCubeGeneratedArena();
+    CubeArenaGenerator::Generate(Params, *GeneratedArena);
+    
+    AGeneratedArena* ArenaActor = GetWorld()->SpawnActor<AGeneratedArena>(FVector::ZeroVector, FRotator::ZeroRotator);
+    
+    if(ArenaActor)
+    {
+        ArenaActor->Build(*GeneratedArena);
+    }
+    
+    UE_LOG(LogCubeProject, Log, TEXT("Generated arena %llu (%d walls, %d obstacles) in %.0f us"), Params.Seed, GeneratedArena->Walls.Num(),
+           GeneratedArena->Obstacles.Num(), (FPlatformTime::Seconds() - StartTime) * 1000000.0);
+}
+
 // Called when the game mode starts
 void ACubeProjectGameMode::BeginPlay()
 {
@@ -68,6 +123,77 @@ void ACubeProjectGameMode::BeginPlay()
     // Set the score to win to default
     ScoreToWin = DefaultScoreToWin;
     
+    // Start the thread which writes the match events to disk
+    if(bRecordMatchEvents && !FParse::Param(FCommandLine::Get(), TEXT("NoMatchLog")))
+    {
+        MatchEventLog = new FMatchEventLog(FPaths::GameSavedDir() / TEXT("MatchLogs"));
+    }
+    
+    // Start the thread which appends the match results read by the rating engine
+    if(bRecordMatchResults && !FParse::Param(FCommandLine::Get(), TEXT("NoMatchResults")))
+    {
+        MatchResultWriter = new FMatchResultWriter(FPaths::GameSavedDir() / TEXT("Ratings") / TEXT("Results.gsrr"));
+    }
+    
+    // Share the live state of the match with external tools when requested
+    FString LiveBridgeName = FCubeLiveBridge::DEFAULT_NAME;
+    
+    FMemory::Memzero(LiveBridgeInputs, sizeof(LiveBridgeInputs));
+    FMemory::Memzero(bLiveBridgeSlots, sizeof(bLiveBridgeSlots));
+    
+    if(FParse::Value(FCommandLine::Get(), TEXT("LiveBridge="), LiveBridgeName) || FParse::Param(FCommandLine::Get(), TEXT("LiveBridge")))
+    {
+        LiveBridge = new FCubeLiveBridge();
+        
+        if(!LiveBridge->Open(LiveBridgeName, true))
+        {
+            delete LiveBridge;
+            LiveBridge = NULL;
+        }
+    }
+    
+    // Sample the players' devices between frames where the platform allows it, or generate the input of a player to
+    // measure the input latency (-SyntheticInput[=<slot>])
+    int32 SyntheticInputSlot = INDEX_NONE;
+    
+    if(!FParse::Value(FCommandLine::Get(), TEXT("SyntheticInput="), SyntheticInputSlot) && FParse::Param(FCommandLine::Get(), TEXT("SyntheticInput")))
+    {
+        SyntheticInputSlot = 0;
+    }
+    
+    FMemory::Memzero(SampledMoves, sizeof(SampledMoves));
+    
+    if(SyntheticInputSlot != INDEX_NONE || (FCubeInputSampler::IsSupported() && !FParse::Param(FCommandLine::Get(), TEXT("NoInputSampler"))))
+    {
+        InputSampler = new FCubeInputSampler(FCubePlayerRegistry::MAX_PLAYERS, SyntheticInputSlot);
+        SampledInputTime = FPlatformTime::Seconds();
+    }
+    
+    // Trace the latency of the inputs up to the display
+    if(SyntheticInputSlot != INDEX_NONE || FParse::Param(FCommandLine::Get(), TEXT("LatencyTrace")))
+    {
+        LatencyTracker = new FCubeLatencyTracker();
+    }
+    
+    // Send the match to the spectator broadcast relay when requested
+    FString BroadcastRelayAddress = FCubeBroadcastPublisher::DEFAULT_RELAY_ADDRESS;
+    
+    if(FParse::Value(FCommandLine::Get(), TEXT("Broadcast="), BroadcastRelayAddress) || FParse::Param(FCommandLine::Get(), TEXT("Broadcast")))
+    {
+        BroadcastPublisher = new FCubeBroadcastPublisher(BroadcastRelayAddress);
+        
+        // Events are queued during the frame, which must not allocate while the match is played
+        PendingBroadcastEvents.Reserve(CUBE_BROADCAST_MAX_EVENTS);
+    }
+    
+    // In the determinism mode, every match is derived from the given seed so that two runs can be compared tick by tick
+    bDeterministic = FParse::Param(FCommandLine::Get(), TEXT("deterministic"));
+    
+    if(!FParse::Value(FCommandLine::Get(), TEXT("seed="), BaseSeed))
+    {
+        BaseSeed = bDeterministic ? 0 : FPlatformTime::Cycles64();
+    }
+    
     UWorld* World = GetWorld();
     
     // If BallClass points to a valid Blueprint, spawn this Blueprint
@@ -91,82 +217,946 @@ void ACubeProjectGameMode::BeginPlay()
         ScoreTextLeft->SetActorRotation(FRotator(0,-180,0));
         ScoreTextRight->SetActorRotation(FRotator(0,-180,0));
     }
+    
+    for(int32 Score = 0; Score <= FMath::Max(ScoreToWin, 0); Score++)
+    {
+        ScoreTexts.Add(FText::AsNumber(Score));
+    }
+    
+    // Create the components of every effect up front, so that no component is spawned while the match is played
+    EffectPool = new FCubeEffectPool(this);
+    EffectPool->AddEffect(ECubeEffect::BallHitWall, BallHitWallSound, BallHitWallParticles);
+    EffectPool->AddEffect(ECubeEffect::BallHitPlayer, BallHitPlayerSound, BallHitPlayerParticles);
+    EffectPool->AddEffect(ECubeEffect::Goal, BallHitGoalSound, BallExplosionParticles);
+    EffectPool->AddEffect(ECubeEffect::PlayerSpin, PlayerSpinSound, PlayerSpinParticles, FCubePlayerRegistry::MAX_PLAYERS);
+    EffectPool->AddEffect(ECubeEffect::WinGame, WinGameSound, NULL, 1);
 
+    // Index the player starts by tag so that each player can find its spawn point without searching the level
+    IndexPlayerStarts();
+    
+    // The first player is spawned automatically by the game. Create the remaining players of both teams.
+    const int32 NumPlayers = FMath::Clamp(PlayersPerTeam * FCubePlayerRegistry::TEAM_COUNT, FCubePlayerRegistry::TEAM_COUNT,
+                                          FCubePlayerRegistry::MAX_PLAYERS);
+    
+    for(int32 Slot = 1; Slot < NumPlayers; Slot++)
+    {
+        UGameplayStatics::CreatePlayer(World, Slot, true);
+    }
+    
     // Retrieve the player which was spawned automatically by the game
     APlayerController* LeftPlayerController = UGameplayStatics::GetPlayerController(World, 0);
     
-    // Spawn the second player using the correct Blueprint class
-    DefaultPawnClass = Player2PawnClass;
-    // Create the second player in the game
-    APlayerController* RightPlayerController = UGameplayStatics::CreatePlayer(GetWorld(), 1, true);//UGameplayStatics::GetPlayerController(World, 1);
-    
     // Enable the mouse cursor for a better user experience
-    LeftPlayerController->bShowMouseCursor = true;
-    LeftPlayerController->bEnableClickEvents = true;
-    LeftPlayerController->bEnableMouseOverEvents = true;
+    if(LeftPlayerController)
+    {
+        LeftPlayerController->bShowMouseCursor = true;
+        LeftPlayerController->bEnableClickEvents = true;
+        LeftPlayerController->bEnableMouseOverEvents = true;
+    }
     
-    // Store the two player pawns
-    ACubePawn* LeftPlayerPawn = NULL;
-    ACubePawn* RightPlayerPawn = NULL;
+    // Register the controller and pawn of every player. Each pawn binds the input of its own controller, so no pawn needs
+    // to know about the others.
+    PlayerRegistry.Clear();
     
-    // Retrieve the pawns for the left and right players
-    if(LeftPlayerController)
-        LeftPlayerPawn = Cast<ACubePawn>(LeftPlayerController->GetPawn());
-    if(RightPlayerController)
-        RightPlayerPawn = Cast<ACubePawn>(RightPlayerController->GetPawn());
+    for(int32 Slot = 0; Slot < NumPlayers; Slot++)
+    {
+        APlayerController* PlayerController = UGameplayStatics::GetPlayerController(World, Slot);
+        ACubePawn* PlayerPawn = PlayerController ? Cast<ACubePawn>(PlayerController->GetPawn()) : NULL;
+        
+#if WITH_EDITOR
+        if(PlayerPawn)
+        {
+            // Label the player's pawn in the World Outliner for convenience. Renaming the pawn itself is meant for the
+            // editor: at runtime, it resets the loaders of the level every time.
+            PlayerPawn->SetActorLabel(FString::Printf(TEXT("Player %d Pawn"), Slot + 1));
+        }
+#endif
+        
+        PlayerRegistry.Register(Slot, PlayerController, PlayerPawn);
+        
+        // Let scripted bots play every slot when requested on the command line
+        if(FParse::Param(FCommandLine::Get(), TEXT("bots")))
+        {
+            SetBot(Slot, MakeShareable(new FCubeScriptedBot()));
+        }
+    }
     
-    // Set the left player to control the right player. Since only one pawn can receive keyboard input, the left pawn
-    // calls the right pawn's methods when player 2's keys are pressed.
-    if(LeftPlayerPawn)
+    // Find the goal defended by each team. The left team defends the goal on the left-hand side of the field.
+    FMemory::Memzero(TeamGoals, sizeof(TeamGoals));
+    
+    for(TActorIterator<AGoal> GoalIterator(World); GoalIterator; ++GoalIterator)
     {
-        if(GEngine)
-            GEngine->AddOnScreenDebugMessage(-1,3.0f,FColor::Yellow,"Register P2 with P1");
+        TeamGoals[GoalIterator->IsRightHandSideGoal() ? 1 : 0] = *GoalIterator;
+    }
+    
+    BuildSimConfig();
+    FCubeMetrics::SetGauge(ECubeGauge::Players, PlayerRegistry.Num());
+    
+    // Let tree search bots play the slots listed on the command line (e.g., -MctsBots=1,3). In the determinism mode, they
+    // search a fixed number of iterations on a fixed number of workers so that their decisions only depend on the seed.
+    FString MctsBotSlots;
+    
+    if(FParse::Value(FCommandLine::Get(), TEXT("MctsBots="), MctsBotSlots, false))
+    {
+        TArray<FString> SlotStrings;
+        MctsBotSlots.ParseIntoArray(SlotStrings, TEXT(","), true);
         
-        LeftPlayerPawn->SetPawn_P2(RightPlayerPawn);
+        for(const FString& SlotString : SlotStrings)
+        {
+            FCubeMctsBot* MctsBot = bDeterministic ? new FCubeMctsBot(0.0f, FCubeMctsBot::DETERMINISTIC_ITERATIONS, FCubeMctsBot::DETERMINISTIC_WORKERS)
+                                                   : new FCubeMctsBot();
+            SetBot(FCString::Atoi(*SlotString), MakeShareable(MctsBot));
+        }
+    }
+    
+    // Let the strict gameplay rules move the ball and pawns in the determinism mode
+    if(bDeterministic)
+    {
+        if(Ball)
+        {
+            Ball->SetDeterministic(true);
+        }
         
-        LeftPlayerPawn->Rename(TEXT("Player 1 Pawn"));
+        for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+        {
+            if(PlayerRegistry.GetPawn(Slot))
+            {
+                PlayerRegistry.GetPawn(Slot)->SetDeterministic(true);
+            }
+        }
     }
     
-    if(RightPlayerPawn)
+    // Let the performance suite take control of the match if it is running
+    if(FCubePerfSuite* PerfSuite = FCubePerfSuite::Get())
     {
-        // Rename the right player's name for convenience
-        RightPlayerPawn->Rename(TEXT("Player 2 Pawn"));
+        PerfSuite->OnGameModeBeginPlay(this);
     }
     
-    // Update the pawns controlled by the first and second players
-    Player1Pawn = LeftPlayerPawn;
-    Player2Pawn = RightPlayerPawn;
+    // Let the soak test take control of the match if it is running
+    if(FCubeSoakTest* SoakTest = FCubeSoakTest::Get())
+    {
+        SoakTest->OnGameModeBeginPlay(this);
+    }
+    
+    // Let the actor save check take control of the match if it is running
+    if(FCubeActorSaveCheck* ActorSaveCheck = FCubeActorSaveCheck::Get())
+    {
+        ActorSaveCheck->OnGameModeBeginPlay(this);
+    }
+}
 
+void ACubeProjectGameMode::SetBot(int32 Slot, TSharedPtr<FCubeBot> Bot)
+{
+    if(FCubePlayerRegistry::IsValidSlot(Slot))
+    {
+        Bots[Slot] = Bot;
+    }
 }
 
-AActor* ACubeProjectGameMode::ChoosePlayerStart_Implementation(AController* Player)
+void ACubeProjectGameMode::TickBots(float DeltaTime)
 {
-    // Get the UWorld instance controlling the game
-    UWorld* World = GetWorld();
+    if(!Ball)
+        return;
     
-    if(GEngine)
-        GEngine->AddOnScreenDebugMessage(-1,10.0f,FColor::White,"CHOOSE SPAWN POINT");
+    // Give the bots a copy of the match which they can simulate ahead
+    FCubeMatchState MatchState;
+    CaptureMatchState(MatchState);
     
-    // Iterate through each player start in the game and choose an appropriate one for the given player
-    for(TActorIterator<APlayerStart> PlayerStartIterator(World); PlayerStartIterator; ++PlayerStartIterator)
+    FCubeBotContext Context;
+    Context.BallLocation = FVector2D(Ball->GetActorLocation().Y, Ball->GetActorLocation().Z);
+    Context.BallVelocity = FVector2D(Ball->GetVelocity().Y, Ball->GetVelocity().Z);
+    Context.DeltaTime = DeltaTime;
+    Context.MatchState = &MatchState;
+    Context.SimConfig = &SimConfig;
+    Context.MatchSeed = MatchSeed;
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
     {
-        // Spawn the first player (player 0) at the player start with tag "0"
-        if(Player == UGameplayStatics::GetPlayerController(World,0) && PlayerStartIterator->PlayerStartTag == "0")
+        ACubePawn* Pawn = PlayerRegistry.GetPawn(Slot);
+        
+        if(!Bots[Slot].IsValid() || !Pawn)
+            continue;
+        
+        const int32 Team = FCubePlayerRegistry::GetTeam(Slot);
+        const AGoal* OwnGoal = TeamGoals[Team];
+        const AGoal* OpponentGoal = TeamGoals[1 - Team];
+        
+        Context.Slot = Slot;
+        Context.Team = Team;
+        Context.PawnLocation = FVector2D(Pawn->GetActorLocation().Y, Pawn->GetActorLocation().Z);
+        Context.PawnVelocity = FVector2D(Pawn->GetVelocity().Y, Pawn->GetVelocity().Z);
+        Context.bCanSpin = !Pawn->IsSpinning();
+        Context.OwnGoalLocation = OwnGoal ? FVector2D(OwnGoal->GetActorLocation().Y, OwnGoal->GetActorLocation().Z) : FVector2D::ZeroVector;
+        Context.OpponentGoalLocation = OpponentGoal ? FVector2D(OpponentGoal->GetActorLocation().Y, OpponentGoal->GetActorLocation().Z)
+                                                    : FVector2D::ZeroVector;
+        
+        // Apply the bot's decision exactly like player input
+        const FCubeBotInput Input = Bots[Slot]->Think(Context);
+        
+        Pawn->MoveX(Input.MoveX);
+        Pawn->MoveY(Input.MoveY);
+        
+        if(Input.bSpin)
         {
-            if(GEngine)
-                GEngine->AddOnScreenDebugMessage(-1,10.0f,FColor::White,"Spawn player 0");
-            
-            return *PlayerStartIterator;
+            Pawn->OnReleaseActionButton();
+        }
+    }
+}
+
+void ACubeProjectGameMode::ReceiveLiveBridgeInputs()
+{
+    if(!LiveBridge)
+        return;
+    
+    FCubeLiveInput Input;
+    
+    while(LiveBridge->PopInput(Input))
+    {
+        if(!FCubePlayerRegistry::IsValidSlot(Input.Slot))
+            continue;
+        
+        // A spin stays pending until it is applied, even if a later input of the same frame doesn't spin
+        const bool bSpinPending = bLiveBridgeSlots[Input.Slot] && LiveBridgeInputs[Input.Slot].bSpin;
+        
+        LiveBridgeInputs[Input.Slot] = Input;
+        LiveBridgeInputs[Input.Slot].bSpin |= bSpinPending ? 1 : 0;
+        bLiveBridgeSlots[Input.Slot] = true;
+    }
+}
+
+void ACubeProjectGameMode::ApplyLiveBridgeInputs()
+{
+    if(!LiveBridge)
+        return;
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        ACubePawn* Pawn = PlayerRegistry.GetPawn(Slot);
+        
+        if(!bLiveBridgeSlots[Slot] || !Pawn)
+            continue;
+        
+        FCubeLiveInput& Input = LiveBridgeInputs[Slot];
+        
+        Pawn->MoveX(Input.MoveX / 127.0f);
+        Pawn->MoveY(Input.MoveY / 127.0f);
+        
+        if(Input.bSpin)
+        {
+            Pawn->OnReleaseActionButton();
+            Input.bSpin = 0;
+        }
+    }
+}
+
+void ACubeProjectGameMode::PublishLiveState()
+{
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    if(!LiveBridge || !GameState)
+        return;
+    
+    FCubeLiveState State;
+    FMemory::Memzero(State);
+    
+    State.FrameNumber = (uint32)GFrameCounter;
+    State.MatchTick = (uint32)(GameState->GetTimerWheel().GetCurrentTick() - MatchStartSimulationTick);
+    State.GameState = GameState->GetState();
+    State.Scores[0] = LeftPlayerScore;
+    State.Scores[1] = RightPlayerScore;
+    State.NumPlayers = PlayerRegistry.Num();
+    
+    if(Ball)
+    {
+        State.BallLocationY = Ball->GetActorLocation().Y;
+        State.BallLocationZ = Ball->GetActorLocation().Z;
+        State.BallVelocityY = Ball->GetVelocity().Y;
+        State.BallVelocityZ = Ball->GetVelocity().Z;
+        State.BallSpeed = Ball->GetSpeed();
+    }
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        const ACubePawn* Pawn = PlayerRegistry.GetPawn(Slot);
+        FCubeLivePawnState& PawnState = State.Pawns[Slot];
+        
+        if(Pawn)
+        {
+            PawnState.LocationY = Pawn->GetActorLocation().Y;
+            PawnState.LocationZ = Pawn->GetActorLocation().Z;
+            PawnState.VelocityY = Pawn->GetVelocity().Y;
+            PawnState.VelocityZ = Pawn->GetVelocity().Z;
+            PawnState.bSpinning = Pawn->IsSpinning() ? 1 : 0;
+        }
+        
+        PawnState.LastInputSequence = LiveBridgeInputs[Slot].Sequence;
+    }
+    
+    LiveBridge->PublishState(State);
+}
+
+void ACubeProjectGameMode::ApplySampledInputs()
+{
+    if(!InputSampler)
+        return;
+    
+    // Integrate each slot's movement input over the frame, from the last frame's time to now
+    const double FrameStartTime = SampledInputTime;
+    const double FrameEndTime = FPlatformTime::Seconds();
+    double SlotTimes[FCubePlayerRegistry::MAX_PLAYERS];
+    float WeightedMoves[FCubePlayerRegistry::MAX_PLAYERS][2];
+    double SpinTimes[FCubePlayerRegistry::MAX_PLAYERS];
+    FCubeInputEvent Event;
+    
+    FMemory::Memzero(WeightedMoves, sizeof(WeightedMoves));
+    
+    for(int32 Slot = 0; Slot < FCubePlayerRegistry::MAX_PLAYERS; Slot++)
+    {
+        SlotTimes[Slot] = FrameStartTime;
+        SpinTimes[Slot] = 0.0;
+    }
+    
+    while(InputSampler->PopEvent(Event))
+    {
+        const int32 Slot = Event.Slot;
+        const double EventTime = FMath::Clamp(Event.Time, FrameStartTime, FrameEndTime);
+        
+        WeightedMoves[Slot][0] += SampledMoves[Slot][0] * (float)(EventTime - SlotTimes[Slot]);
+        WeightedMoves[Slot][1] += SampledMoves[Slot][1] * (float)(EventTime - SlotTimes[Slot]);
+        SlotTimes[Slot] = EventTime;
+        SampledMoves[Slot][0] = Event.MoveX;
+        SampledMoves[Slot][1] = Event.MoveY;
+        
+        // Only the first release of the frame can spin: the pawn can't spin again until its spin is done
+        if(Event.bSpinReleased && SpinTimes[Slot] == 0.0)
+        {
+            SpinTimes[Slot] = EventTime;
         }
-        // Spawn the second player at the player start with tag "1" (set in the details panel of the player start actor)
-        else if(Player == UGameplayStatics::GetPlayerController(World,1) && PlayerStartIterator->PlayerStartTag == "1")
+    }
+    
+    SampledInputTime = FrameEndTime;
+    
+    const float FrameDuration = (float)FMath::Max(FrameEndTime - FrameStartTime, 1e-6);
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        ACubePawn* Pawn = PlayerRegistry.GetPawn(Slot);
+        
+        if(!Pawn)
+            continue;
+        
+        // Bots and tools drive their pawns themselves
+        const bool bSampled = !Bots[Slot].IsValid() && !bLiveBridgeSlots[Slot];
+        Pawn->SetInputSampled(bSampled);
+        
+        if(!bSampled)
+            continue;
+        
+        WeightedMoves[Slot][0] += SampledMoves[Slot][0] * (float)(FrameEndTime - SlotTimes[Slot]);
+        WeightedMoves[Slot][1] += SampledMoves[Slot][1] * (float)(FrameEndTime - SlotTimes[Slot]);
+        
+        Pawn->MoveX(WeightedMoves[Slot][0] / (127.0f * FrameDuration));
+        Pawn->MoveY(WeightedMoves[Slot][1] / (127.0f * FrameDuration));
+        
+        if(SpinTimes[Slot] != 0.0)
         {
-            if(GEngine)
-                GEngine->AddOnScreenDebugMessage(-1,10.0f,FColor::White,"Spawn player 1");
+            if(LatencyTracker)
+            {
+                LatencyTracker->BeginInput(SpinTimes[Slot]);
+            }
             
-            return *PlayerStartIterator;
+            Pawn->ReleaseActionButton((float)(FrameEndTime - SpinTimes[Slot]));
+            
+            if(LatencyTracker)
+            {
+                LatencyTracker->EndInput();
+            }
         }
     }
+}
+
+void ACubeProjectGameMode::BroadcastState()
+{
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    if(!BroadcastPublisher || !GameState)
+        return;
+    
+    FCubeBroadcastState State;
+    FMemory::Memzero(State);
+    
+    State.Tick = (uint32)(GameState->GetTimerWheel().GetCurrentTick() - MatchStartSimulationTick);
+    State.GameState = GameState->GetState();
+    State.Scores[0] = LeftPlayerScore;
+    State.Scores[1] = RightPlayerScore;
+    State.NumPlayers = PlayerRegistry.Num();
+    
+    if(Ball)
+    {
+        State.BallY = CubeBroadcast::QuantizeLocation(Ball->GetActorLocation().Y);
+        State.BallZ = CubeBroadcast::QuantizeLocation(Ball->GetActorLocation().Z);
+    }
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        if(const ACubePawn* Pawn = PlayerRegistry.GetPawn(Slot))
+        {
+            State.PawnY[Slot] = CubeBroadcast::QuantizeLocation(Pawn->GetActorLocation().Y);
+            State.PawnZ[Slot] = CubeBroadcast::QuantizeLocation(Pawn->GetActorLocation().Z);
+            State.PawnRoll[Slot] = CubeBroadcast::QuantizeAngle(Pawn->GetActorRotation().Roll);
+        }
+    }
+    
+    // The frame is encoded once here and shared by every spectator downstream
+    BroadcastPublisher->Publish(State, PendingBroadcastEvents);
+    PendingBroadcastEvents.Reset();
+}
+
+void ACubeProjectGameMode::BuildSimConfig()
+{
+    FCubeSimArena& Arena = SimConfig.Arena;
+    
+    // A generated arena is known exactly. Otherwise, the goal lines are the planes of the goals' triggers.
+    if(GeneratedArena)
+    {
+        Arena = GeneratedArena->Arena;
+    }
+    else if(TeamGoals[0] && TeamGoals[1])
+    {
+        Arena.LeftGoalLineY = TeamGoals[0]->GetActorLocation().Y;
+        Arena.RightGoalLineY = TeamGoals[1]->GetActorLocation().Y;
+        Arena.GoalCenterZ = (TeamGoals[0]->GetActorLocation().Z + TeamGoals[1]->GetActorLocation().Z) * 0.5f;
+        Arena.GoalHalfHeight = FMath::Min(TeamGoals[0]->GetMouthHalfHeight(), TeamGoals[1]->GetMouthHalfHeight());
+    }
+    
+    // Find the floor and ceiling by tracing from the center of the field. The goals only overlap, so they never stop a trace.
+    FCollisionQueryParams QueryParams(TEXT("SimArena"), false, Ball);
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        QueryParams.AddIgnoredActor(PlayerRegistry.GetPawn(Slot));
+    }
+    
+    FHitResult Hit;
+    
+    if(!GeneratedArena && GetWorld()->LineTraceSingleByChannel(Hit, FVector::ZeroVector, FVector(0.0f, 0.0f, -HALF_WORLD_MAX), ECC_WorldStatic,
+                                                               QueryParams))
+    {
+        Arena.FloorZ = Hit.Location.Z;
+    }
+    
+    if(!GeneratedArena && GetWorld()->LineTraceSingleByChannel(Hit, FVector::ZeroVector, FVector(0.0f, 0.0f, HALF_WORLD_MAX), ECC_WorldStatic,
+                                                               QueryParams))
+    {
+        Arena.CeilingZ = Hit.Location.Z;
+    }
+    
+    if(Ball)
+    {
+        SimConfig.BallRules = Ball->GetRules();
+        SimConfig.BallRadius = Ball->GetSimpleCollisionRadius();
+    }
+    
+    if(const ACubePawn* Pawn = PlayerRegistry.GetPawn(0))
+    {
+        SimConfig.PawnRules = Pawn->GetRules();
+        SimConfig.PawnRadius = Pawn->GetSimpleCollisionRadius();
+        SimConfig.SpinCooldownTicks = (uint16)ACubeProjectGameState::SecondsToTicks(Pawn->GetSpinDuration());
+    }
+    
+    SimConfig.HitCooldownTicks = (uint16)ACubeProjectGameState::SecondsToTicks(ABall::MULTIPLE_HIT_COOLDOWN);
+    SimConfig.TickDuration = 1.0f / ACubeProjectGameState::SIMULATION_TICK_RATE;
+    
+    // Let the simulation see the real walls of the arena if they were cooked (see UCookArenaCollisionCommandlet)
+    FString MapName = GetWorld()->GetMapName();
+    MapName.RemoveFromStart(GetWorld()->StreamingLevelsPrefix);
+    
+    delete ArenaGeometry;
+    ArenaGeometry = new FCubeArenaGeometry();
+    
+    if(GeneratedArena)
+    {
+        // The generated walls are known exactly, so they are built here rather than cooked
+        CubeArenaGenerator::BuildGeometry(*GeneratedArena, *ArenaGeometry);
+        UE_LOG(LogCubeProject, Log, TEXT("Simulating the generated arena with %d wall primitives"), ArenaGeometry->NumPrimitives());
+    }
+    else if(ArenaGeometry->LoadFromFile(FCubeArenaGeometry::GetFileName(MapName)))
+    {
+        UE_LOG(LogCubeProject, Log, TEXT("Simulating %s with %d cooked wall primitives"), *MapName, ArenaGeometry->NumPrimitives());
+    }
+    else
+    {
+        UE_LOG(LogCubeProject, Log, TEXT("No cooked collision for %s, simulating its box"), *MapName);
+        delete ArenaGeometry;
+        ArenaGeometry = NULL;
+    }
+    
+    SimConfig.Geometry = ArenaGeometry;
+}
+
+void ACubeProjectGameMode::CaptureMatchState(FCubeMatchState& OutState) const
+{
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    FMemory::Memzero(OutState);
+    OutState.NumPlayers = PlayerRegistry.Num();
+    OutState.Scores[0] = (uint8)LeftPlayerScore;
+    OutState.Scores[1] = (uint8)RightPlayerScore;
+    
+    if(!GameState)
+        return;
+    
+    const FGameplayTimerWheel& TimerWheel = GameState->GetTimerWheel();
+    OutState.Tick = (uint32)(TimerWheel.GetCurrentTick() - MatchStartSimulationTick);
+    
+    if(Ball)
+    {
+        Ball->CaptureSimState(OutState.Ball, TimerWheel);
+    }
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        if(PlayerRegistry.GetPawn(Slot))
+        {
+            PlayerRegistry.GetPawn(Slot)->CaptureSimState(OutState.Pawns[Slot], TimerWheel);
+        }
+    }
+}
+
+void ACubeProjectGameMode::SaveMatch(const FString& SaveName)
+{
+    const FString FileName = CubeMatchSave::GetFileName(SaveName.IsEmpty() ? TEXT("Quicksave") : SaveName);
+    FCubeMatchSaveRecord Record;
+    
+    if(!SaveMatchState(Record))
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("There is no match in progress to save"));
+        return;
+    }
+    
+    if(!CubeMatchSave::SaveToFile(Record, FileName))
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("Could not write the saved match to %s"), *FileName);
+        return;
+    }
+    
+    UE_LOG(LogCubeProject, Log, TEXT("Saved the match at tick %u to %s"), Record.Tick, *FileName);
+}
+
+void ACubeProjectGameMode::ResumeMatch(const FString& SaveName)
+{
+    const FString FileName = CubeMatchSave::GetFileName(SaveName.IsEmpty() ? TEXT("Quicksave") : SaveName);
+    FCubeMatchSaveRecord Record;
+    
+    if(!CubeMatchSave::LoadFromFile(FileName, Record))
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("%s is not a saved match of this version"), *FileName);
+        return;
+    }
+    
+    if(!ResumeMatchState(Record))
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("The match saved in %s has %d players and can't be resumed in this game"), *FileName, Record.NumPlayers);
+        return;
+    }
+    
+    UE_LOG(LogCubeProject, Log, TEXT("Resumed the match saved in %s at tick %u"), *FileName, Record.Tick);
+}
+
+bool ACubeProjectGameMode::SaveMatchState(FCubeMatchSaveRecord& OutRecord) const
+{
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    if(!GameState || !Ball || GameState->GetState() < EGameState::RESET || PlayerRegistry.Num() == 0)
+        return false;
+    
+    const FGameplayTimerWheel& TimerWheel = GameState->GetTimerWheel();
+    
+    CubeMatchSave::InitRecord(OutRecord);
+    OutRecord.Seed = MatchSeed;
+    OutRecord.KickoffDraws = KickoffStream.GetCounter();
+    OutRecord.Tick = (uint32)(TimerWheel.GetCurrentTick() - MatchStartSimulationTick);
+    OutRecord.PendingTime = GameState->GetUnsimulatedTime();
+    OutRecord.FlowState = (uint8)GameState->GetState();
+    OutRecord.FlowTimerTicks = GameState->GetGameStartTicks();
+    OutRecord.NumPlayers = (uint8)PlayerRegistry.Num();
+    OutRecord.Scores[0] = (uint8)LeftPlayerScore;
+    OutRecord.Scores[1] = (uint8)RightPlayerScore;
+    OutRecord.ScoreToWin = (uint8)FMath::Clamp(ScoreToWin, 1, (int32)MAX_uint8);
+    OutRecord.LastScoringTeam = bRightPlayerScoredLast ? 1 : 0;
+    OutRecord.GoalSequence = GoalSequence;
+    
+    Ball->SaveState(OutRecord.Ball, TimerWheel);
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        if(!PlayerRegistry.GetPawn(Slot))
+            return false;
+        
+        PlayerRegistry.GetPawn(Slot)->SaveState(OutRecord.Pawns[Slot], TimerWheel);
+    }
+    
+    return true;
+}
+
+bool ACubeProjectGameMode::ResumeMatchState(const FCubeMatchSaveRecord& Record)
+{
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    if(!GameState || !Ball || GameState->GetState() == EGameState::GAME_BOOT || Record.NumPlayers != PlayerRegistry.Num())
+        return false;
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        if(!PlayerRegistry.GetPawn(Slot))
+            return false;
+    }
+    
+    FGameplayTimerWheel& TimerWheel = GameState->GetTimerWheel();
+    
+    // A match can be resumed from the main menu, in which case the menu is skipped
+    if(GameState->GetState() == EGameState::MAIN_MENU)
+    {
+        TimerWheel.Cancel(QuitMainMenuTimerHandle);
+        
+        if(ACubeProjectLevelScriptActor* LevelScript = Cast<ACubeProjectLevelScriptActor>(GetWorld()->GetLevelScriptActor()))
+        {
+            LevelScript->HideMainMenu();
+        }
+    }
+    
+    // Continue the saved match's random streams, and count its ticks from the tick it was saved at
+    MatchSeed = Record.Seed;
+    KickoffStream = FCubeRandomStream(MatchSeed, ECubeRandomStream::Kickoff);
+    KickoffStream.SetCounter(Record.KickoffDraws);
+    MatchStartSimulationTick = TimerWheel.GetCurrentTick() - Record.Tick;
+    
+    LeftPlayerScore = Record.Scores[0];
+    RightPlayerScore = Record.Scores[1];
+    ScoreToWin = Record.ScoreToWin;
+    bRightPlayerScoredLast = (Record.LastScoringTeam == 1);
+    GoalSequence = Record.GoalSequence;
+    NumGoals = FMath::Min(LeftPlayerScore + RightPlayerScore, MAX_RECORDED_GOALS);
+    
+    // The timers are scheduled again with the ticks they had left
+    const int32 LastPlayerHit = Record.Ball.LastPlayerHit;
+    Ball->RestoreState(Record.Ball, (LastPlayerHit != INDEX_NONE) ? PlayerRegistry.GetPawn(LastPlayerHit) : NULL, TimerWheel);
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        PlayerRegistry.GetPawn(Slot)->RestoreState(Record.Pawns[Slot], TimerWheel);
+    }
+    
+    const EGameState::Type FlowState = (EGameState::Type)Record.FlowState;
+    GameState->ResumeState(FlowState, Record.PendingTime, Record.FlowTimerTicks);
+    
+    // The players only control their pawns while the match is being played, as set when the game enters PUSH_BALL
+    SetPlayerInputEnabled(FlowState == EGameState::PLAYING);
+    UpdateScoreText();
+    
+    return true;
+}
+
+void ACubeProjectGameMode::StepDeterministic(float DeltaTime)
+{
+    // Move the pawns in slot order, then the ball, so that collisions are resolved in the same order on every machine
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        if(PlayerRegistry.GetPawn(Slot))
+        {
+            PlayerRegistry.GetPawn(Slot)->StepDeterministic(DeltaTime);
+        }
+    }
+    
+    if(Ball)
+    {
+        Ball->StepDeterministic(DeltaTime);
+    }
+    
+    // Hash the resulting state. The fields are only recorded when they are written to the desync trace.
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    FCubeStateHasher Hasher(DesyncTrace.IsRecording() ? &StateFields : NULL);
+    
+    HashGameplayState(Hasher);
+    LastStateHash = Hasher.GetHash();
+    
+    if(DesyncTrace.IsRecording() && GameState)
+    {
+        DesyncTrace.Record((uint32)(GameState->GetTimerWheel().GetCurrentTick() - MatchStartSimulationTick), LastStateHash, StateFields);
+    }
+}
+
+void ACubeProjectGameMode::HashGameplayState(FCubeStateHasher& Hasher) const
+{
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    if(!GameState)
+        return;
+    
+    const FGameplayTimerWheel& TimerWheel = GameState->GetTimerWheel();
+    
+    Hasher.AddInt(TEXT("Match.State"), INDEX_NONE, GameState->GetState());
+    Hasher.AddInt(TEXT("Match.LeftScore"), INDEX_NONE, LeftPlayerScore);
+    Hasher.AddInt(TEXT("Match.RightScore"), INDEX_NONE, RightPlayerScore);
+    Hasher.AddInt(TEXT("Match.KickoffDraws"), INDEX_NONE, (int32)KickoffStream.GetCounter());
+    Hasher.AddInt(TEXT("Match.ActiveTimers"), INDEX_NONE, TimerWheel.Num());
+    
+    if(Ball)
+    {
+        Ball->HashState(Hasher, TimerWheel);
+    }
+    
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        if(PlayerRegistry.GetPawn(Slot))
+        {
+            PlayerRegistry.GetPawn(Slot)->HashState(Hasher, TimerWheel);
+        }
+    }
+}
+
+void ACubeProjectGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    DesyncTrace.End();
+    
+    // Write the remaining events and stop the event log's thread
+    delete MatchEventLog;
+    MatchEventLog = NULL;
+    
+    // Write the remaining results and stop the result writer's thread
+    delete MatchResultWriter;
+    MatchResultWriter = NULL;
+    
+    delete LiveBridge;
+    LiveBridge = NULL;
+    
+    delete BroadcastPublisher;
+    BroadcastPublisher = NULL;
+    
+    delete InputSampler;
+    InputSampler = NULL;
+    
+    delete EffectPool;
+    EffectPool = NULL;
+    
+    SimConfig.Geometry = NULL;
+    delete ArenaGeometry;
+    ArenaGeometry = NULL;
+    
+    delete GeneratedArena;
+    GeneratedArena = NULL;
+    
+    // The render thread may still hold traces of the last frames
+    if(LatencyTracker)
+    {
+        FlushRenderingCommands();
+        delete LatencyTracker;
+        LatencyTracker = NULL;
+    }
+    
+    Super::EndPlay(EndPlayReason);
+}
+
+void ACubeProjectGameMode::BeginMatchLog()
+{
+    UWorld* World = GetWorld();
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    // Forget the goals of the previous match
+    GoalSequence = 0;
+    NumGoals = 0;
+    
+    // Stamp the events of the new match relative to its start
+    MatchStartTick = GameState ? GameState->GetMatchTick() : 0;
+    MatchStartTime = World->GetTimeSeconds();
+    
+    if(MatchEventLog)
+    {
+        FString ArenaName = World->GetMapName();
+        ArenaName.RemoveFromStart(World->StreamingLevelsPrefix);
+        
+        MatchEventLog->BeginMatch(ArenaName);
+    }
+}
+
+void ACubeProjectGameMode::SeedMatch()
+{
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    // Derive the match's seed from the base seed, so that the Nth match of two runs with the same seed is the same
+    MatchSeed = FCubeRandomStream::Mix(BaseSeed + (uint64)NumMatchesSeeded);
+    NumMatchesSeeded++;
+    
+    KickoffStream = FCubeRandomStream(MatchSeed, ECubeRandomStream::Kickoff);
+    MatchStartSimulationTick = GameState ? GameState->GetTimerWheel().GetCurrentTick() : 0;
+    
+    if(bDeterministic)
+    {
+        const FString TraceFileName = FPaths::GameSavedDir() / TEXT("Determinism") / FString::Printf(TEXT("Match_%llu_%d.gsdt"), BaseSeed,
+                                                                                                  NumMatchesSeeded);
+        DesyncTrace.Begin(TraceFileName, MatchSeed);
+        
+        UE_LOG(LogCubeProject, Log, TEXT("Deterministic match %d seeded with %llu. Writing its desync trace to %s"), NumMatchesSeeded, MatchSeed,
+               *TraceFileName);
+    }
+}
+
+void ACubeProjectGameMode::RecordMatchEvent(EMatchEventType::Type Type, int32 Slot, const FVector& Location, const FVector& Normal, float Speed,
+                                            float Angle, int32 Param)
+{
+    // Count the events for the metrics, whether or not they are logged
+    switch(Type)
+    {
+        case EMatchEventType::WallHit:
+            FCubeMetrics::IncrementCounter(ECubeCounter::WallHits);
+            break;
+        case EMatchEventType::PlayerHit:
+            FCubeMetrics::IncrementCounter(ECubeCounter::PlayerHits);
+            break;
+        case EMatchEventType::Spin:
+            FCubeMetrics::IncrementCounter(ECubeCounter::Spins);
+            break;
+        case EMatchEventType::Goal:
+            FCubeMetrics::IncrementCounter(ECubeCounter::Goals);
+            break;
+        default:
+            break;
+    }
+    
+    // Show the events to the spectators with the next broadcast frame
+    if(BroadcastPublisher && PendingBroadcastEvents.Num() < CUBE_BROADCAST_MAX_EVENTS)
+    {
+        FCubeBroadcastEvent& BroadcastEvent = PendingBroadcastEvents[PendingBroadcastEvents.AddUninitialized()];
+        BroadcastEvent.Type = (uint8)Type;
+        BroadcastEvent.Slot = (int8)Slot;
+        BroadcastEvent.Param = (int16)Param;
+        BroadcastEvent.LocationY = CubeBroadcast::QuantizeLocation(Location.Y);
+        BroadcastEvent.LocationZ = CubeBroadcast::QuantizeLocation(Location.Z);
+    }
+    
+    if(!MatchEventLog)
+        return;
+    
+    ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
+    
+    FMatchEvent Event;
+    Event.Tick = GameState ? GameState->GetMatchTick() - MatchStartTick : 0;
+    Event.Time = GetWorld()->GetTimeSeconds() - MatchStartTime;
+    Event.Type = Type;
+    Event.Slot = (int8)Slot;
+    Event.Param = (int16)Param;
+    Event.LocationY = Location.Y;
+    Event.LocationZ = Location.Z;
+    Event.NormalY = Normal.Y;
+    Event.NormalZ = Normal.Z;
+    Event.Speed = Speed;
+    Event.Angle = Angle;
+    
+    MatchEventLog->Append(Event);
+}
+
+void ACubeProjectGameMode::RecordMatchResult()
+{
+    if(!MatchResultWriter)
+        return;
+    
+    // Only people are rated. A match in which a bot or an external tool controlled a player (e.g., in the performance suite
+    // or the soak test) is not recorded.
+    for(int32 Slot = 0; Slot < PlayerRegistry.Num(); Slot++)
+    {
+        if(Bots[Slot].IsValid() || bLiveBridgeSlots[Slot])
+            return;
+    }
+    
+    // The result is written by the writer thread, so the game thread never waits on the disk when a match ends
+    if(!MatchResultWriter->Append(GetTeamName(0), GetTeamName(1), LeftPlayerScore, RightPlayerScore, GoalSequence, NumGoals))
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("The result of the match was dropped: the result writer can't keep up"));
+    }
+}
+
+FString ACubeProjectGameMode::GetTeamName(int32 Team) const
+{
+    FString TeamName;
+    
+    for(int32 Slot = Team; Slot < PlayerRegistry.Num(); Slot += FCubePlayerRegistry::TEAM_COUNT)
+    {
+        const APlayerController* Controller = PlayerRegistry.GetController(Slot);
+        const FString PlayerName = (Controller && Controller->PlayerState) ? Controller->PlayerState->PlayerName
+                                                                            : FString::Printf(TEXT("Player%d"), Slot + 1);
+        
+        TeamName += TeamName.IsEmpty() ? PlayerName : (TEXT("+") + PlayerName);
+    }
+    
+    return TeamName;
+}
+
+void ACubeProjectGameMode::IndexPlayerStarts()
+{
+    FMemory::Memzero(PlayerStarts, sizeof(PlayerStarts));
+    
+    // Store each player start under the slot given by its tag (set in the details panel of the player start actor)
+    for(TActorIterator<APlayerStart> PlayerStartIterator(GetWorld()); PlayerStartIterator; ++PlayerStartIterator)
+    {
+        const FString Tag = PlayerStartIterator->PlayerStartTag.ToString();
+        
+        if(!Tag.IsNumeric())
+            continue;
+        
+        const int32 Slot = FCString::Atoi(*Tag);
+        
+        if(FCubePlayerRegistry::IsValidSlot(Slot) && !PlayerStarts[Slot])
+        {
+            PlayerStarts[Slot] = *PlayerStartIterator;
+        }
+    }
+    
+    // The level only has a start for the first player of each team. Give the other players of a team a start on the line of
+    // its first player, alternately above and below it.
+    const int32 NumPlayers = FMath::Clamp(PlayersPerTeam * FCubePlayerRegistry::TEAM_COUNT, FCubePlayerRegistry::TEAM_COUNT,
+                                          FCubePlayerRegistry::MAX_PLAYERS);
+    FActorSpawnParameters SpawnParameters;
+    SpawnParameters.bNoCollisionFail = true;
+    
+    for(int32 Slot = FCubePlayerRegistry::TEAM_COUNT; Slot < NumPlayers; Slot++)
+    {
+        const APlayerStart* TeamStart = PlayerStarts[FCubePlayerRegistry::GetTeam(Slot)];
+        
+        if(PlayerStarts[Slot] || !TeamStart)
+            continue;
+        
+        const int32 TeamIndex = Slot / FCubePlayerRegistry::TEAM_COUNT;
+        const float Offset = ((TeamIndex + 1) / 2) * PLAYER_START_SPACING * ((TeamIndex % 2) ? 1.0f : -1.0f);
+        
+        const FVector Location = TeamStart->GetActorLocation() + FVector(0.0f, 0.0f, Offset);
+        APlayerStart* PlayerStart = GetWorld()->SpawnActor<APlayerStart>(APlayerStart::StaticClass(), Location, TeamStart->GetActorRotation(),
+                                                                         SpawnParameters);
+        
+        if(PlayerStart)
+        {
+            PlayerStart->PlayerStartTag = FName(*FString::FromInt(Slot));
+            PlayerStarts[Slot] = PlayerStart;
+        }
+    }
+    
+    bPlayerStartsIndexed = true;
+}
+
+AActor* ACubeProjectGameMode::ChoosePlayerStart_Implementation(AController* Player)
+{
+    // The first player is spawned before the game mode begins play. Index the player starts now if it hasn't been done.
+    if(!bPlayerStartsIndexed)
+    {
+        IndexPlayerStarts();
+    }
+    
+    // Spawn the player at the player start whose tag matches its slot
+    const int32 Slot = FCubePlayerRegistry::GetSlot(Player);
+    
+    if(FCubePlayerRegistry::IsValidSlot(Slot) && PlayerStarts[Slot])
+    {
+        return PlayerStarts[Slot];
+    }
     
     if(GEngine)
         GEngine->AddOnScreenDebugMessage(-1,10.0f,FColor::White,"Choose default spawn");
@@ -175,8 +1165,23 @@ AActor* ACubeProjectGameMode::ChoosePlayerStart_Implementation(AController* Play
     return Super::ChoosePlayerStart(Player);
 }
 
+UClass* ACubeProjectGameMode::GetDefaultPawnClassForController_Implementation(AController* InController)
+{
+    const int32 Slot = FCubePlayerRegistry::GetSlot(InController);
+    
+    // Players on the right team use the second player's Blueprint
+    if(Slot != INDEX_NONE && FCubePlayerRegistry::GetTeam(Slot) == 1 && Player2PawnClass)
+    {
+        return *Player2PawnClass;
+    }
+    
+    return Player1PawnClass ? *Player1PawnClass : Super::GetDefaultPawnClassForController_Implementation(InController);
+}
+
 void ACubeProjectGameMode::OnBallOverlap(AActor* OtherActor)
 {
+    FGameplayAllocationScope GameplayAllocationScope;
+    
     // If the actor which overlapped the ball is non-null, check if the ball hit a goal.
     if(OtherActor)
     {
@@ -204,9 +1209,22 @@ void ACubeProjectGameMode::OnBallOverlap(AActor* OtherActor)
 
 void ACubeProjectGameMode::OnGoal(bool bRightPlayerScored)
 {
-    if(GEngine)
-        GEngine->AddOnScreenDebugMessage(-1,3.0f,FColor::Yellow,"GOAL");
+    // Record the goal along with the team which scored
+    RecordMatchEvent(EMatchEventType::Goal, INDEX_NONE, Ball->GetActorLocation(), FVector::ZeroVector, Ball->GetVelocity().Size(), 0.0f,
+                     bRightPlayerScored ? 1 : 0);
 
+    // Remember which player scored each goal so that the match can be replayed by the rating engine
+    if(NumGoals < MAX_RECORDED_GOALS)
+    {
+        GoalSequence |= (bRightPlayerScored ? 1u : 0u) << NumGoals;
+        NumGoals++;
+    }
+    else if(LeftPlayerScore + RightPlayerScore == MAX_RECORDED_GOALS)
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("The match has more than %d goals: the rating engine will only replay the first %d"),
+               MAX_RECORDED_GOALS, MAX_RECORDED_GOALS);
+    }
+    
     // If the right player scored
     if(bRightPlayerScored)
     {
@@ -234,11 +1252,18 @@ void ACubeProjectGameMode::OnGoal(bool bRightPlayerScored)
             // Inform the GameState instance that the game is over.
             GameState->SetState(EGameState::GAME_OVER);
             
-            // Play the game-winning sound
-            if(WinGameSound)
+            // The match is over. Close its event log and store its result.
+            if(MatchEventLog)
             {
-                UGameplayStatics::PlaySoundAtLocation(World,WinGameSound,FVector::ZeroVector);
+                MatchEventLog->EndMatch();
             }
+            
+            RecordMatchResult();
+            DesyncTrace.End();
+            FCubeMetrics::IncrementCounter(ECubeCounter::MatchesCompleted);
+            
+            // Play the game-winning sound
+            PlayEffect(ECubeEffect::WinGame, FVector::ZeroVector);
         }
         // Else, if the game still isn't over, reset the ball and the players to their start positions.
         else
@@ -248,21 +1273,13 @@ void ACubeProjectGameMode::OnGoal(bool bRightPlayerScored)
         }
     }
     
-    // Play the sound of the ball hitting a goal
-    if(BallHitGoalSound)
-    {
-        UGameplayStatics::PlaySoundAtLocation(World,BallHitGoalSound,Ball->GetActorLocation());
-    }
-    
-    // Play an explosion particle effect on the ball since a goal was just scored
-    if(BallExplosionParticles)
-    {
-        UGameplayStatics::SpawnEmitterAtLocation(World,BallExplosionParticles,Ball->GetActorLocation());
-    }
+    // Play the sound of the ball hitting a goal, with an explosion on the ball since a goal was just scored
+    PlayEffect(ECubeEffect::Goal, Ball->GetActorLocation());
     
-    // Play a camera shake when the user scores a goal
+    // Play a camera shake when the user scores a goal. The camera manager creates an object for every shake it plays.
     if(ScoreGoalCameraShake)
     {
+        FEngineAllocationScope EngineAllocationScope;
         World->GetFirstPlayerController()->ClientPlayCameraShake(ScoreGoalCameraShake, 1.0f, ECameraAnimPlaySpace::World,
                                                                                 FRotator::ZeroRotator);
     }
@@ -272,14 +1289,13 @@ void ACubeProjectGameMode::OnGoal(bool bRightPlayerScored)
 void ACubeProjectGameMode::PushBall(const bool bMoveRight)
 {
     // Give the ball an initial push to get the game started.
-    Ball->StartMove(bMoveRight);
+    Ball->StartMove(bMoveRight, KickoffStream);
 }
 
 void ACubeProjectGameMode::ResetField()
 {
     // Reset each pawn and actor on the field to their default locations
-    Player1Pawn->Reset();
-    Player2Pawn->Reset();
+    PlayerRegistry.ResetPawns();
     Ball->Reset();
 }
 
@@ -303,12 +1319,19 @@ void ACubeProjectGameMode::StartGame()
         
         // Start a timer which will call OnQuitMainMenuTimerComplete() once complete.
         // Once this method is called, game state is switched to "RESET" and the game starts
-        GetWorld()->GetTimerManager().SetTimer(QuitMainMenuTimerHandle,this,&ACubeProjectGameMode::OnQuitMainMenuTimerComplete,QuitMainMenuTimerDuration,false);
+        FGameplayTimerWheel& TimerWheel = GameState->GetTimerWheel();
+        TimerWheel.Cancel(QuitMainMenuTimerHandle);
+        QuitMainMenuTimerHandle = TimerWheel.Schedule(ACubeProjectGameState::SecondsToTicks(QuitMainMenuTimerDuration),this,
+                                                      &ACubeProjectGameMode::OnQuitMainMenuTimerComplete);
     }
 }
 
 void ACubeProjectGameMode::OnQuitMainMenuTimerComplete()
 {
+    // Start recording the match before the state changes so that the transition is part of its log
+    BeginMatchLog();
+    SeedMatch();
+    
     // Retrieve the object controlling the game's state
     ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
     // Tell the GameState instance to reset the field and start the game
@@ -323,6 +1346,10 @@ void ACubeProjectGameMode::RestartGame()
     // Reload the game level
     //UGameplayStatics::OpenLevel(GetWorld(),TwoPlayerGameMapName);
     
+    // Start recording the new match before the state changes so that the transition is part of its log
+    BeginMatchLog();
+    SeedMatch();
+    
     ACubeProjectGameState* GameState = GetGameState<ACubeProjectGameState>();
     GameState->SetState(EGameState::RESET);
     
@@ -339,33 +1366,42 @@ void ACubeProjectGameMode::RestartGame()
 
 void ACubeProjectGameMode::UpdateScoreText()
 {
-    // Update the score displayed on screen using the TextRenderActors displaying the game score
-    ScoreTextLeft->GetTextRender()->SetText(FText::AsNumber(LeftPlayerScore));
-    ScoreTextRight->GetTextRender()->SetText(FText::AsNumber(RightPlayerScore));
-
-}
-
-void ACubeProjectGameMode::SetPlayerInputEnabled(bool bEnabled)
-{
-    // Get the world instance controlling the game
-    UWorld* World = GetWorld();
+    // Update the score displayed on screen using the TextRenderActors displaying the game score. The texts of the scores
+    // reachable in a match are formatted once, at BeginPlay().
+    const int32 Scores[] = { LeftPlayerScore, RightPlayerScore };
+    ATextRenderActor* ScoreTextActors[] = { ScoreTextLeft, ScoreTextRight };
     
-    // If player input should be enabled
-    if(bEnabled)
+    for(int32 Side = 0; Side < ARRAY_COUNT(Scores); Side++)
     {
-        // Enable player input
-        UGameplayStatics::GetPlayerController(World,0)->ResetIgnoreMoveInput();
-        UGameplayStatics::GetPlayerController(World,1)->ResetIgnoreMoveInput();
+        UTextRenderComponent* TextRender = ScoreTextActors[Side] ? ScoreTextActors[Side]->GetTextRender() : NULL;
+        
+        if(!TextRender)
+            continue;
+        
+        const FText ScoreText = ScoreTexts.IsValidIndex(Scores[Side]) ? ScoreTexts[Scores[Side]] : FText::AsNumber(Scores[Side]);
+        
+        // Setting a text recreates its render state, even if the text did not change
+        if(!TextRender->Text.IdenticalTo(ScoreText))
+        {
+            TextRender->SetText(ScoreText);
+        }
     }
-    // Else, if player input should be disabled
-    else
+}
+
+void ACubeProjectGameMode::PlayEffect(ECubeEffect::Type Effect, const FVector& SoundLocation, const FVector& ParticleLocation)
+{
+    if(EffectPool)
     {
-        // Disable player input
-        UGameplayStatics::GetPlayerController(World,0)->SetIgnoreMoveInput(true);
-        UGameplayStatics::GetPlayerController(World,1)->SetIgnoreMoveInput(true);
+        EffectPool->Play(Effect, SoundLocation, ParticleLocation);
     }
 }
 
+void ACubeProjectGameMode::SetPlayerInputEnabled(bool bEnabled)
+{
+    // Enable or disable the input of every player in the match
+    PlayerRegistry.SetInputEnabled(bEnabled);
+}
+
 ABall* ACubeProjectGameMode::GetBall()
 {
     // Return the ball currently on the field.
@@ -1,6 +1,14 @@
 #pragma once
 
 #include "GameFramework/GameMode.h"
+#include "CubePlayerRegistry.h"
+#include "MatchEventLogFormat.h"
+#include "GameplayTimerWheel.h"
+#include "CubeDeterminism.h"
+#include "CubeMatchSim.h"
+#include "CubeLiveBridgeFormat.h"
+#include "CubeBroadcastFormat.h"
+#include "CubeEffectPool.h"
 #include "CubeProjectGameMode.generated.h"
 
 UCLASS()
@@ -12,13 +20,26 @@ public:
     // Called to initialize the game mode's properties
     ACubeProjectGameMode();
     
+    /** Spawns a generated arena when -GenerateArena is given, before the first player looks for its player start. The
+      * arena is described by the parameters read by CubeArenaGenerator::ParseParams(), its seed may also be given in
+      * the level's URL (?ArenaSeed=<seed>), and it is best played in an empty map
+      * (e.g., /Engine/Maps/Entry), as the level's own walls and goals are kept. */
+    virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+    
     // Called when the game starts
     virtual void BeginPlay() override;
     
-    /** Returns the PlayerStart actor where the given player should spawn. This is used to make sure that the first player
-      * is always spawned at the right and the second player is always spawned to the left. */
+    // Called when the game ends
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    
+    /** Returns the PlayerStart actor where the given player should spawn. Each player spawns at the player start whose tag
+      * matches the player's slot (e.g., the first player spawns at the player start with tag "0"). */
     virtual AActor* ChoosePlayerStart_Implementation(AController* Player) override;
     
+    /** Returns the pawn Blueprint for the given player. Players on the left team use the first player's Blueprint, and
+      * players on the right team use the second player's Blueprint. */
+    virtual UClass* GetDefaultPawnClassForController_Implementation(AController* InController) override;
+    
     /** Called when the ball overlaps another actor. If a goal is overlapped, a point is given to the correct player. */
     UFUNCTION()
     void OnBallOverlap(AActor* OtherActor);
@@ -48,6 +69,78 @@ public:
       * When the timer is enabled and the game is waiting to start, player input is disabled. */
     void SetPlayerInputEnabled(bool bEnabled);
     
+    /** Records a gameplay event in the current match's event log. The event is stamped with the current match tick and time.
+      * Does nothing if event recording is disabled. */
+    void RecordMatchEvent(EMatchEventType::Type Type, int32 Slot, const FVector& Location, const FVector& Normal, float Speed, float Angle,
+                          int32 Param = 0);
+    
+    /** Assigns a bot to control the player in the given slot. Pass an invalid pointer to give the control back to the player. */
+    void SetBot(int32 Slot, TSharedPtr<class FCubeBot> Bot);
+    
+    /** Lets every bot control its pawn. Called from ACubeProjectGameState::Tick() while the game is being played. */
+    void TickBots(float DeltaTime);
+    
+    /** Pops the inputs pushed by external tools through the live state bridge (-LiveBridge[=<name>]). The latest input of
+      * each slot is held until the next one arrives. Called at the start of every ACubeProjectGameState::Tick(). */
+    void ReceiveLiveBridgeInputs();
+    
+    /** Applies the inputs received through the live state bridge to the pawns, exactly like the input of a bot. Called
+      * from ACubeProjectGameState::Tick() while the game is being played. */
+    void ApplyLiveBridgeInputs();
+    
+    /** Publishes the state of the match through the live state bridge. Called at the end of every ACubeProjectGameState::Tick(). */
+    void PublishLiveState();
+    
+    /** Applies the inputs sampled by the input sampler since the last frame to the players' pawns. Each movement input is
+      * weighted by the part of the frame it was held for, and each spin is applied at the time the button was released.
+      * Called at the start of every ACubeProjectGameState::Tick(). */
+    void ApplySampledInputs();
+    
+    /** Sends the state and events of the tick to the spectator broadcast relay (-Broadcast[=<address:port>]). Called at the
+      * end of every ACubeProjectGameState::Tick(). */
+    void BroadcastState();
+    
+    /** Plays a sound and particle effect with the components pooled when the game mode began play. */
+    void PlayEffect(ECubeEffect::Type Effect, const FVector& SoundLocation, const FVector& ParticleLocation);
+    FORCEINLINE void PlayEffect(ECubeEffect::Type Effect, const FVector& Location) { PlayEffect(Effect, Location, Location); }
+
+    /** Returns true if the game runs in the determinism mode (-deterministic). In this mode, the game state advances the whole
+      * match in fixed simulation ticks, the ball and pawns are moved with strict math instead of PhysX and the movement
+      * components, and the hash of the gameplay state is written to a desync trace in Saved/Determinism at every tick. */
+    FORCEINLINE bool IsDeterministic() const { return bDeterministic; }
+    
+    /** Moves the pawns and the ball by one simulation tick and hashes the resulting state. Called from ACubeProjectGameState::Tick()
+      * in the determinism mode. */
+    void StepDeterministic(float DeltaTime);
+    
+    /** Adds the gameplay state of the match (game state, score, random streams, ball and pawns) to the given hash. */
+    void HashGameplayState(FCubeStateHasher& Hasher) const;
+    
+    /** Returns the hash of the gameplay state at the last simulation tick. Only computed in the determinism mode. */
+    FORCEINLINE uint64 GetLastStateHash() const { return LastStateHash; }
+    
+    /** Saves the match in progress to Saved/Matches/<SaveName>.gsms (console command: SaveMatch <name>). */
+    UFUNCTION(Exec)
+    void SaveMatch(const FString& SaveName);
+    
+    /** Replaces the match in progress with the one saved in Saved/Matches/<SaveName>.gsms, which may have been saved by
+      * another process (console command: ResumeMatch <name>). */
+    UFUNCTION(Exec)
+    void ResumeMatch(const FString& SaveName);
+    
+    /** Copies the state of the match in progress, timers included, to a saved match. Returns false if no match is in progress. */
+    bool SaveMatchState(struct FCubeMatchSaveRecord& OutRecord) const;
+    
+    /** Replaces the state of the match in progress with a saved one. In the determinism mode, the match then plays on exactly
+      * as the saved match would have. Returns false if the game has not booted or the save has another number of players. */
+    bool ResumeMatchState(const struct FCubeMatchSaveRecord& Record);
+    
+    /** Returns the seed of the current match's random streams. */
+    FORCEINLINE uint64 GetMatchSeed() const { return MatchSeed; }
+    
+    /** Returns the registry storing the controller and pawn of every player in the match. */
+    FORCEINLINE const FCubePlayerRegistry& GetPlayerRegistry() const { return PlayerRegistry; }
+    
     /** Returns the score obtained by the player which starts on the left-hand side of the field. */
     int32 GetLeftPlayerScore() const;
     /** Returns the score obtained by the player which starts on the right-hand side of the field. */
@@ -69,9 +162,20 @@ public:
       * glitches. */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=GameSettings)
     bool bPackagedBuild = false;
+    /** If true, the events of every match are recorded to a log file in Saved/MatchLogs. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=GameSettings)
+    bool bRecordMatchEvents = true;
+    /** If true, the result of every match played by people is appended to Saved/Ratings/Results.gsrr, which the rating
+      * engine reads. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=GameSettings)
+    bool bRecordMatchResults = true;
     /** The default score needed to win the game. */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=GameSettings)
     int32 DefaultScoreToWin = 3;
+    /** The number of players on each team. Set to 2 for a 2v2 match and to 4 for a 4v4 match. Each player needs a player
+      * start tagged with its slot ("0" to "7") in the level. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=GameSettings, meta=(ClampMin="1", ClampMax="4"))
+    int32 PlayersPerTeam = 1;
     /** The duration of the "Quit Main Menu" timer. This timer is a small delay between the time the user presses
       * ENTER in the main menu and the time the game starts. This allows breathing room before the game starts */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=GameSettings)
@@ -129,6 +233,30 @@ private:
      */
     void OnGoal(bool bRightPlayerScored);
     
+    /** Appends the result of the match which just ended to the results file read by the rating engine, unless a bot or an
+      * external tool controlled one of its players. */
+    void RecordMatchResult();
+    
+    /** Returns the name used to rate the given team: the names of its players, joined by '+'. */
+    FString GetTeamName(int32 Team) const;
+    
+    /** Starts recording the events of a new match. Called whenever a match starts or restarts. */
+    void BeginMatchLog();
+    
+    /** Seeds the random streams of a new match and, in the determinism mode, starts its desync trace. Called whenever a
+      * match starts or restarts. */
+    void SeedMatch();
+    
+    /** Stores every player start in the level by its slot tag, and spawns the starts of the players the level has none for.
+      * Called once at BeginPlay(), or earlier if a player spawns before the game mode begins play. */
+    void IndexPlayerStarts();
+    
+    /** Describes the arena and the tuning of the ball and pawns to the match simulation. Called once at BeginPlay(). */
+    void BuildSimConfig();
+    
+    /** Copies the gameplay state of the match to its form in the match simulation. */
+    void CaptureMatchState(FCubeMatchState& OutState) const;
+    
     /** The name of the map for a two-player match. This is the level loaded once the game restarts. */
     UPROPERTY(EditAnywhere, Category=GameSettings)
     FName TwoPlayerGameMapName;
@@ -136,11 +264,11 @@ private:
     /** The handle which is in charge of controlling the "Quit Main Menu" timer. This timer is a small delay between
       * the time the user presses enter in the main menu and the time the game starts. This allows breathing room 
       * before the game starts */
-    FTimerHandle QuitMainMenuTimerHandle;
+    FGameplayTimerHandle QuitMainMenuTimerHandle;
     
-    /** The pawn blueprint used for the first player. */
+    /** The pawn blueprint used by the players on the left team. */
     TSubclassOf<class APawn> Player1PawnClass;
-    /** The pawn blueprint used for the second player. */
+    /** The pawn blueprint used by the players on the right team. */
     TSubclassOf<class APawn> Player2PawnClass;
     /** The blueprint used to spawn the ball. */
     TSubclassOf<class ABall> BallClass;
@@ -148,10 +276,52 @@ private:
     /** The Blueprint used for the score text at the top of the screen. */
     TSubclassOf<class ATextRenderActor> ScoreTextClass;
     
-    /** The pawn controlled by the first player. */
-    APawn* Player1Pawn;
-    /** The pawn controlled by the second player. */
-    APawn* Player2Pawn;
+    /** Stores the controller and pawn of every player in the match. */
+    FCubePlayerRegistry PlayerRegistry;
+    
+    /** The bot controlling each player slot, if any. */
+    TSharedPtr<class FCubeBot> Bots[FCubePlayerRegistry::MAX_PLAYERS];
+    
+    /** The goal defended by each team. Team 0 defends the goal on the left-hand side. */
+    class AGoal* TeamGoals[FCubePlayerRegistry::TEAM_COUNT];
+    
+    /** The arena and tuning used by bots which look ahead with the match simulation. */
+    FCubeSimConfig SimConfig;
+    /** The cooked walls of the level, or the walls of the generated arena, used by SimConfig. NULL if the level's
+      * collision was not cooked. */
+    class FCubeArenaGeometry* ArenaGeometry = NULL;
+    /** The arena generated at InitGame(). NULL unless -GenerateArena is given. */
+    struct FCubeGeneratedArena* GeneratedArena = NULL;
+    
+    /** Shares the live state of the match with external tools and receives their inputs. NULL unless -LiveBridge is given. */
+    class FCubeLiveBridge* LiveBridge = NULL;
+    /** The last input received through the live state bridge for each slot. */
+    FCubeLiveInput LiveBridgeInputs[FCubePlayerRegistry::MAX_PLAYERS];
+    /** True for each slot controlled through the live state bridge. */
+    bool bLiveBridgeSlots[FCubePlayerRegistry::MAX_PLAYERS];
+    
+    /** Samples the players' devices at 1 kHz, or generates the input of a player with -SyntheticInput. NULL if
+      * -NoInputSampler is given or if the platform can't sample devices. */
+    class FCubeInputSampler* InputSampler = NULL;
+    /** Traces the latency of the inputs up to the display. NULL unless -LatencyTrace or -SyntheticInput is given. */
+    class FCubeLatencyTracker* LatencyTracker = NULL;
+    /** The last movement input sampled for each slot, quantized to 1/127. */
+    int8 SampledMoves[FCubePlayerRegistry::MAX_PLAYERS][2];
+    /** The time up to which the sampled inputs were applied, in FPlatformTime::Seconds(). */
+    double SampledInputTime = 0.0;
+    
+    /** Sends the match to the spectator broadcast relay. NULL unless -Broadcast is given. */
+    class FCubeBroadcastPublisher* BroadcastPublisher = NULL;
+    /** The events recorded since the last broadcast frame. */
+    TArray<FCubeBroadcastEvent> PendingBroadcastEvents;
+    
+    /** The player start for each player slot, indexed by the player start's tag ("0" to "7"). */
+    APlayerStart* PlayerStarts[FCubePlayerRegistry::MAX_PLAYERS];
+    /** True once the level's player starts have been indexed. */
+    bool bPlayerStartsIndexed = false;
+    /** The vertical distance between the spawned starts of the players of a team, in cm. Four starts fit between the floor
+      * and the ceiling. */
+    static constexpr float PLAYER_START_SPACING = 100.0f;
     /** The ball currently on the field. */
     class ABall* Ball;
     
@@ -159,6 +329,11 @@ private:
     ATextRenderActor* ScoreTextLeft;
     /** The text actor which displays the right-hand score */
     ATextRenderActor* ScoreTextRight;
+    /** The text of every score up to the score to win, formatted once so that updating the score text formats nothing. */
+    TArray<FText> ScoreTexts;
+
+    /** Plays the sounds and particle effects of the match without spawning components. */
+    FCubeEffectPool* EffectPool = NULL;
     
     /** The score for the player on the left. */
     int32 LeftPlayerScore;
@@ -168,6 +343,43 @@ private:
     /** The score a player needs to win the game. */
     int32 ScoreToWin;
     
+    /** Bit N is set if the right player scored the Nth goal of the current match. Lets the rating engine replay the match
+      * with a different score to win. */
+    uint32 GoalSequence = 0;
+    /** The number of goals recorded in GoalSequence, up to MAX_RECORDED_GOALS. Later goals are not recorded. */
+    int32 NumGoals = 0;
+    /** The number of goals GoalSequence can hold. */
+    static constexpr int32 MAX_RECORDED_GOALS = 32;
+    
+    /** Records the events of each match to disk. NULL if event recording is disabled. */
+    class FMatchEventLog* MatchEventLog = NULL;
+    /** Appends the result of each match to the rating engine's results file. */
+    class FMatchResultWriter* MatchResultWriter = NULL;
+    /** The game state's tick count when the current match started. Events are stamped relative to this tick. */
+    uint32 MatchStartTick = 0;
+    /** The world time when the current match started. Events are stamped relative to this time. */
+    float MatchStartTime = 0.0f;
+    
     /** True if the right player won last (i.e., the player starting on the right of the field scored the last goal). */
     bool bRightPlayerScoredLast = true;
+    
+    /** True in the determinism mode. */
+    bool bDeterministic = false;
+    /** The seed from which the seed of every match is derived. Set with -seed=<value>, random otherwise. */
+    uint64 BaseSeed = 0;
+    /** The number of matches seeded since the game mode began play. */
+    int32 NumMatchesSeeded = 0;
+    /** The seed of the current match. */
+    uint64 MatchSeed = 0;
+    /** Draws the ball's direction at each kickoff. */
+    FCubeRandomStream KickoffStream;
+    
+    /** Writes the hash of the gameplay state at every simulation tick of the current match, in the determinism mode. */
+    FCubeDesyncTrace DesyncTrace;
+    /** The fields hashed at the last simulation tick. Only recorded while a desync trace is written. */
+    TArray<FCubeStateField> StateFields;
+    /** The simulation tick at which the current match started. */
+    uint64 MatchStartSimulationTick = 0;
+    /** The hash of the gameplay state at the last simulation tick. */
+    uint64 LastStateHash = 0;
 };
\ No newline at end of file
@@ -3,6 +3,10 @@
 #include "CubeProjectGameMode.h"
 #include "CubeProjectLevelScriptActor.h"
 #include "Ball.h"
+#include "FrameTimeTelemetry.h"
+#include "CubeMetrics.h"
+#include "CubeLatencyTracker.h"
+#include "MallocCounter.h"
 
 /** The amount of time it takes for the game to restart after a goal */
 const float ACubeProjectGameState::GAME_START_TIMER_DURATION = 1.0f;
@@ -14,12 +18,85 @@ ACubeProjectGameState::ACubeProjectGameState()
     
     // The game always starts in 'BOOT' mode
     CurrentState = EGameState::GAME_BOOT;
+    
+    FrameTimeTelemetry = MakeShareable(new FFrameTimeTelemetry());
 }
 
 void ACubeProjectGameState::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
     
+    MatchTick++;
+    
+    // Record the time taken by the last frame under the current state
+    FrameTimeTelemetry->Sample(DeltaTime, CurrentState);
+    FCubeMetrics::ObserveHistogram(ECubeHistogram::FrameTime, DeltaTime);
+    
+    ACubeProjectGameMode* GameMode = (ACubeProjectGameMode*)GetWorld()->GetAuthGameMode();
+    const bool bDeterministic = GameMode && GameMode->IsDeterministic();
+    
+    // Everything the match does during the frame is gameplay code, which is expected not to allocate while a match is played.
+    // This includes feeding the live state bridge and the spectator broadcast at the end of the frame.
+    {
+        FGameplayAllocationScope GameplayAllocationScope;
+        
+        // Take the inputs that external tools pushed and the players' inputs sampled since the last frame
+        if(GameMode)
+        {
+            GameMode->ReceiveLiveBridgeInputs();
+            GameMode->ApplySampledInputs();
+        }
+        
+        // Advance the gameplay timers by the number of simulation ticks elapsed during the frame. The small tolerance keeps a
+        // frame of exactly one tick from being split across two frames because of rounding.
+        UnsimulatedTime += DeltaTime;
+        const float TickDuration = 1.0f / SIMULATION_TICK_RATE;
+        
+        while(UnsimulatedTime >= TickDuration - KINDA_SMALL_NUMBER)
+        {
+            UnsimulatedTime = FMath::Max(UnsimulatedTime - TickDuration, 0.0f);
+            StepSimulation();
+        }
+        
+        if(!bDeterministic)
+        {
+            UpdateState(DeltaTime);
+        }
+        
+        // Let external tools and spectators see the state reached at the end of the frame
+        if(GameMode)
+        {
+            GameMode->PublishLiveState();
+            GameMode->BroadcastState();
+        }
+    }
+    
+    // Carry the inputs which had an effect during the frame to the render thread
+    if(FCubeLatencyTracker* LatencyTracker = FCubeLatencyTracker::Get())
+    {
+        LatencyTracker->EndFrame();
+    }
+}
+
+void ACubeProjectGameState::StepSimulation()
+{
+    ACubeProjectGameMode* GameMode = (ACubeProjectGameMode*)GetWorld()->GetAuthGameMode();
+    const float TickDuration = 1.0f / SIMULATION_TICK_RATE;
+    
+    TimerWheel.Advance();
+    FCubeMetrics::IncrementCounter(ECubeCounter::TicksSimulated);
+    
+    // In the determinism mode, the whole match advances one simulation tick at a time, so that it plays out the same way
+    // whatever the frame rate
+    if(GameMode && GameMode->IsDeterministic())
+    {
+        UpdateState(TickDuration);
+        GameMode->StepDeterministic(TickDuration);
+    }
+}
+
+void ACubeProjectGameState::UpdateState(float DeltaTime)
+{
     UWorld* World = GetWorld();
     
     ACubeProjectLevelScriptActor* LevelBlueprint = Cast<ACubeProjectLevelScriptActor>(World->GetLevelScriptActor());
@@ -36,7 +113,7 @@ void ACubeProjectGameState::Tick(float DeltaTime)
                 // Disable player input when the game starts
                 GameMode->SetPlayerInputEnabled(false);
                 // Transition to the main menu when the game boots
-                CurrentState = EGameState::MAIN_MENU;
+                SetState(EGameState::MAIN_MENU);
                 break;
             }
             case EGameState::MAIN_MENU:
@@ -50,11 +127,12 @@ void ACubeProjectGameState::Tick(float DeltaTime)
                 GameMode->UpdateScoreText();
                 GameMode->SetPlayerInputEnabled(false);
                 // Start a timer which will call OnGameStart once complete. Once this method is called, game state is switched to "PUSH_BALL"
-                World->GetTimerManager().SetTimer(GameStartTimerHandle,this,&ACubeProjectGameState::OnGameStart,GAME_START_TIMER_DURATION,false);
+                TimerWheel.Cancel(GameStartTimerHandle);
+                GameStartTimerHandle = TimerWheel.Schedule(SecondsToTicks(GAME_START_TIMER_DURATION),this,&ACubeProjectGameState::OnGameStart);
                 if(LevelBlueprint)
                     LevelBlueprint->ShowGameStartTimer();
                 // Wait until the timer elapses before starting the game 
-                CurrentState = EGameState::WAITING_TO_START;
+                SetState(EGameState::WAITING_TO_START);
                 break;
             }
             case EGameState::WAITING_TO_START:
@@ -68,12 +146,14 @@ void ACubeProjectGameState::Tick(float DeltaTime)
                 GameMode->SetPlayerInputEnabled(true);
                 // Gives the ball an initial push to get the game started. If the right-most player scored last, shoot the ball to the left
                 GameMode->PushBall(!GameMode->DidRightPlayerScoreLast());
-                CurrentState = EGameState::PLAYING;
+                SetState(EGameState::PLAYING);
                 break;
             }
             case EGameState::PLAYING:
             {
-                // Wait for a player to score
+                // Let the bots play while waiting for a player to score
+                GameMode->TickBots(DeltaTime);
+                GameMode->ApplyLiveBridgeInputs();
                 break;
             }
             case EGameState::GAME_OVER:
@@ -86,7 +166,7 @@ void ACubeProjectGameState::Tick(float DeltaTime)
                 
                 GameMode->SetPlayerInputEnabled(false);
                 GameMode->GetBall()->SetEnabled(false);
-                CurrentState = EGameState::WAITING_TO_RESTART;
+                SetState(EGameState::WAITING_TO_RESTART);
                 break;
             }
             case EGameState::WAITING_TO_RESTART:
@@ -97,7 +177,7 @@ void ACubeProjectGameState::Tick(float DeltaTime)
                 
             default:
                 // By default, wait for the game to start.
-                CurrentState = EGameState::WAITING_TO_START;
+                SetState(EGameState::WAITING_TO_START);
                 break;
         }
     }
@@ -107,7 +187,32 @@ void ACubeProjectGameState::Tick(float DeltaTime)
 void ACubeProjectGameState::OnGameStart()
 {
     // Push the ball to start the game.
-    CurrentState = EGameState::PUSH_BALL;
+    SetState(EGameState::PUSH_BALL);
+}
+
+uint32 ACubeProjectGameState::SecondsToTicks(float Seconds)
+{
+    return (uint32)FMath::Max(FMath::CeilToInt(Seconds * SIMULATION_TICK_RATE - KINDA_SMALL_NUMBER), 0);
+}
+
+uint32 ACubeProjectGameState::GetGameStartTicks() const
+{
+    return TimerWheel.GetRemainingTicks(GameStartTimerHandle);
+}
+
+void ACubeProjectGameState::ResumeState(EGameState::Type NewState, float InUnsimulatedTime, uint32 GameStartTicks)
+{
+    CurrentState = NewState;
+    UnsimulatedTime = InUnsimulatedTime;
+    ResetStartTime = 0.0;
+    FCubeMetrics::SetGauge(ECubeGauge::GameState, NewState);
+    
+    TimerWheel.Cancel(GameStartTimerHandle);
+    
+    if(NewState == EGameState::WAITING_TO_START)
+    {
+        GameStartTimerHandle = TimerWheel.Schedule(GameStartTicks, this, &ACubeProjectGameState::OnGameStart);
+    }
 }
 
 EGameState::Type ACubeProjectGameState::GetState() const
@@ -119,4 +224,24 @@ void ACubeProjectGameState::SetState(EGameState::Type GameState)
 {
     // Update the game's current state. The Tick() function then calls the appropriate methods based on this new state.
     CurrentState = GameState;
+    FCubeMetrics::SetGauge(ECubeGauge::GameState, GameState);
+    
+    // Time the pause between a goal and the next kickoff
+    if(GameState == EGameState::RESET)
+    {
+        ResetStartTime = FPlatformTime::Seconds();
+    }
+    else if(GameState == EGameState::PLAYING && ResetStartTime > 0.0)
+    {
+        FCubeMetrics::ObserveHistogram(ECubeHistogram::ResetToPlaying, FPlatformTime::Seconds() - ResetStartTime);
+        ResetStartTime = 0.0;
+    }
+    
+    // Record the transition in the match's event log
+    ACubeProjectGameMode* GameMode = GetWorld() ? GetWorld()->GetAuthGameMode<ACubeProjectGameMode>() : NULL;
+    
+    if(GameMode)
+    {
+        GameMode->RecordMatchEvent(EMatchEventType::StateChange, INDEX_NONE, FVector::ZeroVector, FVector::ZeroVector, 0.0f, 0.0f, GameState);
+    }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GameFramework/GameState.h"
+#include "GameplayTimerWheel.h"
 #include "CubeProjectGameState.generated.h"
 
 /** Determines the current state of the game */
@@ -37,16 +38,63 @@ public:
     /** Sets the current state of the game. This affects the logic in the Tick() method. */
     void SetState(EGameState::Type NewState);
     
+    /** Returns the frame time statistics recorded for each game state. */
+    FORCEINLINE const class FFrameTimeTelemetry& GetFrameTimeTelemetry() const { return *FrameTimeTelemetry; }
+    
+    /** Returns the number of times the game state has ticked since the game started. */
+    FORCEINLINE uint32 GetMatchTick() const { return MatchTick; }
+    
+    /** Returns the wheel scheduling the gameplay timers and cooldowns. It advances SIMULATION_TICK_RATE times per second of game time. */
+    FORCEINLINE FGameplayTimerWheel& GetTimerWheel() { return TimerWheel; }
+    
+    /** Returns the game time which has not been simulated yet, less than one simulation tick. */
+    FORCEINLINE float GetUnsimulatedTime() const { return UnsimulatedTime; }
+    
+    /** Returns the number of ticks left before the countdown started in the RESET state ends, or zero. */
+    uint32 GetGameStartTicks() const;
+    
+    /** Puts the game in the state of a resumed match, with the given time left to simulate and ticks left on the countdown
+      * started in the RESET state. Unlike SetState(), the transition is not recorded. */
+    void ResumeState(EGameState::Type NewState, float InUnsimulatedTime, uint32 GameStartTicks);
+    
+    /** Advances the gameplay timers by one simulation tick. In the determinism mode, the game flow, pawns and ball advance
+      * with them. Called by Tick() for every tick elapsed during the frame, and by tools which play a match ahead. */
+    void StepSimulation();
+    
+    /** Returns the number of simulation ticks in the given duration, rounded up. */
+    static uint32 SecondsToTicks(float Seconds);
+    
     /** The amount of time it takes for the game to restart after a goal */
     static const float GAME_START_TIMER_DURATION;
     
+    /** The number of simulation ticks per second of game time. */
+    static constexpr int32 SIMULATION_TICK_RATE = 60;
+    
 private:
+    /** Updates the game according to its current state. Called every frame, or every simulation tick in the determinism mode. */
+    void UpdateState(float DeltaTime);
+    
     /** Called once the timer to start the game elapses. Transitions the game to "PUSH_BALL" state and unlocks player input. */
     void OnGameStart();
     
     /** Handle to manage the timer displayed when the game is about to start. */
-    FTimerHandle GameStartTimerHandle;
+    FGameplayTimerHandle GameStartTimerHandle;
+    
+    /** Schedules the gameplay timers and cooldowns on simulation ticks. */
+    FGameplayTimerWheel TimerWheel;
+    
+    /** The game time which has not been simulated yet, less than one simulation tick. */
+    float UnsimulatedTime = 0.0f;
     
     /** Stores the current state of the game. */
     EGameState::Type CurrentState;
+    
+    /** The number of times the game state has ticked since the game started. */
+    uint32 MatchTick = 0;
+    
+    /** The time at which the game last entered RESET, or zero once the game is playing again. */
+    double ResetStartTime = 0.0;
+    
+    /** Records the frame times of every tick under the current game state. */
+    TSharedPtr<class FFrameTimeTelemetry> FrameTimeTelemetry;
 };
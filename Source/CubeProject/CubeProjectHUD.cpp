@@ -0,0 +1,20 @@
+#include "CubeProject.h"
+#include "CubeProjectHUD.h"
+#include "CubeProjectGameState.h"
+#include "FrameTimeTelemetry.h"
+
+void ACubeProjectHUD::DrawHUD()
+{
+    Super::DrawHUD();
+
+    if(!FFrameTimeTelemetry::IsOverlayEnabled())
+        return;
+
+    // The telemetry is sampled by the game state. Only draw it on the first player's viewport.
+    ACubeProjectGameState* GameState = GetWorld()->GetGameState<ACubeProjectGameState>();
+
+    if(GameState && PlayerOwner && PlayerOwner == GetWorld()->GetFirstPlayerController())
+    {
+        GameState->GetFrameTimeTelemetry().DrawOverlay(Canvas, GEngine->GetSmallFont(), 20.0f, 20.0f);
+    }
+}
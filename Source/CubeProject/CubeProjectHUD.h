@@ -0,0 +1,17 @@
+#pragma once
+
+#include "GameFramework/HUD.h"
+#include "CubeProjectHUD.generated.h"
+
+/**
+ * HUD for the game. Draws the frame time overlay (see FFrameTimeTelemetry) when cube.FrameStats is enabled.
+ */
+UCLASS()
+class CUBEPROJECT_API ACubeProjectHUD : public AHUD
+{
+    GENERATED_BODY()
+
+public:
+    // Called every frame to draw the HUD
+    virtual void DrawHUD() override;
+};
@@ -0,0 +1,155 @@
+#include "CubeProject.h"
+#include "CubeReplay.h"
+#include "CubeMatchSave.h"
+
+void CubeReplay::Write(const FCubeReplay& Replay, TArray<uint8>& OutData)
+{
+    FCubeReplayHeader Header;
+    FMemory::Memzero(Header);
+    Header.Magic = FCubeReplayHeader::MAGIC;
+    Header.Version = FCubeReplayHeader::VERSION;
+    Header.HeaderSize = (uint16)sizeof(FCubeReplayHeader);
+
+    const FCubeArenaParams& Params = Replay.ArenaParams;
+    Header.bGeneratedArena = Replay.bGeneratedArena ? 1 : 0;
+    Header.ObstacleLayout = (uint8)Params.ObstacleLayout;
+    Header.NumObstacles = (uint16)FMath::Clamp(Params.NumObstacles, 0, (int32)MAX_uint16);
+    Header.HalfLength = Params.HalfLength;
+    Header.HalfHeight = Params.HalfHeight;
+    Header.GoalHalfHeight = Params.GoalHalfHeight;
+    Header.CornerRadius = Params.CornerRadius;
+    Header.ObstacleHalfSize = Params.ObstacleHalfSize;
+    Header.ArenaSeed = Params.Seed;
+    Header.NumTicks = (uint32)Replay.NumTicks();
+    Header.Start = Replay.Start;
+
+    const int32 NumInputs = Header.NumTicks * Replay.Start.NumPlayers;
+    OutData.SetNumUninitialized(sizeof(Header) + NumInputs * sizeof(FCubeReplayInput));
+    FMemory::Memcpy(OutData.GetData(), &Header, sizeof(Header));
+
+    FCubeReplayInput* Inputs = (FCubeReplayInput*)(OutData.GetData() + sizeof(Header));
+
+    for(int32 Index = 0; Index < NumInputs; Index++)
+    {
+        Inputs[Index].MoveX = Replay.Inputs[Index].MoveX;
+        Inputs[Index].MoveY = Replay.Inputs[Index].MoveY;
+        Inputs[Index].bSpin = Replay.Inputs[Index].bSpin ? 1 : 0;
+    }
+}
+
+bool CubeReplay::Read(const uint8* Data, int32 Size, FCubeReplay& OutReplay)
+{
+    if(Size < (int32)sizeof(FCubeReplayHeader))
+        return false;
+
+    FCubeReplayHeader Header;
+    FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+    if(Header.Magic != FCubeReplayHeader::MAGIC || Header.Version != FCubeReplayHeader::VERSION || Header.HeaderSize != sizeof(Header))
+        return false;
+
+    if(Header.ObstacleLayout >= ECubeObstacleLayout::Count)
+        return false;
+
+    // The start is checked like any saved match
+    FCubeMatchSaveRecord Start;
+
+    if(!CubeMatchSave::Read((const uint8*)&Header.Start, sizeof(Header.Start), Start))
+        return false;
+
+    const int64 NumInputs = (int64)Header.NumTicks * Start.NumPlayers;
+
+    if(Size != (int64)sizeof(Header) + NumInputs * (int64)sizeof(FCubeReplayInput))
+        return false;
+
+    OutReplay.Start = Start;
+    OutReplay.bGeneratedArena = Header.bGeneratedArena != 0;
+
+    FCubeArenaParams& Params = OutReplay.ArenaParams;
+    Params = FCubeArenaParams();
+    Params.HalfLength = Header.HalfLength;
+    Params.HalfHeight = Header.HalfHeight;
+    Params.GoalHalfHeight = Header.GoalHalfHeight;
+    Params.CornerRadius = Header.CornerRadius;
+    Params.ObstacleLayout = (ECubeObstacleLayout::Type)Header.ObstacleLayout;
+    Params.NumObstacles = Header.NumObstacles;
+    Params.ObstacleHalfSize = Header.ObstacleHalfSize;
+    Params.NumPlayers = Start.NumPlayers;
+    Params.Seed = Header.ArenaSeed;
+
+    const FCubeReplayInput* Inputs = (const FCubeReplayInput*)(Data + sizeof(Header));
+    OutReplay.Inputs.SetNumUninitialized((int32)NumInputs);
+
+    for(int32 Index = 0; Index < NumInputs; Index++)
+    {
+        OutReplay.Inputs[Index].MoveX = Inputs[Index].MoveX;
+        OutReplay.Inputs[Index].MoveY = Inputs[Index].MoveY;
+        OutReplay.Inputs[Index].bSpin = Inputs[Index].bSpin != 0;
+    }
+
+    return true;
+}
+
+bool CubeReplay::SaveToFile(const FCubeReplay& Replay, const FString& FileName)
+{
+    TArray<uint8> Data;
+    Write(Replay, Data);
+    return FFileHelper::SaveArrayToFile(Data, *FileName);
+}
+
+bool CubeReplay::LoadFromFile(const FString& FileName, FCubeReplay& OutReplay)
+{
+    TArray<uint8> Data;
+
+    if(!FFileHelper::LoadFileToArray(Data, *FileName, FILEREAD_Silent))
+        return false;
+
+    return Read(Data.GetData(), Data.Num(), OutReplay);
+}
+
+void CubeReplay::MakeConfig(const FCubeReplay& Replay, FCubeSimConfig& OutConfig, FCubeArenaGeometry& OutGeometry)
+{
+    if(Replay.bGeneratedArena)
+    {
+        FCubeGeneratedArena GeneratedArena;
+        CubeArenaGenerator::Generate(Replay.ArenaParams, GeneratedArena);
+        CubeArenaGenerator::BuildGeometry(GeneratedArena, OutGeometry);
+
+        OutConfig.Arena = GeneratedArena.Arena;
+        OutConfig.Geometry = &OutGeometry;
+    }
+}
+
+FCubeReplayPlayer::FCubeReplayPlayer(const FCubeReplay& InReplay)
+    : Replay(InReplay)
+    , KickoffStream(InReplay.Start.Seed, ECubeRandomStream::Kickoff)
+    , ScoreToWin(FMath::Max((int32)InReplay.Start.ScoreToWin, 1))
+    , NextTick(0)
+    , bMatchOver(false)
+{
+    CubeReplay::MakeConfig(Replay, Config, Geometry);
+    CubeMatchSave::RestoreSimState(Replay.Start, State, StartLocations);
+    KickoffStream.SetCounter(Replay.Start.KickoffDraws);
+}
+
+FCubeSimEvents FCubeReplayPlayer::Tick()
+{
+    const FCubeSimEvents Events = CubeSim::Step(State, Config, Replay.GetInputs(NextTick));
+    NextTick++;
+
+    if(Events.ScoringTeam != INDEX_NONE)
+    {
+        if(State.Scores[Events.ScoringTeam] >= ScoreToWin)
+        {
+            bMatchOver = true;
+        }
+        else
+        {
+            // Reset the field and push the ball away from the team which scored, like FCubeHostedMatch
+            CubeSim::ResetField(State, StartLocations);
+            CubeSim::Kickoff(State, Config, KickoffStream, Events.ScoringTeam != 1);
+        }
+    }
+
+    return Events;
+}
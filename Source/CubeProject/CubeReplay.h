@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CubeReplayFormat.h"
+#include "CubeMatchSim.h"
+#include "CubeArenaGenerator.h"
+#include "CubeArenaGeometry.h"
+
+/** A match of the simulation, recorded as the state it started from and the input of every player at every tick (see
+  * CubeReplayFormat.h). */
+struct FCubeReplay
+{
+    /** The state of the match before the first tick: ball, pawns, start locations, scores, score to win and seed. */
+    FCubeMatchSaveRecord Start;
+    /** True if the match is played in an arena generated from ArenaParams, rather than in the default arena. */
+    bool bGeneratedArena = false;
+    FCubeArenaParams ArenaParams;
+    /** The input of every player at every tick: Start.NumPlayers inputs per tick. */
+    TArray<FCubeSimInput> Inputs;
+
+    /** Returns the number of ticks recorded. */
+    FORCEINLINE int32 NumTicks() const { return Start.NumPlayers > 0 ? Inputs.Num() / Start.NumPlayers : 0; }
+    /** Returns the inputs of every player at the given tick. */
+    FORCEINLINE const FCubeSimInput* GetInputs(int32 Tick) const { return &Inputs[Tick * Start.NumPlayers]; }
+};
+
+/** Writes and reads replays. */
+namespace CubeReplay
+{
+    /** Replaces the given bytes with the replay. */
+    CUBEPROJECT_API void Write(const FCubeReplay& Replay, TArray<uint8>& OutData);
+
+    /** Reads a replay, and checks that its start can be played. Returns false if it can't. */
+    CUBEPROJECT_API bool Read(const uint8* Data, int32 Size, FCubeReplay& OutReplay);
+
+    /** Writes a replay to a file. Returns false if the file could not be written. */
+    CUBEPROJECT_API bool SaveToFile(const FCubeReplay& Replay, const FString& FileName);
+
+    /** Reads a replay from a file. Returns false if the file could not be read or is not a valid replay. */
+    CUBEPROJECT_API bool LoadFromFile(const FString& FileName, FCubeReplay& OutReplay);
+
+    /** Fills the arena of a replay's match. When the arena is generated, the config points to the given geometry, which must
+      * outlive it. */
+    CUBEPROJECT_API void MakeConfig(const FCubeReplay& Replay, FCubeSimConfig& OutConfig, FCubeArenaGeometry& OutGeometry);
+}
+
+/**
+ * Plays a replay back with the match simulation. The game flow is kept to what changes the outcome: after each goal, the
+ * field is reset and the ball kicked off at once, away from the team which scored, and the match ends once a team reaches
+ * the score to win. The countdown before each kickoff is skipped, as nothing moves during it.
+ */
+class CUBEPROJECT_API FCubeReplayPlayer
+{
+public:
+    /** Prepares the match at the start of the replay, which must outlive the player. */
+    explicit FCubeReplayPlayer(const FCubeReplay& InReplay);
+
+    /** Plays the next recorded tick. Must not be called once IsOver() returns true. */
+    FCubeSimEvents Tick();
+
+    /** Returns true once every recorded tick was played, or once a team won. */
+    FORCEINLINE bool IsOver() const { return bMatchOver || NextTick >= Replay.NumTicks(); }
+
+    /** Returns true once a team reached the score to win. */
+    FORCEINLINE bool IsMatchOver() const { return bMatchOver; }
+
+    /** Returns the number of recorded ticks played. */
+    FORCEINLINE int32 GetNumTicksPlayed() const { return NextTick; }
+
+    /** Returns the score a team needs to win. */
+    FORCEINLINE int32 GetScoreToWin() const { return ScoreToWin; }
+
+    FORCEINLINE const FCubeMatchState& GetState() const { return State; }
+    FORCEINLINE const FCubeSimConfig& GetConfig() const { return Config; }
+
+private:
+    const FCubeReplay& Replay;
+    /** The arena and tuning of the match. Its geometry points to Geometry when the arena is generated. */
+    FCubeSimConfig Config;
+    FCubeArenaGeometry Geometry;
+    FCubeMatchState State;
+    FVector2D StartLocations[FCubePlayerRegistry::MAX_PLAYERS];
+    FCubeRandomStream KickoffStream;
+    int32 ScoreToWin;
+    /** The index of the next recorded tick. */
+    int32 NextTick;
+    bool bMatchOver;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CubeMatchSaveFormat.h"
+
+/**
+ * Layout of a replay (.gsrp file): a match of the simulation, from a saved state and the input of every player at every
+ * tick. Playing the inputs back from the saved state gives the same match, tick for tick, on every machine. A replay is
+ * an FCubeReplayHeader, followed by NumTicks * Start.NumPlayers FCubeReplayInput, tick after tick and slot after slot.
+ * A tick is a step of the simulation: while the game flow waits, e.g., for a kickoff, no input is recorded.
+ *
+ * Like saved matches, replays only use fixed-size integers and floats, without padding. All values are little-endian. A
+ * reader rejects a replay whose version or header size differ from its own.
+ */
+
+#pragma pack(push, 1)
+
+/** The input of a player for one tick, as in FCubeSimInput. */
+struct FCubeReplayInput
+{
+    int8 MoveX;
+    int8 MoveY;
+    uint8 bSpin;
+};
+
+/** The start of a replay. */
+struct FCubeReplayHeader
+{
+    static constexpr uint32 MAGIC = 0x50525347; // "GSRP"
+    static constexpr uint16 VERSION = 1;
+
+    uint32 Magic;
+    uint16 Version;
+    /** The size of the header, to reject files written with another layout under the same version. */
+    uint16 HeaderSize;
+
+    /** Non-zero if the match is played in an arena generated by CubeArenaGenerator, from the parameters below. Otherwise,
+      * the match is played in the default arena. */
+    uint8 bGeneratedArena;
+    /** The ECubeObstacleLayout of the generated arena. */
+    uint8 ObstacleLayout;
+    uint16 NumObstacles;
+    float HalfLength;
+    float HalfHeight;
+    float GoalHalfHeight;
+    float CornerRadius;
+    float ObstacleHalfSize;
+    uint64 ArenaSeed;
+
+    /** The number of ticks recorded. */
+    uint32 NumTicks;
+    /** The state of the match before the first tick. */
+    FCubeMatchSaveRecord Start;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(FCubeReplayInput) == 3, "The replay input layout must not depend on the platform");
+static_assert(sizeof(FCubeReplayHeader) == 362, "The replay layout must not depend on the platform");
@@ -0,0 +1,199 @@
+#include "CubeProject.h"
+#include "CubeSimBatch.h"
+#include "CubeStrictFloat.h"
+
+// Every x86 platform the game ships on has SSE2. The other platforms loop over the scalar rules.
+#if PLATFORM_ENABLE_VECTORINTRINSICS && !PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+    #define CUBE_SIM_BATCH_SSE 1
+    #include <emmintrin.h>
+#else
+    #define CUBE_SIM_BATCH_SSE 0
+#endif
+
+#if CUBE_SIM_BATCH_SSE
+namespace
+{
+    /** Returns A where the mask is set, and B elsewhere. */
+    FORCEINLINE __m128 Select(__m128 Mask, __m128 A, __m128 B)
+    {
+        return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B));
+    }
+
+    /** Returns X1 * X2 + Y1 * Y2, rounded after each operation like the scalar rules. */
+    FORCEINLINE __m128 Dot(__m128 X1, __m128 Y1, __m128 X2, __m128 Y2)
+    {
+        return _mm_add_ps(_mm_mul_ps(X1, X2), _mm_mul_ps(Y1, Y2));
+    }
+
+    /** CubeSim::SafeNormal() of four vectors. */
+    FORCEINLINE void SafeNormal(__m128 X, __m128 Y, __m128& OutX, __m128& OutY)
+    {
+        const __m128 SizeSquared = Dot(X, Y, X, Y);
+        const __m128 Scale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(SizeSquared));
+        const __m128 bNormalized = _mm_cmpge_ps(SizeSquared, _mm_set1_ps(CubeSim::SAFE_NORMAL_TOLERANCE_SQUARED));
+
+        OutX = _mm_and_ps(bNormalized, _mm_mul_ps(X, Scale));
+        OutY = _mm_and_ps(bNormalized, _mm_mul_ps(Y, Scale));
+    }
+
+    /** CubeSim::ClampSize() of four vectors. */
+    FORCEINLINE void ClampSize(__m128 X, __m128 Y, __m128 MinSize, __m128 MaxSize, __m128& OutX, __m128& OutY)
+    {
+        const __m128 Size = _mm_sqrt_ps(Dot(X, Y, X, Y));
+        const __m128 ClampedSize = _mm_min_ps(_mm_max_ps(Size, MinSize), MaxSize);
+        const __m128 Scale = _mm_div_ps(ClampedSize, Size);
+        const __m128 bUnclamped = _mm_cmpeq_ps(ClampedSize, Size);
+        const __m128 bLongEnough = _mm_cmpge_ps(Size, _mm_set1_ps(SMALL_NUMBER));
+
+        OutX = _mm_and_ps(bLongEnough, Select(bUnclamped, X, _mm_mul_ps(X, Scale)));
+        OutY = _mm_and_ps(bLongEnough, Select(bUnclamped, Y, _mm_mul_ps(Y, Scale)));
+    }
+}
+#endif
+
+bool CubeSimBatch::IsVectorized()
+{
+    return CUBE_SIM_BATCH_SSE != 0;
+}
+
+void CubeSimBatch::BounceOffWalls(int32 Count, const float* DirectionX, const float* DirectionY, const float* NormalX, const float* NormalY,
+                                  const float* Speed, const FCubeBallRules& Rules, float* OutDirectionX, float* OutDirectionY, float* OutSpeed)
+{
+    int32 Index = 0;
+
+#if CUBE_SIM_BATCH_SSE
+    const __m128 MinSpeed = _mm_set1_ps(Rules.MinSpeed);
+    const __m128 MaxSpeed = _mm_set1_ps(Rules.MaxSpeed);
+    const __m128 Two = _mm_set1_ps(2.0f);
+
+    for(; Index + WIDTH <= Count; Index += WIDTH)
+    {
+        const __m128 X = _mm_loadu_ps(DirectionX + Index);
+        const __m128 Y = _mm_loadu_ps(DirectionY + Index);
+        __m128 NX, NY;
+        SafeNormal(_mm_loadu_ps(NormalX + Index), _mm_loadu_ps(NormalY + Index), NX, NY);
+
+        // Mirror the direction by the normal: D - 2 (D.N) N
+        const __m128 TwiceDot = _mm_mul_ps(Dot(X, Y, NX, NY), Two);
+        const __m128 BouncedX = _mm_sub_ps(X, _mm_mul_ps(NX, TwiceDot));
+        const __m128 BouncedY = _mm_sub_ps(Y, _mm_mul_ps(NY, TwiceDot));
+
+        const __m128 BallSpeed = _mm_loadu_ps(Speed + Index);
+        __m128 VelocityX, VelocityY;
+        ClampSize(_mm_mul_ps(BouncedX, BallSpeed), _mm_mul_ps(BouncedY, BallSpeed), MinSpeed, MaxSpeed, VelocityX, VelocityY);
+
+        _mm_storeu_ps(OutDirectionX + Index, BouncedX);
+        _mm_storeu_ps(OutDirectionY + Index, BouncedY);
+        _mm_storeu_ps(OutSpeed + Index, _mm_sqrt_ps(Dot(VelocityX, VelocityY, VelocityX, VelocityY)));
+    }
+#endif
+
+    for(; Index < Count; Index++)
+    {
+        const FVector2D Normal = CubeSim::SafeNormal(FVector2D(NormalX[Index], NormalY[Index]));
+        const FVector2D Direction = CubeSim::BounceOffWall(FVector2D(DirectionX[Index], DirectionY[Index]), Normal);
+
+        OutDirectionX[Index] = Direction.X;
+        OutDirectionY[Index] = Direction.Y;
+        OutSpeed[Index] = CubeSim::Size(CubeSim::GetBallVelocity(Direction, Speed[Index], Rules));
+    }
+}
+
+void CubeSimBatch::BounceOffPlayers(int32 Count, const float* BallX, const float* BallY, const float* PlayerX, const float* PlayerY,
+                                    const float* PlayerVelocityX, const float* PlayerVelocityY, const FCubeBallRules& Rules,
+                                    float* OutDirectionX, float* OutDirectionY)
+{
+    int32 Index = 0;
+
+#if CUBE_SIM_BATCH_SSE
+    const __m128 CosAngleToIgnore = _mm_set1_ps(Rules.CosAngleToIgnorePlayerVelocity);
+    const __m128 BounceFactor = _mm_set1_ps(Rules.PlayerSpeedBounceFactor);
+
+    for(; Index + WIDTH <= Count; Index += WIDTH)
+    {
+        const __m128 VelocityX = _mm_loadu_ps(PlayerVelocityX + Index);
+        const __m128 VelocityY = _mm_loadu_ps(PlayerVelocityY + Index);
+
+        // The ball bounces away from the player's center, and follows the player's velocity unless the player moves against the bounce
+        __m128 BounceX, BounceY;
+        __m128 PlayerDirectionX, PlayerDirectionY;
+        SafeNormal(_mm_sub_ps(_mm_loadu_ps(BallX + Index), _mm_loadu_ps(PlayerX + Index)),
+                   _mm_sub_ps(_mm_loadu_ps(BallY + Index), _mm_loadu_ps(PlayerY + Index)), BounceX, BounceY);
+        SafeNormal(VelocityX, VelocityY, PlayerDirectionX, PlayerDirectionY);
+
+        const __m128 bIgnoreVelocity = _mm_cmplt_ps(Dot(BounceX, BounceY, PlayerDirectionX, PlayerDirectionY), CosAngleToIgnore);
+        const __m128 FollowX = _mm_add_ps(BounceX, _mm_mul_ps(VelocityX, BounceFactor));
+        const __m128 FollowY = _mm_add_ps(BounceY, _mm_mul_ps(VelocityY, BounceFactor));
+
+        _mm_storeu_ps(OutDirectionX + Index, Select(bIgnoreVelocity, BounceX, FollowX));
+        _mm_storeu_ps(OutDirectionY + Index, Select(bIgnoreVelocity, BounceY, FollowY));
+    }
+#endif
+
+    for(; Index < Count; Index++)
+    {
+        const FVector2D Direction = CubeSim::BounceOffPlayer(FVector2D(BallX[Index], BallY[Index]), FVector2D(PlayerX[Index], PlayerY[Index]),
+                                                             FVector2D(PlayerVelocityX[Index], PlayerVelocityY[Index]), Rules);
+
+        OutDirectionX[Index] = Direction.X;
+        OutDirectionY[Index] = Direction.Y;
+    }
+}
+
+void CubeSimBatch::GetBallVelocities(int32 Count, const float* DirectionX, const float* DirectionY, const float* Speed, const FCubeBallRules& Rules,
+                                     float* OutVelocityX, float* OutVelocityY)
+{
+    int32 Index = 0;
+
+#if CUBE_SIM_BATCH_SSE
+    const __m128 MinSpeed = _mm_set1_ps(Rules.MinSpeed);
+    const __m128 MaxSpeed = _mm_set1_ps(Rules.MaxSpeed);
+
+    for(; Index + WIDTH <= Count; Index += WIDTH)
+    {
+        const __m128 BallSpeed = _mm_loadu_ps(Speed + Index);
+        __m128 VelocityX, VelocityY;
+        ClampSize(_mm_mul_ps(_mm_loadu_ps(DirectionX + Index), BallSpeed), _mm_mul_ps(_mm_loadu_ps(DirectionY + Index), BallSpeed), MinSpeed, MaxSpeed,
+                  VelocityX, VelocityY);
+
+        _mm_storeu_ps(OutVelocityX + Index, VelocityX);
+        _mm_storeu_ps(OutVelocityY + Index, VelocityY);
+    }
+#endif
+
+    for(; Index < Count; Index++)
+    {
+        const FVector2D Velocity = CubeSim::GetBallVelocity(FVector2D(DirectionX[Index], DirectionY[Index]), Speed[Index], Rules);
+
+        OutVelocityX[Index] = Velocity.X;
+        OutVelocityY[Index] = Velocity.Y;
+    }
+}
+
+void CubeSimBatch::AddSpinThrusts(int32 Count, const float* VelocityX, const float* VelocityY, const float* InputX, const FCubePawnRules& Rules,
+                                  float* OutVelocityX, float* OutVelocityY)
+{
+    int32 Index = 0;
+
+#if CUBE_SIM_BATCH_SSE
+    const __m128 ThrustForce = _mm_set1_ps(Rules.ThrustForce);
+    const __m128 Zero = _mm_setzero_ps();
+
+    for(; Index + WIDTH <= Count; Index += WIDTH)
+    {
+        __m128 ThrustDirectionX, ThrustDirectionY;
+        SafeNormal(_mm_loadu_ps(InputX + Index), Zero, ThrustDirectionX, ThrustDirectionY);
+
+        _mm_storeu_ps(OutVelocityX + Index, _mm_add_ps(_mm_loadu_ps(VelocityX + Index), _mm_mul_ps(ThrustDirectionX, ThrustForce)));
+        _mm_storeu_ps(OutVelocityY + Index, _mm_add_ps(_mm_loadu_ps(VelocityY + Index), _mm_mul_ps(ThrustDirectionY, ThrustForce)));
+    }
+#endif
+
+    for(; Index < Count; Index++)
+    {
+        const FVector2D Velocity = CubeSim::AddSpinThrust(FVector2D(VelocityX[Index], VelocityY[Index]), FVector2D(InputX[Index], 0.0f), Rules);
+
+        OutVelocityX[Index] = Velocity.X;
+        OutVelocityY[Index] = Velocity.Y;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CubeSimRules.h"
+
+/**
+ * The per-contact rules of CubeSimRules.h applied to many contacts at once, for tools which resolve many contacts per
+ * tick (e.g., matches hosted side by side). Each vector is passed as two arrays, one per component. The kernels process
+ * WIDTH contacts at a time with SSE, and the remaining ones with the scalar rules.
+ *
+ * The kernels use the same operations in the same order as the scalar rules, with correctly rounded division and square
+ * root, so every result is bit-identical to the scalar one: they can be mixed with the match simulation without breaking
+ * its determinism. Like the scalar rules, the player bounce compares cosines rather than taking acos() of the angle.
+ */
+namespace CubeSimBatch
+{
+    /** The number of contacts processed at once. */
+    static constexpr int32 WIDTH = 4;
+
+    /** Returns true if the kernels are vectorized on this platform. Otherwise, they loop over the scalar rules. */
+    CUBEPROJECT_API bool IsVectorized();
+
+    /** Bounces balls off walls with BounceOffWall(), the walls' normals being normalized first as in ABall::NotifyHit(), and
+      * returns the speed at which each ball then moves, once clamped (see ABall::GetBounceSpeed()). */
+    CUBEPROJECT_API void BounceOffWalls(int32 Count, const float* DirectionX, const float* DirectionY, const float* NormalX, const float* NormalY,
+                                        const float* Speed, const FCubeBallRules& Rules, float* OutDirectionX, float* OutDirectionY, float* OutSpeed);
+
+    /** Bounces balls off players with BounceOffPlayer(). */
+    CUBEPROJECT_API void BounceOffPlayers(int32 Count, const float* BallX, const float* BallY, const float* PlayerX, const float* PlayerY,
+                                          const float* PlayerVelocityX, const float* PlayerVelocityY, const FCubeBallRules& Rules,
+                                          float* OutDirectionX, float* OutDirectionY);
+
+    /** Returns the clamped velocity of balls with GetBallVelocity(). */
+    CUBEPROJECT_API void GetBallVelocities(int32 Count, const float* DirectionX, const float* DirectionY, const float* Speed, const FCubeBallRules& Rules,
+                                           float* OutVelocityX, float* OutVelocityY);
+
+    /** Spins pawns with AddSpinThrust(). The thrust is horizontal, so only the horizontal input is needed. */
+    CUBEPROJECT_API void AddSpinThrusts(int32 Count, const float* VelocityX, const float* VelocityY, const float* InputX, const FCubePawnRules& Rules,
+                                        float* OutVelocityX, float* OutVelocityY);
+}
@@ -0,0 +1,150 @@
+#include "CubeProject.h"
+#include "CubeSimRules.h"
+#include "CubeBallPhysics.h"
+#include "CubeStrictFloat.h"
+
+float CubeSim::Size(const FVector2D& Vector)
+{
+    return CubeBallPhysics::Size(Vector);
+}
+
+FVector2D CubeSim::SafeNormal(const FVector2D& Vector)
+{
+    return CubeBallPhysics::SafeNormal(Vector);
+}
+
+FVector2D CubeSim::ClampSize(const FVector2D& Vector, float MinSize, float MaxSize)
+{
+    return CubeBallPhysics::ClampSize(Vector, MinSize, MaxSize);
+}
+
+FVector2D CubeSim::Integrate(const FVector2D& Location, const FVector2D& Velocity, float DeltaTime)
+{
+    return FVector2D(Location.X + Velocity.X * DeltaTime, Location.Y + Velocity.Y * DeltaTime);
+}
+
+FVector2D CubeSim::SlideAlongSurface(const FVector2D& Delta, const FVector2D& Normal, float RemainingFraction)
+{
+    // Remove the part of the remaining move going into the surface
+    const FVector2D Remaining(Delta.X * RemainingFraction, Delta.Y * RemainingFraction);
+    const float Dot = Remaining.X * Normal.X + Remaining.Y * Normal.Y;
+
+    return FVector2D(Remaining.X - Normal.X * Dot, Remaining.Y - Normal.Y * Dot);
+}
+
+int8 CubeSim::QuantizeAxis(float Value)
+{
+    return (int8)FMath::Clamp(FMath::RoundToInt(Value * 127.0f), -127, 127);
+}
+
+FVector2D CubeSim::GetInputMove(int8 StepsX, int8 StepsY)
+{
+    return ClampSize(FVector2D(StepsX / 127.0f, StepsY / 127.0f), 0.0f, 1.0f);
+}
+
+FVector2D CubeSim::QuantizeInput(float MoveX, float MoveY)
+{
+    return GetInputMove(QuantizeAxis(MoveX), QuantizeAxis(MoveY));
+}
+
+FVector2D CubeSim::GetKickoffDirection(FCubeRandomStream& Stream, bool bMoveRight)
+{
+    // The horizontal direction is always drawn before the vertical one, so that the stream is consumed in the same order
+    const float DirectionX = bMoveRight ? Stream.GetRange(0.0f, 1.0f) : Stream.GetRange(-1.0f, 0.0f);
+    const float DirectionY = Stream.GetRange(-0.5f, 0.5f);
+
+    return SafeNormal(FVector2D(DirectionX, DirectionY));
+}
+
+FVector2D CubeSim::GetBallVelocity(const FVector2D& Direction, float Speed, const FCubeBallRules& Rules)
+{
+    return CubeBallPhysics::GetBallVelocity(Direction, Speed, Rules);
+}
+
+FVector2D CubeSim::BounceOffWall(const FVector2D& Direction, const FVector2D& Normal)
+{
+    // Mirror the direction by the normal: D - 2 (D.N) N
+    const float Dot = Direction.X * Normal.X + Direction.Y * Normal.Y;
+    const float TwiceDot = Dot * 2.0f;
+
+    return FVector2D(Direction.X - Normal.X * TwiceDot, Direction.Y - Normal.Y * TwiceDot);
+}
+
+FVector2D CubeSim::BounceOffPlayer(const FVector2D& BallLocation, const FVector2D& PlayerLocation, const FVector2D& PlayerVelocity,
+                                   const FCubeBallRules& Rules)
+{
+    return CubeBallPhysics::BounceOffPlayer(BallLocation, PlayerLocation, PlayerVelocity, Rules);
+}
+
+FVector2D CubeSim::AddPlayerVelocity(const FVector2D& Direction, const FVector2D& PlayerVelocity, const FCubeBallRules& Rules)
+{
+    return CubeBallPhysics::AddPlayerVelocity(Direction, PlayerVelocity, Rules);
+}
+
+FVector2D CubeSim::UpdatePawnVelocity(const FVector2D& InVelocity, const FVector2D& Input, const FCubePawnRules& Rules, float DeltaTime)
+{
+    FVector2D Velocity = InVelocity;
+
+    const FVector2D ControlAcceleration = ClampSize(Input, 0.0f, 1.0f);
+    const float AnalogInputModifier = Size(ControlAcceleration);
+    const float MaxPawnSpeed = Rules.MaxSpeed * AnalogInputModifier;
+    const float SpeedSquared = Velocity.X * Velocity.X + Velocity.Y * Velocity.Y;
+    const bool bExceedingMaxSpeed = SpeedSquared > MaxPawnSpeed * MaxPawnSpeed * 1.01f;
+
+    if(AnalogInputModifier > 0.0f && !bExceedingMaxSpeed)
+    {
+        // Turn the velocity towards the input direction
+        if(SpeedSquared > 0.0f)
+        {
+            const float TimeScale = FMath::Clamp(DeltaTime * Rules.TurningBoost, 0.0f, 1.0f);
+            const float Speed = Size(Velocity);
+            const FVector2D Turn(ControlAcceleration.X * Speed - Velocity.X, ControlAcceleration.Y * Speed - Velocity.Y);
+
+            Velocity = FVector2D(Velocity.X + Turn.X * TimeScale, Velocity.Y + Turn.Y * TimeScale);
+        }
+    }
+    else if(SpeedSquared > 0.0f)
+    {
+        // Slow down, without braking below the maximum speed if the pawn started above it
+        const FVector2D OldDirection = SafeNormal(Velocity);
+        float NewSpeed = FMath::Max(Size(Velocity) - FMath::Abs(Rules.Deceleration) * DeltaTime, 0.0f);
+
+        if(bExceedingMaxSpeed && NewSpeed < MaxPawnSpeed)
+        {
+            NewSpeed = MaxPawnSpeed;
+        }
+
+        Velocity = FVector2D(OldDirection.X * NewSpeed, OldDirection.Y * NewSpeed);
+    }
+
+    // Accelerate in the input direction and clamp the speed
+    const float NewSpeedSquared = Velocity.X * Velocity.X + Velocity.Y * Velocity.Y;
+    const float NewMaxSpeed = (NewSpeedSquared > MaxPawnSpeed * MaxPawnSpeed * 1.01f) ? Size(Velocity) : MaxPawnSpeed;
+    const float AccelerationStep = FMath::Abs(Rules.Acceleration) * DeltaTime;
+
+    Velocity = FVector2D(Velocity.X + ControlAcceleration.X * AccelerationStep, Velocity.Y + ControlAcceleration.Y * AccelerationStep);
+    return ClampSize(Velocity, 0.0f, NewMaxSpeed);
+}
+
+FVector2D CubeSim::AddSpinThrust(const FVector2D& Velocity, const FVector2D& Input, const FCubePawnRules& Rules)
+{
+    // Like ACubePawn::AddThrust(), the input is normalized in the world's XY plane, so the thrust is always horizontal
+    const FVector2D ThrustDirection = SafeNormal(FVector2D(Input.X, 0.0f));
+
+    return FVector2D(Velocity.X + ThrustDirection.X * Rules.ThrustForce, Velocity.Y + ThrustDirection.Y * Rules.ThrustForce);
+}
+
+ECubeBallProfile::Type CubeBallPhysics::FindProfile(const FCubeBallRules& Rules)
+{
+    // Compare the bits: a profile only replaces the rules if it computes exactly the same results
+    const FCubeBallRules DefaultRules = MakeRules<FCubeDefaultBallProfile>();
+    const FCubeBallRules LargeRules = MakeRules<FCubeLargeBallProfile>();
+
+    if(FMemory::Memcmp(&Rules, &DefaultRules, sizeof(Rules)) == 0)
+        return ECubeBallProfile::Default;
+
+    if(FMemory::Memcmp(&Rules, &LargeRules, sizeof(Rules)) == 0)
+        return ECubeBallProfile::Large;
+
+    return ECubeBallProfile::Count;
+}
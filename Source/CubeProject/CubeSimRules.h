@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CubeDeterminism.h"
+
+/** The tuning of the ball, copied from ABall. The balls the game ships also exist as compile-time profiles (see
+  * CubeBallPhysics.h). */
+struct FCubeBallRules
+{
+    /** The ball's speed at kickoff and after bouncing off a player. */
+    float DefaultSpeed = 300.0f;
+    /** The bounds of the ball's speed. */
+    float MinSpeed = 300.0f;
+    float MaxSpeed = 600.0f;
+    /** How much of a player's velocity is transferred to the ball when the player hits it. */
+    float PlayerSpeedBounceFactor = 0.001f;
+    /** The cosine of the angle between the bounce direction and the player's velocity above which the player's velocity is
+      * ignored. Comparing cosines avoids acos(), whose result differs between platforms. Defaults to cos(100 degrees). */
+    float CosAngleToIgnorePlayerVelocity = -0.173648178f;
+};
+
+/** The tuning of a pawn's movement, copied from its UFloatingPawnMovement. */
+struct FCubePawnRules
+{
+    float MaxSpeed = 1200.0f;
+    float Acceleration = 4000.0f;
+    float Deceleration = 8000.0f;
+    float TurningBoost = 8.0f;
+    /** The speed added in the input direction when the pawn spins. */
+    float ThrustForce = 1000.0f;
+};
+
+/**
+ * The gameplay rules of the ball and pawns, written with strict floating-point math so that they give bit-identical
+ * results on every machine (see CubeStrictFloat.h). Used by the actors in the determinism mode, and by every system which
+ * simulates matches without the engine. Vectors are in the game's plane: X holds the world's Y and Y the world's Z. The
+ * ball rules are implemented by the templates of CubeBallPhysics.h, which can also be specialized for a ball profile.
+ */
+namespace CubeSim
+{
+    /** Vectors whose squared length is below this are not normalized. Matches FVector::GetSafeNormal(). */
+    static constexpr float SAFE_NORMAL_TOLERANCE_SQUARED = 1.e-8f;
+
+    /** Converts a world vector to the game's plane, and back. */
+    FORCEINLINE FVector2D ToPlane(const FVector& Vector) { return FVector2D(Vector.Y, Vector.Z); }
+    FORCEINLINE FVector ToWorld(const FVector2D& Vector, float WorldX = 0.0f) { return FVector(WorldX, Vector.X, Vector.Y); }
+
+    /** Returns the length of a vector. */
+    CUBEPROJECT_API float Size(const FVector2D& Vector);
+
+    /** Returns the vector scaled to unit length, or zero if it is too small to be normalized. */
+    CUBEPROJECT_API FVector2D SafeNormal(const FVector2D& Vector);
+
+    /** Returns the vector with its length clamped to the given range. A zero vector stays zero. */
+    CUBEPROJECT_API FVector2D ClampSize(const FVector2D& Vector, float MinSize, float MaxSize);
+
+    /** Returns the location reached after moving at the given velocity for the given time. */
+    CUBEPROJECT_API FVector2D Integrate(const FVector2D& Location, const FVector2D& Velocity, float DeltaTime);
+
+    /** Returns the part of a blocked move which slides along the surface with the given normal. */
+    CUBEPROJECT_API FVector2D SlideAlongSurface(const FVector2D& Delta, const FVector2D& Normal, float RemainingFraction);
+
+    /** Quantizes a movement axis to steps of 1/127, between -127 and 127. Inputs are recorded, saved and replayed in
+      * these steps, one byte per axis. */
+    CUBEPROJECT_API int8 QuantizeAxis(float Value);
+
+    /** Returns the movement input of the given steps, with its length clamped to 1. The input is quantized once, to the
+      * steps: the actors and the match simulation both turn the steps into a movement with this function. */
+    CUBEPROJECT_API FVector2D GetInputMove(int8 StepsX, int8 StepsY);
+
+    /** Quantizes a movement input to the steps of QuantizeAxis() and returns the resulting movement (see GetInputMove()). */
+    CUBEPROJECT_API FVector2D QuantizeInput(float MoveX, float MoveY);
+
+    /** Draws the direction of the ball at kickoff, towards the right or left of the field. */
+    CUBEPROJECT_API FVector2D GetKickoffDirection(FCubeRandomStream& Stream, bool bMoveRight);
+
+    /** Returns the ball's velocity for the given direction and speed, clamped to the ball's speed range. */
+    CUBEPROJECT_API FVector2D GetBallVelocity(const FVector2D& Direction, float Speed, const FCubeBallRules& Rules);
+
+    /** Returns the ball's direction after bouncing off a surface with the given normal. */
+    CUBEPROJECT_API FVector2D BounceOffWall(const FVector2D& Direction, const FVector2D& Normal);
+
+    /** Returns the ball's direction after bouncing off a player. The ball bounces away from the player's center and follows
+      * the player's velocity, unless the player moves against the bounce. */
+    CUBEPROJECT_API FVector2D BounceOffPlayer(const FVector2D& BallLocation, const FVector2D& PlayerLocation, const FVector2D& PlayerVelocity,
+                                              const FCubeBallRules& Rules);
+
+    /** Returns the ball's direction once the given player's velocity is added to it. */
+    CUBEPROJECT_API FVector2D AddPlayerVelocity(const FVector2D& Direction, const FVector2D& PlayerVelocity, const FCubeBallRules& Rules);
+
+    /** Returns a pawn's velocity after one step of input. Matches UFloatingPawnMovement::ApplyControlInputToVelocity(). */
+    CUBEPROJECT_API FVector2D UpdatePawnVelocity(const FVector2D& Velocity, const FVector2D& Input, const FCubePawnRules& Rules, float DeltaTime);
+
+    /** Returns a pawn's velocity after it spins, pushed horizontally in the direction of its input. */
+    CUBEPROJECT_API FVector2D AddSpinThrust(const FVector2D& Velocity, const FVector2D& Input, const FCubePawnRules& Rules);
+}
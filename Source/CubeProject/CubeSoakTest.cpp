@@ -0,0 +1,322 @@
+#include "CubeProject.h"
+#include "CubeSoakTest.h"
+#include "CubeProjectGameMode.h"
+#include "CubeProjectGameState.h"
+#include "CubeBot.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Components/AudioComponent.h"
+
+FCubeSoakTest* FCubeSoakTest::Instance = NULL;
+
+/** The growth over the soak allowed for each metric: a relative tolerance on its first value after the warm-up, and an
+  * absolute slack. The slack absorbs the allocator's and the engine's caches, which settle within a few megabytes. */
+static const float TREND_TOLERANCES[ECubeSoakMetric::Count] = { 0.05f, 0.01f, 0.0f, 0.0f, 0.0f, 0.0f };
+static const float TREND_SLACK[ECubeSoakMetric::Count] = { 32.0f, 50.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+
+void FCubeSoakTest::Start()
+{
+    if(!Instance)
+    {
+        Instance = new FCubeSoakTest();
+    }
+}
+
+void FCubeSoakTest::Stop()
+{
+    delete Instance;
+    Instance = NULL;
+}
+
+FCubeSoakTest::FCubeSoakTest()
+    : MapIndex(0)
+    , bLoadingMap(false)
+    , MaxMatches(0)
+    , MaxSeconds(0.0)
+    , SampleInterval(10)
+    , ReloadInterval(50)
+    , StartTime(FPlatformTime::Seconds())
+    , MatchTime(0.0f)
+    , NumMatches(0)
+    , NumStuckMatches(0)
+    , NextArenaSeed(1)
+{
+    GConfig->GetArray(TEXT("CubeSoakTest"), TEXT("Maps"), Maps, GGameIni);
+
+    float Hours = 0.0f;
+    FParse::Value(FCommandLine::Get(), TEXT("SoakHours="), Hours);
+    FParse::Value(FCommandLine::Get(), TEXT("SoakMatches="), MaxMatches);
+    FParse::Value(FCommandLine::Get(), TEXT("SoakSampleEvery="), SampleInterval);
+    FParse::Value(FCommandLine::Get(), TEXT("SoakReloadEvery="), ReloadInterval);
+    FParse::Value(FCommandLine::Get(), TEXT("ArenaSeed="), NextArenaSeed);
+
+    MaxSeconds = Hours * 3600.0;
+    SampleInterval = FMath::Max(SampleInterval, 1);
+
+    // Play for an hour unless told otherwise
+    if(MaxMatches <= 0 && MaxSeconds <= 0.0)
+    {
+        MaxSeconds = 3600.0;
+    }
+
+    // Simulate every frame with the same step, without waiting for the real time to catch up
+    FApp::SetUseFixedTimeStep(true);
+    FApp::SetFixedDeltaTime(FIXED_DELTA_TIME);
+
+    UE_LOG(LogCubeProject, Display, TEXT("Soak: playing for %.1f hours or %d matches, sampling every %d matches and reloading every %d"),
+           MaxSeconds / 3600.0, MaxMatches, SampleInterval, ReloadInterval);
+}
+
+void FCubeSoakTest::OnGameModeBeginPlay(ACubeProjectGameMode* InGameMode)
+{
+    GameMode = InGameMode;
+    bLoadingMap = false;
+    MatchTime = 0.0f;
+
+    for(int32 Slot = 0; Slot < InGameMode->GetPlayerRegistry().Num(); Slot++)
+    {
+        InGameMode->SetBot(Slot, MakeShareable(new FCubeScriptedBot()));
+    }
+}
+
+bool FCubeSoakTest::Tick(float DeltaTime)
+{
+    ACubeProjectGameMode* CurrentGameMode = GameMode.Get();
+
+    // Wait for a level to be loaded
+    if(!CurrentGameMode || bLoadingMap)
+        return true;
+
+    ACubeProjectGameState* GameState = CurrentGameMode->GetGameState<ACubeProjectGameState>();
+
+    if(!GameState)
+        return true;
+
+    switch(GameState->GetState())
+    {
+        case EGameState::GAME_BOOT:
+        {
+            break;
+        }
+        case EGameState::MAIN_MENU:
+        {
+            // Start the match as if the user pressed the start key in the main menu
+            MatchTime = 0.0f;
+            CurrentGameMode->StartGame();
+            break;
+        }
+        case EGameState::WAITING_TO_RESTART:
+        {
+            OnMatchEnded(CurrentGameMode, true);
+            break;
+        }
+        default:
+        {
+            MatchTime += DeltaTime;
+
+            if(MatchTime > MATCH_TIMEOUT)
+            {
+                UE_LOG(LogCubeProject, Warning, TEXT("Soak: match %d did not end within %.0f seconds"), NumMatches + 1, MATCH_TIMEOUT);
+                OnMatchEnded(CurrentGameMode, false);
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+void FCubeSoakTest::OnMatchEnded(ACubeProjectGameMode* CurrentGameMode, bool bCompleted)
+{
+    NumMatches++;
+    NumStuckMatches += bCompleted ? 0 : 1;
+    MatchTime = 0.0f;
+
+    if(NumMatches % SampleInterval == 0)
+    {
+        TakeSample(CurrentGameMode);
+    }
+
+    const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+    if((MaxMatches > 0 && NumMatches >= MaxMatches) || (MaxSeconds > 0.0 && Seconds >= MaxSeconds))
+    {
+        Finish();
+        return;
+    }
+
+    if(ReloadInterval > 0 && NumMatches % ReloadInterval == 0)
+    {
+        // Reload the level, or load the next one, so that the previous world is torn down. A generated arena gets a new seed.
+        const FString MapName = (Maps.Num() > 0) ? Maps[MapIndex++ % Maps.Num()] : UWorld::RemovePIEPrefix(CurrentGameMode->GetWorld()->GetMapName());
+        const FString Options = FString::Printf(TEXT("ArenaSeed=%llu"), NextArenaSeed++);
+
+        UE_LOG(LogCubeProject, Display, TEXT("Soak: loading %s?%s after %d matches"), *MapName, *Options, NumMatches);
+        UGameplayStatics::OpenLevel(CurrentGameMode, FName(*MapName), true, Options);
+        bLoadingMap = true;
+        return;
+    }
+
+    CurrentGameMode->RestartGame();
+}
+
+void FCubeSoakTest::TakeSample(ACubeProjectGameMode* CurrentGameMode)
+{
+    // Only count what is still referenced
+    CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+    FCubeSoakSample Sample;
+    Sample.NumMatches = NumMatches;
+    Sample.Seconds = FPlatformTime::Seconds() - StartTime;
+
+    int32 ObjectCount = 0;
+
+    for(TObjectIterator<UObject> ObjectIterator; ObjectIterator; ++ObjectIterator)
+    {
+        ObjectCount++;
+    }
+
+    int32 ActiveParticleComponents = 0;
+
+    for(TObjectIterator<UParticleSystemComponent> ComponentIterator; ComponentIterator; ++ComponentIterator)
+    {
+        ActiveParticleComponents += ComponentIterator->IsActive() ? 1 : 0;
+    }
+
+    int32 ActiveAudioComponents = 0;
+
+    for(TObjectIterator<UAudioComponent> ComponentIterator; ComponentIterator; ++ComponentIterator)
+    {
+        ActiveAudioComponents += ComponentIterator->IsActive() ? 1 : 0;
+    }
+
+    ACubeProjectGameState* GameState = CurrentGameMode->GetGameState<ACubeProjectGameState>();
+
+    Sample.Values[ECubeSoakMetric::ResidentMB] = FPlatformMemory::GetStats().UsedPhysical / (1024.0f * 1024.0f);
+    Sample.Values[ECubeSoakMetric::ObjectCount] = (float)ObjectCount;
+    Sample.Values[ECubeSoakMetric::ActorCount] = (float)CurrentGameMode->GetWorld()->GetActorCount();
+    Sample.Values[ECubeSoakMetric::ActiveParticleComponents] = (float)ActiveParticleComponents;
+    Sample.Values[ECubeSoakMetric::ActiveAudioComponents] = (float)ActiveAudioComponents;
+    Sample.Values[ECubeSoakMetric::GameplayTimers] = GameState ? (float)GameState->GetTimerWheel().Num() : 0.0f;
+
+    Samples.Add(Sample);
+
+    UE_LOG(LogCubeProject, Display, TEXT("Soak: %d matches in %.0f s: %.1f MB, %d objects, %d actors, %d particle and %d audio components active, %.0f timers"),
+           NumMatches, Sample.Seconds, Sample.Values[ECubeSoakMetric::ResidentMB], ObjectCount, CurrentGameMode->GetWorld()->GetActorCount(),
+           ActiveParticleComponents, ActiveAudioComponents, Sample.Values[ECubeSoakMetric::GameplayTimers]);
+}
+
+float FCubeSoakTest::GetTrendGrowth(ECubeSoakMetric::Type Metric) const
+{
+    const int32 First = WARMUP_SAMPLES;
+    const int32 NumTrendSamples = Samples.Num() - First;
+
+    if(NumTrendSamples < 2)
+        return 0.0f;
+
+    // Least squares fit of the metric against the number of matches played
+    double MeanX = 0.0;
+    double MeanY = 0.0;
+
+    for(int32 Index = First; Index < Samples.Num(); Index++)
+    {
+        MeanX += Samples[Index].NumMatches;
+        MeanY += Samples[Index].Values[Metric];
+    }
+
+    MeanX /= NumTrendSamples;
+    MeanY /= NumTrendSamples;
+
+    double Covariance = 0.0;
+    double Variance = 0.0;
+
+    for(int32 Index = First; Index < Samples.Num(); Index++)
+    {
+        const double DeltaX = Samples[Index].NumMatches - MeanX;
+        Covariance += DeltaX * (Samples[Index].Values[Metric] - MeanY);
+        Variance += DeltaX * DeltaX;
+    }
+
+    if(Variance <= 0.0)
+        return 0.0f;
+
+    const double Slope = Covariance / Variance;
+    return (float)(Slope * (Samples.Last().NumMatches - Samples[First].NumMatches));
+}
+
+void FCubeSoakTest::Finish()
+{
+    // Write a line per sample, which plots the trend of every metric
+    FString Csv = TEXT("Matches,Seconds");
+
+    for(int32 Metric = 0; Metric < ECubeSoakMetric::Count; Metric++)
+    {
+        Csv += FString::Printf(TEXT(",%s"), GetMetricName((ECubeSoakMetric::Type)Metric));
+    }
+
+    Csv += TEXT("\n");
+
+    for(const FCubeSoakSample& Sample : Samples)
+    {
+        Csv += FString::Printf(TEXT("%d,%.1f"), Sample.NumMatches, Sample.Seconds);
+
+        for(int32 Metric = 0; Metric < ECubeSoakMetric::Count; Metric++)
+        {
+            Csv += FString::Printf(TEXT(",%.3f"), Sample.Values[Metric]);
+        }
+
+        Csv += TEXT("\n");
+    }
+
+    const FString SamplesFileName = FPaths::GameSavedDir() / TEXT("Soak") / TEXT("Samples.csv");
+    FFileHelper::SaveStringToFile(Csv, *SamplesFileName);
+
+    int32 NumFailures = 0;
+
+    if(Samples.Num() - WARMUP_SAMPLES < MIN_TREND_SAMPLES)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Soak: %d samples are too few to judge the trends (%d needed). Play more matches or sample more often."),
+               Samples.Num(), WARMUP_SAMPLES + MIN_TREND_SAMPLES);
+        NumFailures++;
+    }
+    else
+    {
+        for(int32 Metric = 0; Metric < ECubeSoakMetric::Count; Metric++)
+        {
+            const float Growth = GetTrendGrowth((ECubeSoakMetric::Type)Metric);
+            const float Limit = FMath::Abs(Samples[WARMUP_SAMPLES].Values[Metric]) * TREND_TOLERANCES[Metric] + TREND_SLACK[Metric];
+
+            if(Growth > Limit)
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("Soak: %s grew by %.2f over %d matches (limit %.2f)"), GetMetricName((ECubeSoakMetric::Type)Metric),
+                       Growth, Samples.Last().NumMatches - Samples[WARMUP_SAMPLES].NumMatches, Limit);
+                NumFailures++;
+            }
+        }
+    }
+
+    if(NumStuckMatches > 0)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Soak: %d of %d matches did not end"), NumStuckMatches, NumMatches);
+        NumFailures++;
+    }
+
+    if(NumFailures > 0)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Soak: FAILED after %d matches. Samples written to %s"), NumMatches, *SamplesFileName);
+    }
+    else
+    {
+        UE_LOG(LogCubeProject, Display, TEXT("Soak: PASSED after %d matches. Samples written to %s"), NumMatches, *SamplesFileName);
+    }
+
+    GameMode = NULL;
+    CubeTestRun::RequestExit(NumFailures > 0);
+}
+
+const TCHAR* FCubeSoakTest::GetMetricName(ECubeSoakMetric::Type Metric)
+{
+    static const TCHAR* Names[ECubeSoakMetric::Count] = { TEXT("ResidentMB"), TEXT("ObjectCount"), TEXT("ActorCount"), TEXT("ActiveParticleComponents"),
+                                                          TEXT("ActiveAudioComponents"), TEXT("GameplayTimers") };
+
+    return Names[Metric];
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Ticker.h"
+
+class ACubeProjectGameMode;
+
+/** The metrics sampled by FCubeSoakTest. None of them may keep growing over a soak. */
+namespace ECubeSoakMetric
+{
+    enum Type
+    {
+        /** The physical memory used by the process, in megabytes. */
+        ResidentMB,
+        /** The number of UObjects alive after a garbage collection. */
+        ObjectCount,
+        /** The number of actors in the level. */
+        ActorCount,
+        /** The particle system and audio components which are active, in every world. */
+        ActiveParticleComponents,
+        ActiveAudioComponents,
+        /** The timers scheduled in the game state's timer wheel. */
+        GameplayTimers,
+
+        Count
+    };
+}
+
+/** The metrics sampled after a number of matches. */
+struct FCubeSoakSample
+{
+    /** The number of matches played when the sample was taken. */
+    int32 NumMatches;
+    /** The time since the soak started, in seconds. */
+    double Seconds;
+    /** The value of each ECubeSoakMetric. */
+    float Values[ECubeSoakMetric::Count];
+};
+
+/**
+ * Long-running soak test. Enabled with -Soak, it lets scripted bots play matches back to back in every player slot, with
+ * a fixed time step so that frames are simulated as fast as the machine allows. Each finished match is restarted with
+ * ACubeProjectGameMode::RestartGame(), and every few matches the level is reloaded, which also generates a new arena if
+ * -GenerateArena is given. Every few matches, after a garbage collection, the memory, objects, actors, active effect
+ * components and gameplay timers are sampled and written to Saved/Soak/Samples.csv.
+ *
+ * Once the soak ends, a line is fitted to the samples of each metric, leaving out the first ones while caches and pools
+ * warm up. The soak fails if a metric grows over the run by more than its tolerance: a leak shows up as a steady trend
+ * long before a kiosk runs out of memory, whereas a single spike does not. Every failing metric is written to the log as
+ * an error, and a failed soak makes the game exit with a failing status.
+ *
+ * Typical usage, for an eight-hour soak on a build machine:
+ *   CubeProject -Soak -SoakHours=8 -nullrhi -unattended [-SoakMatches=<count>] [-SoakSampleEvery=<matches>]
+ *               [-SoakReloadEvery=<matches>] [-GenerateArena]
+ *
+ * The levels to cycle through are listed in the [CubeSoakTest] section of DefaultGame.ini; by default, the level the game
+ * boots into is reloaded.
+ */
+class CUBEPROJECT_API FCubeSoakTest : public FTickerObjectBase
+{
+public:
+    /** The fixed time step of the simulated frames, in seconds. */
+    static constexpr float FIXED_DELTA_TIME = 1.0f / 60.0f;
+    /** The number of first samples left out of the trends. */
+    static constexpr int32 WARMUP_SAMPLES = 2;
+    /** The number of samples needed after the warm-up to judge the trends. */
+    static constexpr int32 MIN_TREND_SAMPLES = 4;
+    /** A match which lasts longer than this many simulated seconds is restarted and counted as stuck. */
+    static constexpr float MATCH_TIMEOUT = 600.0f;
+
+    /** Creates the soak test. Called at startup when -Soak is on the command line. */
+    static void Start();
+    /** Destroys the soak test. */
+    static void Stop();
+    /** Returns the running soak test, or NULL if the game was not started with -Soak. */
+    static FCubeSoakTest* Get() { return Instance; }
+
+    /** Called by the game mode once every player has been created. Hands every slot to a bot. */
+    void OnGameModeBeginPlay(ACubeProjectGameMode* GameMode);
+
+    // FTickerObjectBase interface
+    virtual bool Tick(float DeltaTime) override;
+
+    /** Returns the name of a metric. */
+    static const TCHAR* GetMetricName(ECubeSoakMetric::Type Metric);
+
+private:
+    FCubeSoakTest();
+
+    /** Called when a match is over. Samples the metrics and reloads the level when due, and restarts the match otherwise. */
+    void OnMatchEnded(ACubeProjectGameMode* CurrentGameMode, bool bCompleted);
+
+    /** Collects garbage and records the metrics. */
+    void TakeSample(ACubeProjectGameMode* CurrentGameMode);
+
+    /** Returns the growth of a metric over the samples after the warm-up, read from the line fitted to them. */
+    float GetTrendGrowth(ECubeSoakMetric::Type Metric) const;
+
+    /** Writes the samples, judges the trends and exits the game. */
+    void Finish();
+
+    /** The levels to cycle through. Empty to reload the level the game booted into. */
+    TArray<FString> Maps;
+    /** The index of the next level to load. */
+    int32 MapIndex;
+
+    /** The game mode of the current level. */
+    TWeakObjectPtr<ACubeProjectGameMode> GameMode;
+    /** True while a level is being loaded. */
+    bool bLoadingMap;
+
+    /** The number of matches to play. Zero to play until the time limit. */
+    int32 MaxMatches;
+    /** How long the soak lasts, in seconds of real time. Zero to play until the match limit. */
+    double MaxSeconds;
+    /** The number of matches between samples, and between level reloads. */
+    int32 SampleInterval;
+    int32 ReloadInterval;
+
+    /** The time at which the soak started. */
+    double StartTime;
+    /** The simulated time spent in the current match. */
+    float MatchTime;
+    /** The number of matches played, and how many of them timed out. */
+    int32 NumMatches;
+    int32 NumStuckMatches;
+    /** The seed of the arena generated at the next reload. */
+    uint64 NextArenaSeed;
+
+    /** The samples taken so far. */
+    TArray<FCubeSoakSample> Samples;
+
+    /** The running soak test. */
+    static FCubeSoakTest* Instance;
+};
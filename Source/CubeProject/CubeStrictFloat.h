@@ -0,0 +1,15 @@
+#pragma once
+
+// Included by the translation units computing gameplay state which must be bit-identical on every machine, and by the
+// headers defining such code inline (CubeBallPhysics.h) before their first definition. The engine builds with fast
+// floating-point math on some compilers, which allows reordering operations and fusing multiplies and adds differently on
+// each platform. These pragmas restore IEEE semantics for the rest of the translation unit. Only +, -, *, / and sqrt are
+// used by that code: they are correctly rounded, unlike sin, cos or acos.
+#if defined(_MSC_VER) && !defined(__clang__)
+    #pragma float_control(precise, on)
+    #pragma fp_contract(off)
+#elif defined(__clang__)
+    #pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+    #pragma GCC optimize("fp-contract=off")
+#endif
@@ -0,0 +1,180 @@
+#include "CubeProject.h"
+#include "DesyncCheckCommandlet.h"
+#include "CubeDeterminism.h"
+
+namespace
+{
+    /** A desync trace loaded in memory. */
+    struct FDesyncTraceFile
+    {
+        uint64 Seed = 0;
+        /** The name of each field, including the index of its owner (e.g., "Pawn.Location.Y[1]"). */
+        TArray<FString> FieldNames;
+        /** The tick and hash of each record. */
+        TArray<uint32> Ticks;
+        TArray<uint64> Hashes;
+        /** The bits of every field of every record, one record after the other. */
+        TArray<uint32> FieldBits;
+    };
+
+    /** Loads a desync trace. Returns false if the file can't be read or is not a desync trace. */
+    bool LoadTrace(const FString& FileName, FDesyncTraceFile& OutTrace)
+    {
+        TArray<uint8> Data;
+
+        if(!FFileHelper::LoadFileToArray(Data, *FileName))
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("Could not read %s"), *FileName);
+            return false;
+        }
+
+        FMemoryReader Reader(Data);
+        uint32 Magic = 0;
+        uint32 Version = 0;
+        int32 NumFields = 0;
+
+        Reader << Magic;
+        Reader << Version;
+
+        if(Magic != FCubeDesyncTrace::MAGIC || Version != FCubeDesyncTrace::VERSION)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("%s is not a desync trace (or was written by another version)"), *FileName);
+            return false;
+        }
+
+        Reader << OutTrace.Seed;
+        Reader << NumFields;
+
+        for(int32 Field = 0; Field < NumFields && !Reader.IsError(); Field++)
+        {
+            FString Name;
+            int32 Index = INDEX_NONE;
+            Reader << Name;
+            Reader << Index;
+
+            OutTrace.FieldNames.Add(Index == INDEX_NONE ? Name : FString::Printf(TEXT("%s[%d]"), *Name, Index));
+        }
+
+        // Read the records until the end of the file. A trace cut short by a crash keeps its complete records.
+        const int64 RecordSize = sizeof(uint32) + sizeof(uint64) + NumFields * sizeof(uint32);
+
+        while(!Reader.IsError() && Reader.TotalSize() - Reader.Tell() >= RecordSize)
+        {
+            uint32 Tick = 0;
+            uint64 Hash = 0;
+            Reader << Tick;
+            Reader << Hash;
+
+            OutTrace.Ticks.Add(Tick);
+            OutTrace.Hashes.Add(Hash);
+
+            for(int32 Field = 0; Field < NumFields; Field++)
+            {
+                uint32 Bits = 0;
+                Reader << Bits;
+                OutTrace.FieldBits.Add(Bits);
+            }
+        }
+
+        return !Reader.IsError();
+    }
+
+    /** Formats the bits of a field both as an integer and as a float, since the trace doesn't store the field's type. */
+    FString FormatBits(uint32 Bits)
+    {
+        float Value;
+        FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+        return FString::Printf(TEXT("0x%08x (int %d, float %.9g)"), Bits, (int32)Bits, Value);
+    }
+}
+
+UDesyncCheckCommandlet::UDesyncCheckCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UDesyncCheckCommandlet::Main(const FString& Params)
+{
+    FString FileNameA;
+    FString FileNameB;
+    FParse::Value(*Params, TEXT("a="), FileNameA);
+    FParse::Value(*Params, TEXT("b="), FileNameB);
+
+    FDesyncTraceFile TraceA;
+    FDesyncTraceFile TraceB;
+
+    if(FileNameA.IsEmpty() || FileNameB.IsEmpty())
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=DesyncCheck -a=<trace> -b=<trace>"));
+        return 2;
+    }
+
+    if(!LoadTrace(FileNameA, TraceA) || !LoadTrace(FileNameB, TraceB))
+        return 2;
+
+    if(TraceA.Seed != TraceB.Seed)
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("The traces were recorded with different seeds (%llu and %llu)"), TraceA.Seed, TraceB.Seed);
+    }
+
+    if(TraceA.FieldNames != TraceB.FieldNames)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("The traces hash different fields (%d and %d). Were they recorded with the same number of players?"),
+               TraceA.FieldNames.Num(), TraceB.FieldNames.Num());
+        return 1;
+    }
+
+    const int32 NumFields = TraceA.FieldNames.Num();
+    const int32 NumRecords = FMath::Min(TraceA.Ticks.Num(), TraceB.Ticks.Num());
+
+    for(int32 Record = 0; Record < NumRecords; Record++)
+    {
+        if(TraceA.Ticks[Record] == TraceB.Ticks[Record] && TraceA.Hashes[Record] == TraceB.Hashes[Record])
+            continue;
+
+        UE_LOG(LogCubeProject, Error, TEXT("Desync at tick %u (record %d): hash %016llx != %016llx"), TraceA.Ticks[Record], Record,
+               TraceA.Hashes[Record], TraceB.Hashes[Record]);
+
+        if(TraceA.Ticks[Record] != TraceB.Ticks[Record])
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("  The traces skipped different ticks (%u and %u)"), TraceA.Ticks[Record], TraceB.Ticks[Record]);
+        }
+
+        // Report the first field which diverged, then the number of other fields which differ at this tick
+        int32 NumDifferentFields = 0;
+
+        for(int32 Field = 0; Field < NumFields; Field++)
+        {
+            const uint32 BitsA = TraceA.FieldBits[Record * NumFields + Field];
+            const uint32 BitsB = TraceB.FieldBits[Record * NumFields + Field];
+
+            if(BitsA == BitsB)
+                continue;
+
+            if(NumDifferentFields == 0)
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("  First divergent field: %s"), *TraceA.FieldNames[Field]);
+                UE_LOG(LogCubeProject, Error, TEXT("    a: %s"), *FormatBits(BitsA));
+                UE_LOG(LogCubeProject, Error, TEXT("    b: %s"), *FormatBits(BitsB));
+            }
+
+            NumDifferentFields++;
+        }
+
+        UE_LOG(LogCubeProject, Error, TEXT("  %d of %d fields differ at this tick"), NumDifferentFields, NumFields);
+        return 1;
+    }
+
+    if(TraceA.Ticks.Num() != TraceB.Ticks.Num())
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("The traces match for their first %d ticks, but one is longer (%d and %d ticks)"), NumRecords,
+               TraceA.Ticks.Num(), TraceB.Ticks.Num());
+        return 1;
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("The traces match: %d ticks, %d fields per tick"), NumRecords, NumFields);
+    return 0;
+}
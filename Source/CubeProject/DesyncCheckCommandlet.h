@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "DesyncCheckCommandlet.generated.h"
+
+/**
+ * Compares two desync traces written by the determinism mode (the .gsdt files in Saved/Determinism), e.g., the same match played on two
+ * machines, and reports the first simulation tick at which their gameplay state hashes differ, along with the first field
+ * which diverged.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=DesyncCheck -a=<trace> -b=<trace>
+ *
+ * Returns 0 if the traces match, 1 if they diverge and 2 if a trace can't be read.
+ */
+UCLASS()
+class UDesyncCheckCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UDesyncCheckCommandlet();
+
+    // Compares the traces
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,90 @@
+#include "CubeProject.h"
+#include "FrameTimeHistogram.h"
+
+FFrameTimeHistogram::FFrameTimeHistogram()
+{
+    Reset();
+}
+
+void FFrameTimeHistogram::Record(uint64 Microseconds)
+{
+    const uint64 Value = FMath::Min(Microseconds, (1ull << MAX_VALUE_BITS) - 1);
+
+    Counts[GetBucketIndex(Value)]++;
+    TotalCount++;
+    TotalValue += Value;
+    MaxValue = FMath::Max(MaxValue, Value);
+}
+
+void FFrameTimeHistogram::Reset()
+{
+    FMemory::Memzero(Counts, sizeof(Counts));
+    TotalCount = 0;
+    TotalValue = 0;
+    MaxValue = 0;
+}
+
+void FFrameTimeHistogram::Merge(const FFrameTimeHistogram& Other)
+{
+    for(int32 BucketIndex = 0; BucketIndex < BUCKET_COUNT; BucketIndex++)
+    {
+        Counts[BucketIndex] += Other.Counts[BucketIndex];
+    }
+
+    TotalCount += Other.TotalCount;
+    TotalValue += Other.TotalValue;
+    MaxValue = FMath::Max(MaxValue, Other.MaxValue);
+}
+
+float FFrameTimeHistogram::GetPercentileMilliseconds(float Percentile) const
+{
+    if(TotalCount == 0)
+        return 0.0f;
+
+    // The rank of the value we are looking for, counting from one
+    const double TargetRank = FMath::Clamp(Percentile, 0.0f, 100.0f) / 100.0 * TotalCount;
+    uint64 Rank = FMath::Max<uint64>(1, (uint64)TargetRank);
+
+    if(Rank < TargetRank)
+    {
+        Rank++;
+    }
+    uint64 CumulativeCount = 0;
+
+    for(int32 BucketIndex = 0; BucketIndex < BUCKET_COUNT; BucketIndex++)
+    {
+        CumulativeCount += Counts[BucketIndex];
+
+        if(CumulativeCount >= Rank)
+        {
+            // Never report more than the largest value actually recorded
+            return FMath::Min(GetBucketMidpoint(BucketIndex), MaxValue) / 1000.0f;
+        }
+    }
+
+    return GetMaxMilliseconds();
+}
+
+int32 FFrameTimeHistogram::GetBucketIndex(uint64 Value)
+{
+    // Small values have a bucket of their own
+    if(Value < SUB_BUCKET_COUNT)
+        return (int32)Value;
+
+    // Larger values are grouped by their highest bit, then by the next SUB_BUCKET_BITS - 1 bits
+    const int32 Shift = FPlatformMath::FloorLog2_64(Value) - (SUB_BUCKET_BITS - 1);
+    const int32 SubBucket = (int32)(Value >> Shift) - SUB_BUCKET_HALF_COUNT;
+
+    return SUB_BUCKET_COUNT + (Shift - 1) * SUB_BUCKET_HALF_COUNT + SubBucket;
+}
+
+uint64 FFrameTimeHistogram::GetBucketMidpoint(int32 BucketIndex)
+{
+    if(BucketIndex < SUB_BUCKET_COUNT)
+        return BucketIndex;
+
+    const int32 Shift = (BucketIndex - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF_COUNT + 1;
+    const uint64 SubBucket = (BucketIndex - SUB_BUCKET_COUNT) % SUB_BUCKET_HALF_COUNT + SUB_BUCKET_HALF_COUNT;
+
+    return (SubBucket << Shift) + ((1ull << Shift) >> 1);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * Histogram of durations in microseconds with a bounded relative error, in the style of HdrHistogram. Values below
+ * 128 us are counted exactly. Larger values fall in buckets which are at most 1/64 (1.6%) of their value wide. Recording
+ * a value is a few integer operations and never allocates, so it can be done every frame.
+ */
+class CUBEPROJECT_API FFrameTimeHistogram
+{
+public:
+    /** Each power of two above 128 us is split into 2^(SUB_BUCKET_BITS - 1) buckets. */
+    static constexpr int32 SUB_BUCKET_BITS = 7;
+    static constexpr int32 SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr int32 SUB_BUCKET_HALF_COUNT = SUB_BUCKET_COUNT / 2;
+    /** The largest value which can be recorded, about 4.6 hours. Larger values are clamped. */
+    static constexpr int32 MAX_VALUE_BITS = 34;
+    static constexpr int32 BUCKET_COUNT = SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_HALF_COUNT;
+
+    FFrameTimeHistogram();
+
+    /** Counts a duration, in microseconds. */
+    void Record(uint64 Microseconds);
+    /** Counts a duration, in milliseconds. */
+    FORCEINLINE void RecordMilliseconds(float Milliseconds) { Record((uint64)FMath::Max(Milliseconds * 1000.0f, 0.0f)); }
+
+    /** Removes every recorded value. */
+    void Reset();
+
+    /** Adds the values recorded in another histogram to this one. */
+    void Merge(const FFrameTimeHistogram& Other);
+
+    /** Returns the value, in milliseconds, below which the given percentage of the recorded values fall (e.g., 99.9). */
+    float GetPercentileMilliseconds(float Percentile) const;
+
+    /** Returns the largest recorded value, in milliseconds. */
+    FORCEINLINE float GetMaxMilliseconds() const { return MaxValue / 1000.0f; }
+    /** Returns the average of the recorded values, in milliseconds. */
+    FORCEINLINE float GetMeanMilliseconds() const { return TotalCount > 0 ? (float)(TotalValue / TotalCount) / 1000.0f : 0.0f; }
+    /** Returns the number of recorded values. */
+    FORCEINLINE uint64 GetCount() const { return TotalCount; }
+
+private:
+    /** Returns the bucket counting the given value. */
+    static int32 GetBucketIndex(uint64 Value);
+    /** Returns the value in the middle of the given bucket. */
+    static uint64 GetBucketMidpoint(int32 BucketIndex);
+
+    /** The number of values counted in each bucket. */
+    uint32 Counts[BUCKET_COUNT];
+    uint64 TotalCount;
+    uint64 TotalValue;
+    uint64 MaxValue;
+};
@@ -0,0 +1,204 @@
+#include "CubeProject.h"
+#include "FrameTimeTelemetry.h"
+
+static TAutoConsoleVariable<int32> CVarFrameStats(
+    TEXT("cube.FrameStats"),
+    0,
+    TEXT("1 to draw the frame time overlay with the percentiles of the current game state."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFrameStatsLogInterval(
+    TEXT("cube.FrameStats.LogInterval"),
+    0.0f,
+    TEXT("The number of seconds between two frame time summaries in the log. 0 disables the summaries."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarUncappedFrameRate(
+    TEXT("cube.UncappedFrameRate"),
+    0,
+    TEXT("1 to remove the frame rate limit, frame rate smoothing and vsync. Also enabled by the -uncapped command line switch."),
+    ECVF_Default);
+
+/** The percentiles shown in the overlay and the log. */
+static const float PERCENTILES[] = { 50.0f, 95.0f, 99.0f, 99.9f };
+
+FFrameTimeTelemetry::FFrameTimeTelemetry()
+    : LastGameState(EGameState::GAME_BOOT)
+    , TimeUntilLogSummary(0.0f)
+    , AppliedUncappedFrameRate(0)
+    , bDefaultSmoothFrameRate(false)
+    , bDefaultUseFixedFrameRate(false)
+    , DefaultMaxFPS(0.0f)
+    , DefaultVSync(0)
+{
+    FMemory::Memzero(LastMilliseconds, sizeof(LastMilliseconds));
+
+    if(FParse::Param(FCommandLine::Get(), TEXT("uncapped")))
+    {
+        CVarUncappedFrameRate->Set(1);
+    }
+}
+
+void FFrameTimeTelemetry::Sample(float DeltaSeconds, EGameState::Type GameState)
+{
+    UpdateFrameRateMode();
+
+    // The engine measures the thread and GPU times of the previous frame
+    LastMilliseconds[EFrameTimeMetric::Frame] = DeltaSeconds * 1000.0f;
+    LastMilliseconds[EFrameTimeMetric::GameThread] = FPlatformTime::ToMilliseconds(GGameThreadTime);
+    LastMilliseconds[EFrameTimeMetric::RenderThread] = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+    LastMilliseconds[EFrameTimeMetric::GPU] = FPlatformTime::ToMilliseconds(GGPUFrameTime);
+    LastGameState = GameState;
+
+    if(GameState >= 0 && GameState < NUM_GAME_STATES)
+    {
+        for(int32 Metric = 0; Metric < EFrameTimeMetric::Count; Metric++)
+        {
+            Histograms[Metric][GameState].RecordMilliseconds(LastMilliseconds[Metric]);
+            TotalHistograms[Metric].RecordMilliseconds(LastMilliseconds[Metric]);
+        }
+    }
+
+    // Periodically write the percentiles to the log
+    const float LogInterval = CVarFrameStatsLogInterval.GetValueOnGameThread();
+
+    if(LogInterval > 0.0f)
+    {
+        TimeUntilLogSummary -= DeltaSeconds;
+
+        if(TimeUntilLogSummary <= 0.0f)
+        {
+            LogSummary();
+            TimeUntilLogSummary = LogInterval;
+        }
+    }
+}
+
+void FFrameTimeTelemetry::Reset()
+{
+    for(int32 Metric = 0; Metric < EFrameTimeMetric::Count; Metric++)
+    {
+        for(FFrameTimeHistogram& Histogram : Histograms[Metric])
+        {
+            Histogram.Reset();
+        }
+
+        TotalHistograms[Metric].Reset();
+    }
+}
+
+void FFrameTimeTelemetry::LogSummary() const
+{
+    UE_LOG(LogCubeProject, Log, TEXT("Frame times (ms)          state                 frames     p50     p95     p99   p99.9     max"));
+
+    for(int32 Metric = 0; Metric < EFrameTimeMetric::Count; Metric++)
+    {
+        for(int32 GameState = 0; GameState < NUM_GAME_STATES; GameState++)
+        {
+            const FFrameTimeHistogram& Histogram = Histograms[Metric][GameState];
+
+            if(Histogram.GetCount() == 0)
+                continue;
+
+            UE_LOG(LogCubeProject, Log, TEXT("  %-24s %-20s %8llu %7.2f %7.2f %7.2f %7.2f %7.2f"), GetMetricName((EFrameTimeMetric::Type)Metric),
+                   GetGameStateName((EGameState::Type)GameState), Histogram.GetCount(), Histogram.GetPercentileMilliseconds(PERCENTILES[0]),
+                   Histogram.GetPercentileMilliseconds(PERCENTILES[1]), Histogram.GetPercentileMilliseconds(PERCENTILES[2]),
+                   Histogram.GetPercentileMilliseconds(PERCENTILES[3]), Histogram.GetMaxMilliseconds());
+        }
+    }
+}
+
+void FFrameTimeTelemetry::DrawOverlay(UCanvas* Canvas, UFont* Font, float X, float Y) const
+{
+    const float LineHeight = 14.0f;
+
+    Canvas->SetDrawColor(FColor::White);
+    Canvas->DrawText(Font, FString::Printf(TEXT("%s   frame %.2f ms   game %.2f ms   render %.2f ms   gpu %.2f ms"), GetGameStateName(LastGameState),
+                                           LastMilliseconds[EFrameTimeMetric::Frame], LastMilliseconds[EFrameTimeMetric::GameThread],
+                                           LastMilliseconds[EFrameTimeMetric::RenderThread], LastMilliseconds[EFrameTimeMetric::GPU]), X, Y);
+    Y += LineHeight;
+
+    Canvas->DrawText(Font, TEXT("                    p50      p95      p99    p99.9      max"), X, Y);
+    Y += LineHeight;
+
+    // Show the percentiles of the current game state, then over the whole session
+    for(int32 Pass = 0; Pass < 2; Pass++)
+    {
+        Canvas->SetDrawColor(Pass == 0 ? FColor::Yellow : FColor::Cyan);
+
+        for(int32 Metric = 0; Metric < EFrameTimeMetric::Count; Metric++)
+        {
+            const FFrameTimeHistogram& Histogram = (Pass == 0) ? Histograms[Metric][LastGameState] : TotalHistograms[Metric];
+
+            Canvas->DrawText(Font, FString::Printf(TEXT("%-6s %-12s %7.2f  %7.2f  %7.2f  %7.2f  %7.2f"), Pass == 0 ? TEXT("state") : TEXT("all"),
+                                                   GetMetricName((EFrameTimeMetric::Type)Metric), Histogram.GetPercentileMilliseconds(PERCENTILES[0]),
+                                                   Histogram.GetPercentileMilliseconds(PERCENTILES[1]), Histogram.GetPercentileMilliseconds(PERCENTILES[2]),
+                                                   Histogram.GetPercentileMilliseconds(PERCENTILES[3]), Histogram.GetMaxMilliseconds()), X, Y);
+            Y += LineHeight;
+        }
+    }
+}
+
+bool FFrameTimeTelemetry::IsOverlayEnabled()
+{
+    return CVarFrameStats.GetValueOnGameThread() != 0;
+}
+
+const TCHAR* FFrameTimeTelemetry::GetGameStateName(EGameState::Type GameState)
+{
+    static const TCHAR* Names[NUM_GAME_STATES] =
+    {
+        TEXT("GAME_BOOT"), TEXT("MAIN_MENU"), TEXT("RESET"), TEXT("WAITING_TO_START"),
+        TEXT("PUSH_BALL"), TEXT("PLAYING"), TEXT("GAME_OVER"), TEXT("WAITING_TO_RESTART")
+    };
+
+    return (GameState >= 0 && GameState < NUM_GAME_STATES) ? Names[GameState] : TEXT("UNKNOWN");
+}
+
+const TCHAR* FFrameTimeTelemetry::GetMetricName(EFrameTimeMetric::Type Metric)
+{
+    static const TCHAR* Names[EFrameTimeMetric::Count] = { TEXT("frame"), TEXT("game thread"), TEXT("render thread"), TEXT("gpu") };
+
+    return Names[Metric];
+}
+
+void FFrameTimeTelemetry::UpdateFrameRateMode()
+{
+    const int32 UncappedFrameRate = CVarUncappedFrameRate.GetValueOnGameThread();
+
+    if(UncappedFrameRate == AppliedUncappedFrameRate || !GEngine)
+        return;
+
+    IConsoleVariable* MaxFPS = IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS"));
+    IConsoleVariable* VSync = IConsoleManager::Get().FindConsoleVariable(TEXT("r.VSync"));
+
+    if(UncappedFrameRate)
+    {
+        // Remember the current settings so that they can be restored
+        bDefaultSmoothFrameRate = GEngine->bSmoothFrameRate;
+        bDefaultUseFixedFrameRate = GEngine->bUseFixedFrameRate;
+        DefaultMaxFPS = MaxFPS ? MaxFPS->GetFloat() : 0.0f;
+        DefaultVSync = VSync ? VSync->GetInt() : 0;
+
+        // Without smoothing, the engine no longer clamps the frame rate to SmoothedFrameRateRange (22-60 fps)
+        GEngine->bSmoothFrameRate = false;
+        GEngine->bUseFixedFrameRate = false;
+
+        if(MaxFPS)
+            MaxFPS->Set(0.0f);
+        if(VSync)
+            VSync->Set(0);
+    }
+    else
+    {
+        GEngine->bSmoothFrameRate = bDefaultSmoothFrameRate;
+        GEngine->bUseFixedFrameRate = bDefaultUseFixedFrameRate;
+
+        if(MaxFPS)
+            MaxFPS->Set(DefaultMaxFPS);
+        if(VSync)
+            VSync->Set(DefaultVSync);
+    }
+
+    AppliedUncappedFrameRate = UncappedFrameRate;
+}
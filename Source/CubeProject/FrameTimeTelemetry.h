@@ -0,0 +1,100 @@
+#pragma once
+
+#include "FrameTimeHistogram.h"
+#include "CubeProjectGameState.h"
+
+/** The frame timings tracked by FFrameTimeTelemetry. */
+namespace EFrameTimeMetric
+{
+    enum Type
+    {
+        /** The time between two frames. */
+        Frame,
+        /** The time spent on the game thread. */
+        GameThread,
+        /** The time spent on the render thread. */
+        RenderThread,
+        /** The time the GPU spent rendering the frame. Zero when running with -nullrhi. */
+        GPU,
+
+        Count
+    };
+}
+
+/**
+ * Records the frame, game thread, render thread and GPU times of every frame in a histogram per game state, so that
+ * stutters can be traced back to a part of the game flow (e.g., RESET or a fast rally). Sampled by ACubeProjectGameState
+ * every tick, so the game thread numbers are also available with -nullrhi. Drawn by ACubeProjectHUD and periodically
+ * written to the log.
+ *
+ * Console variables:
+ *   cube.FrameStats             1 to draw the frame time overlay.
+ *   cube.FrameStats.LogInterval The number of seconds between two frame time summaries in the log. 0 to disable.
+ *   cube.UncappedFrameRate      1 to remove the frame rate limit and smoothing, for high refresh rate displays.
+ */
+class CUBEPROJECT_API FFrameTimeTelemetry
+{
+public:
+    /** The number of game states tracked separately. */
+    static constexpr int32 NUM_GAME_STATES = EGameState::WAITING_TO_RESTART + 1;
+
+    FFrameTimeTelemetry();
+
+    /** Records the timings of the last frame under the given game state. Called once per tick. */
+    void Sample(float DeltaSeconds, EGameState::Type GameState);
+
+    /** Removes every recorded frame. */
+    void Reset();
+
+    /** Returns the histogram of a metric for a game state. */
+    FORCEINLINE const FFrameTimeHistogram& GetHistogram(EFrameTimeMetric::Type Metric, EGameState::Type GameState) const { return Histograms[Metric][GameState]; }
+
+    /** Returns the histogram of a metric over every game state. */
+    FORCEINLINE const FFrameTimeHistogram& GetTotalHistogram(EFrameTimeMetric::Type Metric) const { return TotalHistograms[Metric]; }
+
+    /** Returns the timings of the last sampled frame, in milliseconds. */
+    FORCEINLINE float GetLastMilliseconds(EFrameTimeMetric::Type Metric) const { return LastMilliseconds[Metric]; }
+
+    /** Returns the last sampled game state. */
+    FORCEINLINE EGameState::Type GetLastGameState() const { return LastGameState; }
+
+    /** Writes the p50/p95/p99/p99.9 of every metric for every game state to the log. */
+    void LogSummary() const;
+
+    /** Draws the frame time overlay on the given canvas. */
+    void DrawOverlay(class UCanvas* Canvas, class UFont* Font, float X, float Y) const;
+
+    /** Returns true if the overlay should be drawn (cube.FrameStats). */
+    static bool IsOverlayEnabled();
+
+    /** Returns the name of a game state. */
+    static const TCHAR* GetGameStateName(EGameState::Type GameState);
+
+    /** Returns the name of a metric. */
+    static const TCHAR* GetMetricName(EFrameTimeMetric::Type Metric);
+
+private:
+    /** Applies cube.UncappedFrameRate to the engine whenever it changes. */
+    void UpdateFrameRateMode();
+
+    /** The histogram of each metric for each game state. */
+    FFrameTimeHistogram Histograms[EFrameTimeMetric::Count][NUM_GAME_STATES];
+    /** The histogram of each metric over every game state. */
+    FFrameTimeHistogram TotalHistograms[EFrameTimeMetric::Count];
+
+    /** The timings of the last sampled frame. */
+    float LastMilliseconds[EFrameTimeMetric::Count];
+    /** The last sampled game state. */
+    EGameState::Type LastGameState;
+
+    /** The time left before the next summary is written to the log. */
+    float TimeUntilLogSummary;
+
+    /** The value of cube.UncappedFrameRate last applied to the engine. */
+    int32 AppliedUncappedFrameRate;
+    /** The engine's frame rate settings before the frame rate was uncapped. */
+    bool bDefaultSmoothFrameRate;
+    bool bDefaultUseFixedFrameRate;
+    float DefaultMaxFPS;
+    int32 DefaultVSync;
+};
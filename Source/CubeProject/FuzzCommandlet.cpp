@@ -0,0 +1,183 @@
+#include "CubeProject.h"
+#include "FuzzCommandlet.h"
+#include "CubeFuzz.h"
+#include "ParallelFor.h"
+
+namespace
+{
+    /** A failing case, once shrunk. */
+    struct FFuzzFailedCase
+    {
+        uint64 Seed;
+        FCubeReplay Case;
+        FCubeFuzzFailure Failure;
+    };
+
+    /** The cases played by one worker, so the workers never share any data but the stop condition. */
+    struct FFuzzPartialResult
+    {
+        int32 NumCases = 0;
+        uint64 NumTicks = 0;
+        int32 NumShrinkRuns = 0;
+        TArray<FFuzzFailedCase> FailedCases;
+    };
+
+    void LogFailure(const FCubeFuzzFailure& Failure)
+    {
+        if(Failure.Slot != INDEX_NONE)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("  %s broken after tick %d by slot %d (%g)"), CubeFuzz::GetInvariantName(Failure.Invariant),
+                   Failure.Tick, Failure.Slot, Failure.Value);
+        }
+        else
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("  %s broken after tick %d (%g)"), CubeFuzz::GetInvariantName(Failure.Invariant), Failure.Tick,
+                   Failure.Value);
+        }
+    }
+
+    /** Plays a saved replay back and checks it. */
+    int32 CheckReplay(const FString& FileName)
+    {
+        FCubeReplay Replay;
+
+        if(!CubeReplay::LoadFromFile(FileName, Replay))
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("%s is not a valid replay"), *FileName);
+            return 2;
+        }
+
+        FCubeFuzzFailure Failure;
+        uint64 NumTicks = 0;
+
+        if(CubeFuzz::CheckCase(Replay, Failure, NumTicks))
+        {
+            UE_LOG(LogCubeProject, Display, TEXT("%s: %llu ticks of %d players, no invariant broken"), *FileName, NumTicks, (int32)Replay.Start.NumPlayers);
+            return 0;
+        }
+
+        UE_LOG(LogCubeProject, Error, TEXT("%s: %d players"), *FileName, (int32)Replay.Start.NumPlayers);
+        LogFailure(Failure);
+        return 1;
+    }
+}
+
+UFuzzCommandlet::UFuzzCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UFuzzCommandlet::Main(const FString& Params)
+{
+    FString ReplayFileName;
+
+    if(FParse::Value(*Params, TEXT("replay="), ReplayFileName))
+    {
+        return CheckReplay(ReplayFileName);
+    }
+
+    float Duration = 60.0f;
+    int32 NumTicks = 1200;
+    int32 MaxFailures = 16;
+    uint64 BaseSeed = FPlatformTime::Cycles64();
+
+    FParse::Value(*Params, TEXT("duration="), Duration);
+    FParse::Value(*Params, TEXT("ticks="), NumTicks);
+    FParse::Value(*Params, TEXT("maxfailures="), MaxFailures);
+    FParse::Value(*Params, TEXT("seed="), BaseSeed);
+
+    if(Duration <= 0.0f || NumTicks < 1 || MaxFailures < 1)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=Fuzz [-duration=<seconds>] [-ticks=<count>] [-seed=<seed>] [-maxfailures=<count>] | -replay=<file>"));
+        return 2;
+    }
+
+    const int32 NumWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+    UE_LOG(LogCubeProject, Display, TEXT("Fuzzing cases of %d ticks on %d threads for %.0f seconds, seeded with %llu"), NumTicks, NumWorkers, Duration, BaseSeed);
+
+    // Each worker plays the cases of its own seeds, until the time is up or enough cases failed
+    TArray<FFuzzPartialResult> PartialResults;
+    PartialResults.SetNum(NumWorkers);
+    FThreadSafeCounter NumFailures;
+    const double StartTime = FPlatformTime::Seconds();
+    const double EndTime = StartTime + Duration;
+
+    ParallelFor(NumWorkers, [&](int32 WorkerIndex)
+    {
+        FFuzzPartialResult& Result = PartialResults[WorkerIndex];
+        FCubeReplay Case;
+        FCubeFuzzFailure Failure;
+
+        for(uint64 CaseIndex = WorkerIndex; FPlatformTime::Seconds() < EndTime && NumFailures.GetValue() < MaxFailures; CaseIndex += NumWorkers)
+        {
+            const uint64 Seed = FCubeRandomStream::Mix(BaseSeed + CaseIndex);
+            CubeFuzz::GenerateCase(Seed, NumTicks, Case);
+            Result.NumCases++;
+
+            if(CubeFuzz::CheckCase(Case, Failure, Result.NumTicks))
+                continue;
+
+            NumFailures.Increment();
+            Result.NumShrinkRuns += CubeFuzz::Shrink(Case, Failure);
+
+            FFuzzFailedCase& FailedCase = Result.FailedCases[Result.FailedCases.AddDefaulted()];
+            FailedCase.Seed = Seed;
+            FailedCase.Case = Case;
+            FailedCase.Failure = Failure;
+        }
+    });
+
+    const double Seconds = FMath::Max(FPlatformTime::Seconds() - StartTime, 1e-6);
+
+    // Merge the results of every worker and save the shrunk cases
+    int32 NumCases = 0;
+    uint64 TotalTicks = 0;
+    int32 NumShrinkRuns = 0;
+    int32 FailuresPerInvariant[ECubeFuzzInvariant::Count] = {};
+
+    for(const FFuzzPartialResult& Result : PartialResults)
+    {
+        NumCases += Result.NumCases;
+        TotalTicks += Result.NumTicks;
+        NumShrinkRuns += Result.NumShrinkRuns;
+
+        for(const FFuzzFailedCase& FailedCase : Result.FailedCases)
+        {
+            FailuresPerInvariant[FailedCase.Failure.Invariant]++;
+
+            const FString FileName = FPaths::GameSavedDir() / TEXT("Fuzz") / FString::Printf(TEXT("%s_%llu.gsrp"),
+                                     CubeFuzz::GetInvariantName(FailedCase.Failure.Invariant), FailedCase.Seed);
+
+            UE_LOG(LogCubeProject, Error, TEXT("Case %llu failed, shrunk to %d ticks of %d players: %s"), FailedCase.Seed, FailedCase.Case.NumTicks(),
+                   (int32)FailedCase.Case.Start.NumPlayers, *FileName);
+            LogFailure(FailedCase.Failure);
+
+            if(!CubeReplay::SaveToFile(FailedCase.Case, FileName))
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("  Could not save the replay"));
+            }
+        }
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("%d cases, %llu ticks in %.1f seconds: %.1f M ticks per minute"), NumCases, TotalTicks, Seconds,
+           TotalTicks * 60.0 / Seconds / 1000000.0);
+
+    for(int32 Invariant = 0; Invariant < ECubeFuzzInvariant::Count; Invariant++)
+    {
+        if(FailuresPerInvariant[Invariant] > 0)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("%s: %d failing cases"), CubeFuzz::GetInvariantName((ECubeFuzzInvariant::Type)Invariant),
+                   FailuresPerInvariant[Invariant]);
+        }
+    }
+
+    if(NumShrinkRuns > 0)
+    {
+        UE_LOG(LogCubeProject, Display, TEXT("The failing cases were played %d times while they were shrunk"), NumShrinkRuns);
+    }
+
+    return (NumFailures.GetValue() > 0) ? 1 : 0;
+}
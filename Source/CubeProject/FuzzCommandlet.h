@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "FuzzCommandlet.generated.h"
+
+/**
+ * Fuzzes the match simulation on every core for the given duration (see CubeFuzz.h): random cases of random players,
+ * arenas, spawns and inputs are played and the gameplay invariants are checked after every tick. Each failing case is
+ * shrunk and saved as a replay in Saved/Fuzz/<Invariant>_<Seed>.gsrp. With -replay=<file>, the given replay is played
+ * back and checked instead, to reproduce a failure.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=Fuzz [-duration=<seconds>] [-ticks=<count>] [-seed=<seed>] [-maxfailures=<count>]
+ *        UE4Editor-Cmd CubeProject -run=Fuzz -replay=<file>
+ *
+ * Returns 0 if no case broke an invariant, 1 if one did and 2 on invalid arguments.
+ */
+UCLASS()
+class UFuzzCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UFuzzCommandlet();
+
+    // Runs the fuzzer
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,228 @@
+#include "CubeProject.h"
+#include "GameplayTimerWheel.h"
+
+/** The number of timers the pool can hold before it needs to grow. */
+static const int32 INITIAL_TIMER_CAPACITY = 64;
+
+FGameplayTimerWheel::FGameplayTimerWheel()
+    : FirstFreeTimer(INDEX_NONE)
+    , NumActiveTimers(0)
+    , CurrentTick(0)
+{
+    for(int32& SlotHead : SlotHeads)
+    {
+        SlotHead = INDEX_NONE;
+    }
+
+    Timers.Reserve(INITIAL_TIMER_CAPACITY);
+}
+
+FGameplayTimerHandle FGameplayTimerWheel::Schedule(uint32 DelayTicks, const FSimpleDelegate& Callback)
+{
+    const int32 TimerIndex = AllocateTimer();
+    Timers[TimerIndex].Callback = Callback;
+
+    return Start(TimerIndex, DelayTicks);
+}
+
+int32 FGameplayTimerWheel::AllocateTimer()
+{
+    // Reuse a free timer, or grow the pool
+    int32 TimerIndex = FirstFreeTimer;
+
+    if(TimerIndex != INDEX_NONE)
+    {
+        FirstFreeTimer = Timers[TimerIndex].Next;
+    }
+    else
+    {
+        TimerIndex = Timers.AddDefaulted();
+        Timers[TimerIndex].MethodCaller = NULL;
+        Timers[TimerIndex].Serial = 1;
+    }
+
+    return TimerIndex;
+}
+
+FGameplayTimerHandle FGameplayTimerWheel::Start(int32 TimerIndex, uint32 DelayTicks)
+{
+    FTimer& Timer = Timers[TimerIndex];
+    Timer.ExpireTick = CurrentTick + FMath::Clamp<uint32>(DelayTicks, 1, MAX_DELAY_TICKS);
+
+    Link(TimerIndex);
+    NumActiveTimers++;
+
+    FGameplayTimerHandle Handle;
+    Handle.Index = TimerIndex;
+    Handle.Serial = Timer.Serial;
+    return Handle;
+}
+
+void FGameplayTimerWheel::Cancel(FGameplayTimerHandle& Handle)
+{
+    if(Find(Handle))
+    {
+        Unlink(Handle.Index);
+        Release(Handle.Index);
+    }
+
+    Handle.Invalidate();
+}
+
+bool FGameplayTimerWheel::IsActive(const FGameplayTimerHandle& Handle) const
+{
+    return Find(Handle) != NULL;
+}
+
+uint32 FGameplayTimerWheel::GetRemainingTicks(const FGameplayTimerHandle& Handle) const
+{
+    const FTimer* Timer = Find(Handle);
+    return Timer ? (uint32)(Timer->ExpireTick - CurrentTick) : 0;
+}
+
+void FGameplayTimerWheel::Advance()
+{
+    CurrentTick++;
+
+    // Each time a level wraps around, move the timers of the next slot of the level above down to the lower levels
+    for(int32 Level = 1; Level < LEVEL_COUNT; Level++)
+    {
+        if(((CurrentTick >> (SLOT_BITS * (Level - 1))) & (SLOTS_PER_LEVEL - 1)) != 0)
+            break;
+
+        Cascade(Level, (int32)((CurrentTick >> (SLOT_BITS * Level)) & (SLOTS_PER_LEVEL - 1)));
+    }
+
+    // Fire the timers due this tick. Timers are removed one at a time so that a callback can safely schedule or cancel timers.
+    int32& SlotHead = SlotHeads[(int32)(CurrentTick & (SLOTS_PER_LEVEL - 1))];
+
+    while(SlotHead != INDEX_NONE)
+    {
+        const int32 TimerIndex = SlotHead;
+        FTimer& Timer = Timers[TimerIndex];
+        FSimpleDelegate Callback = MoveTemp(Timer.Callback);
+        UObject* Object = Timer.Object.Get();
+        const FMethodCaller MethodCaller = Timer.MethodCaller;
+        uint64 Method[ARRAY_COUNT(Timer.Method)];
+        FMemory::Memcpy(Method, Timer.Method, sizeof(Method));
+
+        Unlink(TimerIndex);
+        Release(TimerIndex);
+
+        if(MethodCaller)
+        {
+            // The object may have been destroyed while the timer was waiting
+            if(Object)
+            {
+                MethodCaller(Object, Method);
+            }
+        }
+        else
+        {
+            Callback.ExecuteIfBound();
+        }
+    }
+}
+
+void FGameplayTimerWheel::Clear()
+{
+    for(int32 Slot = 0; Slot < LEVEL_COUNT * SLOTS_PER_LEVEL; Slot++)
+    {
+        while(SlotHeads[Slot] != INDEX_NONE)
+        {
+            const int32 TimerIndex = SlotHeads[Slot];
+            Unlink(TimerIndex);
+            Release(TimerIndex);
+        }
+    }
+}
+
+void FGameplayTimerWheel::Link(int32 TimerIndex)
+{
+    FTimer& Timer = Timers[TimerIndex];
+    const uint64 Delay = Timer.ExpireTick - CurrentTick;
+
+    // Find the lowest level which covers the delay. The slot within the level is given by the expiration tick's bits.
+    int32 Level = 0;
+
+    while(Level < LEVEL_COUNT - 1 && Delay >= (1ull << (SLOT_BITS * (Level + 1))))
+    {
+        Level++;
+    }
+
+    const int32 SlotInLevel = (int32)((Timer.ExpireTick >> (SLOT_BITS * Level)) & (SLOTS_PER_LEVEL - 1));
+    const int32 Slot = Level * SLOTS_PER_LEVEL + SlotInLevel;
+
+    // Insert the timer at the head of the slot's list
+    Timer.Slot = Slot;
+    Timer.Previous = INDEX_NONE;
+    Timer.Next = SlotHeads[Slot];
+
+    if(Timer.Next != INDEX_NONE)
+    {
+        Timers[Timer.Next].Previous = TimerIndex;
+    }
+
+    SlotHeads[Slot] = TimerIndex;
+}
+
+void FGameplayTimerWheel::Unlink(int32 TimerIndex)
+{
+    FTimer& Timer = Timers[TimerIndex];
+
+    if(Timer.Previous != INDEX_NONE)
+    {
+        Timers[Timer.Previous].Next = Timer.Next;
+    }
+    else
+    {
+        SlotHeads[Timer.Slot] = Timer.Next;
+    }
+
+    if(Timer.Next != INDEX_NONE)
+    {
+        Timers[Timer.Next].Previous = Timer.Previous;
+    }
+
+    Timer.Slot = INDEX_NONE;
+}
+
+void FGameplayTimerWheel::Release(int32 TimerIndex)
+{
+    FTimer& Timer = Timers[TimerIndex];
+
+    // Invalidate the handles pointing to this timer and return it to the pool
+    Timer.Callback.Unbind();
+    Timer.Object = NULL;
+    Timer.MethodCaller = NULL;
+    Timer.Serial = (Timer.Serial == MAX_uint32) ? 1 : Timer.Serial + 1;
+    Timer.Next = FirstFreeTimer;
+    FirstFreeTimer = TimerIndex;
+
+    NumActiveTimers--;
+}
+
+void FGameplayTimerWheel::Cascade(int32 Level, int32 SlotInLevel)
+{
+    int32& SlotHead = SlotHeads[Level * SLOTS_PER_LEVEL + SlotInLevel];
+
+    // Detach the slot's list first. Its timers are due within the span of this slot, so each one moves to a lower level.
+    int32 TimerIndex = SlotHead;
+    SlotHead = INDEX_NONE;
+
+    while(TimerIndex != INDEX_NONE)
+    {
+        const int32 NextTimerIndex = Timers[TimerIndex].Next;
+        Link(TimerIndex);
+        TimerIndex = NextTimerIndex;
+    }
+}
+
+const FGameplayTimerWheel::FTimer* FGameplayTimerWheel::Find(const FGameplayTimerHandle& Handle) const
+{
+    if(!Handle.IsValid() || !Timers.IsValidIndex(Handle.Index))
+        return NULL;
+
+    const FTimer& Timer = Timers[Handle.Index];
+    return (Timer.Serial == Handle.Serial && Timer.Slot != INDEX_NONE) ? &Timer : NULL;
+}
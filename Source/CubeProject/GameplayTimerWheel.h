@@ -0,0 +1,149 @@
+#pragma once
+
+/** Identifies a timer scheduled on an FGameplayTimerWheel. A handle stays safe to use after its timer fired or was
+  * cancelled: the wheel then reports it as inactive. */
+struct FGameplayTimerHandle
+{
+    /** The timer's index in the wheel's pool. */
+    int32 Index = INDEX_NONE;
+    /** Incremented each time a pool entry is reused, so that stale handles don't match the new timer. Zero is never used. */
+    uint32 Serial = 0;
+
+    /** Returns true if the handle was set by FGameplayTimerWheel::Schedule(). The timer may have fired since. */
+    FORCEINLINE bool IsValid() const { return Serial != 0; }
+
+    /** Clears the handle without cancelling its timer. */
+    FORCEINLINE void Invalidate() { Index = INDEX_NONE; Serial = 0; }
+};
+
+/**
+ * Schedules gameplay callbacks a number of simulation ticks in the future. Timers are kept in a hierarchical wheel of
+ * LEVEL_COUNT levels of SLOTS_PER_LEVEL slots each: a timer due in less than 64 ticks sits in the first level, one due in
+ * less than 64^2 ticks in the second level, and so on. Every time a level wraps around, the next slot of the level above
+ * is moved down, so each timer is moved at most LEVEL_COUNT - 1 times.
+ *
+ * Scheduling and cancelling a timer are O(1) and only allocate when the pool of timers grows. Advancing the wheel only
+ * touches the slots which are due, so idle cooldowns cost nothing. Since the wheel counts ticks and not seconds, timers
+ * fire on the same tick on every run of the same match.
+ */
+class CUBEPROJECT_API FGameplayTimerWheel
+{
+public:
+    /** Each level has 2^SLOT_BITS slots. */
+    static constexpr int32 SLOT_BITS = 6;
+    static constexpr int32 SLOTS_PER_LEVEL = 1 << SLOT_BITS;
+    static constexpr int32 LEVEL_COUNT = 4;
+    /** The longest delay a timer can have, about 77 hours at 60 ticks per second. Longer delays are clamped. */
+    static constexpr uint32 MAX_DELAY_TICKS = (1u << (SLOT_BITS * LEVEL_COUNT)) - 1;
+
+    FGameplayTimerWheel();
+
+    /** Calls the given delegate once 'DelayTicks' ticks have elapsed. A delay of zero fires on the next tick. A timer
+      * without a bound delegate can be used as a cooldown, checked with IsActive(). Copying a bound delegate allocates, so
+      * gameplay code schedules its callbacks with the overload below. */
+    FGameplayTimerHandle Schedule(uint32 DelayTicks, const FSimpleDelegate& Callback);
+
+    /** Calls the given member function once 'DelayTicks' ticks have elapsed. The object is not kept alive by the timer. The
+      * object and function are stored in the timer as they are, rather than bound to a delegate, whose binding and copies
+      * allocate: scheduling such a timer does not allocate once the pool is large enough. */
+    template<class UserClass>
+    FORCEINLINE FGameplayTimerHandle Schedule(uint32 DelayTicks, UserClass* Object, void (UserClass::*Method)())
+    {
+        static_assert(sizeof(Method) <= sizeof(FTimer::Method), "The member function pointer does not fit in a timer");
+
+        const int32 TimerIndex = AllocateTimer();
+        FTimer& Timer = Timers[TimerIndex];
+        Timer.Object = static_cast<UObject*>(Object);
+        Timer.MethodCaller = &CallMethod<UserClass>;
+        FMemory::Memcpy(Timer.Method, &Method, sizeof(Method));
+
+        return Start(TimerIndex, DelayTicks);
+    }
+
+    /** Cancels the given timer if it has not fired yet, and invalidates the handle. */
+    void Cancel(FGameplayTimerHandle& Handle);
+
+    /** Returns true if the given timer is waiting to fire. */
+    bool IsActive(const FGameplayTimerHandle& Handle) const;
+
+    /** Returns the number of ticks left before the given timer fires, or zero if it is not active. */
+    uint32 GetRemainingTicks(const FGameplayTimerHandle& Handle) const;
+
+    /** Advances the wheel by one tick and fires the timers which are due. */
+    void Advance();
+
+    /** Cancels every timer. */
+    void Clear();
+
+    /** Returns the number of ticks the wheel has advanced since it was created. */
+    FORCEINLINE uint64 GetCurrentTick() const { return CurrentTick; }
+
+    /** Returns the number of timers waiting to fire. */
+    FORCEINLINE int32 Num() const { return NumActiveTimers; }
+
+private:
+    /** Calls the member function stored in a timer on its object. */
+    typedef void (*FMethodCaller)(UObject* Object, const void* Method);
+
+    /** A scheduled timer. Timers in the same slot form a doubly-linked list through the indices of the pool. */
+    struct FTimer
+    {
+        /** The delegate to call, for a timer scheduled with one. */
+        FSimpleDelegate Callback;
+        /** The object and member function to call, for a timer scheduled with them. The member function pointer is stored as
+          * bytes, which are large enough for any pointer to a member function. */
+        TWeakObjectPtr<UObject> Object;
+        FMethodCaller MethodCaller;
+        uint64 Method[3];
+        uint64 ExpireTick;
+        int32 Previous;
+        int32 Next;
+        /** The slot holding the timer, or INDEX_NONE if the timer is free. */
+        int32 Slot;
+        uint32 Serial;
+    };
+
+    /** Calls the member function stored in Method on the object, which is a UserClass. */
+    template<class UserClass>
+    static void CallMethod(UObject* Object, const void* Method)
+    {
+        void (UserClass::*UserMethod)();
+        FMemory::Memcpy(&UserMethod, Method, sizeof(UserMethod));
+        (static_cast<UserClass*>(Object)->*UserMethod)();
+    }
+
+    /** Takes a free timer from the pool, or grows the pool. Returns the timer's index. */
+    int32 AllocateTimer();
+
+    /** Schedules a timer taken from the pool, whose callback is set. Returns its handle. */
+    FGameplayTimerHandle Start(int32 TimerIndex, uint32 DelayTicks);
+
+    /** Places a timer in the slot matching its expiration tick. */
+    void Link(int32 TimerIndex);
+
+    /** Removes a timer from its slot. */
+    void Unlink(int32 TimerIndex);
+
+    /** Returns a timer to the pool. */
+    void Release(int32 TimerIndex);
+
+    /** Moves every timer in the given slot of the given level to the levels below. */
+    void Cascade(int32 Level, int32 SlotInLevel);
+
+    /** Returns the timer referenced by the handle, or NULL if the timer is no longer active. */
+    const FTimer* Find(const FGameplayTimerHandle& Handle) const;
+
+    /** The first timer of each slot, indexed by Level * SLOTS_PER_LEVEL + SlotInLevel. */
+    int32 SlotHeads[LEVEL_COUNT * SLOTS_PER_LEVEL];
+
+    /** Every timer ever created. Free timers are chained through their Next index. */
+    TArray<FTimer> Timers;
+    /** The first free timer in the pool. */
+    int32 FirstFreeTimer;
+
+    /** The number of timers waiting to fire. */
+    int32 NumActiveTimers;
+
+    /** The number of ticks elapsed. */
+    uint64 CurrentTick;
+};
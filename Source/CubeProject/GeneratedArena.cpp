@@ -0,0 +1,111 @@
+#include "CubeProject.h"
+#include "GeneratedArena.h"
+#include "CubeArenaGenerator.h"
+#include "Goal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+
+namespace
+{
+    /** The size of the engine's cube mesh. */
+    const float CUBE_MESH_SIZE = 100.0f;
+    /** The half-thickness of the goals' trigger volumes. A ball enters the trigger as it touches the goal line. */
+    const float GOAL_TRIGGER_HALF_THICKNESS = 1.0f;
+
+    /** Returns the transform of the cube instance which fills a box of the arena. */
+    FTransform GetBoxTransform(const FCubeArenaBox& Box)
+    {
+        const FQuat Rotation(FVector(1.0f, 0.0f, 0.0f), FMath::Atan2(Box.Axis.Y, Box.Axis.X));
+        const FVector Scale(2.0f * AGeneratedArena::HALF_DEPTH, 2.0f * Box.HalfSize.X, 2.0f * Box.HalfSize.Y);
+
+        return FTransform(Rotation, CubeSim::ToWorld(Box.Center), Scale / CUBE_MESH_SIZE);
+    }
+}
+
+AGeneratedArena::AGeneratedArena()
+{
+    static ConstructorHelpers::FObjectFinder<UStaticMesh> CubeMesh(TEXT("/Engine/BasicShapes/Cube.Cube"));
+
+    Walls = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Walls"));
+    Walls->SetMobility(EComponentMobility::Static);
+    Walls->SetStaticMesh(CubeMesh.Object);
+    Walls->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+    RootComponent = Walls;
+
+    Obstacles = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Obstacles"));
+    Obstacles->SetMobility(EComponentMobility::Static);
+    Obstacles->SetStaticMesh(CubeMesh.Object);
+    Obstacles->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+    Obstacles->AttachTo(RootComponent);
+}
+
+void AGeneratedArena::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    DestroySpawnedActors();
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void AGeneratedArena::Build(const FCubeGeneratedArena& Arena)
+{
+    UWorld* World = GetWorld();
+
+    Walls->ClearInstances();
+    Obstacles->ClearInstances();
+
+    for(const FCubeArenaBox& Box : Arena.Walls)
+    {
+        Walls->AddInstance(GetBoxTransform(Box));
+    }
+
+    for(const FCubeArenaBox& Box : Arena.Obstacles)
+    {
+        Obstacles->AddInstance(GetBoxTransform(Box));
+    }
+
+    DestroySpawnedActors();
+
+    // The goals' triggers stand on the goal lines, across the goal mouths. The left goal is defended by team 0.
+    const FCubeSimArena& Field = Arena.Arena;
+    const FVector TriggerExtent(HALF_DEPTH, GOAL_TRIGGER_HALF_THICKNESS, Field.GoalHalfHeight);
+
+    for(int32 Team = 0; Team < FCubePlayerRegistry::TEAM_COUNT; Team++)
+    {
+        const float GoalLineY = (Team == 0) ? Field.LeftGoalLineY : Field.RightGoalLineY;
+        AGoal* Goal = World->SpawnActor<AGoal>(CubeSim::ToWorld(FVector2D(GoalLineY, Field.GoalCenterZ)), FRotator::ZeroRotator);
+
+        if(Goal)
+        {
+            Goal->SetMouth(Team == 1, TriggerExtent);
+            SpawnedActors.Add(Goal);
+        }
+    }
+
+    // Tag each player start with its slot, as ACubeProjectGameMode::IndexPlayerStarts() expects
+    FActorSpawnParameters SpawnParameters;
+    SpawnParameters.bNoCollisionFail = true;
+
+    for(int32 Slot = 0; Slot < Arena.NumPlayers; Slot++)
+    {
+        APlayerStart* PlayerStart = World->SpawnActor<APlayerStart>(APlayerStart::StaticClass(), CubeSim::ToWorld(Arena.StartLocations[Slot]),
+                                                                    FRotator::ZeroRotator, SpawnParameters);
+
+        if(PlayerStart)
+        {
+            PlayerStart->PlayerStartTag = FName(*FString::FromInt(Slot));
+            SpawnedActors.Add(PlayerStart);
+        }
+    }
+}
+
+void AGeneratedArena::DestroySpawnedActors()
+{
+    for(AActor* Actor : SpawnedActors)
+    {
+        if(Actor)
+        {
+            Actor->Destroy();
+        }
+    }
+
+    SpawnedActors.Reset();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "GeneratedArena.generated.h"
+
+/**
+ * Spawns an arena generated by CubeArenaGenerator: its walls and obstacles as instances of a cube, with one physics body
+ * per instance, and its goals and player starts as regular actors, so that the game mode finds them as it finds those of
+ * an authored level. Building an arena spawns four actors and a few dozen instances.
+ */
+UCLASS()
+class CUBEPROJECT_API AGeneratedArena : public AActor
+{
+    GENERATED_BODY()
+
+public:
+    // Creates the instanced walls
+    AGeneratedArena();
+
+    // Destroys the goals and player starts spawned for the arena
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    /** Replaces the arena with the given one, in the plane of the game at X = 0. */
+    void Build(const struct FCubeGeneratedArena& Arena);
+
+    /** How far the walls reach on each side of the plane of the game. */
+    static constexpr float HALF_DEPTH = 100.0f;
+
+private:
+    /** Destroys the goals and player starts spawned for the arena. */
+    void DestroySpawnedActors();
+
+    UPROPERTY(VisibleAnywhere, Category = "Arena", meta = (AllowPrivateAccess = "true"))
+    class UInstancedStaticMeshComponent* Walls;
+
+    UPROPERTY(VisibleAnywhere, Category = "Arena", meta = (AllowPrivateAccess = "true"))
+    class UInstancedStaticMeshComponent* Obstacles;
+
+    /** The goals and player starts spawned for the arena. */
+    UPROPERTY(Transient)
+    TArray<AActor*> SpawnedActors;
+};
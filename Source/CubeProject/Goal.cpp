@@ -21,6 +21,17 @@ void AGoal::BeginPlay()
     Super::BeginPlay();
 }
 
+float AGoal::GetMouthHalfHeight() const
+{
+    return TriggerVolume->GetScaledBoxExtent().Z;
+}
+
+void AGoal::SetMouth(bool bInRightHandSideGoal, const FVector& TriggerExtent)
+{
+    bRightHandSideGoal = bInRightHandSideGoal;
+    TriggerVolume->SetBoxExtent(TriggerExtent);
+}
+
 void AGoal::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
@@ -21,6 +21,12 @@ public:
     /** Returns true if the goal is on the right-hand side of the field. If so, this goal belongs to player 2. */
     FORCEINLINE bool IsRightHandSideGoal() { return bRightHandSideGoal; };
     
+    /** Returns half the height of the goal's trigger volume, in world units. */
+    float GetMouthHalfHeight() const;
+    
+    /** Sets the side of the field the goal is on, and the half-size of its trigger volume. Used by generated arenas. */
+    void SetMouth(bool bInRightHandSideGoal, const FVector& TriggerExtent);
+    
 private:
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Trigger", meta = (AllowPrivateAccess = "true"))
     class UBoxComponent* TriggerVolume;
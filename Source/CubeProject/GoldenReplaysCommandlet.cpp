@@ -0,0 +1,298 @@
+#include "CubeProject.h"
+#include "GoldenReplaysCommandlet.h"
+#include "CubeGoldenReplay.h"
+#include "CubePerfBaseline.h"
+
+namespace
+{
+    /** The section of Config/PerfBaseline.ini holding the throughput of the golden replays. */
+    const TCHAR* BASELINE_SECTION = TEXT("GoldenReplays");
+    /** The default relative tolerance of the throughput, used when the baseline file does not set one. */
+    constexpr float DEFAULT_TOLERANCE = 0.25f;
+
+    /** A replay of the corpus and its golden values. */
+    struct FGoldenReplayFile
+    {
+        FString Name;
+        FCubeReplay Replay;
+        FCubeGoldenValues Golden;
+    };
+
+    FCubeGoldenScenario& AddScenario(TArray<FCubeGoldenScenario>& Scenarios, const TCHAR* Name, int32 NumPlayers, int32 ScoreToWin, int32 NumTicks,
+                                     uint64 Seed, float Noise)
+    {
+        FCubeGoldenScenario& Scenario = Scenarios[Scenarios.AddDefaulted()];
+        Scenario.Name = Name;
+        Scenario.NumPlayers = NumPlayers;
+        Scenario.ScoreToWin = ScoreToWin;
+        Scenario.NumTicks = NumTicks;
+        Scenario.Seed = Seed;
+        Scenario.bGeneratedArena = false;
+        Scenario.Noise = Noise;
+        return Scenario;
+    }
+
+    /** The matches of the corpus: every team size, the default arena and generated ones, clean and noisy play, and enough
+      * ticks for goals, resets and, with a low score to win, restarts. Changing them requires recording the corpus again. */
+    void GetScenarios(TArray<FCubeGoldenScenario>& OutScenarios)
+    {
+        AddScenario(OutScenarios, TEXT("Duel"), 2, 3, 3600, 1001, 0.05f);
+        AddScenario(OutScenarios, TEXT("DuelNoisy"), 2, 3, 3600, 1002, 0.3f);
+        AddScenario(OutScenarios, TEXT("SuddenDeath"), 2, 1, 7200, 1003, 0.1f);
+        AddScenario(OutScenarios, TEXT("TwoVsTwo"), 4, 5, 3600, 1004, 0.15f);
+        AddScenario(OutScenarios, TEXT("Crowd"), 8, 5, 2400, 1005, 0.3f);
+
+        FCubeGoldenScenario& RoundCorners = AddScenario(OutScenarios, TEXT("RoundCorners"), 3, 2, 3600, 1006, 0.2f);
+        RoundCorners.bGeneratedArena = true;
+        RoundCorners.ArenaParams.CornerRadius = 150.0f;
+
+        FCubeGoldenScenario& Pillars = AddScenario(OutScenarios, TEXT("Pillars"), 4, 3, 3600, 1007, 0.2f);
+        Pillars.bGeneratedArena = true;
+        Pillars.ArenaParams.ObstacleLayout = ECubeObstacleLayout::Grid;
+        Pillars.ArenaParams.NumObstacles = 6;
+
+        FCubeGoldenScenario& Scattered = AddScenario(OutScenarios, TEXT("Scattered"), 2, 3, 3600, 1008, 0.3f);
+        Scattered.bGeneratedArena = true;
+        Scattered.ArenaParams.HalfLength = 1000.0f;
+        Scattered.ArenaParams.HalfHeight = 320.0f;
+        Scattered.ArenaParams.CornerRadius = 80.0f;
+        Scattered.ArenaParams.ObstacleLayout = ECubeObstacleLayout::Scattered;
+        Scattered.ArenaParams.NumObstacles = 8;
+        Scattered.ArenaParams.Seed = 1008;
+    }
+
+    /** Records every scenario to the given directory. */
+    int32 RecordCorpus(const FString& Directory)
+    {
+        TArray<FCubeGoldenScenario> Scenarios;
+        GetScenarios(Scenarios);
+
+        FCubeReplay Replay;
+        FCubeGoldenValues Golden;
+
+        for(const FCubeGoldenScenario& Scenario : Scenarios)
+        {
+            CubeGoldenReplay::Record(Scenario, Replay, Golden);
+
+            const FString BaseName = Directory / Scenario.Name;
+
+            if(!CubeReplay::SaveToFile(Replay, BaseName + TEXT(".gsrp")) || !CubeGoldenReplay::SaveToFile(Golden, BaseName + TEXT(".gsgd")))
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("Could not write %s"), *BaseName);
+                return 2;
+            }
+
+            UE_LOG(LogCubeProject, Display, TEXT("%s: %d ticks, %d steps, %d goals, %d matches completed, final score %d-%d"), Scenario.Name,
+                   Golden.Hashes.Num(), Golden.NumSteps, Golden.Goals.Num(), Golden.NumCompletedMatches, Golden.FinalScores[0], Golden.FinalScores[1]);
+        }
+
+        UE_LOG(LogCubeProject, Display, TEXT("Recorded %d golden replays to %s"), Scenarios.Num(), *Directory);
+        return 0;
+    }
+
+    /** Compares a replay played back to its golden values, and reports the first differences. Returns true if they match. */
+    bool CompareToGolden(const FString& Name, const FCubeGoldenValues& Golden, const FCubeGoldenValues& Played)
+    {
+        bool bMatches = true;
+
+        // The first divergent hash tells when the gameplay changed; the goals and scores tell how much
+        for(int32 Tick = 0; Tick < Golden.Hashes.Num(); Tick++)
+        {
+            if(Played.Hashes[Tick] != Golden.Hashes[Tick])
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("%s: the state diverged at tick %d (%016llx, golden %016llx)"), *Name, Tick, Played.Hashes[Tick],
+                       Golden.Hashes[Tick]);
+                bMatches = false;
+                break;
+            }
+        }
+
+        for(int32 Goal = 0; Goal < FMath::Max(Golden.Goals.Num(), Played.Goals.Num()); Goal++)
+        {
+            if(Goal >= Golden.Goals.Num() || Goal >= Played.Goals.Num())
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("%s: %d goals scored, golden %d"), *Name, Played.Goals.Num(), Golden.Goals.Num());
+                bMatches = false;
+                break;
+            }
+
+            const FCubeGoldenGoal& PlayedGoal = Played.Goals[Goal];
+            const FCubeGoldenGoal& GoldenGoal = Golden.Goals[Goal];
+
+            if(PlayedGoal.Tick != GoldenGoal.Tick || PlayedGoal.Team != GoldenGoal.Team)
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("%s: goal %d scored by team %d at tick %u, golden team %d at tick %u"), *Name, Goal, PlayedGoal.Team,
+                       PlayedGoal.Tick, GoldenGoal.Team, GoldenGoal.Tick);
+                bMatches = false;
+                break;
+            }
+        }
+
+        if(Played.FinalScores[0] != Golden.FinalScores[0] || Played.FinalScores[1] != Golden.FinalScores[1])
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("%s: final score %d-%d, golden %d-%d"), *Name, Played.FinalScores[0], Played.FinalScores[1],
+                   Golden.FinalScores[0], Golden.FinalScores[1]);
+            bMatches = false;
+        }
+
+        if(Played.NumSteps != Golden.NumSteps || Played.NumCompletedMatches != Golden.NumCompletedMatches)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("%s: %d steps and %d matches completed, golden %d and %d"), *Name, Played.NumSteps,
+                   Played.NumCompletedMatches, Golden.NumSteps, Golden.NumCompletedMatches);
+            bMatches = false;
+        }
+
+        return bMatches;
+    }
+
+    /** Compares the throughput to the baseline, or records it with -UpdateBaseline. Returns false if it regressed. */
+    bool CheckThroughput(double TicksPerSecond, bool bUpdateBaseline)
+    {
+        const FString BaselineFileName = CubePerfBaseline::GetFileName();
+
+        if(bUpdateBaseline)
+        {
+            TArray<FString> Keys;
+            TArray<FString> Values;
+            Keys.Add(TEXT("TicksPerSecond"));
+            Values.Add(FString::Printf(TEXT("%.0f"), TicksPerSecond));
+
+            if(!CubePerfBaseline::SetValues(BaselineFileName, BASELINE_SECTION, Keys, Values))
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("Could not write the baseline to %s"), *BaselineFileName);
+                return false;
+            }
+
+            UE_LOG(LogCubeProject, Display, TEXT("Baseline written to %s"), *BaselineFileName);
+            return true;
+        }
+
+        FConfigFile Baseline;
+        Baseline.Read(BaselineFileName);
+
+        FString BaselineString;
+
+        if(!Baseline.GetString(BASELINE_SECTION, TEXT("TicksPerSecond"), BaselineString))
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("No throughput baseline. Run with -UpdateBaseline on the reference machine to record one."));
+            return false;
+        }
+
+        FString ToleranceString;
+        const float Tolerance = Baseline.GetString(BASELINE_SECTION, TEXT("Tolerance"), ToleranceString) ? FCString::Atof(*ToleranceString)
+                                                                                                          : DEFAULT_TOLERANCE;
+        const double Expected = FCString::Atod(*BaselineString);
+        const double Limit = Expected * (1.0 - Tolerance);
+
+        if(TicksPerSecond < Limit)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("Throughput regressed: %.0f ticks per second, baseline %.0f (limit %.0f)"), TicksPerSecond, Expected, Limit);
+            return false;
+        }
+
+        UE_LOG(LogCubeProject, Display, TEXT("Throughput within the baseline of %.0f ticks per second"), Expected);
+        return true;
+    }
+}
+
+UGoldenReplaysCommandlet::UGoldenReplaysCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UGoldenReplaysCommandlet::Main(const FString& Params)
+{
+    FString Directory = CubeGoldenReplay::GetCorpusDir();
+    int32 NumRepeats = 5;
+
+    FParse::Value(*Params, TEXT("dir="), Directory);
+    FParse::Value(*Params, TEXT("repeat="), NumRepeats);
+
+    if(NumRepeats < 1)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=GoldenReplays [-dir=<directory>] [-repeat=<count>] [-UpdateBaseline] | -record [-dir=<directory>]"));
+        return 2;
+    }
+
+    if(FParse::Param(*Params, TEXT("record")))
+    {
+        return RecordCorpus(Directory);
+    }
+
+    TArray<FString> FileNames;
+    IFileManager::Get().FindFiles(FileNames, *(Directory / TEXT("*.gsrp")), true, false);
+    FileNames.Sort();
+
+    if(FileNames.Num() == 0)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("No golden replays in %s: run -run=GoldenReplays -record first"), *Directory);
+        return 2;
+    }
+
+    TArray<FGoldenReplayFile> Files;
+    Files.SetNum(FileNames.Num());
+
+    for(int32 Index = 0; Index < FileNames.Num(); Index++)
+    {
+        FGoldenReplayFile& File = Files[Index];
+        File.Name = FPaths::GetBaseFilename(FileNames[Index]);
+
+        const FString BaseName = Directory / File.Name;
+
+        if(!CubeReplay::LoadFromFile(BaseName + TEXT(".gsrp"), File.Replay) || !CubeGoldenReplay::LoadFromFile(BaseName + TEXT(".gsgd"), File.Golden))
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("%s is not a valid golden replay"), *BaseName);
+            return 2;
+        }
+    }
+
+    // Check every replay against its golden values
+    int32 NumMismatches = 0;
+    FCubeGoldenValues Played;
+
+    for(const FGoldenReplayFile& File : Files)
+    {
+        CubeGoldenReplay::Play(File.Replay, File.Golden.Hashes.Num(), true, Played);
+
+        if(CompareToGolden(File.Name, File.Golden, Played))
+        {
+            UE_LOG(LogCubeProject, Display, TEXT("%s: %d ticks, %d goals, final score %d-%d"), *File.Name, File.Golden.Hashes.Num(),
+                   File.Golden.Goals.Num(), File.Golden.FinalScores[0], File.Golden.FinalScores[1]);
+        }
+        else
+        {
+            NumMismatches++;
+        }
+    }
+
+    // Time the replays without hashing, which the game does not pay for
+    uint64 TotalTicks = 0;
+    double TotalSeconds = 0.0;
+
+    for(const FGoldenReplayFile& File : Files)
+    {
+        const double StartTime = FPlatformTime::Seconds();
+
+        for(int32 Repeat = 0; Repeat < NumRepeats; Repeat++)
+        {
+            CubeGoldenReplay::Play(File.Replay, File.Golden.Hashes.Num(), false, Played);
+        }
+
+        const double Seconds = FMath::Max(FPlatformTime::Seconds() - StartTime, 1e-6);
+        const uint64 NumTicks = (uint64)File.Golden.Hashes.Num() * NumRepeats;
+        TotalTicks += NumTicks;
+        TotalSeconds += Seconds;
+
+        UE_LOG(LogCubeProject, Display, TEXT("%s: %.0f ticks per second"), *File.Name, NumTicks / Seconds);
+    }
+
+    const double TicksPerSecond = TotalTicks / TotalSeconds;
+    UE_LOG(LogCubeProject, Display, TEXT("%d golden replays, %d mismatched; %llu ticks in %.2f seconds: %.0f ticks per second"), Files.Num(),
+           NumMismatches, TotalTicks, TotalSeconds, TicksPerSecond);
+
+    const bool bThroughputOk = CheckThroughput(TicksPerSecond, FParse::Param(*Params, TEXT("UpdateBaseline")));
+    return (NumMismatches == 0 && bThroughputOk) ? 0 : 1;
+}
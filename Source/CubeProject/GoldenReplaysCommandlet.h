@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "GoldenReplaysCommandlet.generated.h"
+
+/**
+ * Plays every replay of the CubeSim golden corpus (Content/GoldenReplays, see CubeGoldenReplay.h) back through the game
+ * flow and the match simulation, headless, and checks that each gives its golden goal ticks, final scores and per-tick
+ * state hashes. The replays are then played again, without hashing, to report the throughput in ticks per second, which
+ * is compared to the [GoldenReplays] section of Config/PerfBaseline.ini. A missing baseline fails the run.
+ *
+ * The replays never spawn the match actors: they check the rules and the game flow of the simulation, not ABall,
+ * ACubePawn or the game mode (see CubeGoldenReplay.h).
+ *
+ * With -record, the corpus is recorded again from its scenarios instead. Only do so after a deliberate gameplay change.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=GoldenReplays [-dir=<directory>] [-repeat=<count>] [-UpdateBaseline]
+ *        UE4Editor-Cmd CubeProject -run=GoldenReplays -record [-dir=<directory>]
+ *
+ * Returns 0 if every replay matched its golden values at the expected speed, 1 if one did not and 2 on invalid arguments
+ * or an unreadable corpus.
+ */
+UCLASS()
+class UGoldenReplaysCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UGoldenReplaysCommandlet();
+
+    // Checks or records the corpus
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,170 @@
+#include "CubeProject.h"
+#include "HostedBotMatchBenchCommandlet.h"
+#include "CubeBotMatchScheduler.h"
+#include "CubeHostedMatch.h"
+#include "CubeMctsBot.h"
+#include "CubeArenaGeometry.h"
+#include "CubeArenaGenerator.h"
+
+UHostedBotMatchBenchCommandlet::UHostedBotMatchBenchCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UHostedBotMatchBenchCommandlet::Main(const FString& Params)
+{
+    int32 NumMatches = 256;
+    int32 NumPlayers = 2;
+    int32 ScoreToWin = 3;
+    int32 NumMctsMatches = 0;
+    float Duration = 30.0f;
+    float BudgetMilliseconds = 2.0f;
+    FString ArenaName;
+
+    FParse::Value(*Params, TEXT("matches="), NumMatches);
+    FParse::Value(*Params, TEXT("players="), NumPlayers);
+    FParse::Value(*Params, TEXT("scoretowin="), ScoreToWin);
+    FParse::Value(*Params, TEXT("mcts="), NumMctsMatches);
+    FParse::Value(*Params, TEXT("duration="), Duration);
+    FParse::Value(*Params, TEXT("budget="), BudgetMilliseconds);
+    FParse::Value(*Params, TEXT("arena="), ArenaName);
+
+    const bool bGenerateArenas = FParse::Param(*Params, TEXT("generatearena"));
+    uint64 ArenaSeed = 0;
+    const bool bSharedArena = FParse::Value(*Params, TEXT("ArenaSeed="), ArenaSeed);
+
+    if(NumMatches <= 0 || NumPlayers < 1 || NumPlayers > FCubePlayerRegistry::MAX_PLAYERS || Duration <= 0.0f || (bGenerateArenas && !ArenaName.IsEmpty()))
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=HostedBotMatchBench [-matches=<count>] [-players=<1-8>] [-duration=<seconds>] [-budget=<milliseconds>] ")
+                                      TEXT("[-scoretowin=<goals>] [-mcts=<count>] [-arena=<map> | -generatearena [-ArenaSeed=<seed>] [<arena parameters>]]"));
+        return 2;
+    }
+
+    // Every match shares the same read-only arena and tuning
+    FCubeSimConfig Config;
+    FCubeArenaGeometry Geometry;
+
+    if(!ArenaName.IsEmpty())
+    {
+        if(!Geometry.LoadFromFile(FCubeArenaGeometry::GetFileName(ArenaName)))
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("No cooked collision for %s: run -run=CookArenaCollision -maps=%s first"), *ArenaName, *ArenaName);
+            return 2;
+        }
+
+        Config.Arena = Geometry.GetArena();
+        Config.Geometry = &Geometry;
+        UE_LOG(LogCubeProject, Display, TEXT("Hosting the matches in %s (%d wall primitives)"), *ArenaName, Geometry.NumPrimitives());
+    }
+
+    const uint64 BaseSeed = FPlatformTime::Cycles64();
+    const int32 NumWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+
+    // Each match plays its own generated arena, drawn from the match's seed, unless every match shares the given one. The
+    // arrays are sized up front, as the matches keep references to their config.
+    FCubeArenaParams ArenaParams;
+    ArenaParams.NumPlayers = NumPlayers;
+    CubeArenaGenerator::ParseParams(*Params, ArenaParams);
+
+    const int32 NumArenas = bGenerateArenas ? (bSharedArena ? 1 : NumMatches) : 0;
+    TArray<FCubeSimConfig> ArenaConfigs;
+    TArray<FCubeArenaGeometry> ArenaGeometries;
+    ArenaConfigs.Init(Config, NumArenas);
+    ArenaGeometries.SetNum(NumArenas);
+
+    if(NumArenas > 0)
+    {
+        FCubeGeneratedArena GeneratedArena;
+        const double GenerateStartTime = FPlatformTime::Seconds();
+
+        for(int32 Index = 0; Index < NumArenas; Index++)
+        {
+            if(!bSharedArena)
+            {
+                ArenaParams.Seed = FCubeRandomStream::Mix(BaseSeed + Index);
+            }
+
+            CubeArenaGenerator::Generate(ArenaParams, GeneratedArena);
+            CubeArenaGenerator::BuildGeometry(GeneratedArena, ArenaGeometries[Index]);
+            ArenaConfigs[Index].Arena = GeneratedArena.Arena;
+            ArenaConfigs[Index].Geometry = &ArenaGeometries[Index];
+        }
+
+        UE_LOG(LogCubeProject, Display, TEXT("Generated %d arenas in %.1f us each"), NumArenas,
+               1000000.0 * (FPlatformTime::Seconds() - GenerateStartTime) / NumArenas);
+    }
+
+    FCubeBotMatchScheduler Scheduler(Config.TickDuration, BudgetMilliseconds / 1000.0);
+
+    // Measure the memory of the matches from the process' point of view, allocator overhead included
+    const uint64 UsedMemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+    const double StartTime = FPlatformTime::Seconds();
+
+    for(int32 Index = 0; Index < NumMatches; Index++)
+    {
+        const FCubeSimConfig& MatchConfig = (NumArenas > 0) ? ArenaConfigs[FMath::Min(Index, NumArenas - 1)] : Config;
+        FCubeHostedMatch* Match = new FCubeHostedMatch(MatchConfig, NumPlayers, ScoreToWin, FCubeRandomStream::Mix(BaseSeed + Index));
+
+        // The search bots use a single worker each: the scheduler already runs one match per core
+        if(Index < NumMctsMatches && NumPlayers > 1)
+        {
+            Match->SetBot(1, MakeShareable(new FCubeMctsBot(BudgetMilliseconds * 0.5f, 0, 1)));
+        }
+
+        Scheduler.AddMatch(Match, StartTime);
+    }
+
+    const uint64 UsedMemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+
+    UE_LOG(LogCubeProject, Display, TEXT("Hosting %d matches of %d players on %d workers (%.1f ms budget per match and update)"), NumMatches, NumPlayers,
+           NumWorkers, BudgetMilliseconds);
+
+    const double EndTime = StartTime + Duration;
+    double NextReportTime = StartTime + 5.0;
+    FCubeBotMatchSchedulerStats LastStats;
+
+    while(FPlatformTime::Seconds() < EndTime && !GIsRequestingExit)
+    {
+        Scheduler.Update(FPlatformTime::Seconds());
+
+        const double Now = FPlatformTime::Seconds();
+
+        if(Now >= NextReportTime)
+        {
+            const FCubeBotMatchSchedulerStats& Stats = Scheduler.GetStats();
+
+            UE_LOG(LogCubeProject, Display, TEXT("%.0f ticks/s, %.2f cores busy, %llu ticks dropped, %llu budget overruns, %d ticks behind at worst"),
+                   (Stats.TicksSimulated - LastStats.TicksSimulated) / 5.0, (Stats.BusySeconds - LastStats.BusySeconds) / 5.0,
+                   Stats.TicksDropped - LastStats.TicksDropped, Stats.BudgetOverruns - LastStats.BudgetOverruns, Stats.MaxOwedTicks);
+
+            LastStats = Stats;
+            NextReportTime += 5.0;
+        }
+
+        // Sleep until the next tick is due
+        FPlatformProcess::Sleep(FMath::Max(Config.TickDuration - (float)(FPlatformTime::Seconds() - Now), 0.0f));
+    }
+
+    const double WallSeconds = FPlatformTime::Seconds() - StartTime;
+    const FCubeBotMatchSchedulerStats& Stats = Scheduler.GetStats();
+    const double BusyCores = Stats.BusySeconds / WallSeconds;
+    int32 NumCompletedMatches = 0;
+
+    for(int32 Index = 0; Index < Scheduler.Num(); Index++)
+    {
+        NumCompletedMatches += Scheduler.GetMatch(Index).GetNumCompletedMatches();
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("Simulated %llu ticks in %.1f s (%.1f%% of real time), %d matches completed"), Stats.TicksSimulated, WallSeconds,
+           100.0 * Stats.TicksSimulated / (NumMatches * WallSeconds / Config.TickDuration), NumCompletedMatches);
+    UE_LOG(LogCubeProject, Display, TEXT("%.1f us per match tick, %.2f cores busy: %.0f matches per core in real time"),
+           Stats.TicksSimulated > 0 ? 1000000.0 * Stats.BusySeconds / Stats.TicksSimulated : 0.0, BusyCores,
+           Stats.BusySeconds > 0.0 ? Stats.TicksSimulated * Config.TickDuration / Stats.BusySeconds : 0.0);
+    UE_LOG(LogCubeProject, Display, TEXT("Memory per match: %u bytes for the match object, %.1f KB in the process"), (uint32)sizeof(FCubeHostedMatch),
+           (UsedMemoryAfter > UsedMemoryBefore) ? (UsedMemoryAfter - UsedMemoryBefore) / 1024.0 / NumMatches : 0.0);
+
+    return 0;
+}
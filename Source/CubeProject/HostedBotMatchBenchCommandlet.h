@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "HostedBotMatchBenchCommandlet.generated.h"
+
+/**
+ * Benchmarks hosting many concurrent bot matches in one process (see FCubeBotMatchScheduler), and reports how many matches
+ * a core can step in real time and how much memory each match needs. It is not a server players can join: there is no
+ * session, connection or replication, and every player is a bot. The matches run the match simulation (see
+ * FCubeHostedMatch), whose pawns don't collide with each other, unlike the pawns of ACubeProjectGameMode's matches.
+ *
+ * Matches are played on the default arena by scripted bots, or within the cooked walls of a level with -arena=<map> (see
+ * UCookArenaCollisionCommandlet); with -mcts=<count>, the first matches are played by a search bot in slot 1 to load the
+ * scheduler with uneven matches. With -generatearena, each match plays an arena generated from its seed, or every match
+ * plays the arena of -ArenaSeed=<seed>; the other parameters of the arenas are read by CubeArenaGenerator::ParseParams().
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=HostedBotMatchBench [-matches=<count>] [-players=<count>] [-duration=<seconds>]
+ *        [-budget=<milliseconds>] [-scoretowin=<goals>] [-mcts=<count>] [-arena=<map> | -generatearena [-ArenaSeed=<seed>]]
+ *
+ * Returns 0 once the matches ran for the given duration, and 2 on invalid arguments.
+ */
+UCLASS()
+class UHostedBotMatchBenchCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UHostedBotMatchBenchCommandlet();
+
+    // Runs the benchmark
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,120 @@
+#include "CubeProject.h"
+#include "LiveBridgeProbeCommandlet.h"
+#include "CubeLiveBridge.h"
+#include "CubePlayerRegistry.h"
+
+ULiveBridgeProbeCommandlet::ULiveBridgeProbeCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 ULiveBridgeProbeCommandlet::Main(const FString& Params)
+{
+    FString Name = FCubeLiveBridge::DEFAULT_NAME;
+    int32 Slot = 1;
+    float Duration = 10.0f;
+
+    FParse::Value(*Params, TEXT("name="), Name);
+    FParse::Value(*Params, TEXT("slot="), Slot);
+    FParse::Value(*Params, TEXT("duration="), Duration);
+
+    if(!FCubePlayerRegistry::IsValidSlot(Slot))
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=LiveBridgeProbe [-name=<region>] [-slot=<0-7>] [-duration=<seconds>]"));
+        return 2;
+    }
+
+    FCubeLiveBridge Bridge;
+
+    if(!Bridge.Open(Name, false))
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Could not open the live bridge '%s'. Is the game running with -LiveBridge?"), *Name);
+        return 2;
+    }
+
+    FCubeLiveState State;
+    uint32 LastFrameNumber = 0;
+    uint32 NextSequence = 1;
+    uint32 InFlightSequence = 0;
+    double InFlightPushTime = 0.0;
+    int32 NumReads = 0;
+    int32 NumFailedReads = 0;
+    int32 NumFrames = 0;
+    double ReadSeconds = 0.0;
+    TArray<double> RoundTrips;
+
+    const double EndTime = FPlatformTime::Seconds() + Duration;
+
+    while(FPlatformTime::Seconds() < EndTime)
+    {
+        NumReads++;
+
+        const double ReadStartTime = FPlatformTime::Seconds();
+        const bool bRead = Bridge.ReadState(State);
+        ReadSeconds += FPlatformTime::Seconds() - ReadStartTime;
+
+        if(!bRead)
+        {
+            NumFailedReads++;
+            continue;
+        }
+
+        // Time the round trip of the input in flight once a published state acknowledges it
+        if(InFlightSequence != 0 && State.Pawns[Slot].LastInputSequence >= InFlightSequence)
+        {
+            RoundTrips.Add(FPlatformTime::Seconds() - InFlightPushTime);
+            InFlightSequence = 0;
+        }
+
+        if(State.FrameNumber == LastFrameNumber)
+        {
+            // Yield until the game publishes its next frame
+            FPlatformProcess::Sleep(0.0f);
+            continue;
+        }
+
+        LastFrameNumber = State.FrameNumber;
+        NumFrames++;
+
+        // Steer the pawn towards the ball, with one input in flight at a time
+        if(InFlightSequence == 0 && Slot < State.NumPlayers)
+        {
+            const FCubeLivePawnState& Pawn = State.Pawns[Slot];
+            const FVector2D ToBall = FVector2D(State.BallLocationY - Pawn.LocationY, State.BallLocationZ - Pawn.LocationZ).GetSafeNormal();
+
+            FCubeLiveInput Input;
+            Input.Sequence = NextSequence++;
+            Input.Slot = (int8)Slot;
+            Input.MoveX = (int8)FMath::RoundToInt(ToBall.X * 127.0f);
+            Input.MoveY = (int8)FMath::RoundToInt(ToBall.Y * 127.0f);
+            Input.bSpin = 0;
+
+            if(Bridge.PushInput(Input))
+            {
+                InFlightSequence = Input.Sequence;
+                InFlightPushTime = FPlatformTime::Seconds();
+            }
+        }
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("Read %d states in %.2f us on average (%d failed, %u torn copies retried) over %d published frames"),
+           NumReads, ReadSeconds * 1000000.0 / FMath::Max(NumReads, 1), NumFailedReads, Bridge.GetNumTornReads(), NumFrames);
+
+    if(RoundTrips.Num() > 0)
+    {
+        // The round trip includes the wait for the game's next frame, which dominates it
+        RoundTrips.Sort();
+        UE_LOG(LogCubeProject, Display, TEXT("Input round trip over %d inputs: p50 %.1f us, p99 %.1f us, max %.1f us"), RoundTrips.Num(),
+               RoundTrips[RoundTrips.Num() / 2] * 1000000.0, RoundTrips[(RoundTrips.Num() * 99) / 100] * 1000000.0,
+               RoundTrips.Last() * 1000000.0);
+    }
+    else
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("No input was acknowledged. Is slot %d in use?"), Slot);
+    }
+
+    return 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "LiveBridgeProbeCommandlet.generated.h"
+
+/**
+ * Connects to a game running with -LiveBridge as an external tool would, and drives one pawn towards the ball through the
+ * live state bridge. Reports how often the state could be read, how many reads overlapped a write, and the round trip of
+ * the inputs: the time from pushing an input to reading a published state which acknowledges it.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=LiveBridgeProbe [-name=<region>] [-slot=<slot>] [-duration=<seconds>]
+ *
+ * Returns 0 once the probe ran for the given duration, and 2 if the region can't be opened.
+ */
+UCLASS()
+class ULiveBridgeProbeCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    ULiveBridgeProbeCommandlet();
+
+    // Runs the probe
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,211 @@
+#include "CubeProject.h"
+#include "MallocCounter.h"
+#include "PlatformStackWalk.h"
+
+FMallocCounter* FMallocCounter::Instance = NULL;
+
+FMallocCounter::FMallocCounter(FMalloc* InInnerMalloc)
+    : InnerMalloc(InInnerMalloc)
+    , NumAllocations(0)
+    , NumAllocatedBytes(0)
+    , NumGameplayAllocations(0)
+    , NumGameplayAllocatedBytes(0)
+    , GameplayScopeDepth(0)
+    , EngineScopeDepth(0)
+    , bCaptureCallsites(false)
+    , bInRecordCallsite(false)
+    , Callsites(NULL)
+    , NumUnrecordedAllocations(0)
+{
+}
+
+void FMallocCounter::Install()
+{
+    if(Instance || !GMalloc)
+        return;
+
+    // Memory allocated before the counter was installed is freed through the counter, which forwards it to the same allocator
+    Instance = new FMallocCounter(GMalloc);
+    GMalloc = Instance;
+}
+
+void FMallocCounter::SetCaptureCallsites(bool bCapture)
+{
+    // The table is allocated behind the counter's back, so that it is not counted as an allocation of the caller
+    if(bCapture && !Callsites)
+    {
+        Callsites = (FCallsite*)InnerMalloc->Malloc(MAX_CALLSITES * sizeof(FCallsite), alignof(FCallsite));
+        FMemory::Memzero(Callsites, MAX_CALLSITES * sizeof(FCallsite));
+    }
+
+    bCaptureCallsites = bCapture;
+}
+
+void FMallocCounter::RecordCallsite(SIZE_T Size)
+{
+    if(bInRecordCallsite || !Callsites)
+        return;
+
+    bInRecordCallsite = true;
+
+    uint64 BackTrace[CALLSITE_SKIPPED_FRAMES + CALLSITE_DEPTH];
+    FMemory::Memzero(BackTrace, sizeof(BackTrace));
+    FPlatformStackWalk::CaptureStackBackTrace(BackTrace, ARRAY_COUNT(BackTrace));
+
+    const uint64* Frames = BackTrace + CALLSITE_SKIPPED_FRAMES;
+    const uint32 Hash = FCrc::MemCrc32(Frames, CALLSITE_DEPTH * sizeof(uint64));
+    bool bRecorded = false;
+
+    // Open addressing: probe from the callsite's hash until its slot or a free slot is found
+    for(int32 Probe = 0; Probe < MAX_CALLSITES && !bRecorded; Probe++)
+    {
+        FCallsite& Callsite = Callsites[(Hash + Probe) & (MAX_CALLSITES - 1)];
+
+        if(Callsite.NumAllocations == 0)
+        {
+            FMemory::Memcpy(Callsite.BackTrace, Frames, sizeof(Callsite.BackTrace));
+            Callsite.Hash = Hash;
+        }
+        else if(Callsite.Hash != Hash || FMemory::Memcmp(Callsite.BackTrace, Frames, sizeof(Callsite.BackTrace)) != 0)
+        {
+            continue;
+        }
+
+        Callsite.NumAllocations++;
+        Callsite.NumAllocatedBytes += Size;
+        bRecorded = true;
+    }
+
+    if(!bRecorded)
+    {
+        NumUnrecordedAllocations++;
+    }
+
+    bInRecordCallsite = false;
+}
+
+void FMallocCounter::DumpGameplayCallsites(FOutputDevice& Ar, int32 MaxCallsites) const
+{
+    Ar.Logf(TEXT("FMallocCounter: %llu gameplay allocations, %llu bytes"), NumGameplayAllocations, NumGameplayAllocatedBytes);
+
+    if(!Callsites)
+    {
+        Ar.Logf(TEXT("FMallocCounter: callsites were not recorded. Run with -AllocTrace to record them."));
+        return;
+    }
+
+    TArray<int32> Indices;
+
+    for(int32 Index = 0; Index < MAX_CALLSITES; Index++)
+    {
+        if(Callsites[Index].NumAllocations > 0)
+        {
+            Indices.Add(Index);
+        }
+    }
+
+    Indices.Sort([this](int32 A, int32 B) { return Callsites[A].NumAllocations > Callsites[B].NumAllocations; });
+
+    FPlatformStackWalk::InitStackWalking();
+
+    for(int32 Rank = 0; Rank < FMath::Min(Indices.Num(), MaxCallsites); Rank++)
+    {
+        const FCallsite& Callsite = Callsites[Indices[Rank]];
+        Ar.Logf(TEXT("  %u allocations, %llu bytes:"), Callsite.NumAllocations, Callsite.NumAllocatedBytes);
+
+        for(int32 Depth = 0; Depth < CALLSITE_DEPTH && Callsite.BackTrace[Depth] != 0; Depth++)
+        {
+            ANSICHAR Symbol[1024];
+            Symbol[0] = 0;
+            FPlatformStackWalk::ProgramCounterToHumanReadableString(Depth, Callsite.BackTrace[Depth], Symbol, ARRAY_COUNT(Symbol));
+            Ar.Logf(TEXT("    %s"), ANSI_TO_TCHAR(Symbol));
+        }
+    }
+
+    if(NumUnrecordedAllocations > 0)
+    {
+        Ar.Logf(TEXT("  %llu allocations were not recorded because every callsite was in use"), NumUnrecordedAllocations);
+    }
+}
+
+void* FMallocCounter::Malloc(SIZE_T Size, uint32 Alignment)
+{
+    CountAllocation(Size);
+    return InnerMalloc->Malloc(Size, Alignment);
+}
+
+void* FMallocCounter::Realloc(void* Original, SIZE_T Size, uint32 Alignment)
+{
+    // Only a realloc which allocates a block, or grows one, counts as an allocation. Shrinking a block, or freeing it with a
+    // size of 0, does not. A block whose size the allocator can't tell is counted.
+    SIZE_T OriginalSize = 0;
+
+    if(Size > 0 && (!Original || !InnerMalloc->GetAllocationSize(Original, OriginalSize) || Size > OriginalSize))
+    {
+        CountAllocation(Size);
+    }
+
+    return InnerMalloc->Realloc(Original, Size, Alignment);
+}
+
+void FMallocCounter::Free(void* Original)
+{
+    InnerMalloc->Free(Original);
+}
+
+bool FMallocCounter::GetAllocationSize(void* Original, SIZE_T& SizeOut)
+{
+    return InnerMalloc->GetAllocationSize(Original, SizeOut);
+}
+
+void FMallocCounter::Trim()
+{
+    InnerMalloc->Trim();
+}
+
+void FMallocCounter::SetupTLSCachesOnCurrentThread()
+{
+    InnerMalloc->SetupTLSCachesOnCurrentThread();
+}
+
+void FMallocCounter::ClearAndDisableTLSCachesOnCurrentThread()
+{
+    InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+}
+
+void FMallocCounter::InitializeStatsMetadata()
+{
+    InnerMalloc->InitializeStatsMetadata();
+}
+
+void FMallocCounter::UpdateStats()
+{
+    InnerMalloc->UpdateStats();
+}
+
+void FMallocCounter::GetAllocatorStats(FGenericMemoryStats& OutStats)
+{
+    InnerMalloc->GetAllocatorStats(OutStats);
+}
+
+void FMallocCounter::DumpAllocatorStats(FOutputDevice& Ar)
+{
+    Ar.Logf(TEXT("FMallocCounter: %llu allocations, %llu bytes on the game thread"), NumAllocations, NumAllocatedBytes);
+    DumpGameplayCallsites(Ar);
+    InnerMalloc->DumpAllocatorStats(Ar);
+}
+
+bool FMallocCounter::IsInternallyThreadSafe() const
+{
+    return InnerMalloc->IsInternallyThreadSafe();
+}
+
+bool FMallocCounter::ValidateHeap()
+{
+    return InnerMalloc->ValidateHeap();
+}
+
+const TCHAR* FMallocCounter::GetDescriptiveName()
+{
+    return InnerMalloc->GetDescriptiveName();
+}
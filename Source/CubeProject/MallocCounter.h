@@ -0,0 +1,171 @@
+#pragma once
+
+/**
+ * Allocator proxy which counts the allocations made on the game thread. Installed in front of GMalloc at startup when a
+ * run needs allocation numbers (e.g., -PerfSuite or -AllocTrace), since counting adds a small cost to every allocation.
+ *
+ * The allocations made inside an FGameplayAllocationScope are also counted as gameplay allocations. Gameplay code is meant
+ * to allocate nothing while a match is played, which the performance suite enforces. With -AllocTrace, the callstack of
+ * every gameplay allocation is recorded as well, and the most frequent ones are written to the log at exit.
+ */
+class CUBEPROJECT_API FMallocCounter : public FMalloc
+{
+public:
+    /** Installs the counter in front of the current allocator. Does nothing if it is already installed. */
+    static void Install();
+
+    /** Returns the installed counter, or NULL if allocations are not being counted. */
+    static FMallocCounter* Get() { return Instance; }
+
+    /** Returns the number of allocations made on the game thread since startup. */
+    FORCEINLINE uint64 GetNumAllocations() const { return NumAllocations; }
+    /** Returns the number of bytes allocated on the game thread since startup. */
+    FORCEINLINE uint64 GetNumAllocatedBytes() const { return NumAllocatedBytes; }
+
+    /** Returns the number of allocations made by gameplay code since startup. */
+    FORCEINLINE uint64 GetNumGameplayAllocations() const { return NumGameplayAllocations; }
+    /** Returns the number of bytes allocated by gameplay code since startup. */
+    FORCEINLINE uint64 GetNumGameplayAllocatedBytes() const { return NumGameplayAllocatedBytes; }
+
+    /** Starts or stops recording the callstack of every gameplay allocation. Must be called on the game thread. */
+    void SetCaptureCallsites(bool bCapture);
+    /** Returns true if the callstacks of gameplay allocations are being recorded. */
+    FORCEINLINE bool IsCapturingCallsites() const { return Callsites != NULL && bCaptureCallsites; }
+
+    /** Writes the recorded callsites of gameplay allocations, the most frequent first. */
+    void DumpGameplayCallsites(FOutputDevice& Ar, int32 MaxCallsites = 16) const;
+
+    // FMalloc interface
+    virtual void* Malloc(SIZE_T Size, uint32 Alignment) override;
+    virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override;
+    virtual void Free(void* Original) override;
+    virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override;
+    virtual void Trim() override;
+    virtual void SetupTLSCachesOnCurrentThread() override;
+    virtual void ClearAndDisableTLSCachesOnCurrentThread() override;
+    virtual void InitializeStatsMetadata() override;
+    virtual void UpdateStats() override;
+    virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override;
+    virtual void DumpAllocatorStats(FOutputDevice& Ar) override;
+    virtual bool IsInternallyThreadSafe() const override;
+    virtual bool ValidateHeap() override;
+    virtual const TCHAR* GetDescriptiveName() override;
+
+private:
+    friend class FGameplayAllocationScope;
+    friend class FEngineAllocationScope;
+
+    /** The number of callsites which can be recorded. A power of two, since callsites are found by their hash. */
+    static constexpr int32 MAX_CALLSITES = 256;
+    /** The number of frames recorded for each callsite. */
+    static constexpr int32 CALLSITE_DEPTH = 12;
+    /** The number of frames skipped at the top of each callstack, which are inside the allocator. */
+    static constexpr int32 CALLSITE_SKIPPED_FRAMES = 4;
+
+    /** A callstack which allocated in gameplay code. */
+    struct FCallsite
+    {
+        uint64 BackTrace[CALLSITE_DEPTH];
+        uint32 Hash;
+        uint32 NumAllocations;
+        uint64 NumAllocatedBytes;
+    };
+
+    explicit FMallocCounter(FMalloc* InInnerMalloc);
+
+    /** Counts an allocation if it is made on the game thread. Only the game thread writes the counters. */
+    FORCEINLINE void CountAllocation(SIZE_T Size)
+    {
+        if(FPlatformTLS::GetCurrentThreadId() == GGameThreadId)
+        {
+            NumAllocations++;
+            NumAllocatedBytes += Size;
+
+            if(GameplayScopeDepth > 0 && EngineScopeDepth == 0)
+            {
+                NumGameplayAllocations++;
+                NumGameplayAllocatedBytes += Size;
+
+                if(bCaptureCallsites)
+                {
+                    RecordCallsite(Size);
+                }
+            }
+        }
+    }
+
+    /** Adds a gameplay allocation to the callsite of the current callstack. */
+    void RecordCallsite(SIZE_T Size);
+
+    /** The allocator doing the actual work. */
+    FMalloc* InnerMalloc;
+
+    uint64 NumAllocations;
+    uint64 NumAllocatedBytes;
+    uint64 NumGameplayAllocations;
+    uint64 NumGameplayAllocatedBytes;
+
+    /** The number of gameplay scopes and engine scopes the game thread is in. */
+    int32 GameplayScopeDepth;
+    int32 EngineScopeDepth;
+
+    /** True while the callsites of gameplay allocations are recorded. */
+    bool bCaptureCallsites;
+    /** True while a callstack is being captured, since capturing may allocate the first time. */
+    bool bInRecordCallsite;
+    /** The recorded callsites, indexed by their hash. Allocated from the inner allocator the first time capture starts. */
+    FCallsite* Callsites;
+    /** The number of gameplay allocations which could not be recorded because every callsite is in use. */
+    uint64 NumUnrecordedAllocations;
+
+    /** The installed counter. */
+    static FMallocCounter* Instance;
+};
+
+/**
+ * Marks the code run during its lifetime as gameplay code. The allocations it makes are counted by FMallocCounter as
+ * gameplay allocations. Scopes nest, and must only be opened on the game thread.
+ */
+class FGameplayAllocationScope
+{
+public:
+    FORCEINLINE FGameplayAllocationScope()
+    {
+        if(FMallocCounter* MallocCounter = FMallocCounter::Get())
+        {
+            MallocCounter->GameplayScopeDepth++;
+        }
+    }
+
+    FORCEINLINE ~FGameplayAllocationScope()
+    {
+        if(FMallocCounter* MallocCounter = FMallocCounter::Get())
+        {
+            MallocCounter->GameplayScopeDepth--;
+        }
+    }
+};
+
+/**
+ * Marks a call from gameplay code into an engine system which allocates for its own bookkeeping, such as starting a
+ * sound or a camera shake. Its allocations still count towards the game thread totals, but not as gameplay allocations.
+ */
+class FEngineAllocationScope
+{
+public:
+    FORCEINLINE FEngineAllocationScope()
+    {
+        if(FMallocCounter* MallocCounter = FMallocCounter::Get())
+        {
+            MallocCounter->EngineScopeDepth++;
+        }
+    }
+
+    FORCEINLINE ~FEngineAllocationScope()
+    {
+        if(FMallocCounter* MallocCounter = FMallocCounter::Get())
+        {
+            MallocCounter->EngineScopeDepth--;
+        }
+    }
+};
@@ -0,0 +1,313 @@
+#include "CubeProject.h"
+#include "MatchEventLog.h"
+
+namespace
+{
+    /** Appends the raw bytes of a value to a column. */
+    template<typename T>
+    FORCEINLINE void AppendValue(TArray<uint8>& Column, const T& Value)
+    {
+        const int32 Offset = Column.AddUninitialized(sizeof(T));
+        FMemory::Memcpy(Column.GetData() + Offset, &Value, sizeof(T));
+    }
+
+    /** Computes the smallest and largest values stored in a column of type T. */
+    template<typename T>
+    void GetColumnRange(const TArray<uint8>& Column, double& OutMin, double& OutMax)
+    {
+        const T* Values = reinterpret_cast<const T*>(Column.GetData());
+        const int32 NumValues = Column.Num() / sizeof(T);
+
+        T Min = NumValues > 0 ? Values[0] : T(0);
+        T Max = Min;
+
+        for(int32 Index = 1; Index < NumValues; Index++)
+        {
+            Min = FMath::Min(Min, Values[Index]);
+            Max = FMath::Max(Max, Values[Index]);
+        }
+
+        OutMin = (double)Min;
+        OutMax = (double)Max;
+    }
+}
+
+FMatchEventLog::FMatchEventLog(const FString& InDirectory)
+    : Events(QUEUE_CAPACITY)
+    , PendingHeaders(16)
+    , Directory(InDirectory)
+    , NumEventsSinceWake(0)
+    , NumDroppedEvents(0)
+    , File(NULL)
+    , NumBlockEvents(0)
+    , BlockEventTypeMask(0)
+    , NumFileEvents(0)
+{
+    for(TArray<uint8>& Column : Columns)
+    {
+        Column.Reserve(EVENTS_PER_BLOCK * sizeof(uint32));
+    }
+
+    IFileManager::Get().MakeDirectory(*Directory, true);
+
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, TEXT("MatchEventLogWriter"), 0, TPri_BelowNormal);
+}
+
+FMatchEventLog::~FMatchEventLog()
+{
+    // Close the current match and let the writer thread write the remaining events before exiting
+    EndMatch();
+    Stop();
+
+    if(Thread)
+    {
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+}
+
+void FMatchEventLog::BeginMatch(const FString& ArenaName)
+{
+    FMatchLogFileHeader Header;
+    FMemory::Memzero(Header);
+    Header.Magic = FMatchLogFileHeader::MAGIC;
+    Header.Version = FMatchLogFileHeader::VERSION;
+    Header.NumColumns = EMatchLogColumn::Count;
+    Header.StartTime = FDateTime::UtcNow().ToUnixTimestamp();
+
+    const FGuid MatchId = FGuid::NewGuid();
+    Header.MatchId[0] = MatchId.A;
+    Header.MatchId[1] = MatchId.B;
+    Header.MatchId[2] = MatchId.C;
+    Header.MatchId[3] = MatchId.D;
+
+    FCStringAnsi::Strncpy(Header.ArenaName, TCHAR_TO_ANSI(*ArenaName), ARRAY_COUNT(Header.ArenaName));
+
+    // The header is picked up by the writer thread when it reaches the 'begin match' command in the event queue
+    if(PendingHeaders.Enqueue(Header))
+    {
+        AppendCommand(COMMAND_BEGIN_MATCH);
+    }
+}
+
+void FMatchEventLog::EndMatch()
+{
+    AppendCommand(COMMAND_END_MATCH);
+}
+
+bool FMatchEventLog::Append(const FMatchEvent& Event)
+{
+    if(!Events.Enqueue(Event))
+    {
+        NumDroppedEvents++;
+        return false;
+    }
+
+    // Only wake the writer thread once there is enough data for a full block. Otherwise, it wakes up on its own periodically.
+    if(++NumEventsSinceWake >= EVENTS_PER_BLOCK)
+    {
+        NumEventsSinceWake = 0;
+        WakeEvent->Trigger();
+    }
+
+    return true;
+}
+
+void FMatchEventLog::AppendCommand(ECommand Command)
+{
+    FMatchEvent CommandEvent;
+    FMemory::Memzero(CommandEvent);
+    CommandEvent.Type = COMMAND_EVENT_TYPE;
+    CommandEvent.Param = (int16)Command;
+
+    // Commands must never be lost. Give the writer thread time to make room in the unlikely case the queue is full.
+    while(!Events.Enqueue(CommandEvent))
+    {
+        WakeEvent->Trigger();
+        FPlatformProcess::Sleep(0.0f);
+    }
+
+    WakeEvent->Trigger();
+}
+
+uint32 FMatchEventLog::Run()
+{
+    while(StopRequested.GetValue() == 0)
+    {
+        DrainQueue();
+
+        // Sleep until a full block is ready, or write whatever has accumulated after a short while
+        WakeEvent->Wait(100);
+    }
+
+    // Write the events appended before the thread was asked to stop
+    DrainQueue();
+    CloseFile();
+
+    return 0;
+}
+
+void FMatchEventLog::Stop()
+{
+    StopRequested.Set(1);
+    WakeEvent->Trigger();
+}
+
+void FMatchEventLog::DrainQueue()
+{
+    FMatchEvent Event;
+
+    while(Events.Dequeue(Event))
+    {
+        if(Event.Type != COMMAND_EVENT_TYPE)
+        {
+            AddToBlock(Event);
+        }
+        else if(Event.Param == COMMAND_BEGIN_MATCH)
+        {
+            OpenFile();
+        }
+        else if(Event.Param == COMMAND_END_MATCH)
+        {
+            CloseFile();
+        }
+    }
+}
+
+void FMatchEventLog::AddToBlock(const FMatchEvent& Event)
+{
+    // Events appended outside of a match are not recorded
+    if(!File)
+        return;
+
+    AppendValue(Columns[EMatchLogColumn::Tick], Event.Tick);
+    AppendValue(Columns[EMatchLogColumn::Time], Event.Time);
+    AppendValue(Columns[EMatchLogColumn::EventType], Event.Type);
+    AppendValue(Columns[EMatchLogColumn::Slot], Event.Slot);
+    AppendValue(Columns[EMatchLogColumn::Param], Event.Param);
+    AppendValue(Columns[EMatchLogColumn::LocationY], Event.LocationY);
+    AppendValue(Columns[EMatchLogColumn::LocationZ], Event.LocationZ);
+    AppendValue(Columns[EMatchLogColumn::NormalY], Event.NormalY);
+    AppendValue(Columns[EMatchLogColumn::NormalZ], Event.NormalZ);
+    AppendValue(Columns[EMatchLogColumn::Speed], Event.Speed);
+    AppendValue(Columns[EMatchLogColumn::Angle], Event.Angle);
+
+    BlockEventTypeMask |= (1u << Event.Type);
+    NumBlockEvents++;
+
+    if(NumBlockEvents >= EVENTS_PER_BLOCK)
+    {
+        FlushBlock();
+    }
+}
+
+void FMatchEventLog::FlushBlock()
+{
+    if(!File || NumBlockEvents == 0)
+        return;
+
+    FMatchLogBlockHeader BlockHeader;
+    FMemory::Memzero(BlockHeader);
+    BlockHeader.Magic = FMatchLogBlockHeader::MAGIC;
+    BlockHeader.NumEvents = NumBlockEvents;
+    BlockHeader.EventTypeMask = BlockEventTypeMask;
+
+    // Compress every column on its own so that readers can decompress only the columns they need
+    TArray<uint8> BlockData;
+
+    for(int32 ColumnIndex = 0; ColumnIndex < EMatchLogColumn::Count; ColumnIndex++)
+    {
+        const TArray<uint8>& Column = Columns[ColumnIndex];
+        FMatchLogColumnChunk& Chunk = BlockHeader.Columns[ColumnIndex];
+
+        switch(ColumnIndex)
+        {
+            case EMatchLogColumn::Tick:      GetColumnRange<uint32>(Column, Chunk.Min, Chunk.Max); break;
+            case EMatchLogColumn::EventType: GetColumnRange<uint8>(Column, Chunk.Min, Chunk.Max); break;
+            case EMatchLogColumn::Slot:      GetColumnRange<int8>(Column, Chunk.Min, Chunk.Max); break;
+            case EMatchLogColumn::Param:     GetColumnRange<int16>(Column, Chunk.Min, Chunk.Max); break;
+            default:                         GetColumnRange<float>(Column, Chunk.Min, Chunk.Max); break;
+        }
+
+        int32 CompressedSize = FCompression::CompressMemoryBound(COMPRESS_ZLIB, Column.Num());
+        CompressionBuffer.SetNumUninitialized(CompressedSize, false);
+
+        const bool bCompressed = FCompression::CompressMemory(COMPRESS_ZLIB, CompressionBuffer.GetData(), CompressedSize,
+                                                              Column.GetData(), Column.Num()) && CompressedSize < Column.Num();
+
+        Chunk.Offset = BlockData.Num();
+        Chunk.UncompressedSize = Column.Num();
+        Chunk.bCompressed = bCompressed ? 1 : 0;
+        Chunk.CompressedSize = bCompressed ? CompressedSize : Column.Num();
+
+        // Store the column uncompressed if compression did not make it smaller
+        BlockData.Append(bCompressed ? CompressionBuffer.GetData() : Column.GetData(), Chunk.CompressedSize);
+    }
+
+    BlockHeader.DataSize = BlockData.Num();
+
+    BlockOffsets.Add(File->Tell());
+    File->Serialize(&BlockHeader, sizeof(BlockHeader));
+    File->Serialize(BlockData.GetData(), BlockData.Num());
+
+    NumFileEvents += NumBlockEvents;
+
+    // Start a new block
+    for(TArray<uint8>& Column : Columns)
+    {
+        Column.Reset();
+    }
+
+    NumBlockEvents = 0;
+    BlockEventTypeMask = 0;
+}
+
+void FMatchEventLog::OpenFile()
+{
+    FMatchLogFileHeader Header;
+
+    if(!PendingHeaders.Dequeue(Header))
+        return;
+
+    CloseFile();
+
+    const FString FileName = FString::Printf(TEXT("%s_%lld_%08x%08x%08x%08x.gsml"), ANSI_TO_TCHAR(Header.ArenaName), Header.StartTime,
+                                             Header.MatchId[0], Header.MatchId[1], Header.MatchId[2], Header.MatchId[3]);
+
+    File = IFileManager::Get().CreateFileWriter(*(Directory / FileName));
+
+    if(!File)
+    {
+        UE_LOG(LogCubeProject, Warning, TEXT("Could not create match event log '%s'"), *FileName);
+        return;
+    }
+
+    File->Serialize(&Header, sizeof(Header));
+}
+
+void FMatchEventLog::CloseFile()
+{
+    if(!File)
+        return;
+
+    FlushBlock();
+
+    FMatchLogTrailer Trailer;
+    FMemory::Memzero(Trailer);
+    Trailer.BlockIndexOffset = File->Tell();
+    Trailer.NumBlocks = BlockOffsets.Num();
+    Trailer.NumEvents = NumFileEvents;
+    Trailer.Magic = FMatchLogTrailer::MAGIC;
+
+    File->Serialize(BlockOffsets.GetData(), BlockOffsets.Num() * sizeof(uint64));
+    File->Serialize(&Trailer, sizeof(Trailer));
+    File->Close();
+    delete File;
+
+    File = NULL;
+    BlockOffsets.Reset();
+    NumFileEvents = 0;
+}
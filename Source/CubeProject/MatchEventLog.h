@@ -0,0 +1,99 @@
+#pragma once
+
+#include "MatchEventLogFormat.h"
+
+/**
+ * Records the gameplay events of each match to a columnar binary log (see MatchEventLogFormat.h). The game thread appends
+ * events to a lock-free single-producer/single-consumer queue, and never waits on the disk. A background thread drains
+ * the queue, groups the events into blocks, compresses each column and writes the blocks to one file per match.
+ */
+class CUBEPROJECT_API FMatchEventLog : public FRunnable
+{
+public:
+    /** The maximum number of events waiting to be written. Events appended while the queue is full are dropped. */
+    static constexpr uint32 QUEUE_CAPACITY = 65536;
+    /** The number of events stored in a full block. */
+    static constexpr int32 EVENTS_PER_BLOCK = 4096;
+
+    /** Starts the writer thread. Log files are written to the given directory. */
+    explicit FMatchEventLog(const FString& InDirectory);
+
+    /** Writes the remaining events and stops the writer thread. */
+    virtual ~FMatchEventLog();
+
+    /** Starts a new log file for a match played on the given map. Closes the file of the previous match, if any. Game thread only. */
+    void BeginMatch(const FString& ArenaName);
+
+    /** Closes the file of the current match once all of its events are written. Game thread only. */
+    void EndMatch();
+
+    /** Appends an event to the current match. Never blocks. Returns false if the event was dropped because the queue is full. Game thread only. */
+    bool Append(const FMatchEvent& Event);
+
+    /** Returns the number of events dropped because the writer thread could not keep up. */
+    FORCEINLINE uint32 GetNumDroppedEvents() const { return NumDroppedEvents; }
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    /** Marks queue entries which are commands for the writer thread rather than gameplay events. */
+    static constexpr uint8 COMMAND_EVENT_TYPE = 0xFF;
+
+    /** The commands sent to the writer thread through the event queue. Stored in the 'Param' field of a command event. */
+    enum ECommand
+    {
+        COMMAND_BEGIN_MATCH,
+        COMMAND_END_MATCH
+    };
+
+    /** Pushes a command for the writer thread into the event queue, after the events already appended. */
+    void AppendCommand(ECommand Command);
+
+    /** Writer thread: processes every event currently in the queue. */
+    void DrainQueue();
+    /** Writer thread: stores an event in the columns of the current block. */
+    void AddToBlock(const FMatchEvent& Event);
+    /** Writer thread: compresses and writes the current block to the file. */
+    void FlushBlock();
+    /** Writer thread: opens the file for the next match in 'PendingHeaders'. */
+    void OpenFile();
+    /** Writer thread: writes the current block, the block index and the trailer, then closes the file. */
+    void CloseFile();
+
+    /** The queue of events appended by the game thread. */
+    TCircularQueue<FMatchEvent> Events;
+    /** The headers of the matches started by the game thread, waiting to be opened by the writer thread. */
+    TCircularQueue<FMatchLogFileHeader> PendingHeaders;
+
+    /** The directory in which the log files are written. */
+    FString Directory;
+
+    /** The thread writing the log files. */
+    FRunnableThread* Thread;
+    /** Wakes the writer thread once a full block of events is waiting. */
+    FEvent* WakeEvent;
+    /** Set to stop the writer thread. */
+    FThreadSafeCounter StopRequested;
+
+    /** Game thread: the number of events appended since the writer thread was last woken up. */
+    int32 NumEventsSinceWake;
+    /** Game thread: the number of events dropped because the queue was full. */
+    uint32 NumDroppedEvents;
+
+    /** Writer thread: the file of the current match, or NULL if no match is being recorded. */
+    FArchive* File;
+    /** Writer thread: the data of each column of the current block. */
+    TArray<uint8> Columns[EMatchLogColumn::Count];
+    /** Writer thread: the number of events in the current block. */
+    int32 NumBlockEvents;
+    /** Writer thread: the EMatchEventType bits of the events in the current block. */
+    uint32 BlockEventTypeMask;
+    /** Writer thread: the file offset of each block written to the current file. */
+    TArray<uint64> BlockOffsets;
+    /** Writer thread: the number of events written to the current file. */
+    uint32 NumFileEvents;
+    /** Writer thread: scratch buffer holding a compressed column. */
+    TArray<uint8> CompressionBuffer;
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+/**
+ * On-disk layout of a match event log (.gsml file). A log stores the events of one match in blocks. Each block stores
+ * its events column by column, and each column is compressed on its own. A reader can therefore load only the columns
+ * a query needs. Each block header stores the min/max value of every column, so a reader can skip whole blocks
+ * without decompressing them.
+ *
+ *   FMatchLogFileHeader
+ *   Block 0:  FMatchLogBlockHeader, column 0 data, column 1 data, ...
+ *   Block 1:  ...
+ *   Block index: uint64 file offset of each block
+ *   FMatchLogTrailer
+ *
+ * All values are little-endian and the structures are written as-is, without padding.
+ */
+
+/** The type of a recorded gameplay event. */
+namespace EMatchEventType
+{
+    enum Type : uint8
+    {
+        /** The ball bounced off a wall. */
+        WallHit,
+        /** The ball bounced off a player. */
+        PlayerHit,
+        /** A player performed a spin. 'Param' holds the ERotationDirection of the spin. */
+        Spin,
+        /** A goal was scored. 'Param' holds the team which scored. */
+        Goal,
+        /** The game switched state. 'Param' holds the new EGameState. */
+        StateChange,
+
+        Count
+    };
+}
+
+/** The columns stored for each event. The order of this enum is the order of the columns in a block. */
+namespace EMatchLogColumn
+{
+    enum Type
+    {
+        Tick,
+        Time,
+        EventType,
+        Slot,
+        Param,
+        LocationY,
+        LocationZ,
+        NormalY,
+        NormalZ,
+        Speed,
+        Angle,
+
+        Count
+    };
+}
+
+/** A single gameplay event, as appended by gameplay code. Only the y and z axes are stored since the game is played on the YZ plane. */
+struct FMatchEvent
+{
+    /** The match tick at which the event occurred. */
+    uint32 Tick;
+    /** The match time, in seconds, at which the event occurred. */
+    float Time;
+    /** The EMatchEventType of the event. */
+    uint8 Type;
+    /** The slot of the player involved in the event, or -1 if no player is involved. */
+    int8 Slot;
+    /** Extra data depending on the type of the event (see EMatchEventType). */
+    int16 Param;
+    /** The location of the event on the field. */
+    float LocationY;
+    float LocationZ;
+    /** The normal of the surface hit by the ball. */
+    float NormalY;
+    float NormalZ;
+    /** The ball's speed after the event. */
+    float Speed;
+    /** For wall hits, the angle of incidence of the ball. For player hits, the angle between the bounce direction
+      * and the player's velocity. In degrees. */
+    float Angle;
+};
+
+#pragma pack(push, 1)
+
+/** Written once at the start of a log file. */
+struct FMatchLogFileHeader
+{
+    static constexpr uint32 MAGIC = 0x4C4D5347; // "GSML"
+    static constexpr uint16 VERSION = 1;
+
+    uint32 Magic;
+    uint16 Version;
+    /** The number of columns stored in each block (EMatchLogColumn::Count when the file was written). */
+    uint16 NumColumns;
+    /** Unique identifier of the match. */
+    uint32 MatchId[4];
+    /** The name of the map the match was played on, zero-terminated. */
+    ANSICHAR ArenaName[32];
+    /** The time at which the match started, in seconds since the Unix epoch. */
+    int64 StartTime;
+};
+
+/** Describes the data of one column inside a block, along with the column's range of values. */
+struct FMatchLogColumnChunk
+{
+    /** The offset of the column data, relative to the end of the block header. */
+    uint32 Offset;
+    /** The size of the column data in the file. */
+    uint32 CompressedSize;
+    /** The size of the column data once decompressed. Equal to 'CompressedSize' if the column is stored uncompressed. */
+    uint32 UncompressedSize;
+    /** Non-zero if the column data is zlib-compressed. */
+    uint32 bCompressed;
+    /** The smallest and largest values stored in the column. */
+    double Min;
+    double Max;
+};
+
+/** Written at the start of every block. */
+struct FMatchLogBlockHeader
+{
+    static constexpr uint32 MAGIC = 0x4B4C4247; // "GBLK"
+
+    uint32 Magic;
+    /** The number of events stored in the block. */
+    uint32 NumEvents;
+    /** Bit N is set if the block contains at least one event of type N. */
+    uint32 EventTypeMask;
+    /** The size of the block's column data, not counting this header. */
+    uint32 DataSize;
+    FMatchLogColumnChunk Columns[EMatchLogColumn::Count];
+};
+
+/** Written at the very end of the file. Points to the block index. */
+struct FMatchLogTrailer
+{
+    static constexpr uint32 MAGIC = 0x444E4547; // "GEND"
+
+    /** The file offset of the block index. */
+    uint64 BlockIndexOffset;
+    /** The number of blocks in the file. */
+    uint32 NumBlocks;
+    /** The total number of events in the file. */
+    uint32 NumEvents;
+    uint32 Magic;
+};
+
+#pragma pack(pop)
+
+/** Returns the size, in bytes, of a single value of the given column. */
+inline int32 GetMatchLogColumnSize(EMatchLogColumn::Type Column)
+{
+    switch(Column)
+    {
+        case EMatchLogColumn::EventType:
+        case EMatchLogColumn::Slot:
+            return 1;
+        case EMatchLogColumn::Param:
+            return 2;
+        default:
+            return 4;
+    }
+}
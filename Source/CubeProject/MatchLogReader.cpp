@@ -0,0 +1,200 @@
+#include "CubeProject.h"
+#include "MatchLogReader.h"
+
+#if PLATFORM_WINDOWS
+    #include "AllowWindowsPlatformTypes.h"
+    #include <windows.h>
+    #include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+FMatchLogReader::FMatchLogReader()
+    : Data(NULL)
+    , Size(0)
+    , FileHeader(NULL)
+    , NumBlocks(0)
+#if PLATFORM_WINDOWS
+    , FileHandle(NULL)
+    , MappingHandle(NULL)
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    , FileDescriptor(-1)
+#endif
+{
+}
+
+FMatchLogReader::~FMatchLogReader()
+{
+    Close();
+}
+
+bool FMatchLogReader::Open(const FString& FileName)
+{
+    Close();
+
+    if(!MapFile(FileName))
+        return false;
+
+    // The file must at least hold a header and a trailer
+    if(Size < (int64)(sizeof(FMatchLogFileHeader) + sizeof(FMatchLogTrailer)))
+    {
+        Close();
+        return false;
+    }
+
+    FileHeader = reinterpret_cast<const FMatchLogFileHeader*>(Data);
+
+    if(FileHeader->Magic != FMatchLogFileHeader::MAGIC || FileHeader->Version != FMatchLogFileHeader::VERSION
+       || FileHeader->NumColumns != EMatchLogColumn::Count)
+    {
+        Close();
+        return false;
+    }
+
+    FMatchLogTrailer Trailer;
+    FMemory::Memcpy(&Trailer, Data + Size - sizeof(FMatchLogTrailer), sizeof(FMatchLogTrailer));
+
+    const uint64 BlockIndexSize = (uint64)Trailer.NumBlocks * sizeof(uint64);
+
+    // A file whose trailer is missing was not closed properly (e.g., the game crashed during the match)
+    if(Trailer.Magic != FMatchLogTrailer::MAGIC || Trailer.BlockIndexOffset + BlockIndexSize + sizeof(FMatchLogTrailer) != (uint64)Size)
+    {
+        Close();
+        return false;
+    }
+
+    NumBlocks = Trailer.NumBlocks;
+    BlockHeaders.Reset(NumBlocks);
+
+    for(int32 BlockIndex = 0; BlockIndex < NumBlocks; BlockIndex++)
+    {
+        uint64 BlockOffset;
+        FMemory::Memcpy(&BlockOffset, Data + Trailer.BlockIndexOffset + BlockIndex * sizeof(uint64), sizeof(uint64));
+
+        const FMatchLogBlockHeader* BlockHeader = reinterpret_cast<const FMatchLogBlockHeader*>(Data + BlockOffset);
+
+        if(BlockOffset + sizeof(FMatchLogBlockHeader) > Trailer.BlockIndexOffset || BlockHeader->Magic != FMatchLogBlockHeader::MAGIC
+           || BlockOffset + sizeof(FMatchLogBlockHeader) + BlockHeader->DataSize > Trailer.BlockIndexOffset)
+        {
+            Close();
+            return false;
+        }
+
+        BlockHeaders.Add(BlockHeader);
+    }
+
+    return true;
+}
+
+void FMatchLogReader::Close()
+{
+    UnmapFile();
+
+    FileHeader = NULL;
+    BlockHeaders.Reset();
+    NumBlocks = 0;
+}
+
+const uint8* FMatchLogReader::ReadColumn(int32 BlockIndex, EMatchLogColumn::Type Column, TArray<uint8>& Scratch) const
+{
+    const FMatchLogBlockHeader* BlockHeader = BlockHeaders[BlockIndex];
+    const FMatchLogColumnChunk& Chunk = BlockHeader->Columns[Column];
+
+    if((uint64)Chunk.Offset + Chunk.CompressedSize > BlockHeader->DataSize
+       || Chunk.UncompressedSize != BlockHeader->NumEvents * GetMatchLogColumnSize(Column))
+    {
+        return NULL;
+    }
+
+    const uint8* ChunkData = reinterpret_cast<const uint8*>(BlockHeader + 1) + Chunk.Offset;
+
+    // Uncompressed columns are read directly from the mapped file
+    if(!Chunk.bCompressed)
+    {
+        return ChunkData;
+    }
+
+    Scratch.SetNumUninitialized(Chunk.UncompressedSize, false);
+
+    if(!FCompression::UncompressMemory(COMPRESS_ZLIB, Scratch.GetData(), Chunk.UncompressedSize, ChunkData, Chunk.CompressedSize))
+    {
+        return NULL;
+    }
+
+    return Scratch.GetData();
+}
+
+bool FMatchLogReader::MapFile(const FString& FileName)
+{
+#if PLATFORM_WINDOWS
+    FileHandle = CreateFileW(*FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if(FileHandle == INVALID_HANDLE_VALUE)
+    {
+        FileHandle = NULL;
+        return false;
+    }
+
+    LARGE_INTEGER FileSize;
+    GetFileSizeEx(FileHandle, &FileSize);
+    Size = FileSize.QuadPart;
+
+    MappingHandle = Size > 0 ? CreateFileMappingW(FileHandle, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    Data = MappingHandle ? (const uint8*)MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    FileDescriptor = open(TCHAR_TO_UTF8(*FileName), O_RDONLY);
+
+    if(FileDescriptor < 0)
+        return false;
+
+    struct stat FileStat;
+    Size = fstat(FileDescriptor, &FileStat) == 0 ? FileStat.st_size : 0;
+
+    void* Mapping = Size > 0 ? mmap(NULL, Size, PROT_READ, MAP_PRIVATE, FileDescriptor, 0) : MAP_FAILED;
+    Data = Mapping != MAP_FAILED ? (const uint8*)Mapping : NULL;
+#else
+    if(FFileHelper::LoadFileToArray(FileContents, *FileName, FILEREAD_Silent))
+    {
+        Data = FileContents.GetData();
+        Size = FileContents.Num();
+    }
+#endif
+
+    if(!Data)
+    {
+        UnmapFile();
+        return false;
+    }
+
+    return true;
+}
+
+void FMatchLogReader::UnmapFile()
+{
+#if PLATFORM_WINDOWS
+    if(Data)
+        UnmapViewOfFile(Data);
+    if(MappingHandle)
+        CloseHandle(MappingHandle);
+    if(FileHandle)
+        CloseHandle(FileHandle);
+
+    FileHandle = NULL;
+    MappingHandle = NULL;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    if(Data)
+        munmap((void*)Data, Size);
+    if(FileDescriptor >= 0)
+        close(FileDescriptor);
+
+    FileDescriptor = -1;
+#else
+    FileContents.Empty();
+#endif
+
+    Data = NULL;
+    Size = 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "MatchEventLogFormat.h"
+
+/**
+ * Reads a match event log written by FMatchEventLog. The file is memory-mapped, so only the pages holding the block
+ * headers and the columns a query touches are read from disk. Uncompressed columns are returned straight from the
+ * mapping without copying.
+ */
+class CUBEPROJECT_API FMatchLogReader
+{
+public:
+    FMatchLogReader();
+    ~FMatchLogReader();
+
+    /** Maps the given log file and validates its header, trailer and block index. Returns false if the file is not a valid log. */
+    bool Open(const FString& FileName);
+
+    /** Unmaps the current file. */
+    void Close();
+
+    /** Returns the header of the file. Only valid once Open() succeeded. */
+    FORCEINLINE const FMatchLogFileHeader& GetFileHeader() const { return *FileHeader; }
+
+    /** Returns the number of blocks in the file. */
+    FORCEINLINE int32 GetNumBlocks() const { return NumBlocks; }
+
+    /** Returns the header of the given block, which holds the min/max values of each of its columns. */
+    FORCEINLINE const FMatchLogBlockHeader& GetBlockHeader(int32 BlockIndex) const { return *BlockHeaders[BlockIndex]; }
+
+    /** Returns true if the given block contains at least one event of one of the types in the given EMatchEventType mask. */
+    FORCEINLINE bool BlockHasEventTypes(int32 BlockIndex, uint32 EventTypeMask) const { return (BlockHeaders[BlockIndex]->EventTypeMask & EventTypeMask) != 0; }
+
+    /**
+     * Returns the values of a column in the given block, or NULL if the column could not be read. Compressed columns are
+     * decompressed into 'Scratch', which can be reused between calls to avoid allocations.
+     */
+    const uint8* ReadColumn(int32 BlockIndex, EMatchLogColumn::Type Column, TArray<uint8>& Scratch) const;
+
+    /** Typed version of ReadColumn(). T must match the type of the column (see FMatchEvent). */
+    template<typename T>
+    FORCEINLINE const T* ReadColumn(int32 BlockIndex, EMatchLogColumn::Type Column, TArray<uint8>& Scratch) const
+    {
+        return reinterpret_cast<const T*>(ReadColumn(BlockIndex, Column, Scratch));
+    }
+
+private:
+    /** Maps the file into memory. Falls back to reading the whole file on platforms without memory-mapped files. */
+    bool MapFile(const FString& FileName);
+    /** Releases the mapping created by MapFile(). */
+    void UnmapFile();
+
+    /** The first byte of the mapped file. */
+    const uint8* Data;
+    /** The size of the mapped file. */
+    int64 Size;
+
+    /** Points to the file header inside the mapping. */
+    const FMatchLogFileHeader* FileHeader;
+    /** Points to the header of each block inside the mapping. */
+    TArray<const FMatchLogBlockHeader*> BlockHeaders;
+    /** The number of blocks in the file. */
+    int32 NumBlocks;
+
+#if PLATFORM_WINDOWS
+    /** Handles of the mapped file. */
+    void* FileHandle;
+    void* MappingHandle;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+    /** Descriptor of the mapped file. */
+    int32 FileDescriptor;
+#else
+    /** The contents of the file, on platforms without memory-mapped files. */
+    TArray<uint8> FileContents;
+#endif
+};
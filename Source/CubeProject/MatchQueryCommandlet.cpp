@@ -0,0 +1,349 @@
+#include "CubeProject.h"
+#include "MatchQueryCommandlet.h"
+#include "MatchLogReader.h"
+#include "CubeProjectGameState.h"
+#include "ParallelFor.h"
+
+namespace
+{
+    /** The queries supported by the commandlet. */
+    enum class EMatchQuery
+    {
+        KickoffGoals,
+        Rallies,
+        Heatmap
+    };
+
+    /** The query and the filters given on the command line. */
+    struct FMatchQueryOptions
+    {
+        EMatchQuery Query;
+        FString Arena;
+        float KickoffWindow = 2.0f;
+        int32 MinRallyHits = 20;
+        float CellSize = 50.0f;
+        float FromTime = -MAX_FLT;
+        float ToTime = MAX_FLT;
+        float MinSpeed = -MAX_FLT;
+    };
+
+    /** A match or event which satisfies the query. */
+    struct FMatchQueryRow
+    {
+        FString FileName;
+        /** The match time of the goal (kickoff-goals) or of the end of the rally (rallies). */
+        float Time;
+        /** The time since kickoff (kickoff-goals) or the number of player hits (rallies). */
+        float Value;
+    };
+
+    /** The results accumulated by one worker over its share of the files. Merged once every worker is done. */
+    struct FMatchQueryPartialResult
+    {
+        TArray<FMatchQueryRow> Rows;
+        /** The number of hits in each cell, for each arena. */
+        TMap<FString, TMap<FIntPoint, int32>> Heatmaps;
+
+        int32 NumFiles = 0;
+        int32 NumInvalidFiles = 0;
+        int64 NumBlocksRead = 0;
+        int64 NumBlocksSkipped = 0;
+        int64 NumEventsRead = 0;
+    };
+
+    /** Returns the EMatchEventType bits of the events the query needs to look at. */
+    uint32 GetRequiredEventTypes(EMatchQuery Query)
+    {
+        switch(Query)
+        {
+            case EMatchQuery::KickoffGoals:
+                return (1u << EMatchEventType::StateChange) | (1u << EMatchEventType::Goal);
+            case EMatchQuery::Rallies:
+                return (1u << EMatchEventType::StateChange) | (1u << EMatchEventType::Goal) | (1u << EMatchEventType::PlayerHit);
+            default:
+                return (1u << EMatchEventType::WallHit) | (1u << EMatchEventType::PlayerHit);
+        }
+    }
+
+    /** Returns true if the block's min/max statistics show that none of its events can satisfy the query. */
+    bool CanSkipBlock(const FMatchLogReader& Reader, int32 BlockIndex, const FMatchQueryOptions& Options)
+    {
+        if(!Reader.BlockHasEventTypes(BlockIndex, GetRequiredEventTypes(Options.Query)))
+            return true;
+
+        // Kickoffs and rallies span several blocks, so only the heatmap can skip blocks based on their time and speed
+        if(Options.Query != EMatchQuery::Heatmap)
+            return false;
+
+        const FMatchLogBlockHeader& BlockHeader = Reader.GetBlockHeader(BlockIndex);
+        const FMatchLogColumnChunk& TimeChunk = BlockHeader.Columns[EMatchLogColumn::Time];
+        const FMatchLogColumnChunk& SpeedChunk = BlockHeader.Columns[EMatchLogColumn::Speed];
+
+        return TimeChunk.Max < Options.FromTime || TimeChunk.Min > Options.ToTime || SpeedChunk.Max < Options.MinSpeed;
+    }
+
+    /** Closes a log reader when it goes out of scope, so that every way out of a scan releases the file. */
+    struct FScopedMatchLogClose
+    {
+        explicit FScopedMatchLogClose(FMatchLogReader& InReader) : Reader(InReader) {}
+        ~FScopedMatchLogClose() { Reader.Close(); }
+
+        FMatchLogReader& Reader;
+    };
+
+    /** Runs the query over a single log file, adding its results to the worker's partial result. */
+    void ScanFile(const FString& FileName, const FMatchQueryOptions& Options, FMatchLogReader& Reader, TArray<uint8>* Scratch,
+                  FMatchQueryPartialResult& Result)
+    {
+        if(!Reader.Open(FileName))
+        {
+            Result.NumInvalidFiles++;
+            return;
+        }
+
+        FScopedMatchLogClose ScopedClose(Reader);
+        const FString Arena = ANSI_TO_TCHAR(Reader.GetFileHeader().ArenaName);
+
+        // Skip the whole file if it was recorded on another map
+        if(!Options.Arena.IsEmpty() && Arena != Options.Arena)
+            return;
+
+        Result.NumFiles++;
+
+        // The state of the current rally, carried from one block to the next
+        float KickoffTime = -1.0f;
+        int32 RallyHits = 0;
+
+        TMap<FIntPoint, int32>* Heatmap = (Options.Query == EMatchQuery::Heatmap) ? &Result.Heatmaps.FindOrAdd(Arena) : NULL;
+
+        for(int32 BlockIndex = 0; BlockIndex < Reader.GetNumBlocks(); BlockIndex++)
+        {
+            if(CanSkipBlock(Reader, BlockIndex, Options))
+            {
+                Result.NumBlocksSkipped++;
+                continue;
+            }
+
+            Result.NumBlocksRead++;
+
+            const int32 NumEvents = Reader.GetBlockHeader(BlockIndex).NumEvents;
+            Result.NumEventsRead += NumEvents;
+
+            // Only decompress the columns the query uses
+            const uint8* Types = Reader.ReadColumn<uint8>(BlockIndex, EMatchLogColumn::EventType, Scratch[0]);
+            const float* Times = Reader.ReadColumn<float>(BlockIndex, EMatchLogColumn::Time, Scratch[1]);
+
+            if(!Types || !Times)
+                break;
+
+            if(Heatmap)
+            {
+                const float* LocationsY = Reader.ReadColumn<float>(BlockIndex, EMatchLogColumn::LocationY, Scratch[2]);
+                const float* LocationsZ = Reader.ReadColumn<float>(BlockIndex, EMatchLogColumn::LocationZ, Scratch[3]);
+                const float* Speeds = Reader.ReadColumn<float>(BlockIndex, EMatchLogColumn::Speed, Scratch[4]);
+
+                if(!LocationsY || !LocationsZ || !Speeds)
+                    break;
+
+                for(int32 Index = 0; Index < NumEvents; Index++)
+                {
+                    const bool bHit = (Types[Index] == EMatchEventType::WallHit || Types[Index] == EMatchEventType::PlayerHit);
+
+                    if(bHit && Times[Index] >= Options.FromTime && Times[Index] <= Options.ToTime && Speeds[Index] >= Options.MinSpeed)
+                    {
+                        const FIntPoint Cell(FMath::FloorToInt(LocationsY[Index] / Options.CellSize), FMath::FloorToInt(LocationsZ[Index] / Options.CellSize));
+                        Heatmap->FindOrAdd(Cell)++;
+                    }
+                }
+
+                continue;
+            }
+
+            const int16* Params = Reader.ReadColumn<int16>(BlockIndex, EMatchLogColumn::Param, Scratch[2]);
+
+            if(!Params)
+                break;
+
+            for(int32 Index = 0; Index < NumEvents; Index++)
+            {
+                const float Time = Times[Index];
+
+                switch(Types[Index])
+                {
+                    case EMatchEventType::StateChange:
+                    {
+                        // The ball is pushed as the game enters the PLAYING state. This is the kickoff.
+                        if(Params[Index] == EGameState::PLAYING)
+                        {
+                            KickoffTime = Time;
+                            RallyHits = 0;
+                        }
+                        break;
+                    }
+                    case EMatchEventType::PlayerHit:
+                    {
+                        RallyHits++;
+                        break;
+                    }
+                    case EMatchEventType::Goal:
+                    {
+                        const bool bInTimeRange = (Time >= Options.FromTime && Time <= Options.ToTime);
+
+                        if(Options.Query == EMatchQuery::KickoffGoals && KickoffTime >= 0.0f && bInTimeRange
+                           && Time - KickoffTime <= Options.KickoffWindow)
+                        {
+                            Result.Rows.Add({ FileName, Time, Time - KickoffTime });
+                        }
+                        else if(Options.Query == EMatchQuery::Rallies && bInTimeRange && RallyHits > Options.MinRallyHits)
+                        {
+                            Result.Rows.Add({ FileName, Time, (float)RallyHits });
+                        }
+
+                        KickoffTime = -1.0f;
+                        RallyHits = 0;
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    /** Writes the heatmap of an arena to a CSV file with one "y,z,count" row per cell. */
+    void WriteHeatmap(const FString& Directory, const FString& Arena, const TMap<FIntPoint, int32>& Heatmap, float CellSize)
+    {
+        FString Csv = TEXT("y,z,count\n");
+
+        for(const auto& Cell : Heatmap)
+        {
+            Csv += FString::Printf(TEXT("%.1f,%.1f,%d\n"), Cell.Key.X * CellSize, Cell.Key.Y * CellSize, Cell.Value);
+        }
+
+        const FString FileName = Directory / (Arena + TEXT("_heatmap.csv"));
+        FFileHelper::SaveStringToFile(Csv, *FileName);
+
+        UE_LOG(LogCubeProject, Display, TEXT("%s: %d cells written to %s"), *Arena, Heatmap.Num(), *FileName);
+    }
+}
+
+UMatchQueryCommandlet::UMatchQueryCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UMatchQueryCommandlet::Main(const FString& Params)
+{
+    FMatchQueryOptions Options;
+    FString LogDirectory = FPaths::GameSavedDir() / TEXT("MatchLogs");
+    FString OutDirectory = FPaths::GameSavedDir() / TEXT("MatchQueries");
+    FString QueryName;
+    int32 Limit = 20;
+
+    FParse::Value(*Params, TEXT("logs="), LogDirectory);
+    FParse::Value(*Params, TEXT("out="), OutDirectory);
+    FParse::Value(*Params, TEXT("query="), QueryName);
+    FParse::Value(*Params, TEXT("arena="), Options.Arena);
+    FParse::Value(*Params, TEXT("window="), Options.KickoffWindow);
+    FParse::Value(*Params, TEXT("minhits="), Options.MinRallyHits);
+    FParse::Value(*Params, TEXT("cell="), Options.CellSize);
+    FParse::Value(*Params, TEXT("from="), Options.FromTime);
+    FParse::Value(*Params, TEXT("to="), Options.ToTime);
+    FParse::Value(*Params, TEXT("minspeed="), Options.MinSpeed);
+    FParse::Value(*Params, TEXT("limit="), Limit);
+
+    if(QueryName == TEXT("kickoff-goals"))
+    {
+        Options.Query = EMatchQuery::KickoffGoals;
+    }
+    else if(QueryName == TEXT("rallies"))
+    {
+        Options.Query = EMatchQuery::Rallies;
+    }
+    else if(QueryName == TEXT("heatmap") && Options.CellSize > 0.0f)
+    {
+        Options.Query = EMatchQuery::Heatmap;
+    }
+    else
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Unknown query '%s'. Expected -query=kickoff-goals, rallies or heatmap."), *QueryName);
+        return 1;
+    }
+
+    TArray<FString> FileNames;
+    IFileManager::Get().FindFilesRecursive(FileNames, *LogDirectory, TEXT("*.gsml"), true, false);
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    // Split the files into more chunks than there are workers so that slow chunks don't hold up the whole query.
+    // Each chunk accumulates its own results, so the workers never share any data.
+    const int32 NumChunks = FMath::Min(FileNames.Num(), FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads() * 4));
+    TArray<FMatchQueryPartialResult> PartialResults;
+    PartialResults.SetNum(NumChunks);
+
+    ParallelFor(NumChunks, [&](int32 ChunkIndex)
+    {
+        FMatchLogReader Reader;
+        TArray<uint8> Scratch[5];
+
+        for(int32 FileIndex = ChunkIndex; FileIndex < FileNames.Num(); FileIndex += NumChunks)
+        {
+            ScanFile(FileNames[FileIndex], Options, Reader, Scratch, PartialResults[ChunkIndex]);
+        }
+    });
+
+    // Merge the results of every chunk
+    FMatchQueryPartialResult Result;
+
+    for(FMatchQueryPartialResult& PartialResult : PartialResults)
+    {
+        Result.Rows.Append(PartialResult.Rows);
+        Result.NumFiles += PartialResult.NumFiles;
+        Result.NumInvalidFiles += PartialResult.NumInvalidFiles;
+        Result.NumBlocksRead += PartialResult.NumBlocksRead;
+        Result.NumBlocksSkipped += PartialResult.NumBlocksSkipped;
+        Result.NumEventsRead += PartialResult.NumEventsRead;
+
+        for(const auto& ArenaHeatmap : PartialResult.Heatmaps)
+        {
+            TMap<FIntPoint, int32>& Heatmap = Result.Heatmaps.FindOrAdd(ArenaHeatmap.Key);
+
+            for(const auto& Cell : ArenaHeatmap.Value)
+            {
+                Heatmap.FindOrAdd(Cell.Key) += Cell.Value;
+            }
+        }
+    }
+
+    const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+    UE_LOG(LogCubeProject, Display, TEXT("Scanned %d matches in %.3f s (%d invalid files). Blocks read: %lld, skipped: %lld. Events read: %lld."),
+           Result.NumFiles, ElapsedTime, Result.NumInvalidFiles, Result.NumBlocksRead, Result.NumBlocksSkipped, Result.NumEventsRead);
+
+    if(Options.Query == EMatchQuery::Heatmap)
+    {
+        IFileManager::Get().MakeDirectory(*OutDirectory, true);
+
+        for(const auto& ArenaHeatmap : Result.Heatmaps)
+        {
+            WriteHeatmap(OutDirectory, ArenaHeatmap.Key, ArenaHeatmap.Value, Options.CellSize);
+        }
+    }
+    else
+    {
+        UE_LOG(LogCubeProject, Display, TEXT("%d matching %s."), Result.Rows.Num(),
+               Options.Query == EMatchQuery::KickoffGoals ? TEXT("goals") : TEXT("rallies"));
+
+        for(int32 RowIndex = 0; RowIndex < FMath::Min(Limit, Result.Rows.Num()); RowIndex++)
+        {
+            const FMatchQueryRow& Row = Result.Rows[RowIndex];
+            UE_LOG(LogCubeProject, Display, TEXT("  %s at %.2f s: %s %.2f"), *FPaths::GetCleanFilename(Row.FileName), Row.Time,
+                   Options.Query == EMatchQuery::KickoffGoals ? TEXT("after kickoff") : TEXT("hits"), Row.Value);
+        }
+    }
+
+    return 0;
+}
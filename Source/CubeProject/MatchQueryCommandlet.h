@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "MatchQueryCommandlet.generated.h"
+
+/**
+ * Runs a query over a corpus of match event logs (see FMatchEventLog). The logs are scanned in parallel and blocks
+ * whose min/max statistics cannot match the query are skipped without being decompressed.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=MatchQuery -logs=<directory> -query=<query> [options]
+ *
+ * Queries:
+ *   kickoff-goals  Goals scored within -window=<seconds> (default 2) of kickoff.
+ *   rallies        Rallies (kickoff to goal) with more than -minhits=<count> (default 20) player hits.
+ *   heatmap        Counts the ball hits in each -cell=<size> (default 50) cell of every arena. Written as CSV files to -out=<directory>.
+ *
+ * Options:
+ *   -arena=<name>     Only scan the matches played on the given map (e.g., Test_01).
+ *   -from=<seconds>   Only consider events which occur after the given match time.
+ *   -to=<seconds>     Only consider events which occur before the given match time.
+ *   -minspeed=<speed> Only consider hits which leave the ball at the given speed or faster.
+ *   -limit=<count>    The maximum number of matching rows printed (default 20).
+ */
+UCLASS()
+class UMatchQueryCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UMatchQueryCommandlet();
+
+    // Runs the query given on the command line
+    virtual int32 Main(const FString& Params) override;
+};
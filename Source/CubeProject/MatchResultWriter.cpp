@@ -0,0 +1,76 @@
+#include "CubeProject.h"
+#include "MatchResultWriter.h"
+#include "RatingEngine.h"
+
+FMatchResultWriter::FMatchResultWriter(const FString& InFileName)
+    : Results(QUEUE_CAPACITY)
+    , FileName(InFileName)
+{
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, TEXT("MatchResultWriter"), 0, TPri_BelowNormal);
+}
+
+FMatchResultWriter::~FMatchResultWriter()
+{
+    Stop();
+
+    if(Thread)
+    {
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+}
+
+bool FMatchResultWriter::Append(const FString& LeftName, const FString& RightName, int32 LeftScore, int32 RightScore, uint32 GoalSequence,
+                                int32 NumGoals)
+{
+    FPendingResult Result;
+    Result.LeftName = LeftName;
+    Result.RightName = RightName;
+    Result.LeftScore = LeftScore;
+    Result.RightScore = RightScore;
+    Result.GoalSequence = GoalSequence;
+    Result.NumGoals = NumGoals;
+
+    if(!Results.Enqueue(Result))
+        return false;
+
+    WakeEvent->Trigger();
+    return true;
+}
+
+uint32 FMatchResultWriter::Run()
+{
+    while(StopRequested.GetValue() == 0)
+    {
+        DrainQueue();
+        WakeEvent->Wait(1000);
+    }
+
+    // Write the results queued before the thread was asked to stop
+    DrainQueue();
+
+    return 0;
+}
+
+void FMatchResultWriter::Stop()
+{
+    StopRequested.Set(1);
+    WakeEvent->Trigger();
+}
+
+void FMatchResultWriter::DrainQueue()
+{
+    FPendingResult Result;
+
+    while(Results.Dequeue(Result))
+    {
+        if(!FRatingEngine::AppendResultToFile(FileName, Result.LeftName, Result.RightName, Result.LeftScore, Result.RightScore,
+                                              Result.GoalSequence, Result.NumGoals))
+        {
+            UE_LOG(LogCubeProject, Warning, TEXT("Could not append the result of %s vs %s to %s"), *Result.LeftName, *Result.RightName, *FileName);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+/**
+ * Appends the results of finished matches to the results file read by the rating engine (see
+ * FRatingEngine::AppendResultToFile()). The game thread queues each result and never waits on the disk; a background
+ * thread appends the queued results to the file.
+ */
+class CUBEPROJECT_API FMatchResultWriter : public FRunnable
+{
+public:
+    /** The maximum number of results waiting to be written. Results queued while the queue is full are dropped. */
+    static constexpr uint32 QUEUE_CAPACITY = 64;
+
+    /** Starts the writer thread, which appends the results to the given file. */
+    explicit FMatchResultWriter(const FString& InFileName);
+
+    /** Writes the remaining results and stops the writer thread. */
+    virtual ~FMatchResultWriter();
+
+    /** Queues the result of a match. Never blocks. Returns false if the result was dropped because the queue is full. Game thread only. */
+    bool Append(const FString& LeftName, const FString& RightName, int32 LeftScore, int32 RightScore, uint32 GoalSequence, int32 NumGoals);
+
+    // FRunnable interface
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    /** A result waiting to be written. */
+    struct FPendingResult
+    {
+        FString LeftName;
+        FString RightName;
+        int32 LeftScore;
+        int32 RightScore;
+        uint32 GoalSequence;
+        int32 NumGoals;
+    };
+
+    /** Writer thread: appends every result currently in the queue to the file. */
+    void DrainQueue();
+
+    /** The results queued by the game thread. */
+    TCircularQueue<FPendingResult> Results;
+
+    /** The results file. */
+    FString FileName;
+
+    /** The thread writing the results. */
+    FRunnableThread* Thread;
+    /** Wakes the writer thread once a result is queued. */
+    FEvent* WakeEvent;
+    /** Set to stop the writer thread. */
+    FThreadSafeCounter StopRequested;
+};
@@ -0,0 +1,150 @@
+#include "CubeProject.h"
+#include "MatchSaveCheckCommandlet.h"
+#include "CubeHostedMatch.h"
+#include "CubeMatchSave.h"
+
+namespace
+{
+    /** The number of times a save and a resume are repeated to time them. */
+    constexpr int32 TIMING_REPEATS = 1000;
+
+    /** Reports the first field which differs between the states of two matches. */
+    void ReportDivergence(const FCubeHostedMatch& Original, const FCubeHostedMatch& Resumed)
+    {
+        TArray<FCubeStateField> OriginalFields;
+        TArray<FCubeStateField> ResumedFields;
+        FCubeStateHasher OriginalHasher(&OriginalFields);
+        FCubeStateHasher ResumedHasher(&ResumedFields);
+        Original.HashState(OriginalHasher);
+        Resumed.HashState(ResumedHasher);
+
+        for(int32 Field = 0; Field < FMath::Min(OriginalFields.Num(), ResumedFields.Num()); Field++)
+        {
+            if(OriginalFields[Field].Bits != ResumedFields[Field].Bits)
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("  First divergent field: %s[%d], %08x in the original match, %08x in the resumed one"),
+                       OriginalFields[Field].Name, OriginalFields[Field].Index, OriginalFields[Field].Bits, ResumedFields[Field].Bits);
+                return;
+            }
+        }
+    }
+}
+
+UMatchSaveCheckCommandlet::UMatchSaveCheckCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UMatchSaveCheckCommandlet::Main(const FString& Params)
+{
+    int32 NumMatches = 64;
+    int32 NumPlayers = 2;
+    int32 NumTicks = 3600;
+    int32 ScoreToWin = 3;
+    uint64 BaseSeed = FPlatformTime::Cycles64();
+
+    FParse::Value(*Params, TEXT("matches="), NumMatches);
+    FParse::Value(*Params, TEXT("players="), NumPlayers);
+    FParse::Value(*Params, TEXT("ticks="), NumTicks);
+    FParse::Value(*Params, TEXT("scoretowin="), ScoreToWin);
+    FParse::Value(*Params, TEXT("seed="), BaseSeed);
+
+    if(NumMatches <= 0 || NumPlayers < 1 || NumPlayers > FCubePlayerRegistry::MAX_PLAYERS || NumTicks < 2)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=MatchSaveCheck [-matches=<count>] [-players=<1-8>] [-ticks=<count>] [-scoretowin=<goals>] ")
+                                      TEXT("[-seed=<seed>]"));
+        return 2;
+    }
+
+    UE_LOG(LogCubeProject, Display, TEXT("Saving and resuming %d matches of %d players, seeded with %llu"), NumMatches, NumPlayers, BaseSeed);
+
+    const FCubeSimConfig Config;
+    FCubeRandomStream SaveTickStream(BaseSeed, ECubeRandomStream::Tools);
+    double SaveSeconds = 0.0;
+    double ResumeSeconds = 0.0;
+
+    for(int32 Index = 0; Index < NumMatches; Index++)
+    {
+        const uint64 Seed = FCubeRandomStream::Mix(BaseSeed + Index);
+        const int32 SaveTick = 1 + (int32)(SaveTickStream.GetUnsignedInt() % (uint32)(NumTicks - 1));
+
+        FCubeHostedMatch Original(Config, NumPlayers, ScoreToWin, Seed);
+
+        for(int32 Tick = 0; Tick < SaveTick; Tick++)
+        {
+            Original.Tick();
+        }
+
+        // Save and resume the match, repeating both to time them
+        FCubeMatchSaveRecord Record;
+        TArray<uint8> Data;
+        double StartTime = FPlatformTime::Seconds();
+
+        for(int32 Repeat = 0; Repeat < TIMING_REPEATS; Repeat++)
+        {
+            Original.Save(Record);
+            CubeMatchSave::Write(Record, Data);
+        }
+
+        SaveSeconds += FPlatformTime::Seconds() - StartTime;
+
+        // The resumed match starts from another seed, so that nothing it keeps from its own seed goes unnoticed
+        FCubeHostedMatch Resumed(Config, NumPlayers, ScoreToWin, ~Seed);
+        FCubeMatchSaveRecord ReadRecord;
+        bool bResumed = true;
+        StartTime = FPlatformTime::Seconds();
+
+        for(int32 Repeat = 0; Repeat < TIMING_REPEATS && bResumed; Repeat++)
+        {
+            bResumed = CubeMatchSave::Read(Data.GetData(), Data.Num(), ReadRecord) && Resumed.Resume(ReadRecord);
+        }
+
+        ResumeSeconds += FPlatformTime::Seconds() - StartTime;
+
+        if(!bResumed)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("Match %d (seed %llu): the save of tick %d could not be resumed"), Index, Seed, SaveTick);
+            return 1;
+        }
+
+        // Saving the resumed match must give back the same bytes
+        TArray<uint8> ResumedData;
+        Resumed.Save(Record);
+        CubeMatchSave::Write(Record, ResumedData);
+
+        if(ResumedData != Data)
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("Match %d (seed %llu): the resumed match saves differently at tick %d"), Index, Seed, SaveTick);
+            ReportDivergence(Original, Resumed);
+            return 1;
+        }
+
+        // Play both matches on, and compare their state at every tick
+        for(int32 Tick = SaveTick; Tick < NumTicks; Tick++)
+        {
+            Original.Tick();
+            Resumed.Tick();
+
+            FCubeStateHasher OriginalHasher;
+            FCubeStateHasher ResumedHasher;
+            Original.HashState(OriginalHasher);
+            Resumed.HashState(ResumedHasher);
+
+            if(OriginalHasher.GetHash() != ResumedHasher.GetHash())
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("Match %d (seed %llu), saved at tick %d: desync at tick %d"), Index, Seed, SaveTick, Tick + 1);
+                ReportDivergence(Original, Resumed);
+                return 1;
+            }
+        }
+    }
+
+    const double NumRoundTrips = (double)NumMatches * TIMING_REPEATS;
+
+    UE_LOG(LogCubeProject, Display, TEXT("Every resumed match played on identically. %d-byte saves: %.2f us to save, %.2f us to resume"),
+           (int32)sizeof(FCubeMatchSaveRecord), 1000000.0 * SaveSeconds / NumRoundTrips, 1000000.0 * ResumeSeconds / NumRoundTrips);
+    return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "MatchSaveCheckCommandlet.generated.h"
+
+/**
+ * Checks that a saved match resumes bit-identically (see CubeMatchSave.h). Each match is played by scripted bots up to a
+ * random tick, saved to bytes and resumed in a new match. The original and the resumed match are then played side by
+ * side, and the hash of their gameplay state is compared at every tick; the first field which diverged is reported. The
+ * time taken to save and to resume a match is reported as well.
+ *
+ * The commandlet only round-trips the match simulation (FCubeHostedMatch). The actors' saves are checked in the game by
+ * -ActorSaveCheck (see CubeActorSaveCheck.h).
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=MatchSaveCheck [-matches=<count>] [-players=<count>] [-ticks=<count>]
+ *        [-scoretowin=<goals>] [-seed=<seed>]
+ *
+ * Returns 0 if every resumed match played on identically, 1 if one diverged and 2 on invalid arguments.
+ */
+UCLASS()
+class UMatchSaveCheckCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UMatchSaveCheckCommandlet();
+
+    // Runs the round trips
+    virtual int32 Main(const FString& Params) override;
+};
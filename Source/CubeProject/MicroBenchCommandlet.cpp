@@ -0,0 +1,441 @@
+#include "CubeProject.h"
+#include "MicroBenchCommandlet.h"
+#include "CubeMatchSim.h"
+#include "CubeSimBatch.h"
+#include "CubeBallPhysics.h"
+#include "CubeStrictFloat.h"
+#include "CubePerfBaseline.h"
+
+namespace
+{
+    /** The section of Config/PerfBaseline.ini holding the cost of each benchmark, in nanoseconds per contact. */
+    const TCHAR* BASELINE_SECTION = TEXT("MicroBench");
+    /** The default relative tolerance of the costs, used when the baseline file does not set one. */
+    constexpr float DEFAULT_TOLERANCE = 0.25f;
+    /** The angle between the bounce and the player's velocity above which ABall::OnHitPlayer() ignored the velocity, when it
+      * compared angles. */
+    constexpr float ANGLE_TO_IGNORE_PLAYER_VELOCITY = 100.0f;
+    /** The seed of the contacts, so that every run measures the same ones. */
+    constexpr uint64 CONTACTS_SEED = 49;
+
+    /** The contacts of the benchmarks, one array per component, and the arrays the benchmarks write to. */
+    struct FMicroBenchData
+    {
+        int32 NumContacts;
+        FCubeBallRules BallRules;
+        FCubePawnRules PawnRules;
+
+        /** The ball hitting a wall, or clamped. */
+        TArray<float> DirectionX, DirectionY, NormalX, NormalY, Speed;
+        /** The ball hitting a player. */
+        TArray<float> BallX, BallY, PlayerX, PlayerY, PlayerVelocityX, PlayerVelocityY;
+        /** The pawn spinning. */
+        TArray<float> PawnVelocityX, PawnVelocityY, InputX;
+
+        TArray<float> OutX, OutY, OutSpeed;
+    };
+
+    /** A benchmark: a group of math, in one variant. */
+    struct FMicroBenchmark
+    {
+        const TCHAR* Name;
+        /** The benchmark of the same group which the variant is compared to, or NULL. */
+        const TCHAR* ReferenceName;
+        /** True if the variant must write the same bits as its reference, which it then replaces. */
+        bool bExact;
+        void (*Run)(FMicroBenchData& Data);
+    };
+
+    /** The result of a benchmark. */
+    struct FMicroBenchResult
+    {
+        const FMicroBenchmark* Benchmark;
+        int64 Iterations;
+        double MedianNanoseconds;
+        double MinNanoseconds;
+    };
+
+    FVector2D RandomDirection(FCubeRandomStream& Stream)
+    {
+        const FVector2D Direction = CubeSim::SafeNormal(FVector2D(Stream.GetRange(-1.0f, 1.0f), Stream.GetRange(-1.0f, 1.0f)));
+        return (Direction.X != 0.0f || Direction.Y != 0.0f) ? Direction : FVector2D(1.0f, 0.0f);
+    }
+
+    /** Draws contacts like those of a match, degenerate ones included: players standing still, balls at a player's center. */
+    void GenerateContacts(int32 NumContacts, FMicroBenchData& Data)
+    {
+        FCubeRandomStream Stream(CONTACTS_SEED, ECubeRandomStream::Tools);
+        const FCubeSimConfig Config;
+
+        Data.NumContacts = NumContacts;
+        TArray<float>* Arrays[] = { &Data.DirectionX, &Data.DirectionY, &Data.NormalX, &Data.NormalY, &Data.Speed, &Data.BallX, &Data.BallY,
+                                    &Data.PlayerX, &Data.PlayerY, &Data.PlayerVelocityX, &Data.PlayerVelocityY, &Data.PawnVelocityX,
+                                    &Data.PawnVelocityY, &Data.InputX, &Data.OutX, &Data.OutY, &Data.OutSpeed };
+
+        for(TArray<float>* Array : Arrays)
+        {
+            Array->SetNumZeroed(NumContacts);
+        }
+
+        for(int32 Index = 0; Index < NumContacts; Index++)
+        {
+            // A direction to which players' velocities were added, at speeds on both sides of the clamp
+            const FVector2D Direction = RandomDirection(Stream) * Stream.GetRange(0.5f, 1.5f);
+            Data.DirectionX[Index] = Direction.X;
+            Data.DirectionY[Index] = Direction.Y;
+            Data.Speed[Index] = Stream.GetRange(0.5f * Data.BallRules.MinSpeed, 1.5f * Data.BallRules.MaxSpeed);
+
+            // Most walls are the floor, ceiling or goal lines
+            const FVector2D Normal = (Stream.GetFraction() < 0.5f) ? FVector2D(Stream.GetFraction() < 0.5f ? 1.0f : -1.0f, 0.0f) : RandomDirection(Stream);
+            Data.NormalX[Index] = Normal.X;
+            Data.NormalY[Index] = Normal.Y;
+
+            const FVector2D PlayerLocation(Stream.GetRange(-800.0f, 800.0f), Stream.GetRange(-250.0f, 250.0f));
+            const float ContactDistance = (Config.BallRadius + Config.PawnRadius) * Stream.GetRange(0.8f, 1.0f);
+            const FVector2D BallLocation = (Stream.GetFraction() < 0.02f) ? PlayerLocation : PlayerLocation + RandomDirection(Stream) * ContactDistance;
+            const FVector2D PlayerVelocity = (Stream.GetFraction() < 0.1f) ? FVector2D::ZeroVector
+                                                                          : RandomDirection(Stream) * Stream.GetRange(0.0f, Data.PawnRules.MaxSpeed);
+            Data.BallX[Index] = BallLocation.X;
+            Data.BallY[Index] = BallLocation.Y;
+            Data.PlayerX[Index] = PlayerLocation.X;
+            Data.PlayerY[Index] = PlayerLocation.Y;
+            Data.PlayerVelocityX[Index] = PlayerVelocity.X;
+            Data.PlayerVelocityY[Index] = PlayerVelocity.Y;
+
+            const FVector2D PawnVelocity = RandomDirection(Stream) * Stream.GetRange(0.0f, 1.5f * Data.PawnRules.MaxSpeed);
+            Data.PawnVelocityX[Index] = PawnVelocity.X;
+            Data.PawnVelocityY[Index] = PawnVelocity.Y;
+            Data.InputX[Index] = (Stream.GetFraction() < 0.2f) ? 0.0f : Stream.GetRange(-1.0f, 1.0f);
+        }
+    }
+
+    void WallBounceScalar(FMicroBenchData& Data)
+    {
+        for(int32 Index = 0; Index < Data.NumContacts; Index++)
+        {
+            const FVector2D Normal = CubeSim::SafeNormal(FVector2D(Data.NormalX[Index], Data.NormalY[Index]));
+            const FVector2D Direction = CubeSim::BounceOffWall(FVector2D(Data.DirectionX[Index], Data.DirectionY[Index]), Normal);
+
+            Data.OutX[Index] = Direction.X;
+            Data.OutY[Index] = Direction.Y;
+            Data.OutSpeed[Index] = CubeSim::Size(CubeSim::GetBallVelocity(Direction, Data.Speed[Index], Data.BallRules));
+        }
+    }
+
+    void WallBounceBatch(FMicroBenchData& Data)
+    {
+        CubeSimBatch::BounceOffWalls(Data.NumContacts, Data.DirectionX.GetData(), Data.DirectionY.GetData(), Data.NormalX.GetData(), Data.NormalY.GetData(),
+                                     Data.Speed.GetData(), Data.BallRules, Data.OutX.GetData(), Data.OutY.GetData(), Data.OutSpeed.GetData());
+    }
+
+    /** The player bounce as ABall::OnHitPlayer() computed it before it compared cosines: the angle between the bounce and the
+      * player's velocity from acos(), in degrees. */
+    void PlayerBounceScalarAcos(FMicroBenchData& Data)
+    {
+        for(int32 Index = 0; Index < Data.NumContacts; Index++)
+        {
+            const FVector2D BounceDirection = CubeSim::SafeNormal(FVector2D(Data.BallX[Index] - Data.PlayerX[Index], Data.BallY[Index] - Data.PlayerY[Index]));
+            const FVector2D PlayerVelocity(Data.PlayerVelocityX[Index], Data.PlayerVelocityY[Index]);
+            const float Cos = FVector2D::DotProduct(BounceDirection, CubeSim::SafeNormal(PlayerVelocity));
+            const float Angle = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(Cos, -1.0f, 1.0f)));
+
+            const FVector2D Direction = (Angle > ANGLE_TO_IGNORE_PLAYER_VELOCITY) ? BounceDirection
+                                                                                   : CubeSim::AddPlayerVelocity(BounceDirection, PlayerVelocity, Data.BallRules);
+            Data.OutX[Index] = Direction.X;
+            Data.OutY[Index] = Direction.Y;
+        }
+    }
+
+    void PlayerBounceScalar(FMicroBenchData& Data)
+    {
+        for(int32 Index = 0; Index < Data.NumContacts; Index++)
+        {
+            const FVector2D Direction = CubeSim::BounceOffPlayer(FVector2D(Data.BallX[Index], Data.BallY[Index]), FVector2D(Data.PlayerX[Index], Data.PlayerY[Index]),
+                                                                 FVector2D(Data.PlayerVelocityX[Index], Data.PlayerVelocityY[Index]), Data.BallRules);
+            Data.OutX[Index] = Direction.X;
+            Data.OutY[Index] = Direction.Y;
+        }
+    }
+
+    /** The player bounce specialized for the ball's profile. The contacts use the default tuning. */
+    void PlayerBounceProfile(FMicroBenchData& Data)
+    {
+        for(int32 Index = 0; Index < Data.NumContacts; Index++)
+        {
+            const FVector2D Direction = CubeBallPhysics::BounceOffPlayer(FVector2D(Data.BallX[Index], Data.BallY[Index]),
+                                                                         FVector2D(Data.PlayerX[Index], Data.PlayerY[Index]),
+                                                                         FVector2D(Data.PlayerVelocityX[Index], Data.PlayerVelocityY[Index]),
+                                                                         FCubeDefaultBallProfile());
+            Data.OutX[Index] = Direction.X;
+            Data.OutY[Index] = Direction.Y;
+        }
+    }
+
+    void PlayerBounceBatch(FMicroBenchData& Data)
+    {
+        CubeSimBatch::BounceOffPlayers(Data.NumContacts, Data.BallX.GetData(), Data.BallY.GetData(), Data.PlayerX.GetData(), Data.PlayerY.GetData(),
+                                       Data.PlayerVelocityX.GetData(), Data.PlayerVelocityY.GetData(), Data.BallRules, Data.OutX.GetData(),
+                                       Data.OutY.GetData());
+    }
+
+    void SpeedClampScalar(FMicroBenchData& Data)
+    {
+        for(int32 Index = 0; Index < Data.NumContacts; Index++)
+        {
+            const FVector2D Velocity = CubeSim::GetBallVelocity(FVector2D(Data.DirectionX[Index], Data.DirectionY[Index]), Data.Speed[Index], Data.BallRules);
+            Data.OutX[Index] = Velocity.X;
+            Data.OutY[Index] = Velocity.Y;
+        }
+    }
+
+    void SpeedClampProfile(FMicroBenchData& Data)
+    {
+        for(int32 Index = 0; Index < Data.NumContacts; Index++)
+        {
+            const FVector2D Velocity = CubeBallPhysics::GetBallVelocity(FVector2D(Data.DirectionX[Index], Data.DirectionY[Index]), Data.Speed[Index],
+                                                                        FCubeDefaultBallProfile());
+            Data.OutX[Index] = Velocity.X;
+            Data.OutY[Index] = Velocity.Y;
+        }
+    }
+
+    void SpeedClampBatch(FMicroBenchData& Data)
+    {
+        CubeSimBatch::GetBallVelocities(Data.NumContacts, Data.DirectionX.GetData(), Data.DirectionY.GetData(), Data.Speed.GetData(), Data.BallRules,
+                                        Data.OutX.GetData(), Data.OutY.GetData());
+    }
+
+    void SpinThrustScalar(FMicroBenchData& Data)
+    {
+        for(int32 Index = 0; Index < Data.NumContacts; Index++)
+        {
+            const FVector2D Velocity = CubeSim::AddSpinThrust(FVector2D(Data.PawnVelocityX[Index], Data.PawnVelocityY[Index]),
+                                                              FVector2D(Data.InputX[Index], 0.0f), Data.PawnRules);
+            Data.OutX[Index] = Velocity.X;
+            Data.OutY[Index] = Velocity.Y;
+        }
+    }
+
+    void SpinThrustBatch(FMicroBenchData& Data)
+    {
+        CubeSimBatch::AddSpinThrusts(Data.NumContacts, Data.PawnVelocityX.GetData(), Data.PawnVelocityY.GetData(), Data.InputX.GetData(), Data.PawnRules,
+                                     Data.OutX.GetData(), Data.OutY.GetData());
+    }
+
+    const FMicroBenchmark BENCHMARKS[] =
+    {
+        { TEXT("WallBounce/Scalar"), NULL, false, WallBounceScalar },
+        { TEXT("WallBounce/Batch"), TEXT("WallBounce/Scalar"), true, WallBounceBatch },
+        { TEXT("PlayerBounce/ScalarAcos"), NULL, false, PlayerBounceScalarAcos },
+        { TEXT("PlayerBounce/Scalar"), TEXT("PlayerBounce/ScalarAcos"), false, PlayerBounceScalar },
+        { TEXT("PlayerBounce/Profile"), TEXT("PlayerBounce/Scalar"), true, PlayerBounceProfile },
+        { TEXT("PlayerBounce/Batch"), TEXT("PlayerBounce/Scalar"), true, PlayerBounceBatch },
+        { TEXT("SpeedClamp/Scalar"), NULL, false, SpeedClampScalar },
+        { TEXT("SpeedClamp/Profile"), TEXT("SpeedClamp/Scalar"), true, SpeedClampProfile },
+        { TEXT("SpeedClamp/Batch"), TEXT("SpeedClamp/Scalar"), true, SpeedClampBatch },
+        { TEXT("SpinThrust/Scalar"), NULL, false, SpinThrustScalar },
+        { TEXT("SpinThrust/Batch"), TEXT("SpinThrust/Scalar"), true, SpinThrustBatch },
+    };
+
+    const FMicroBenchmark* FindBenchmark(const TCHAR* Name)
+    {
+        for(const FMicroBenchmark& Benchmark : BENCHMARKS)
+        {
+            if(FCString::Strcmp(Benchmark.Name, Name) == 0)
+                return &Benchmark;
+        }
+
+        return NULL;
+    }
+
+    /** Checks that a variant writes the same bits as the scalar rules it is compared to. */
+    bool CheckBitIdentical(const FMicroBenchmark& Variant, const FMicroBenchmark& Scalar, FMicroBenchData& Data)
+    {
+        Scalar.Run(Data);
+        const TArray<float> ScalarX = Data.OutX;
+        const TArray<float> ScalarY = Data.OutY;
+        const TArray<float> ScalarSpeed = Data.OutSpeed;
+
+        Variant.Run(Data);
+
+        for(int32 Index = 0; Index < Data.NumContacts; Index++)
+        {
+            if(FMemory::Memcmp(&Data.OutX[Index], &ScalarX[Index], sizeof(float)) != 0 || FMemory::Memcmp(&Data.OutY[Index], &ScalarY[Index], sizeof(float)) != 0
+               || FMemory::Memcmp(&Data.OutSpeed[Index], &ScalarSpeed[Index], sizeof(float)) != 0)
+            {
+                UE_LOG(LogCubeProject, Error, TEXT("%s differs from %s at contact %d: (%g, %g, %g) instead of (%g, %g, %g)"), Variant.Name, Scalar.Name, Index,
+                       Data.OutX[Index], Data.OutY[Index], Data.OutSpeed[Index], ScalarX[Index], ScalarY[Index], ScalarSpeed[Index]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /** Runs a benchmark for enough iterations to fill the minimum time, then repeats the timing. */
+    FMicroBenchResult RunBenchmark(const FMicroBenchmark& Benchmark, FMicroBenchData& Data, double MinSeconds, int32 NumRepetitions)
+    {
+        FMicroBenchResult Result;
+        Result.Benchmark = &Benchmark;
+        Result.Iterations = 1;
+
+        // Grow the iterations until they fill the minimum time, like Google Benchmark
+        for(;;)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+
+            for(int64 Iteration = 0; Iteration < Result.Iterations; Iteration++)
+            {
+                Benchmark.Run(Data);
+            }
+
+            const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+            if(Seconds >= MinSeconds)
+                break;
+
+            const double Growth = (Seconds > 0.0) ? 1.4 * MinSeconds / Seconds : 10.0;
+            Result.Iterations = FMath::Max(Result.Iterations + 1, (int64)(Result.Iterations * FMath::Min(Growth, 10.0)));
+        }
+
+        TArray<double> Nanoseconds;
+
+        for(int32 Repetition = 0; Repetition < NumRepetitions; Repetition++)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+
+            for(int64 Iteration = 0; Iteration < Result.Iterations; Iteration++)
+            {
+                Benchmark.Run(Data);
+            }
+
+            Nanoseconds.Add((FPlatformTime::Seconds() - StartTime) * 1e9 / ((double)Result.Iterations * Data.NumContacts));
+        }
+
+        Nanoseconds.Sort();
+        Result.MedianNanoseconds = Nanoseconds[NumRepetitions / 2];
+        Result.MinNanoseconds = Nanoseconds[0];
+        return Result;
+    }
+}
+
+UMicroBenchCommandlet::UMicroBenchCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UMicroBenchCommandlet::Main(const FString& Params)
+{
+    FString Filter;
+    int32 NumContacts = 1024;
+    float MinSeconds = 0.1f;
+    int32 NumRepetitions = 5;
+
+    FParse::Value(*Params, TEXT("filter="), Filter);
+    FParse::Value(*Params, TEXT("contacts="), NumContacts);
+    FParse::Value(*Params, TEXT("mintime="), MinSeconds);
+    FParse::Value(*Params, TEXT("repetitions="), NumRepetitions);
+
+    if(NumContacts < 1 || MinSeconds <= 0.0f || NumRepetitions < 1)
+    {
+        UE_LOG(LogCubeProject, Error, TEXT("Usage: -run=MicroBench [-filter=<substring>] [-contacts=<count>] [-mintime=<seconds>] [-repetitions=<count>] ")
+                                      TEXT("[-UpdateBaseline]"));
+        return 2;
+    }
+
+    FMicroBenchData Data;
+    GenerateContacts(NumContacts, Data);
+
+    UE_LOG(LogCubeProject, Display, TEXT("%d contacts, batches of %d contacts (%s)"), NumContacts, CubeSimBatch::WIDTH,
+           CubeSimBatch::IsVectorized() ? TEXT("SSE") : TEXT("scalar fallback"));
+
+    // A batched or specialized variant which does not give the scalar results can't replace them, however fast it is
+    int32 NumFailures = 0;
+
+    for(const FMicroBenchmark& Benchmark : BENCHMARKS)
+    {
+        if(Benchmark.bExact && !CheckBitIdentical(Benchmark, *FindBenchmark(Benchmark.ReferenceName), Data))
+        {
+            NumFailures++;
+        }
+    }
+
+    TArray<FMicroBenchResult> Results;
+
+    for(const FMicroBenchmark& Benchmark : BENCHMARKS)
+    {
+        if(Filter.IsEmpty() || FCString::Stristr(Benchmark.Name, *Filter))
+        {
+            Results.Add(RunBenchmark(Benchmark, Data, MinSeconds, NumRepetitions));
+        }
+    }
+
+    const FString BaselineFileName = CubePerfBaseline::GetFileName();
+    const bool bUpdateBaseline = FParse::Param(*Params, TEXT("UpdateBaseline"));
+
+    FConfigFile Baseline;
+    Baseline.Read(BaselineFileName);
+
+    FString ToleranceString;
+    const float Tolerance = Baseline.GetString(BASELINE_SECTION, TEXT("Tolerance"), ToleranceString) ? FCString::Atof(*ToleranceString) : DEFAULT_TOLERANCE;
+
+    TArray<FString> BaselineKeys;
+    TArray<FString> BaselineValues;
+
+    UE_LOG(LogCubeProject, Display, TEXT("%-26s %12s %12s %12s %10s  %s"), TEXT("Benchmark"), TEXT("ns/contact"), TEXT("min"), TEXT("iterations"),
+           TEXT("speedup"), TEXT("baseline"));
+
+    for(const FMicroBenchResult& Result : Results)
+    {
+        const FMicroBenchmark& Benchmark = *Result.Benchmark;
+
+        // The speedup over the variant the benchmark replaces, when both ran
+        FString Speedup = TEXT("-");
+
+        for(const FMicroBenchResult& Reference : Results)
+        {
+            if(Benchmark.ReferenceName && FCString::Strcmp(Reference.Benchmark->Name, Benchmark.ReferenceName) == 0)
+            {
+                Speedup = FString::Printf(TEXT("%.2fx"), Reference.MedianNanoseconds / Result.MedianNanoseconds);
+            }
+        }
+
+        FString Status = TEXT("none");
+        FString BaselineString;
+
+        if(bUpdateBaseline)
+        {
+            BaselineKeys.Add(Benchmark.Name);
+            BaselineValues.Add(FString::Printf(TEXT("%.3f"), Result.MedianNanoseconds));
+            Status = TEXT("updated");
+        }
+        else if(Baseline.GetString(BASELINE_SECTION, Benchmark.Name, BaselineString))
+        {
+            const double Limit = FCString::Atod(*BaselineString) * (1.0 + Tolerance);
+            const bool bRegressed = Result.MedianNanoseconds > Limit;
+            Status = FString::Printf(TEXT("%s %s"), *BaselineString, bRegressed ? TEXT("REGRESSED") : TEXT("ok"));
+            NumFailures += bRegressed ? 1 : 0;
+        }
+
+        UE_LOG(LogCubeProject, Display, TEXT("%-26s %12.3f %12.3f %12lld %10s  %s"), Benchmark.Name, Result.MedianNanoseconds, Result.MinNanoseconds,
+               Result.Iterations, *Speedup, *Status);
+    }
+
+    if(bUpdateBaseline)
+    {
+        if(CubePerfBaseline::SetValues(BaselineFileName, BASELINE_SECTION, BaselineKeys, BaselineValues))
+        {
+            UE_LOG(LogCubeProject, Display, TEXT("Baseline written to %s"), *BaselineFileName);
+        }
+        else
+        {
+            UE_LOG(LogCubeProject, Error, TEXT("Could not write the baseline to %s"), *BaselineFileName);
+            NumFailures++;
+        }
+    }
+
+    return (NumFailures > 0) ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "MicroBenchCommandlet.generated.h"
+
+/**
+ * Micro-benchmarks of the per-contact math of the ball and pawns, which only runs the engine-free rules of CubeSimRules.h
+ * and CubeSimBatch.h: the wall bounce with its speed recompute, the player bounce (also as it was computed with acos()),
+ * the ball's speed clamp and the spin thrust, each in a scalar and a batched variant. The ball's rules also run specialized
+ * for the default ball profile (see CubeBallPhysics.h), against the generic rules reading FCubeBallRules. Like Google
+ * Benchmark, each benchmark runs for enough iterations to fill a minimum time, a few times over, and reports the median
+ * cost of a contact in nanoseconds. The batched and specialized variants are first checked to give bit-identical results
+ * to the scalar rules.
+ *
+ * The costs are compared to the [MicroBench] section of Config/PerfBaseline.ini, which -UpdateBaseline records on the
+ * reference machine. Benchmarks without a baseline are reported, not failed.
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=MicroBench [-filter=<substring>] [-contacts=<count>] [-mintime=<seconds>]
+ *        [-repetitions=<count>] [-UpdateBaseline]
+ *
+ * Returns 0 if every benchmark ran within its baseline, 1 if a variant differs from the scalar rules or a benchmark
+ * regressed, and 2 on invalid arguments.
+ */
+UCLASS()
+class UMicroBenchCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UMicroBenchCommandlet();
+
+    // Runs the benchmarks
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,254 @@
+#include "CubeProject.h"
+#include "RatingEngine.h"
+#include "ParallelFor.h"
+
+namespace
+{
+    /** Fixed-size part of a result in a results file. Followed by the UTF-8 names of the left and right competitors. */
+    #pragma pack(push, 1)
+    struct FResultFileRecord
+    {
+        uint8 LeftScore;
+        uint8 RightScore;
+        uint8 NumGoals;
+        uint8 Reserved;
+        uint32 GoalSequence;
+        uint16 LeftNameLength;
+        uint16 RightNameLength;
+    };
+    #pragma pack(pop)
+
+    /** Converts a rating difference into the expected outcome of a match, scaled by 'G' for Glicko. */
+    FORCEINLINE float GetExpectedOutcome(float Rating, float OpponentRating, float G = 1.0f)
+    {
+        return 1.0f / (1.0f + FMath::Pow(10.0f, -G * (Rating - OpponentRating) / 400.0f));
+    }
+
+    /** The Glicko constant q = ln(10) / 400. */
+    const float GLICKO_Q = 0.0057565f;
+
+    /** The Glicko g() function, which lowers the weight of a match against an opponent whose rating is uncertain. */
+    FORCEINLINE float GetGlickoG(float Deviation)
+    {
+        return 1.0f / FMath::Sqrt(1.0f + 3.0f * GLICKO_Q * GLICKO_Q * Deviation * Deviation / (PI * PI));
+    }
+
+    /** Applies one Glicko rating period made of a single match to a competitor. */
+    void UpdateGlicko(FCompetitorRating& Competitor, const FCompetitorRating& Opponent, float Outcome, const FRatingParams& Params)
+    {
+        const float G = GetGlickoG(Opponent.Deviation);
+        const float Expected = GetExpectedOutcome(Competitor.Rating, Opponent.Rating, G);
+        const float InverseDSquared = GLICKO_Q * GLICKO_Q * G * G * Expected * (1.0f - Expected);
+        const float InverseVariance = 1.0f / (Competitor.Deviation * Competitor.Deviation) + InverseDSquared;
+
+        Competitor.Rating += GLICKO_Q / InverseVariance * G * (Outcome - Expected);
+
+        // The deviation shrinks with every match, then grows again to model the time between matches
+        const float Deviation = FMath::Sqrt(1.0f / InverseVariance);
+        Competitor.Deviation = FMath::Min(FMath::Sqrt(Deviation * Deviation + Params.DeviationDecay * Params.DeviationDecay), Params.InitialDeviation);
+    }
+}
+
+FRatingEngine::FRatingEngine(const FRatingParams& InParams)
+    : Params(InParams)
+    , ResultsFileOffset(0)
+{
+}
+
+int32 FRatingEngine::FindOrAddCompetitor(const FName& Name)
+{
+    if(const int32* Competitor = CompetitorIndices.Find(Name))
+    {
+        return *Competitor;
+    }
+
+    const int32 Competitor = Ratings.Add(MakeInitialRating(Params));
+    Names.Add(Name);
+    CompetitorIndices.Add(Name, Competitor);
+
+    return Competitor;
+}
+
+void FRatingEngine::AddResult(const FMatchResultRecord& Result)
+{
+    Results.Add(Result);
+    ApplyResult(Result, Params, Ratings);
+}
+
+void FRatingEngine::AddResult(const FName& LeftName, const FName& RightName, int32 LeftScore, int32 RightScore, uint32 GoalSequence, int32 NumGoals)
+{
+    FMatchResultRecord Result;
+    Result.LeftCompetitor = FindOrAddCompetitor(LeftName);
+    Result.RightCompetitor = FindOrAddCompetitor(RightName);
+    Result.GoalSequence = GoalSequence;
+    Result.NumGoals = (uint8)FMath::Clamp(NumGoals, 0, 32);
+    Result.LeftScore = (uint8)FMath::Clamp(LeftScore, 0, 255);
+    Result.RightScore = (uint8)FMath::Clamp(RightScore, 0, 255);
+    Result.Padding = 0;
+
+    AddResult(Result);
+}
+
+void FRatingEngine::ComputeScenarios(const TArray<FRatingParams>& Scenarios, TArray<TArray<FCompetitorRating>>& OutRatings) const
+{
+    OutRatings.SetNum(Scenarios.Num());
+
+    // Each scenario replays the whole history on its own copy of the ratings, so the scenarios run independently
+    ParallelFor(Scenarios.Num(), [&](int32 ScenarioIndex)
+    {
+        const FRatingParams& ScenarioParams = Scenarios[ScenarioIndex];
+        TArray<FCompetitorRating>& ScenarioRatings = OutRatings[ScenarioIndex];
+
+        ScenarioRatings.Init(MakeInitialRating(ScenarioParams), Ratings.Num());
+
+        for(const FMatchResultRecord& Result : Results)
+        {
+            ApplyResult(Result, ScenarioParams, ScenarioRatings);
+        }
+    });
+}
+
+float FRatingEngine::GetLeftOutcome(const FMatchResultRecord& Result, int32 ScoreToWin)
+{
+    int32 LeftScore = Result.LeftScore;
+    int32 RightScore = Result.RightScore;
+
+    // Replay the goals of the match until one of the competitors reaches the score to win
+    if(ScoreToWin > 0)
+    {
+        LeftScore = RightScore = 0;
+
+        for(int32 Goal = 0; Goal < Result.NumGoals && LeftScore < ScoreToWin && RightScore < ScoreToWin; Goal++)
+        {
+            if(Result.GoalSequence & (1u << Goal))
+            {
+                RightScore++;
+            }
+            else
+            {
+                LeftScore++;
+            }
+        }
+    }
+
+    if(LeftScore == RightScore)
+        return 0.5f;
+
+    return LeftScore > RightScore ? 1.0f : 0.0f;
+}
+
+void FRatingEngine::ApplyResult(const FMatchResultRecord& Result, const FRatingParams& Params, TArray<FCompetitorRating>& Ratings)
+{
+    FCompetitorRating& Left = Ratings[Result.LeftCompetitor];
+    FCompetitorRating& Right = Ratings[Result.RightCompetitor];
+
+    const float LeftOutcome = GetLeftOutcome(Result, Params.ScoreToWin);
+
+    if(Params.System == ERatingSystem::Glicko)
+    {
+        // Both competitors are updated from their ratings before the match
+        const FCompetitorRating LeftBefore = Left;
+
+        UpdateGlicko(Left, Right, LeftOutcome, Params);
+        UpdateGlicko(Right, LeftBefore, 1.0f - LeftOutcome, Params);
+    }
+    else
+    {
+        const float Change = Params.KFactor * (LeftOutcome - GetExpectedOutcome(Left.Rating, Right.Rating));
+
+        Left.Rating += Change;
+        Right.Rating -= Change;
+    }
+
+    Left.NumMatches++;
+    Right.NumMatches++;
+}
+
+FCompetitorRating FRatingEngine::MakeInitialRating(const FRatingParams& Params)
+{
+    FCompetitorRating Rating;
+    Rating.Rating = Params.InitialRating;
+    Rating.Deviation = Params.InitialDeviation;
+    Rating.NumMatches = 0;
+
+    return Rating;
+}
+
+int32 FRatingEngine::ReadResultsFile(const FString& FileName)
+{
+    TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FileName));
+
+    if(!File || File->Size() <= ResultsFileOffset)
+        return 0;
+
+    // Only read the part of the file which was appended since the last call
+    TArray<uint8> Data;
+    Data.SetNumUninitialized(File->Size() - ResultsFileOffset);
+
+    if(!File->Seek(ResultsFileOffset) || !File->Read(Data.GetData(), Data.Num()))
+        return 0;
+
+    Results.Reserve(Results.Num() + Data.Num() / (sizeof(FResultFileRecord) + 16));
+
+    int32 NumResultsRead = 0;
+    int32 Offset = 0;
+
+    while(Offset + (int32)sizeof(FResultFileRecord) <= Data.Num())
+    {
+        FResultFileRecord Record;
+        FMemory::Memcpy(&Record, Data.GetData() + Offset, sizeof(Record));
+
+        const int32 RecordSize = sizeof(Record) + Record.LeftNameLength + Record.RightNameLength;
+
+        // Stop at a record which is still being written. It will be read on the next call.
+        if(Offset + RecordSize > Data.Num())
+            break;
+
+        const ANSICHAR* LeftName = (const ANSICHAR*)Data.GetData() + Offset + sizeof(Record);
+        const ANSICHAR* RightName = LeftName + Record.LeftNameLength;
+
+        const FUTF8ToTCHAR LeftNameTCHAR(LeftName, Record.LeftNameLength);
+        const FUTF8ToTCHAR RightNameTCHAR(RightName, Record.RightNameLength);
+
+        AddResult(FName(*FString(LeftNameTCHAR.Length(), LeftNameTCHAR.Get())), FName(*FString(RightNameTCHAR.Length(), RightNameTCHAR.Get())),
+                  Record.LeftScore, Record.RightScore, Record.GoalSequence, Record.NumGoals);
+
+        Offset += RecordSize;
+        NumResultsRead++;
+    }
+
+    ResultsFileOffset += Offset;
+
+    return NumResultsRead;
+}
+
+bool FRatingEngine::AppendResultToFile(const FString& FileName, const FString& LeftName, const FString& RightName, int32 LeftScore, int32 RightScore,
+                                       uint32 GoalSequence, int32 NumGoals)
+{
+    const FTCHARToUTF8 LeftNameUTF8(*LeftName);
+    const FTCHARToUTF8 RightNameUTF8(*RightName);
+
+    FResultFileRecord Record;
+    Record.LeftScore = (uint8)FMath::Clamp(LeftScore, 0, 255);
+    Record.RightScore = (uint8)FMath::Clamp(RightScore, 0, 255);
+    Record.NumGoals = (uint8)FMath::Clamp(NumGoals, 0, 32);
+    Record.Reserved = 0;
+    Record.GoalSequence = GoalSequence;
+    Record.LeftNameLength = (uint16)FMath::Min(LeftNameUTF8.Length(), (int32)MAX_uint16);
+    Record.RightNameLength = (uint16)FMath::Min(RightNameUTF8.Length(), (int32)MAX_uint16);
+
+    // Write the whole record at once so that a reader never sees half of it
+    TArray<uint8> Data;
+    Data.Append((const uint8*)&Record, sizeof(Record));
+    Data.Append((const uint8*)LeftNameUTF8.Get(), Record.LeftNameLength);
+    Data.Append((const uint8*)RightNameUTF8.Get(), Record.RightNameLength);
+
+    TUniquePtr<FArchive> File(IFileManager::Get().CreateFileWriter(*FileName, FILEWRITE_Append | FILEWRITE_AllowRead));
+
+    if(!File)
+        return false;
+
+    File->Serialize(Data.GetData(), Data.Num());
+
+    return !File->IsError();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+/** The rating systems supported by FRatingEngine. */
+namespace ERatingSystem
+{
+    enum Type
+    {
+        Elo,
+        Glicko
+    };
+}
+
+/** The parameters used to compute the ratings. Changing them and recomputing the ratings gives a what-if scenario. */
+struct FRatingParams
+{
+    /** The rating system used to update the ratings after each match. */
+    ERatingSystem::Type System = ERatingSystem::Elo;
+    /** The maximum change in rating after a single match (Elo only). */
+    float KFactor = 32.0f;
+    /** The rating given to a new competitor. */
+    float InitialRating = 1500.0f;
+    /** The rating deviation given to a new competitor (Glicko only). */
+    float InitialDeviation = 350.0f;
+    /** The increase in rating deviation after each match, modeling the uncertainty which builds up over time (Glicko only). */
+    float DeviationDecay = 15.0f;
+    /** The score needed to win a match. The winner of each match is found by replaying its goals up to this score.
+      * If zero, the winner is the competitor with the highest final score. */
+    int32 ScoreToWin = 0;
+};
+
+/** The rating of a competitor. Kept small so that millions of them fit in cache-friendly arrays. */
+struct FCompetitorRating
+{
+    float Rating;
+    float Deviation;
+    uint32 NumMatches;
+};
+
+/** The result of one match. A match is played between two competitors, which are either single players or teams. */
+struct FMatchResultRecord
+{
+    /** The index of each competitor in the rating engine. */
+    uint32 LeftCompetitor;
+    uint32 RightCompetitor;
+    /** Bit N is set if the right competitor scored the Nth goal of the match. */
+    uint32 GoalSequence;
+    /** The number of goals scored in the match, up to 32. */
+    uint8 NumGoals;
+    uint8 LeftScore;
+    uint8 RightScore;
+    uint8 Padding;
+};
+
+/**
+ * Rates competitors (players, bots or teams) based on match results. Each result updates the ratings of its two
+ * competitors in constant time, so ratings can be kept up to date as results stream in. The full history of results
+ * is kept in a compact array (16 bytes per result) so it can be replayed with other parameters. Several what-if
+ * scenarios are recomputed in parallel.
+ */
+class CUBEPROJECT_API FRatingEngine
+{
+public:
+    explicit FRatingEngine(const FRatingParams& InParams = FRatingParams());
+
+    /** Returns the index of the competitor with the given name, adding it with the initial rating if it is new. */
+    int32 FindOrAddCompetitor(const FName& Name);
+
+    /** Stores a match result and updates the ratings of its competitors. */
+    void AddResult(const FMatchResultRecord& Result);
+    /** Stores a match result given by competitor names and updates the ratings of its competitors. */
+    void AddResult(const FName& LeftName, const FName& RightName, int32 LeftScore, int32 RightScore, uint32 GoalSequence, int32 NumGoals);
+
+    /** Recomputes the ratings of every competitor from the stored results for each set of parameters. The scenarios are
+      * computed in parallel. 'OutRatings[N]' receives the ratings obtained with 'Scenarios[N]'. */
+    void ComputeScenarios(const TArray<FRatingParams>& Scenarios, TArray<TArray<FCompetitorRating>>& OutRatings) const;
+
+    /** Reads the results appended to the given results file since the last call, and applies them. Returns the number of results read. */
+    int32 ReadResultsFile(const FString& FileName);
+
+    /** Appends a match result to a results file. Called by the game when a match ends. */
+    static bool AppendResultToFile(const FString& FileName, const FString& LeftName, const FString& RightName, int32 LeftScore, int32 RightScore,
+                                   uint32 GoalSequence, int32 NumGoals);
+
+    /** Returns the outcome of a match for the left competitor (1 for a win, 0 for a loss, 0.5 for a draw) for the given score to win. */
+    static float GetLeftOutcome(const FMatchResultRecord& Result, int32 ScoreToWin);
+
+    FORCEINLINE int32 GetNumCompetitors() const { return Ratings.Num(); }
+    FORCEINLINE int32 GetNumResults() const { return Results.Num(); }
+    FORCEINLINE const FName& GetCompetitorName(int32 Competitor) const { return Names[Competitor]; }
+    FORCEINLINE const FCompetitorRating& GetRating(int32 Competitor) const { return Ratings[Competitor]; }
+    FORCEINLINE const TArray<FCompetitorRating>& GetRatings() const { return Ratings; }
+    FORCEINLINE const FRatingParams& GetParams() const { return Params; }
+
+private:
+    /** Updates the ratings of the competitors of a match. */
+    static void ApplyResult(const FMatchResultRecord& Result, const FRatingParams& Params, TArray<FCompetitorRating>& Ratings);
+
+    /** Returns the rating given to a new competitor. */
+    static FCompetitorRating MakeInitialRating(const FRatingParams& Params);
+
+    /** The parameters used for the incremental updates. */
+    FRatingParams Params;
+
+    /** Maps each competitor's name to its index in the arrays below. */
+    TMap<FName, int32> CompetitorIndices;
+    /** The name of each competitor. */
+    TArray<FName> Names;
+    /** The current rating of each competitor. */
+    TArray<FCompetitorRating> Ratings;
+    /** Every result added so far, in order. */
+    TArray<FMatchResultRecord> Results;
+
+    /** The offset in the results file up to which results have been read by ReadResultsFile(). */
+    int64 ResultsFileOffset;
+};
@@ -0,0 +1,133 @@
+#include "CubeProject.h"
+#include "RatingsCommandlet.h"
+#include "RatingEngine.h"
+
+namespace
+{
+    /** Prints the competitors with the highest ratings. */
+    void PrintTopRatings(const FRatingEngine& Engine, const TArray<FCompetitorRating>& Ratings, int32 Count)
+    {
+        TArray<int32> Competitors;
+        Competitors.SetNumUninitialized(Ratings.Num());
+
+        for(int32 Competitor = 0; Competitor < Ratings.Num(); Competitor++)
+        {
+            Competitors[Competitor] = Competitor;
+        }
+
+        Competitors.Sort([&Ratings](int32 A, int32 B) { return Ratings[A].Rating > Ratings[B].Rating; });
+
+        for(int32 Rank = 0; Rank < FMath::Min(Count, Competitors.Num()); Rank++)
+        {
+            const FCompetitorRating& Rating = Ratings[Competitors[Rank]];
+
+            UE_LOG(LogCubeProject, Display, TEXT("  %3d. %-32s %7.1f (+/- %5.1f, %u matches)"), Rank + 1,
+                   *Engine.GetCompetitorName(Competitors[Rank]).ToString(), Rating.Rating, Rating.Deviation, Rating.NumMatches);
+        }
+    }
+
+    /** Parses a comma-separated list of numbers. Returns the default value if the list is empty. */
+    TArray<float> ParseList(const FString& List, float DefaultValue)
+    {
+        TArray<FString> Items;
+        List.ParseIntoArray(Items, TEXT(","), true);
+
+        TArray<float> Values;
+
+        for(const FString& Item : Items)
+        {
+            Values.Add(FCString::Atof(*Item));
+        }
+
+        if(Values.Num() == 0)
+        {
+            Values.Add(DefaultValue);
+        }
+
+        return Values;
+    }
+}
+
+URatingsCommandlet::URatingsCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 URatingsCommandlet::Main(const FString& Params)
+{
+    FString ResultsFileName = FPaths::GameSavedDir() / TEXT("Ratings") / TEXT("Results.gsrr");
+    FString SystemName;
+    FString KFactors;
+    FString ScoresToWin;
+    int32 Top = 20;
+
+    FParse::Value(*Params, TEXT("results="), ResultsFileName);
+    FParse::Value(*Params, TEXT("system="), SystemName);
+    FParse::Value(*Params, TEXT("k="), KFactors, false);
+    FParse::Value(*Params, TEXT("scoretowin="), ScoresToWin, false);
+    FParse::Value(*Params, TEXT("top="), Top);
+
+    FRatingParams RatingParams;
+    RatingParams.System = (SystemName == TEXT("glicko")) ? ERatingSystem::Glicko : ERatingSystem::Elo;
+    RatingParams.KFactor = ParseList(KFactors, RatingParams.KFactor)[0];
+
+    FRatingEngine Engine(RatingParams);
+
+    double StartTime = FPlatformTime::Seconds();
+    const int32 NumResults = Engine.ReadResultsFile(ResultsFileName);
+
+    UE_LOG(LogCubeProject, Display, TEXT("Rated %d results between %d competitors in %.3f s."), NumResults, Engine.GetNumCompetitors(),
+           FPlatformTime::Seconds() - StartTime);
+
+    PrintTopRatings(Engine, Engine.GetRatings(), Top);
+
+    if(FParse::Param(*Params, TEXT("whatif")))
+    {
+        // Build one scenario for every combination of K-factor and score to win
+        TArray<FRatingParams> Scenarios;
+
+        for(float KFactor : ParseList(KFactors, RatingParams.KFactor))
+        {
+            for(float ScoreToWin : ParseList(ScoresToWin, 0.0f))
+            {
+                FRatingParams Scenario = RatingParams;
+                Scenario.KFactor = KFactor;
+                Scenario.ScoreToWin = FMath::RoundToInt(ScoreToWin);
+                Scenarios.Add(Scenario);
+            }
+        }
+
+        TArray<TArray<FCompetitorRating>> ScenarioRatings;
+
+        StartTime = FPlatformTime::Seconds();
+        Engine.ComputeScenarios(Scenarios, ScenarioRatings);
+
+        UE_LOG(LogCubeProject, Display, TEXT("Recomputed %d scenarios in %.3f s."), Scenarios.Num(), FPlatformTime::Seconds() - StartTime);
+
+        for(int32 ScenarioIndex = 0; ScenarioIndex < Scenarios.Num(); ScenarioIndex++)
+        {
+            UE_LOG(LogCubeProject, Display, TEXT("K = %.1f, score to win = %d:"), Scenarios[ScenarioIndex].KFactor, Scenarios[ScenarioIndex].ScoreToWin);
+            PrintTopRatings(Engine, ScenarioRatings[ScenarioIndex], Top);
+        }
+    }
+
+    // Update the ratings as the game appends new results, until the process is stopped
+    if(FParse::Param(*Params, TEXT("follow")))
+    {
+        while(!GIsRequestingExit)
+        {
+            FPlatformProcess::Sleep(1.0f);
+
+            if(Engine.ReadResultsFile(ResultsFileName) > 0)
+            {
+                UE_LOG(LogCubeProject, Display, TEXT("%d results:"), Engine.GetNumResults());
+                PrintTopRatings(Engine, Engine.GetRatings(), Top);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "RatingsCommandlet.generated.h"
+
+/**
+ * Rates players, bots and teams from the match results recorded by the game (Saved/Ratings/Results.gsrr).
+ *
+ * Usage: UE4Editor-Cmd CubeProject -run=Ratings [options]
+ *
+ * Options:
+ *   -results=<file>      The results file to read.
+ *   -system=<elo|glicko> The rating system (default elo).
+ *   -k=<factor>          The Elo K-factor (default 32).
+ *   -top=<count>         The number of competitors printed (default 20).
+ *   -follow              Keep reading the results file and update the ratings as new results are appended.
+ *   -whatif              Recompute the ratings in parallel for every combination of the comma-separated lists
+ *                        -k=<list> and -scoretowin=<list>, e.g. -whatif -k=16,32,48 -scoretowin=3,5.
+ */
+UCLASS()
+class URatingsCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    URatingsCommandlet();
+
+    // Computes and prints the ratings
+    virtual int32 Main(const FString& Params) override;
+};